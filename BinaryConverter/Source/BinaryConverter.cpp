@@ -4,6 +4,7 @@
 #include "ModelLoader.h"
 #include "InstanceLoader.h"
 #include "InstanceConverter.h"
+#include "CollisionConverter.h"
 #include <iostream>
 
 void setFileInfo(ModelLoader* p_Loader, ModelConverter* p_Converter);
@@ -15,6 +16,8 @@ int main(int argc, char* argv[])
 	ModelConverter converter;
 	InstanceLoader instanceLoader;
 	InstanceConverter levelConverter;
+	BVLoader collisionLoader;
+	CollisionConverter collisionConverter;
 	if(argc == 1)
 	{
 		return EXIT_FAILURE;
@@ -79,8 +82,23 @@ int main(int argc, char* argv[])
 			levelConverter.clear();
 			return EXIT_SUCCESS;
 		}
+		if(strcmp(type, "txc") == 0)
+		{
+			std::string outputPath(argv[1]);
+			outputPath.replace(outputPath.length() - 4, 4, ".btxc");
+			result = collisionLoader.loadTextFile(argv[1]);
+			if(!result){std::cout<<"Error loading file";return EXIT_FAILURE;}
+			collisionConverter.setMeshName(collisionLoader.getLevelHeader().m_modelName);
+			collisionConverter.setCorners(&collisionLoader.getBoundingVolumes());
+			result = collisionConverter.writeFile(outputPath);
+			if(!result){std::cout<<"Error writing file";return EXIT_FAILURE;}
+			std::cout << outputPath << std::endl;
+			collisionLoader.clear();
+			collisionConverter.clear();
+			return EXIT_SUCCESS;
+		}
 		std::cout << argv[0] << " does not support files of type: " << type << std::endl
-			<< "Supported types are: " << std::endl << "      .txe" << std::endl << "      .txl";
+			<< "Supported types are: " << std::endl << "      .txc" << std::endl << "      .txe" << std::endl << "      .txl";
 
 
 		return EXIT_FAILURE;
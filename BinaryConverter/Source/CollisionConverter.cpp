@@ -0,0 +1,106 @@
+#pragma warning(disable : 4996)
+#include "CollisionConverter.h"
+#include <cstring>
+#include <fstream>
+
+CollisionConverter::CollisionConverter()
+{
+	m_Corners = nullptr;
+	m_BuildHierarchy = true;
+}
+
+CollisionConverter::~CollisionConverter()
+{
+	clear();
+}
+
+void CollisionConverter::clear()
+{
+	m_MeshName = "";
+	m_Corners = nullptr;
+}
+
+bool CollisionConverter::writeFile(std::string p_FilePath)
+{
+	if(!m_Corners || m_Corners->empty())
+	{
+		return false;
+	}
+	std::ofstream output(p_FilePath, std::ostream::out | std::ostream::binary);
+
+	if(!output)
+	{
+		return false;
+	}
+
+	TriangleBVH bvh;
+	if(m_BuildHierarchy)
+	{
+		std::vector<Triangle> triangles(getNumTriangles());
+		for(unsigned int i = 0; i < triangles.size(); i++)
+		{
+			triangles[i] = Triangle(Vector4(m_Corners->at(i * 3).m_Postition),
+				Vector4(m_Corners->at(i * 3 + 1).m_Postition),
+				Vector4(m_Corners->at(i * 3 + 2).m_Postition));
+		}
+		bvh.build(triangles);
+	}
+
+	createHeader(&output, bvh);
+	createTriangleBuffer(&output);
+	createHierarchy(&output, bvh);
+	output.close();
+
+	return !output.fail();
+}
+
+void CollisionConverter::setMeshName(std::string p_MeshName)
+{
+	m_MeshName = p_MeshName;
+}
+
+void CollisionConverter::setCorners(const std::vector<BVLoader::BoundingVolume>* p_Corners)
+{
+	m_Corners = p_Corners;
+}
+
+void CollisionConverter::setBuildHierarchy(bool p_BuildHierarchy)
+{
+	m_BuildHierarchy = p_BuildHierarchy;
+}
+
+void CollisionConverter::createHeader(std::ostream* p_Output, const TriangleBVH& p_BVH)
+{
+	CollisionMeshFormat::Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CollisionMeshFormat::fileMagic, sizeof(header.magic));
+	header.version = CollisionMeshFormat::fileVersion;
+	header.numTriangles = getNumTriangles();
+	header.numNodes = p_BVH.getNodes().size();
+	header.numTriangleIndices = p_BVH.getTriangleIndices().size();
+	strncpy(header.meshName, m_MeshName.c_str(), sizeof(header.meshName) - 1);
+
+	p_Output->write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void CollisionConverter::createTriangleBuffer(std::ostream* p_Output)
+{
+	//Corners left over from an incomplete triangle are not written
+	p_Output->write(reinterpret_cast<const char*>(m_Corners->data()), getNumTriangles() * 3 * sizeof(BVLoader::BoundingVolume));
+}
+
+void CollisionConverter::createHierarchy(std::ostream* p_Output, const TriangleBVH& p_BVH)
+{
+	if(p_BVH.getNodes().empty())
+	{
+		return;
+	}
+
+	p_Output->write(reinterpret_cast<const char*>(p_BVH.getNodes().data()), p_BVH.getNodes().size() * sizeof(TriangleBVH::Node));
+	p_Output->write(reinterpret_cast<const char*>(p_BVH.getTriangleIndices().data()), p_BVH.getTriangleIndices().size() * sizeof(unsigned int));
+}
+
+unsigned int CollisionConverter::getNumTriangles() const
+{
+	return m_Corners->size() / 3;
+}
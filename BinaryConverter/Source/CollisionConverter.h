@@ -0,0 +1,66 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../../Physics/Source/BVLoader.h"
+
+class CollisionConverter
+{
+private:
+	std::string m_MeshName;
+	const std::vector<BVLoader::BoundingVolume>* m_Corners;
+	bool m_BuildHierarchy;
+
+public:
+	/**
+	 * Constructor.
+	 */
+	CollisionConverter();
+
+	/**
+	 * Destructor.
+	 */
+	~CollisionConverter();
+
+	/**
+	 * Use this function to release the references to the loaded data.
+	 */
+	void clear();
+
+	/**
+	 * This function writes the loaded bounding volume to a binary collision mesh file (.btxc)
+	 * that the physics can map into memory without parsing it.
+	 *
+	 * @param p_FilePath is the complete filepath to the output file.
+	 * @return false if something is wrong when writing the file.
+	 */
+	bool writeFile(std::string p_FilePath);
+
+	/**
+	 * This whants the mesh name.
+	 *
+	 * @param p_MeshName is a std::string.
+	 */
+	void setMeshName(std::string p_MeshName);
+
+	/**
+	 * This whants a pointer to the triangle corners from the BVLoader, three per triangle.
+	 *
+	 * @param p_Corners is a vector pointer that contains BVLoader::BoundingVolume.
+	 */
+	void setCorners(const std::vector<BVLoader::BoundingVolume>* p_Corners);
+
+	/**
+	 * Select if a triangle hierarchy should be built and stored in the file. It is on by default.
+	 *
+	 * @param p_BuildHierarchy true to store a hierarchy.
+	 */
+	void setBuildHierarchy(bool p_BuildHierarchy);
+
+protected:
+	void createHeader(std::ostream* p_Output, const TriangleBVH& p_BVH);
+	void createTriangleBuffer(std::ostream* p_Output);
+	void createHierarchy(std::ostream* p_Output, const TriangleBVH& p_BVH);
+	unsigned int getNumTriangles() const;
+};
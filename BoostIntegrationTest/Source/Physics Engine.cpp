@@ -6,6 +6,7 @@
 #include "../../Physics/Source/Body.h"
 #include "../../Physics/Source/BVLoader.h"
 #include "../../Physics/Source/PhysicsLogger.h"
+#include "../../Physics/Source/PhysicsExceptions.h"
 #include "../../Common/Source/ResourceManager.h"
 
 #if _DEBUG
@@ -475,6 +476,234 @@ BOOST_AUTO_TEST_CASE(IPhysicsIntegration)
 	BOOST_CHECK(physics == nullptr);
 	Body::resetBodyHandleCounter();
 }
+
+BOOST_AUTO_TEST_CASE(BodySleepingIntegration)
+{
+	BOOST_MESSAGE(testId + "Testing that resting bodies are put to sleep");
+	IPhysics *physics = IPhysics::createPhysics();
+	physics->initialize(false, 1.f / 60.f);
+	physics->setProfilingEnabled(true);
+
+	physics->createAABB(0.f, true, Vector3(0.f, -100.f, 0.f), Vector3(1000.f, 100.f, 1000.f), false);
+	BodyHandle sphere = physics->createSphere(40.f, false, Vector3(0.f, 50.f, 0.f), 50.f);
+	BOOST_CHECK(!physics->getBodySleeping(sphere));
+
+	physics->update(1.f, 100);
+	BOOST_CHECK(physics->getBodySleeping(sphere));
+	BOOST_CHECK_EQUAL(physics->getProfiledStep(0).bodiesSleeping, 1);
+	BOOST_CHECK_EQUAL(physics->getProfiledStep(0).bodiesIntegrated, 0);
+
+	BOOST_MESSAGE(testId + "Testing that sleeping bodies stay in place until woken");
+	const Vector3 restingPosition = physics->getBodyPosition(sphere);
+	physics->setBodyVelocity(sphere, Vector3(0.f, 0.f, 0.f));
+	physics->applyImpulse(sphere, Vector3(0.f, 0.f, 0.f));
+	physics->update(1.f / 60.f, 1);
+	BOOST_CHECK(physics->getBodySleeping(sphere));
+	BOOST_CHECK_EQUAL(physics->getBodyPosition(sphere).y, restingPosition.y);
+
+	physics->applyImpulse(sphere, Vector3(0.f, 400.f, 0.f));
+	BOOST_CHECK(!physics->getBodySleeping(sphere));
+	physics->update(1.f / 60.f, 1);
+	BOOST_CHECK_GT(physics->getBodyPosition(sphere).y, restingPosition.y);
+
+	IPhysics::deletePhysics(physics);
+	Body::resetBodyHandleCounter();
+}
+
+BOOST_AUTO_TEST_CASE(MovablePairIntegration)
+{
+	BOOST_MESSAGE(testId + "Testing that overlapping movable bodies are separated once");
+	IPhysics *physics = IPhysics::createPhysics();
+	physics->initialize(false, 1.f / 60.f);
+
+	// Gravity is kept, bodies without it are taken for the camera and the player and never collide.
+	// Both fall the same distance, so only the x-axis shows the push.
+	BodyHandle left = physics->createSphere(50.f, false, Vector3(0.f, 0.f, 0.f), 50.f);
+	BodyHandle right = physics->createSphere(50.f, false, Vector3(60.f, 0.f, 0.f), 50.f);
+
+	physics->update(1.f / 60.f, 1);
+
+	const Vector3 leftPosition = physics->getBodyPosition(left);
+	const Vector3 rightPosition = physics->getBodyPosition(right);
+	BOOST_CHECK_CLOSE_FRACTION(rightPosition.x - leftPosition.x, 100.f, 0.001f);
+	BOOST_CHECK_CLOSE_FRACTION(leftPosition.x + rightPosition.x, 60.f, 0.001f);
+
+	IPhysics::deletePhysics(physics);
+	Body::resetBodyHandleCounter();
+}
+
+BOOST_AUTO_TEST_CASE(ContinuousCollisionIntegration)
+{
+	BOOST_MESSAGE(testId + "Testing that fast bodies do not pass through thin walls");
+	IPhysics *physics = IPhysics::createPhysics();
+	physics->initialize(true, 1.f / 30.f);
+
+	BodyHandle wall = physics->createOBB(0.f, true, Vector3(0.f, 0.f, 0.f), Vector3(5.f, 1000.f, 1000.f), false);
+	BodyHandle swept = physics->createSphere(1.f, false, Vector3(-60.f, 0.f, 0.f), 10.f);
+	BodyHandle discrete = physics->createSphere(1.f, false, Vector3(-60.f, 0.f, 100.f), 10.f);
+	physics->setBodyContinuousCollision(swept, true);
+	physics->setBodyVelocity(swept, Vector3(2500.f, 0.f, 0.f));
+	physics->setBodyVelocity(discrete, Vector3(2500.f, 0.f, 0.f));
+
+	physics->update(1.f / 30.f, 1);
+
+	BOOST_CHECK_LT(physics->getBodyPosition(swept).x, 0.f);
+	BOOST_CHECK_GT(physics->getBodyPosition(discrete).x, 15.f);
+
+	bool hitWall = false;
+	for (unsigned int i = 0; i < physics->getHitDataSize(); ++i)
+	{
+		const HitData hit = physics->getHitDataAt(i);
+		BOOST_CHECK(hit.collider != discrete);
+		if (hit.collider == swept && hit.collisionVictim == wall)
+			hitWall = true;
+	}
+	BOOST_CHECK(hitWall);
+
+	IPhysics::deletePhysics(physics);
+	Body::resetBodyHandleCounter();
+}
+
+BOOST_AUTO_TEST_CASE(SnapshotIntegration)
+{
+	BOOST_MESSAGE(testId + "Testing that a restored snapshot replays the same steps");
+	IPhysics *physics = IPhysics::createPhysics();
+	physics->initialize(true, 1.f / 60.f);
+	BOOST_CHECK_THROW(physics->captureSnapshot(), PhysicsException);
+	physics->setSnapshotCapacity(4, 8);
+
+	physics->createAABB(0.f, true, Vector3(0.f, -100.f, 0.f), Vector3(1000.f, 100.f, 1000.f), false);
+	BodyHandle sphere = physics->createSphere(40.f, false, Vector3(0.f, 200.f, 0.f), 50.f);
+	physics->setBodyVelocity(sphere, Vector3(100.f, 0.f, 0.f));
+
+	const unsigned int snapshot = physics->captureSnapshot();
+	const Vector3 startPosition = physics->getBodyPosition(sphere);
+	BOOST_CHECK(physics->hasSnapshot(snapshot));
+
+	physics->update(0.5f, 100);
+	const Vector3 endPosition = physics->getBodyPosition(sphere);
+	const Vector3 endVelocity = physics->getBodyVelocity(sphere);
+	BOOST_CHECK_NE(endPosition.x, startPosition.x);
+
+	BOOST_CHECK(physics->restoreSnapshot(snapshot));
+	BOOST_CHECK_EQUAL(physics->getBodyPosition(sphere).x, startPosition.x);
+	BOOST_CHECK_EQUAL(physics->getBodyPosition(sphere).y, startPosition.y);
+	BOOST_CHECK_EQUAL(physics->getBodyVelocity(sphere).x, 100.f);
+
+	physics->update(0.5f, 100);
+	BOOST_CHECK_EQUAL(physics->getBodyPosition(sphere).x, endPosition.x);
+	BOOST_CHECK_EQUAL(physics->getBodyPosition(sphere).y, endPosition.y);
+	BOOST_CHECK_EQUAL(physics->getBodyVelocity(sphere).y, endVelocity.y);
+
+	BOOST_MESSAGE(testId + "Testing that old snapshots are overwritten");
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		physics->captureSnapshot();
+	}
+	BOOST_CHECK(!physics->hasSnapshot(snapshot));
+	BOOST_CHECK(!physics->restoreSnapshot(snapshot));
+
+	IPhysics::deletePhysics(physics);
+	Body::resetBodyHandleCounter();
+}
+
+BOOST_AUTO_TEST_CASE(BatchedBodyIntegration)
+{
+	BOOST_MESSAGE(testId + "Testing to create a floor of boxes and a sphere in one batch");
+	IPhysics *physics = IPhysics::createPhysics();
+	physics->initialize(true, 1.f / 60.f);
+
+	const unsigned int numTiles = 100;
+	std::vector<BodyDescription> descriptions(numTiles + 2);
+	for (unsigned int i = 0; i < numTiles; ++i)
+	{
+		BodyDescription& tile = descriptions[i];
+		tile.type = BoundingVolumeType::OBB;
+		tile.position = Vector3(((float)(i / 10) - 5.f) * 200.f, 0.f, ((float)(i % 10) - 5.f) * 200.f);
+		tile.extents = Vector3(50.f, 10.f, 50.f);
+		tile.scale = Vector3(2.f, 1.f, 2.f);
+		tile.rotation = Vector3(DirectX::XM_PIDIV2, 0.f, 0.f);
+	}
+	BodyDescription& sphere = descriptions[numTiles];
+	sphere.mass = 40.f;
+	sphere.isImmovable = false;
+	sphere.position = Vector3(130.f, 200.f, 30.f);
+	sphere.extents = Vector3(50.f, 0.f, 0.f);
+	BodyDescription& missingHull = descriptions[numTiles + 1];
+	missingHull.type = BoundingVolumeType::HULL;
+	missingHull.volumeID = "NotLoaded";
+
+	std::vector<BodyHandle> handles(descriptions.size());
+	physics->createBodies(descriptions.data(), (unsigned int)descriptions.size(), handles.data());
+	BOOST_CHECK_EQUAL(handles[numTiles + 1], 0u);
+	BOOST_CHECK(handles[numTiles] != 0);
+	BOOST_CHECK_CLOSE(physics->getBodyPosition(handles[numTiles]).x, 130.f, 0.01f);
+
+	BOOST_MESSAGE(testId + "Testing that the batched boxes are found by ray casts and collisions");
+	const RayHit hit = physics->rayCastHit(DirectX::XMFLOAT4(0.f, -1.f, 0.f, 0.f), DirectX::XMFLOAT4(130.f, 500.f, 30.f, 1.f));
+	BOOST_CHECK(hit.hit);
+	BOOST_CHECK_EQUAL(hit.body, handles[65]);
+	BOOST_CHECK_CLOSE(hit.distance, 490.f, 0.1f);
+
+	physics->update(1.f, 100);
+	BOOST_CHECK_GT(physics->getBodyPosition(handles[numTiles]).y, 0.f);
+	BOOST_CHECK(physics->getBodyOnSomething(handles[numTiles]));
+
+	BOOST_MESSAGE(testId + "Testing that bodies created in a batch are sorted into the octree when it ends");
+	physics->beginBodyBatch();
+	BodyHandle box = physics->createOBB(0.f, true, Vector3(0.f, 0.f, 0.f), Vector3(50.f, 50.f, 50.f), false);
+	physics->setBodyPosition(box, Vector3(0.f, 0.f, 5000.f));
+	BOOST_CHECK_EQUAL(physics->rayCast(DirectX::XMFLOAT4(0.f, -1.f, 0.f, 0.f), DirectX::XMFLOAT4(0.f, 500.f, 5000.f, 1.f)), 0u);
+	physics->endBodyBatch();
+	BOOST_CHECK_EQUAL(physics->rayCast(DirectX::XMFLOAT4(0.f, -1.f, 0.f, 0.f), DirectX::XMFLOAT4(0.f, 500.f, 5000.f, 1.f)), box);
+	BOOST_CHECK_EQUAL(physics->rayCast(DirectX::XMFLOAT4(0.f, -1.f, 0.f, 0.f), DirectX::XMFLOAT4(130.f, 500.f, 30.f, 1.f)), handles[65]);
+
+	IPhysics::deletePhysics(physics);
+	Body::resetBodyHandleCounter();
+}
+
+BOOST_AUTO_TEST_CASE(OverlapQueryIntegration)
+{
+	BOOST_MESSAGE(testId + "Testing sphere overlap queries against a static box and a movable sphere");
+	IPhysics *physics = IPhysics::createPhysics();
+	physics->initialize(false, 1.f / 60.f);
+
+	BodyHandle box = physics->createOBB(0.f, true, Vector3(0.f, 0.f, 0.f), Vector3(100.f, 100.f, 100.f), false);
+	BodyHandle sphere = physics->createSphere(40.f, false, Vector3(1000.f, 0.f, 0.f), 50.f);
+
+	BodyHandle found[2] = {0, 0};
+	BOOST_CHECK_EQUAL(physics->overlapSphere(Vector3(1000.f, 0.f, 0.f), 10.f, true, found, 2), 1u);
+	BOOST_CHECK_EQUAL(found[0], sphere);
+	BOOST_CHECK_EQUAL(physics->overlapSphere(Vector3(0.f, 150.f, 0.f), 60.f, true, found, 2), 1u);
+	BOOST_CHECK_EQUAL(found[0], box);
+	BOOST_CHECK_EQUAL(physics->overlapSphere(Vector3(500.f, 0.f, 0.f), 10.f, false, found, 2), 0u);
+
+	BOOST_MESSAGE(testId + "Testing that exact queries skip bodies only reached by their surrounding sphere");
+	BOOST_CHECK_EQUAL(physics->overlapSphere(Vector3(190.f, 190.f, 190.f), 100.f, false, found, 2), 1u);
+	BOOST_CHECK_EQUAL(physics->overlapSphere(Vector3(190.f, 190.f, 190.f), 100.f, true, found, 2), 0u);
+
+	BOOST_MESSAGE(testId + "Testing box overlap queries");
+	BOOST_CHECK_EQUAL(physics->overlapAABB(Vector3(500.f, 0.f, 0.f), Vector3(600.f, 10.f, 10.f), true, found, 2), 2u);
+	BOOST_CHECK((found[0] == box && found[1] == sphere) || (found[0] == sphere && found[1] == box));
+	BOOST_CHECK_EQUAL(physics->overlapOBB(Vector3(0.f, 250.f, 0.f), Vector3(10.f, 200.f, 10.f), Vector3(0.f, 0.f, 0.f), true, found, 2), 1u);
+	BOOST_CHECK_EQUAL(found[0], box);
+	BOOST_CHECK_EQUAL(physics->overlapOBB(Vector3(0.f, 250.f, 0.f), Vector3(10.f, 200.f, 10.f), Vector3(0.f, 0.f, DirectX::XM_PIDIV2), true, found, 2), 0u);
+
+	BOOST_MESSAGE(testId + "Testing that queries report every overlapping body but only fill the given room");
+	found[0] = found[1] = 0;
+	BOOST_CHECK_EQUAL(physics->overlapAABB(Vector3(500.f, 0.f, 0.f), Vector3(600.f, 10.f, 10.f), true, found, 1), 2u);
+	BOOST_CHECK(found[0] == box || found[0] == sphere);
+	BOOST_CHECK_EQUAL(found[1], 0u);
+
+	BOOST_MESSAGE(testId + "Testing that movable bodies are found where they were moved to before the next step");
+	physics->setBodyPosition(sphere, Vector3(0.f, 0.f, 2000.f));
+	BOOST_CHECK_EQUAL(physics->overlapSphere(Vector3(1000.f, 0.f, 0.f), 10.f, true, found, 2), 0u);
+	BOOST_CHECK_EQUAL(physics->overlapSphere(Vector3(0.f, 0.f, 2000.f), 10.f, true, found, 2), 1u);
+	BOOST_CHECK_EQUAL(found[0], sphere);
+
+	IPhysics::deletePhysics(physics);
+	Body::resetBodyHandleCounter();
+}
 #pragma endregion
 
 #pragma region // ## Step 5 ## //
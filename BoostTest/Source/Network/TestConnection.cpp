@@ -0,0 +1,150 @@
+#include <boost/test/unit_test.hpp>
+#include "../../../Network/Source/Connection.h"
+
+#include <atomic>
+
+BOOST_AUTO_TEST_SUITE(TestConnection)
+
+const unsigned short testPort = 12347;
+
+/**
+ * A connection over loopback, with the remote end read directly from a socket.
+ */
+class LoopbackConnection
+{
+public:
+	boost::asio::io_service m_IO_Service;
+	std::unique_ptr<boost::asio::io_service::work> m_Work;
+	boost::thread m_Thread;
+	boost::asio::ip::tcp::socket m_Remote;
+	std::shared_ptr<Connection> m_Connection;
+
+	LoopbackConnection()
+		:	m_Work(new boost::asio::io_service::work(m_IO_Service)),
+			m_Remote(m_IO_Service)
+	{
+		const boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(), testPort);
+		boost::asio::ip::tcp::acceptor acceptor(m_IO_Service, endpoint);
+		boost::asio::ip::tcp::socket local(m_IO_Service);
+
+		m_Remote.connect(endpoint);
+		acceptor.accept(local);
+		m_Connection.reset(new Connection(std::move(local)));
+
+		m_Thread = boost::thread([this] () { m_IO_Service.run(); });
+	}
+
+	~LoopbackConnection()
+	{
+		m_Connection->disconnect();
+		m_Work.reset();
+		m_IO_Service.stop();
+		m_Thread.join();
+	}
+
+	/**
+	 * Read one message from the remote end of the connection.
+	 */
+	std::string readMessage(uint16_t& p_ID)
+	{
+		uint32_t size;
+		boost::asio::read(m_Remote, boost::asio::buffer(&size, sizeof(size)));
+		boost::asio::read(m_Remote, boost::asio::buffer(&p_ID, sizeof(p_ID)));
+
+		std::string data(size - sizeof(size) - sizeof(p_ID), '\0');
+		boost::asio::read(m_Remote, boost::asio::buffer(&data[0], data.size()));
+
+		return data;
+	}
+
+	/**
+	 * Write one message from the remote end of the connection.
+	 */
+	void writeMessage(const std::string& p_Data, uint16_t p_ID)
+	{
+		const uint32_t size = (uint32_t)(sizeof(size) + sizeof(p_ID) + p_Data.size());
+		boost::asio::write(m_Remote, boost::asio::buffer(&size, sizeof(size)));
+		boost::asio::write(m_Remote, boost::asio::buffer(&p_ID, sizeof(p_ID)));
+		boost::asio::write(m_Remote, boost::asio::buffer(p_Data));
+	}
+};
+
+template <typename Condition>
+static bool waitFor(Condition p_Condition)
+{
+	for (unsigned int i = 0; i < 200 && !p_Condition(); ++i)
+	{
+		boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+	}
+	return p_Condition();
+}
+
+BOOST_AUTO_TEST_CASE(TestQueuedMessagesShareWrite)
+{
+	LoopbackConnection loopback;
+	loopback.m_Connection->setWriteBatching(1024, 500);
+
+	for (uint16_t i = 0; i < 5; ++i)
+	{
+		loopback.m_Connection->writeData("Message " + std::to_string(i), i);
+	}
+
+	for (uint16_t i = 0; i < 5; ++i)
+	{
+		uint16_t id;
+		BOOST_CHECK_EQUAL(loopback.readMessage(id), "Message " + std::to_string(i));
+		BOOST_CHECK_EQUAL(id, i);
+	}
+	BOOST_CHECK_EQUAL(loopback.m_Connection->getNumWrites(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestMessageOverCapWrittenAlone)
+{
+	LoopbackConnection loopback;
+	loopback.m_Connection->setWriteBatching(1024, 500);
+
+	// The large message ends the delay, the small messages around it are written without it
+	const std::string large(2000, 'x');
+	loopback.m_Connection->writeData("Before 1", 1);
+	loopback.m_Connection->writeData("Before 2", 2);
+	loopback.m_Connection->writeData(large, 3);
+	loopback.m_Connection->writeData("After", 4);
+
+	uint16_t id;
+	BOOST_CHECK_EQUAL(loopback.readMessage(id), "Before 1");
+	BOOST_CHECK_EQUAL(loopback.readMessage(id), "Before 2");
+	BOOST_CHECK_EQUAL(loopback.readMessage(id), large);
+	BOOST_CHECK_EQUAL(id, 3);
+	BOOST_CHECK_EQUAL(loopback.readMessage(id), "After");
+	BOOST_CHECK_EQUAL(loopback.m_Connection->getNumWrites(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(TestPausedConnectionStopsReading)
+{
+	LoopbackConnection loopback;
+
+	std::atomic<unsigned int> numReceived(0);
+	Connection* connection = loopback.m_Connection.get();
+	loopback.m_Connection->setSaveData([&numReceived, connection] (uint16_t, std::vector<char>&)
+	{
+		connection->pauseReading();
+		++numReceived;
+	});
+	loopback.m_Connection->startReading();
+
+	loopback.writeMessage("First", 1);
+	loopback.writeMessage("Second", 2);
+	BOOST_REQUIRE(waitFor([&] () { return numReceived == 1; }));
+	boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+	BOOST_CHECK_EQUAL(numReceived, 1);
+
+	// Handlers posted to the connection run while it is paused
+	std::atomic<bool> posted(false);
+	loopback.m_Connection->post([&posted] () { posted = true; });
+	BOOST_CHECK(waitFor([&] () { return posted.load(); }));
+
+	loopback.m_Connection->resumeReading();
+	BOOST_CHECK(waitFor([&] () { return numReceived == 2; }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
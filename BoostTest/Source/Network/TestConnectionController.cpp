@@ -7,6 +7,12 @@ class ConnectionStub : public IConnection
 {
 public:
 	IConnection::saveDataFunction m_SaveData;
+	std::shared_ptr<const std::string> m_LastSharedData;
+	size_t m_MaxWriteBytes;
+	unsigned int m_MaxWriteDelayMs;
+	bool m_ReadPaused;
+
+	ConnectionStub() : m_MaxWriteBytes(0), m_MaxWriteDelayMs(0), m_ReadPaused(false) {}
 
 	bool isConnected() const override { return true; }
 	void disconnect() override {};
@@ -15,17 +21,43 @@ public:
 	{
 		if (m_SaveData)
 		{
-			m_SaveData(p_ID, p_Buffer);
+			std::vector<char> data(p_Buffer.begin(), p_Buffer.end());
+			m_SaveData(p_ID, data);
 		}
 	}
+	void writeSharedData(std::shared_ptr<const std::string> p_Buffer, uint16_t p_ID) override
+	{
+		m_LastSharedData = p_Buffer;
+		writeData(*p_Buffer, p_ID);
+	}
 	void setSaveData(saveDataFunction p_SaveData) override
 	{
 		m_SaveData = p_SaveData;
 	}
 	void setDisconnectedCallback(disconnectedCallback_t p_DisconnectedCallback) override {}
 	void startReading() override {}
+	void pauseReading() override { m_ReadPaused = true; }
+	void resumeReading() override { m_ReadPaused = false; }
+	void post(std::function<void()> p_Handler) override { p_Handler(); }
+	void setWriteBatching(size_t p_MaxBytes, unsigned int p_MaxDelayMs) override
+	{
+		m_MaxWriteBytes = p_MaxBytes;
+		m_MaxWriteDelayMs = p_MaxDelayMs;
+	}
 };
 
+BOOST_AUTO_TEST_CASE(TestSetWriteBatching)
+{
+	std::shared_ptr<ConnectionStub> conn(new ConnectionStub);
+	ConnectionController controller(conn, std::vector<PackageBase::ptr>());
+
+	IConnectionController& controllerInterface = controller;
+	controllerInterface.setWriteBatching(4096, 5);
+
+	BOOST_CHECK_EQUAL(conn->m_MaxWriteBytes, 4096);
+	BOOST_CHECK_EQUAL(conn->m_MaxWriteDelayMs, 5);
+}
+
 BOOST_AUTO_TEST_CASE(TestReceivePackage)
 {
 	IConnection::ptr conn(new ConnectionStub);
@@ -98,6 +130,47 @@ BOOST_AUTO_TEST_CASE(TestSendUpdate)
 	BOOST_CHECK_EQUAL(recExtraData, extraData);
 }
 
+BOOST_AUTO_TEST_CASE(TestBroadcastUpdate)
+{
+	std::shared_ptr<ConnectionStub> conn1(new ConnectionStub);
+	std::shared_ptr<ConnectionStub> conn2(new ConnectionStub);
+
+	std::vector<PackageBase::ptr> prototypes;
+	prototypes.push_back(PackageBase::ptr(new UpdateObjects));
+
+	ConnectionController controller1(conn1, prototypes);
+	ConnectionController controller2(conn2, prototypes);
+
+	UpdateObjectData data;
+	data.m_Id = 1;
+	data.m_Position = Vector3(3.f, 4.f, 5.f);
+	data.m_Rotation = Vector3(6.f, 7.f, 8.f);
+	data.m_RotationVelocity = Vector3(9.f, 10.f, 11.f);
+	data.m_Velocity = Vector3(12.f, 13.f, 14.f);
+	std::string extraData("TestExtraData");
+	const char* cExtraData = extraData.c_str();
+
+	IConnectionController* connections[] = { &controller1, &controller2 };
+	IConnectionController::broadcastUpdateObjects(connections, 2, &data, 1, &cExtraData, 1);
+
+	BOOST_REQUIRE(conn1->m_LastSharedData);
+	BOOST_CHECK_EQUAL(conn1->m_LastSharedData, conn2->m_LastSharedData);
+
+	ConnectionController* controllers[] = { &controller1, &controller2 };
+	for (ConnectionController* controller : controllers)
+	{
+		BOOST_REQUIRE_EQUAL(controller->getNumPackages(), 1);
+
+		Package packageRef = controller->getPackage(0);
+		BOOST_REQUIRE_EQUAL((uint16_t)controller->getPackageType(packageRef), (uint16_t)PackageType::UPDATE_OBJECTS);
+		BOOST_REQUIRE_EQUAL(controller->getNumUpdateObjectData(packageRef), 1);
+		BOOST_CHECK_EQUAL(controller->getUpdateObjectData(packageRef)[0].m_Id, data.m_Id);
+		BOOST_CHECK_EQUAL(controller->getUpdateObjectData(packageRef)[0].m_Position, data.m_Position);
+		BOOST_REQUIRE_EQUAL(controller->getNumUpdateObjectExtraData(packageRef), 1);
+		BOOST_CHECK_EQUAL(controller->getUpdateObjectExtraData(packageRef, 0), extraData);
+	}
+}
+
 BOOST_AUTO_TEST_CASE(TestSendCreateObjects)
 {
 	IConnection::ptr conn(new ConnectionStub);
@@ -275,4 +348,77 @@ BOOST_AUTO_TEST_CASE(TestSendRemoveObjects)
 	BOOST_CHECK_EQUAL(controller.getRemoveObjectRefs(packageRef)[0], testObjectId);
 }
 
+BOOST_AUTO_TEST_CASE(TestRecyclePackages)
+{
+	IConnection::ptr conn(new ConnectionStub);
+
+	std::vector<PackageBase::ptr> prototypes;
+	prototypes.push_back(PackageBase::ptr(new AssignPlayer));
+	prototypes.push_back(PackageBase::ptr(new RemoveObjects));
+
+	ConnectionController controller(conn, prototypes);
+
+	// Wrap around and grow the received queue while recycling consumed packages
+	uint32_t nextSent = 0;
+	uint32_t nextReceived = 0;
+	for (unsigned int round = 0; round < 10; ++round)
+	{
+		for (unsigned int i = 0; i < 50; ++i)
+		{
+			controller.sendAssignPlayer(nextSent);
+			controller.sendRemoveObjects(&nextSent, 1);
+			++nextSent;
+		}
+
+		const unsigned int numPackages = controller.getNumPackages();
+		BOOST_REQUIRE_EQUAL(numPackages, (nextSent - nextReceived) * 2);
+
+		const unsigned int numConsumed = numPackages / 4 * 2;
+		for (unsigned int i = 0; i < numConsumed; i += 2)
+		{
+			BOOST_REQUIRE_EQUAL((uint16_t)controller.getPackageType(controller.getPackage(i)), (uint16_t)PackageType::ASSIGN_PLAYER);
+			BOOST_CHECK_EQUAL(controller.getAssignPlayerObject(controller.getPackage(i)), nextReceived);
+			BOOST_REQUIRE_EQUAL((uint16_t)controller.getPackageType(controller.getPackage(i + 1)), (uint16_t)PackageType::REMOVE_OBJECTS);
+			BOOST_REQUIRE_EQUAL(controller.getNumRemoveObjectRefs(controller.getPackage(i + 1)), 1);
+			BOOST_CHECK_EQUAL(controller.getRemoveObjectRefs(controller.getPackage(i + 1))[0], nextReceived);
+			++nextReceived;
+		}
+		controller.clearPackages(numConsumed);
+	}
+
+	controller.clearPackages(controller.getNumPackages());
+	BOOST_CHECK_EQUAL(controller.getNumPackages(), 0);
+	BOOST_CHECK_EQUAL((uint16_t)controller.getPackageType(controller.getPackage(0)), (uint16_t)PackageType::RESERVED);
+}
+
+BOOST_AUTO_TEST_CASE(TestPauseReadingWhenFull)
+{
+	std::shared_ptr<ConnectionStub> conn(new ConnectionStub);
+
+	std::vector<PackageBase::ptr> prototypes;
+	prototypes.push_back(PackageBase::ptr(new AssignPlayer));
+
+	ConnectionController controller(conn, prototypes);
+
+	// The package that does not fit pauses reading instead of being dropped
+	uint32_t numSent = 0;
+	while (!conn->m_ReadPaused && numSent < 10000)
+	{
+		controller.sendAssignPlayer(numSent++);
+	}
+	BOOST_REQUIRE(conn->m_ReadPaused);
+
+	const unsigned int numPackages = controller.getNumPackages();
+	BOOST_REQUIRE_EQUAL(numPackages, numSent - 1);
+	BOOST_CHECK_EQUAL(controller.getAssignPlayerObject(controller.getPackage(numPackages - 1)), numSent - 2);
+
+	// Making room hands over the waiting package and continues reading
+	controller.clearPackages(1);
+	BOOST_CHECK(!conn->m_ReadPaused);
+
+	BOOST_REQUIRE_EQUAL(controller.getNumPackages(), numPackages);
+	BOOST_CHECK_EQUAL(controller.getAssignPlayerObject(controller.getPackage(0)), 1);
+	BOOST_CHECK_EQUAL(controller.getAssignPlayerObject(controller.getPackage(numPackages - 1)), numSent - 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -13,12 +13,45 @@ BOOST_AUTO_TEST_CASE(TestPackageSerialize)
 
 	std::string serializedData(package.getData());
 
-	PackageBase::ptr deserializedPackage(package.createPackage(serializedData));
+	PackageBase::ptr deserializedPackage(package.createPackage(std::vector<char>(serializedData.begin(), serializedData.end())));
 	CreateObjects* rawDeserializedPackage = (CreateObjects*)deserializedPackage.get();
 
 	BOOST_CHECK_EQUAL(rawDeserializedPackage->m_Object1.size(), 1);
-	BOOST_CHECK_EQUAL(rawDeserializedPackage->m_Object1[0].first, testDescription);
+	BOOST_CHECK_EQUAL(rawDeserializedPackage->m_Object1[0].first.c_str(), testDescription);
 	BOOST_CHECK_EQUAL(rawDeserializedPackage->m_Object1[0].second, testId);
 }
 
+BOOST_AUTO_TEST_CASE(TestPackageReadInPlace)
+{
+	ObjectAction action;
+	action.m_Object1 = 5;
+	action.m_Object2 = "Jump";
+
+	std::string serializedData(action.getData());
+	std::vector<char> data(serializedData.begin(), serializedData.end());
+	const char* buffer = data.data();
+
+	PackageBase::ptr deserializedPackage(action.createPackage(std::move(data)));
+	ObjectAction* rawDeserializedPackage = (ObjectAction*)deserializedPackage.get();
+
+	BOOST_CHECK_EQUAL(rawDeserializedPackage->m_Object1, 5);
+	BOOST_CHECK_EQUAL(rawDeserializedPackage->m_Object2.c_str(), "Jump");
+	BOOST_CHECK(rawDeserializedPackage->m_Object2.c_str() >= buffer);
+	BOOST_CHECK(rawDeserializedPackage->m_Object2.c_str() < buffer + serializedData.size());
+
+	const uint32_t objects[] = { 1, 2, 3 };
+	RemoveObjects remove;
+	remove.m_Object1.assign(objects, objects + 3);
+
+	serializedData = remove.getData();
+	deserializedPackage = remove.createPackage(std::vector<char>(serializedData.begin(), serializedData.end()));
+	RemoveObjects* rawRemove = (RemoveObjects*)deserializedPackage.get();
+
+	BOOST_REQUIRE_EQUAL(rawRemove->m_Object1.size(), 3);
+	BOOST_CHECK_EQUAL(rawRemove->m_Object1[2], 3);
+
+	std::vector<char> truncated(serializedData.begin(), serializedData.end() - 1);
+	BOOST_CHECK_THROW(remove.createPackage(std::move(truncated)), NetworkError);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include <boost/test/unit_test.hpp>
+#include "../../../Network/Source/SnapshotCodec.h"
+#include "../../../Network/include/NetworkExceptions.h"
+
+BOOST_AUTO_TEST_SUITE(TestSnapshotCodec)
+
+static UpdateObjectData createObject(uint32_t p_Id, float p_X)
+{
+	UpdateObjectData data =
+	{
+		Vector3(p_X, 50.f, -2000.f),
+		Vector3(500.f, 0.f, 0.f),
+		Vector3(1.2345f, 0.f, 0.f),
+		Vector3(0.f, 0.f, 0.f),
+		p_Id
+	};
+	return data;
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotRoundTrip)
+{
+	UpdateObjectPrecision precision;
+	std::vector<UpdateObjectData> objects;
+	objects.push_back(createObject(100, 0.33f));
+	objects.push_back(createObject(101, 1000.33f));
+	const std::string look("<ObjectUpdate ActorId=\"100\" Type=\"Look\"/>");
+	const char* extraData[] = { look.c_str() };
+
+	SnapshotBaseline::ptr sent;
+	SnapshotHistory received;
+	std::vector<uint8_t> snapshot;
+	size_t fullSize = 0;
+
+	for (unsigned int tick = 0; tick < 3; ++tick)
+	{
+		objects[0].m_Position.x += 10.f;
+
+		sent = SnapshotCodec::encode(objects.data(), (unsigned int)objects.size(), extraData, 1, precision, sent, snapshot);
+		if (tick == 0)
+		{
+			fullSize = snapshot.size();
+		}
+		else
+		{
+			BOOST_CHECK_LT(snapshot.size() * 4, fullSize);
+		}
+
+		std::vector<UpdateObjectData> decoded;
+		std::vector<std::string> decodedExtra;
+		BOOST_CHECK_EQUAL(SnapshotCodec::decode(snapshot.data(), snapshot.size(), received, decoded, decodedExtra)->m_Id, sent->m_Id);
+
+		BOOST_REQUIRE_EQUAL(decoded.size(), objects.size());
+		for (unsigned int i = 0; i < objects.size(); ++i)
+		{
+			BOOST_CHECK_EQUAL(decoded[i].m_Id, objects[i].m_Id);
+			BOOST_CHECK_SMALL(decoded[i].m_Position.x - objects[i].m_Position.x, 0.05f);
+			BOOST_CHECK_SMALL(decoded[i].m_Rotation.x - objects[i].m_Rotation.x, 0.00026f);
+			BOOST_CHECK_EQUAL(decoded[i].m_Velocity.x, 500.f);
+		}
+		BOOST_REQUIRE_EQUAL(decodedExtra.size(), 1);
+		BOOST_CHECK_EQUAL(decodedExtra[0], look);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotBaselineChanges)
+{
+	UpdateObjectPrecision precision;
+	std::vector<UpdateObjectData> objects;
+	objects.push_back(createObject(100, 0.f));
+	objects.push_back(createObject(101, 1000.f));
+
+	std::vector<uint8_t> snapshot;
+	std::vector<UpdateObjectData> decoded;
+	std::vector<std::string> decodedExtra;
+	SnapshotHistory received;
+	SnapshotBaseline::ptr sent = SnapshotCodec::encode(objects.data(), (unsigned int)objects.size(), nullptr, 0, precision, nullptr, snapshot);
+	SnapshotCodec::decode(snapshot.data(), snapshot.size(), received, decoded, decodedExtra);
+
+	// Snapshots with only extra data keep the baseline
+	const char* extraData[] = { "Color" };
+	BOOST_CHECK_EQUAL(SnapshotCodec::encode(nullptr, 0, extraData, 1, precision, sent, snapshot), sent);
+	BOOST_CHECK(!SnapshotCodec::decode(snapshot.data(), snapshot.size(), received, decoded, decodedExtra));
+	BOOST_CHECK(decoded.empty());
+	BOOST_REQUIRE_EQUAL(decodedExtra.size(), 1);
+	BOOST_CHECK_EQUAL(decodedExtra[0], "Color");
+
+	// Reordered and new objects
+	std::swap(objects[0], objects[1]);
+	objects.push_back(createObject(102, 2000.f));
+	precision.m_PositionSteps = 1.f;
+	sent = SnapshotCodec::encode(objects.data(), (unsigned int)objects.size(), nullptr, 0, precision, sent, snapshot);
+	SnapshotCodec::decode(snapshot.data(), snapshot.size(), received, decoded, decodedExtra);
+
+	BOOST_REQUIRE_EQUAL(decoded.size(), objects.size());
+	for (unsigned int i = 0; i < objects.size(); ++i)
+	{
+		BOOST_CHECK_EQUAL(decoded[i].m_Id, objects[i].m_Id);
+		BOOST_CHECK_EQUAL(decoded[i].m_Position.x, objects[i].m_Position.x);
+	}
+
+	// A delta snapshot can not be decoded without its baseline
+	sent = SnapshotCodec::encode(objects.data(), (unsigned int)objects.size(), nullptr, 0, precision, sent, snapshot);
+	SnapshotHistory empty;
+	BOOST_CHECK_THROW(SnapshotCodec::decode(snapshot.data(), snapshot.size(), empty, decoded, decodedExtra), NetworkError);
+
+	snapshot.resize(snapshot.size() / 2);
+	BOOST_CHECK_THROW(SnapshotCodec::decode(snapshot.data(), snapshot.size(), received, decoded, decodedExtra), NetworkError);
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotAcknowledgedBaseline)
+{
+	UpdateObjectPrecision precision;
+	std::vector<UpdateObjectData> objects;
+	objects.push_back(createObject(100, 0.f));
+	objects.push_back(createObject(101, 1000.f));
+
+	SnapshotHistory received;
+	std::vector<uint8_t> snapshot;
+	std::vector<UpdateObjectData> decoded;
+	std::vector<std::string> decodedExtra;
+	const SnapshotBaseline::ptr acknowledged = SnapshotCodec::encode(objects.data(), (unsigned int)objects.size(), nullptr, 0,
+		precision, nullptr, snapshot);
+	BOOST_CHECK_EQUAL(SnapshotCodec::decode(snapshot.data(), snapshot.size(), received, decoded, decodedExtra)->m_Id, acknowledged->m_Id);
+
+	// Snapshots encoded against the acknowledged baseline can be decoded even if the ones between them were lost
+	std::vector<std::vector<uint8_t>> inFlight;
+	for (unsigned int tick = 0; tick < 3; ++tick)
+	{
+		objects[0].m_Position.x += 10.f;
+		SnapshotCodec::encode(objects.data(), (unsigned int)objects.size(), nullptr, 0, precision, acknowledged, snapshot);
+		inFlight.push_back(snapshot);
+	}
+
+	const SnapshotBaseline::ptr last = SnapshotCodec::decode(inFlight.back().data(), inFlight.back().size(), received, decoded, decodedExtra);
+	BOOST_REQUIRE(last);
+	BOOST_CHECK(SnapshotCodec::isNewer(last->m_Id, acknowledged->m_Id));
+	BOOST_REQUIRE_EQUAL(decoded.size(), objects.size());
+	BOOST_CHECK_EQUAL(decoded[0].m_Position.x, 30.f);
+	BOOST_CHECK_EQUAL(received.find(last->m_Id), last);
+
+	// Late snapshots still have their baseline
+	SnapshotCodec::decode(inFlight.front().data(), inFlight.front().size(), received, decoded, decodedExtra);
+	BOOST_CHECK_EQUAL(decoded[0].m_Position.x, 10.f);
+
+	// Baselines older than the history are forgotten
+	for (unsigned int i = 0; i < SnapshotHistory::maxSnapshots; ++i)
+	{
+		SnapshotCodec::encode(objects.data(), (unsigned int)objects.size(), nullptr, 0, precision, nullptr, snapshot);
+		SnapshotCodec::decode(snapshot.data(), snapshot.size(), received, decoded, decodedExtra);
+	}
+	BOOST_CHECK(!received.find(acknowledged->m_Id));
+	BOOST_CHECK_THROW(SnapshotCodec::decode(inFlight[1].data(), inFlight[1].size(), received, decoded, decodedExtra), NetworkError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
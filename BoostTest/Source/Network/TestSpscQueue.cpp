@@ -0,0 +1,70 @@
+#include <boost/test/unit_test.hpp>
+#include "../../../Network/Source/SpscQueue.h"
+
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(TestSpscQueue)
+
+BOOST_AUTO_TEST_CASE(TestQueueOrder)
+{
+	SpscQueue<int> queue(4);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		BOOST_CHECK(queue.push(i));
+	}
+	int value = 4;
+	BOOST_CHECK(!queue.push(value));
+	BOOST_CHECK_EQUAL(value, 4);
+
+	BOOST_REQUIRE_EQUAL(queue.getNumAvailable(), 4);
+	BOOST_CHECK_EQUAL(queue.at(3), 3);
+
+	queue.pop(value);
+	BOOST_CHECK_EQUAL(value, 0);
+	BOOST_CHECK_EQUAL(queue.at(0), 1);
+
+	value = 4;
+	BOOST_CHECK(queue.push(value));
+	BOOST_REQUIRE_EQUAL(queue.getNumAvailable(), 4);
+	BOOST_CHECK_EQUAL(queue.at(3), 4);
+}
+
+BOOST_AUTO_TEST_CASE(TestQueueThreads)
+{
+	static const unsigned int numValues = 100000;
+	SpscQueue<unsigned int> queue(64);
+
+	std::thread producer([&queue] ()
+	{
+		for (unsigned int i = 0; i < numValues; ++i)
+		{
+			unsigned int value = i;
+			while (!queue.push(value))
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	unsigned int expected = 0;
+	while (expected < numValues)
+	{
+		const size_t numAvailable = queue.getNumAvailable();
+		for (size_t i = 0; i < numAvailable; ++i)
+		{
+			BOOST_REQUIRE_EQUAL(queue.at(i), expected + i);
+		}
+		for (size_t i = 0; i < numAvailable; ++i)
+		{
+			unsigned int value;
+			queue.pop(value);
+			++expected;
+		}
+	}
+
+	producer.join();
+	BOOST_CHECK_EQUAL(queue.getNumAvailable(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,355 @@
+#include <boost/test/unit_test.hpp>
+#include "../../../Network/Source/ConnectionController.h"
+#include "../../../Network/Source/UnreliableChannel.h"
+
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+BOOST_AUTO_TEST_SUITE(TestUnreliableChannel)
+
+const unsigned short testPort = 12346;
+
+/**
+ * Runs an io service on a thread of its own for the duration of a test.
+ */
+class IO_Runner
+{
+public:
+	boost::asio::io_service m_IO_Service;
+	std::unique_ptr<boost::asio::io_service::work> m_Work;
+	boost::thread m_Thread;
+
+	IO_Runner()
+		:	m_Work(new boost::asio::io_service::work(m_IO_Service))
+	{
+		m_Thread = boost::thread([this] () { m_IO_Service.run(); });
+	}
+
+	~IO_Runner()
+	{
+		m_Work.reset();
+		m_IO_Service.stop();
+		m_Thread.join();
+	}
+};
+
+/**
+ * Drops every p_Period:th datagram.
+ */
+static UnreliableChannel::lossFunction_t dropEvery(unsigned int p_Period)
+{
+	std::shared_ptr<unsigned int> count(new unsigned int(0));
+	return [count, p_Period] ()
+	{
+		return ++*count % p_Period == 0;
+	};
+}
+
+template <typename Condition>
+static bool waitFor(Condition p_Condition)
+{
+	for (unsigned int i = 0; i < 200 && !p_Condition(); ++i)
+	{
+		boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+	}
+	return p_Condition();
+}
+
+BOOST_AUTO_TEST_CASE(TestChannelLoss)
+{
+	IO_Runner runner;
+
+	UnreliableChannel::ptr server(new UnreliableChannel(runner.m_IO_Service, testPort));
+	UnreliableChannel::ptr client(new UnreliableChannel(runner.m_IO_Service,
+		boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), testPort)));
+	server->startReceiving();
+	client->startReceiving();
+
+	std::mutex receivedLock;
+	std::vector<uint32_t> serverReceived;
+	std::vector<uint32_t> clientReceived;
+
+	const uint32_t token = server->addPeer([&] (uint16_t p_ID, uint32_t p_Sequence, std::vector<char>& p_Data)
+	{
+		std::lock_guard<std::mutex> lock(receivedLock);
+		serverReceived.push_back(p_Sequence);
+	});
+
+	// The server does not know where the client is until it has heard from it
+	BOOST_CHECK(!server->canSend(token));
+	BOOST_CHECK(!server->send(token, 1, 1, "Data"));
+
+	client->addPeer(token, [&] (uint16_t p_ID, uint32_t p_Sequence, std::vector<char>& p_Data)
+	{
+		std::lock_guard<std::mutex> lock(receivedLock);
+		clientReceived.push_back(p_Sequence);
+	});
+
+	// The client does not send packages until the server has answered its hello
+	BOOST_REQUIRE(waitFor([&] () { return client->canSend(token); }));
+	BOOST_CHECK(server->canSend(token));
+	{
+		std::lock_guard<std::mutex> lock(receivedLock);
+		BOOST_CHECK(serverReceived.empty());
+		BOOST_CHECK(clientReceived.empty());
+	}
+
+	client->setLossFunction(dropEvery(3));
+	for (uint32_t sequence = 1; sequence <= 300; ++sequence)
+	{
+		BOOST_CHECK(client->send(token, sequence, 1, "Data"));
+	}
+	BOOST_CHECK(!client->send(token, 301, 1, std::string(UnreliableChannel::maxPackageSize + 1, 'x')));
+
+	BOOST_REQUIRE(waitFor([&] () -> bool
+	{
+		std::lock_guard<std::mutex> lock(receivedLock);
+		return serverReceived.size() >= 200;
+	}));
+	{
+		std::lock_guard<std::mutex> lock(receivedLock);
+		BOOST_CHECK_EQUAL(serverReceived.size(), 200);
+		for (uint32_t sequence : serverReceived)
+		{
+			BOOST_CHECK_NE(sequence % 3, 0);
+		}
+	}
+
+	// Another endpoint that knows the token can not take the peer over
+	boost::asio::ip::udp::socket intruder(runner.m_IO_Service, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0));
+	char hijack[10] = {};
+	const uint32_t hijackSequence = 5000;
+	const uint16_t hijackID = 1;
+	std::memcpy(hijack, &token, sizeof(token));
+	std::memcpy(hijack + 4, &hijackSequence, sizeof(hijackSequence));
+	std::memcpy(hijack + 8, &hijackID, sizeof(hijackID));
+	intruder.send_to(boost::asio::buffer(hijack), boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), testPort));
+	boost::this_thread::sleep_for(boost::chrono::milliseconds(20));
+
+	client->setLossFunction(UnreliableChannel::lossFunction_t());
+	BOOST_CHECK(client->send(token, 1000, 1, "Data"));
+	BOOST_REQUIRE(waitFor([&] () -> bool
+	{
+		std::lock_guard<std::mutex> lock(receivedLock);
+		return serverReceived.back() == 1000;
+	}));
+	{
+		std::lock_guard<std::mutex> lock(receivedLock);
+		BOOST_CHECK(std::find(serverReceived.begin(), serverReceived.end(), hijackSequence) == serverReceived.end());
+	}
+
+	BOOST_CHECK(server->send(token, 1, 1, "Data"));
+	BOOST_CHECK(waitFor([&] () -> bool
+	{
+		std::lock_guard<std::mutex> lock(receivedLock);
+		return clientReceived.size() == 1;
+	}));
+
+	server->removePeer(token);
+	client->removePeer(token);
+	server->close();
+	client->close();
+}
+
+/**
+ * A connection delivering written packages to another stub.
+ */
+class PairedConnectionStub : public IConnection
+{
+public:
+	PairedConnectionStub* m_Peer;
+	IConnection::saveDataFunction m_SaveData;
+	std::string m_TokenData;
+
+	PairedConnectionStub() : m_Peer(nullptr) {}
+
+	bool isConnected() const override { return true; }
+	void disconnect() override {};
+	bool hasError() const override { return false; }
+	void writeData(const std::string& p_Buffer, uint16_t p_ID) override
+	{
+		if (p_ID == (uint16_t)PackageType::UNRELIABLE_CHANNEL)
+		{
+			m_TokenData = p_Buffer;
+		}
+		if (m_Peer->m_SaveData)
+		{
+			std::vector<char> data(p_Buffer.begin(), p_Buffer.end());
+			m_Peer->m_SaveData(p_ID, data);
+		}
+	}
+	void writeSharedData(std::shared_ptr<const std::string> p_Buffer, uint16_t p_ID) override
+	{
+		writeData(*p_Buffer, p_ID);
+	}
+	void setSaveData(saveDataFunction p_SaveData) override
+	{
+		m_SaveData = p_SaveData;
+	}
+	void setDisconnectedCallback(disconnectedCallback_t p_DisconnectedCallback) override {}
+	void startReading() override {}
+	void pauseReading() override {}
+	void resumeReading() override {}
+	void post(std::function<void()> p_Handler) override { p_Handler(); }
+	void setWriteBatching(size_t p_MaxBytes, unsigned int p_MaxDelayMs) override {}
+};
+
+BOOST_AUTO_TEST_CASE(TestNewestStateWins)
+{
+	IO_Runner runner;
+
+	UnreliableChannel::ptr serverChannel(new UnreliableChannel(runner.m_IO_Service, testPort));
+	UnreliableChannel::ptr clientChannel(new UnreliableChannel(runner.m_IO_Service,
+		boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), testPort)));
+	serverChannel->startReceiving();
+	clientChannel->startReceiving();
+
+	std::vector<PackageBase::ptr> prototypes;
+	prototypes.push_back(PackageBase::ptr(new PlayerControl));
+	prototypes.push_back(PackageBase::ptr(new UpdateObjects));
+
+	std::shared_ptr<PairedConnectionStub> serverConn(new PairedConnectionStub);
+	std::shared_ptr<PairedConnectionStub> clientConn(new PairedConnectionStub);
+	serverConn->m_Peer = clientConn.get();
+	clientConn->m_Peer = serverConn.get();
+
+	{
+		ConnectionController server(serverConn, prototypes);
+		ConnectionController client(clientConn, prototypes);
+
+		client.acceptUnreliableChannel(clientChannel);
+		server.offerUnreliableChannel(serverChannel);
+
+		BOOST_REQUIRE(waitFor([&] () { return client.hasUnreliableChannel(); }));
+		BOOST_CHECK(server.hasUnreliableChannel());
+
+		// Every other player control is lost on the way
+		clientChannel->setLossFunction(dropEvery(2));
+		PlayerControlData data = {};
+		for (unsigned int i = 1; i <= 100; ++i)
+		{
+			data.m_Position.x = (float)i;
+			client.sendPlayerControl(data);
+		}
+
+		BOOST_REQUIRE(waitFor([&] () { return server.getNumPackages() == 50; }));
+		for (unsigned int i = 0; i < 50; ++i)
+		{
+			BOOST_REQUIRE_EQUAL((uint16_t)server.getPackageType(server.getPackage(i)), (uint16_t)PackageType::PLAYER_CONTROL);
+			BOOST_CHECK_EQUAL(server.getPlayerControlData(server.getPackage(i)).m_Position.x, (float)(i * 2 + 1));
+		}
+		server.clearPackages(50);
+
+		// A datagram older than one already received is dropped
+		clientChannel->setLossFunction(UnreliableChannel::lossFunction_t());
+		UnreliableChannelToken token;
+		std::vector<char> tokenData(serverConn->m_TokenData.begin(), serverConn->m_TokenData.end());
+		token.readPackage(tokenData);
+
+		PlayerControl stale;
+		stale.m_Object1 = data;
+		stale.m_Object1.m_Position.x = -1.f;
+		stale.m_Object2 = 0;
+		clientChannel->send(token.m_Object1, 1, (uint16_t)PackageType::PLAYER_CONTROL, stale.getData());
+		client.sendPlayerControl(data);
+
+		BOOST_REQUIRE(waitFor([&] () { return server.getNumPackages() == 1; }));
+		BOOST_CHECK_EQUAL(server.getPlayerControlData(server.getPackage(0)).m_Position.x, 100.f);
+		server.clearPackages(1);
+
+		// Updates are sent in full until the client acknowledges one in its player control
+		UpdateObjectData update = {};
+		update.m_Id = 7;
+		update.m_Position = Vector3(1.f, 2.f, 3.f);
+		const char* extraData = "Look";
+		IConnectionController* connections[] = { &server };
+		auto receiveUpdate = [&] ()
+		{
+			BOOST_REQUIRE(waitFor([&] () { return client.getNumPackages() == 1; }));
+			const Package package = client.getPackage(0);
+			BOOST_REQUIRE_EQUAL((uint16_t)client.getPackageType(package), (uint16_t)PackageType::UPDATE_OBJECTS);
+			BOOST_REQUIRE_EQUAL(client.getNumUpdateObjectData(package), 1);
+			BOOST_CHECK_EQUAL(client.getUpdateObjectData(package)[0].m_Id, 7);
+			BOOST_CHECK_EQUAL(client.getUpdateObjectData(package)[0].m_Position, update.m_Position);
+			BOOST_REQUIRE_EQUAL(client.getNumUpdateObjectExtraData(package), 1);
+			BOOST_CHECK_EQUAL(client.getUpdateObjectExtraData(package, 0), "Look");
+			client.clearPackages(1);
+		};
+
+		IConnectionController::broadcastUpdateObjects(connections, 1, &update, 1, &extraData, 1);
+		receiveUpdate();
+		BOOST_CHECK(!server.getAcknowledgedUpdates());
+
+		client.sendPlayerControl(data);
+		BOOST_REQUIRE(waitFor([&] () { return server.getNumPackages() == 1; }));
+		server.clearPackages(1);
+		const SnapshotBaseline::ptr acknowledged = server.getAcknowledgedUpdates();
+		BOOST_REQUIRE(acknowledged);
+
+		// Later updates are encoded against the acknowledged one, so losing one does not keep the next from being decoded
+		serverChannel->setLossFunction([] () { return true; });
+		update.m_Position.x = 5.f;
+		IConnectionController::broadcastUpdateObjects(connections, 1, &update, 1, &extraData, 1);
+		serverChannel->setLossFunction(UnreliableChannel::lossFunction_t());
+
+		update.m_Position.x = 6.f;
+		IConnectionController::broadcastUpdateObjects(connections, 1, &update, 1, &extraData, 1);
+		receiveUpdate();
+		BOOST_CHECK_EQUAL(server.getAcknowledgedUpdates(), acknowledged);
+	}
+
+	serverChannel->close();
+	clientChannel->close();
+}
+
+BOOST_AUTO_TEST_CASE(TestReliableUntilServerAnswers)
+{
+	IO_Runner runner;
+
+	UnreliableChannel::ptr serverChannel(new UnreliableChannel(runner.m_IO_Service, testPort));
+	UnreliableChannel::ptr clientChannel(new UnreliableChannel(runner.m_IO_Service,
+		boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), testPort)));
+	serverChannel->startReceiving();
+	clientChannel->startReceiving();
+
+	// Every datagram is lost, as if a firewall was in the way
+	serverChannel->setLossFunction([] () { return true; });
+	clientChannel->setLossFunction([] () { return true; });
+
+	std::vector<PackageBase::ptr> prototypes;
+	prototypes.push_back(PackageBase::ptr(new PlayerControl));
+
+	std::shared_ptr<PairedConnectionStub> serverConn(new PairedConnectionStub);
+	std::shared_ptr<PairedConnectionStub> clientConn(new PairedConnectionStub);
+	serverConn->m_Peer = clientConn.get();
+	clientConn->m_Peer = serverConn.get();
+
+	{
+		ConnectionController server(serverConn, prototypes);
+		ConnectionController client(clientConn, prototypes);
+
+		client.acceptUnreliableChannel(clientChannel);
+		server.offerUnreliableChannel(serverChannel);
+
+		// Give the client time to say hello a few times
+		boost::this_thread::sleep_for(boost::chrono::milliseconds(3 * UnreliableChannel::helloIntervalMs));
+		BOOST_CHECK(!client.hasUnreliableChannel());
+		BOOST_CHECK(!server.hasUnreliableChannel());
+
+		PlayerControlData data = {};
+		data.m_Position.x = 42.f;
+		client.sendPlayerControl(data);
+
+		BOOST_REQUIRE_EQUAL(server.getNumPackages(), 1);
+		BOOST_REQUIRE_EQUAL((uint16_t)server.getPackageType(server.getPackage(0)), (uint16_t)PackageType::PLAYER_CONTROL);
+		BOOST_CHECK_EQUAL(server.getPlayerControlData(server.getPackage(0)).m_Position.x, 42.f);
+		server.clearPackages(1);
+	}
+
+	serverChannel->close();
+	clientChannel->close();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
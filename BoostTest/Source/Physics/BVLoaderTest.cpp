@@ -1,6 +1,9 @@
 #include <boost\test\unit_test.hpp>
 #include "..\..\Physics\Source\BVLoader.h"
 #include "..\..\Physics\include\BoundingVolume.h"
+#include "..\..\BinaryConverter\Source\CollisionConverter.h"
+
+#include <cstdio>
 
 class DummyBoundingVolume : public BoundingVolume
 {
@@ -93,4 +96,58 @@ BOOST_AUTO_TEST_CASE(testLoad)
 	BOOST_CHECK_EQUAL(header.m_numFaces, 0);
 }
 
+BOOST_AUTO_TEST_CASE(testLoadBinaryCollisionMesh)
+{
+	std::vector<BVLoader::BoundingVolume> corners;
+	for(int i = 0; i < 30; i++)
+	{
+		BVLoader::BoundingVolume corner;
+		corner.m_Postition = DirectX::XMFLOAT4((float)(i / 3) * 2.f + (i % 3 == 1 ? 1.f : 0.f), i % 3 == 2 ? 1.f : 0.f, 0.f, 1.f);
+		corners.push_back(corner);
+	}
+
+	CollisionConverter converter;
+	converter.setMeshName("CB_Test");
+	converter.setCorners(&corners);
+	BOOST_REQUIRE(converter.writeFile("testCollision.btxc"));
+
+	BVLoader bv;
+	BOOST_REQUIRE(bv.loadBinaryFile("testCollision.btxc"));
+
+	BVLoader::Header header = bv.getLevelHeader();
+	BOOST_CHECK_EQUAL(header.m_modelName, "CB_Test");
+	BOOST_CHECK_EQUAL(header.m_numFaces, 10);
+
+	BOOST_REQUIRE_EQUAL(bv.getNumCorners(), 30);
+	for(unsigned int i = 0; i < 30; i++)
+	{
+		BOOST_CHECK_EQUAL(bv.getCorners()[i].m_Postition.x, corners[i].m_Postition.x);
+		BOOST_CHECK_EQUAL(bv.getCorners()[i].m_Postition.y, corners[i].m_Postition.y);
+	}
+
+	BOOST_CHECK_GT(bv.getNumBVHNodes(), 1);
+	BOOST_CHECK_EQUAL(bv.getNumBVHTriangleIndices(), 10);
+	BOOST_CHECK_EQUAL(bv.getBoundingVolumes().size(), 30);
+
+	bv.clear();
+	BOOST_CHECK_EQUAL(bv.getNumCorners(), 0);
+	BOOST_CHECK_EQUAL(bv.getNumBVHNodes(), 0);
+
+	std::remove("testCollision.btxc");
+}
+
+BOOST_AUTO_TEST_CASE(testRejectBrokenBinaryCollisionMesh)
+{
+	{
+		std::ofstream output("testBroken.btxc", std::ostream::out | std::ostream::binary);
+		output << "BTXC but not a real header";
+	}
+
+	BVLoader bv;
+	BOOST_CHECK(!bv.loadBinaryFile("testBroken.btxc"));
+	BOOST_CHECK_EQUAL(bv.getNumCorners(), 0);
+
+	std::remove("testBroken.btxc");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
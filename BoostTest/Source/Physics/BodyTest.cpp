@@ -139,6 +139,30 @@ BOOST_AUTO_TEST_CASE(BodyTest_Update)
 	BOOST_CHECK_EQUAL(m_LastAcceleration.z, 0.f);
 }
 
+BOOST_AUTO_TEST_CASE(BodyTest_UpdateMovesVolumes)
+{
+	Body body = Body(1.f, BoundingVolume::ptr(new Sphere(1.f, DirectX::XMFLOAT4(1.f, 2.f, 3.f, 1.f))), false, false);
+	body.setVelocity(DirectX::XMFLOAT4(60.f, 0.f, -120.f, 0.f));
+
+	body.update(1.f / 60.f);
+
+	DirectX::XMFLOAT4 bodyPos = body.getPosition();
+	BOOST_CHECK_CLOSE_FRACTION(bodyPos.x, 2.f, 0.0001f);
+	BOOST_CHECK_CLOSE_FRACTION(bodyPos.y, 2.f, 0.0001f);
+	BOOST_CHECK_CLOSE_FRACTION(bodyPos.z, 1.f, 0.0001f);
+	BOOST_CHECK_EQUAL(bodyPos.w, 1.f);
+
+	DirectX::XMFLOAT4 volumePos = body.getVolume()->getPosition();
+	BOOST_CHECK_CLOSE_FRACTION(volumePos.x, bodyPos.x, 0.0001f);
+	BOOST_CHECK_CLOSE_FRACTION(volumePos.y, bodyPos.y, 0.0001f);
+	BOOST_CHECK_CLOSE_FRACTION(volumePos.z, bodyPos.z, 0.0001f);
+	BOOST_CHECK_EQUAL(volumePos.w, 1.f);
+
+	DirectX::XMFLOAT4 spherePos = body.getSurroundingSphere()->getPosition();
+	BOOST_CHECK_CLOSE_FRACTION(spherePos.x, bodyPos.x, 0.0001f);
+	BOOST_CHECK_CLOSE_FRACTION(spherePos.z, bodyPos.z, 0.0001f);
+}
+
 BOOST_AUTO_TEST_CASE(BodyTest_Impulse)
 {
 	Body body = Body(1.f, nullptr, false, false);
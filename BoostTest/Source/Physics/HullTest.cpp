@@ -84,4 +84,37 @@ BOOST_AUTO_TEST_CASE(setPosition)
 
 
 
+BOOST_AUTO_TEST_CASE(SharedShapeHullTest)
+{
+	std::vector<Triangle> triangles;
+	triangles.push_back(Triangle(Vector4(1.f, 0.f, 0.f, 1.f), Vector4(2.f, 0.f, 0.f, 1.f), Vector4(1.f, 1.f, 0.f, 1.f)));
+
+	HullShape::ptr shape = HullShape::create(triangles);
+	Hull first(shape);
+	Hull second(shape);
+
+	BOOST_CHECK(first.getShape() == second.getShape());
+	BOOST_CHECK_EQUAL(shape.use_count(), 3);
+
+	first.setRotation(DirectX::XMMatrixRotationZ(DirectX::XM_PIDIV2));
+	first.scale(DirectX::XMVectorSet(2.f, 2.f, 2.f, 0.f));
+	first.setPosition(DirectX::XMVectorSet(0.f, 10.f, 0.f, 1.f));
+
+	Triangle rotated = first.getTriangleInWorldCoord(0);
+	BOOST_CHECK_SMALL(rotated.corners[0].x, 0.0001f);
+	BOOST_CHECK_CLOSE(rotated.corners[0].y, 12.f, 0.001f);
+	BOOST_CHECK_CLOSE(rotated.corners[1].y, 14.f, 0.001f);
+	BOOST_CHECK_CLOSE(first.getSphere().getRadius(), 4.f, 0.001f);
+
+	Triangle untouched = second.getTriangleInWorldCoord(0);
+	BOOST_CHECK_EQUAL(untouched.corners[0].x, 1.f);
+	BOOST_CHECK_EQUAL(untouched.corners[0].y, 0.f);
+	BOOST_CHECK_EQUAL(second.getTriangleAt(0).corners[1].x, 2.f);
+
+	std::vector<unsigned int> found;
+	first.findTrianglesInBox(DirectX::XMVectorSet(-0.5f, 12.5f, -0.5f, 1.f), DirectX::XMVectorSet(0.5f, 13.5f, 0.5f, 1.f),
+		[&found] (unsigned int p_Triangle) { found.push_back(p_Triangle); });
+	BOOST_CHECK_EQUAL(found.size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include <boost\test\unit_test.hpp>
+#include "..\..\Physics\Source\BodyStorage.h"
+#include "..\..\Physics\include\Sphere.h"
+
+using namespace DirectX;
+
+static Body createSphereBody(bool p_IsImmovable, float p_X)
+{
+	return Body(1.f, BoundingVolume::ptr(new Sphere(1.f, XMFLOAT4(p_X, 0.f, 0.f, 1.f))), p_IsImmovable, false);
+}
+
+BOOST_AUTO_TEST_SUITE(TestBodyStorage)
+
+BOOST_AUTO_TEST_CASE(TestBodyStorageAddFind)
+{
+	BodyStorage storage;
+
+	BodyStorage::BodyHandle first = storage.add(createSphereBody(true, 1.f));
+	BodyStorage::BodyHandle second = storage.add(createSphereBody(false, 2.f));
+	BodyStorage::BodyHandle third = storage.add(createSphereBody(true, 3.f));
+
+	BOOST_CHECK_EQUAL(first, 1);
+	BOOST_CHECK_EQUAL(second, 2);
+	BOOST_CHECK_EQUAL(third, 3);
+	BOOST_CHECK_EQUAL(storage.size(), 3);
+	BOOST_CHECK_EQUAL(storage.getMovableCount(), 1);
+
+	BOOST_REQUIRE(storage.find(second) != nullptr);
+	BOOST_CHECK_EQUAL(storage.find(second)->getHandle(), second);
+	BOOST_CHECK_EQUAL(storage.find(second)->getVolume()->getBodyHandle(), second);
+	BOOST_CHECK_EQUAL(storage.find(third)->getPosition().x, 3.f);
+	BOOST_CHECK_EQUAL(storage[0].getHandle(), second);
+
+	BOOST_CHECK(storage.find(0) == nullptr);
+	BOOST_CHECK(storage.find(4) == nullptr);
+	BOOST_CHECK(storage.find((BodyStorage::BodyHandle)-1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(TestBodyStorageRemove)
+{
+	BodyStorage storage;
+
+	BodyStorage::BodyHandle movable1 = storage.add(createSphereBody(false, 1.f));
+	BodyStorage::BodyHandle immovable = storage.add(createSphereBody(true, 2.f));
+	BodyStorage::BodyHandle movable2 = storage.add(createSphereBody(false, 3.f));
+
+	BOOST_CHECK(storage.remove(movable1));
+	BOOST_CHECK(!storage.remove(movable1));
+	BOOST_CHECK(storage.find(movable1) == nullptr);
+
+	BOOST_CHECK_EQUAL(storage.size(), 2);
+	BOOST_REQUIRE_EQUAL(storage.getMovableCount(), 1);
+	BOOST_CHECK_EQUAL(storage[0].getHandle(), movable2);
+	BOOST_CHECK_EQUAL(storage[1].getHandle(), immovable);
+	BOOST_CHECK_EQUAL(storage.find(immovable)->getPosition().x, 2.f);
+	BOOST_CHECK_EQUAL(storage.find(movable2)->getPosition().x, 3.f);
+
+	BodyStorage::BodyHandle reused = storage.add(createSphereBody(true, 4.f));
+	BOOST_CHECK_NE(reused, movable1);
+	BOOST_CHECK(storage.find(movable1) == nullptr);
+	BOOST_CHECK_EQUAL(storage.find(reused)->getPosition().x, 4.f);
+}
+
+BOOST_AUTO_TEST_CASE(TestBodyStorageClear)
+{
+	BodyStorage storage;
+
+	BodyStorage::BodyHandle oldBody = storage.add(createSphereBody(false, 1.f));
+	storage.clear();
+
+	BOOST_CHECK_EQUAL(storage.size(), 0);
+	BOOST_CHECK_EQUAL(storage.getMovableCount(), 0);
+	BOOST_CHECK(storage.find(oldBody) == nullptr);
+
+	BodyStorage::BodyHandle newBody = storage.add(createSphereBody(false, 2.f));
+	BOOST_CHECK_NE(newBody, oldBody);
+	BOOST_CHECK(storage.find(oldBody) == nullptr);
+	BOOST_CHECK_EQUAL(storage.find(newBody)->getPosition().x, 2.f);
+}
+
+BOOST_AUTO_TEST_CASE(TestBodyStorageBatchedIntegration)
+{
+	BodyStorage storage;
+	std::vector<BodyStorage::BodyHandle> handles;
+
+	// More bodies than one batch, with a sleeping and a massless body among them
+	for (unsigned int i = 0; i < 11; ++i)
+	{
+		Body body(i == 4 ? 0.f : 1.f + i, BoundingVolume::ptr(new Sphere(1.f, XMFLOAT4((float)i, 0.f, 0.f, 1.f))), false, false);
+		body.setGravity(9.82f);
+		body.addForce(XMFLOAT4((float)i, 2.f, -1.f, 0.f));
+		if (i == 2)
+			body.sleep();
+		handles.push_back(storage.add(std::move(body)));
+	}
+
+	Body single(1.f + 7.f, BoundingVolume::ptr(new Sphere(1.f, XMFLOAT4(7.f, 0.f, 0.f, 1.f))), false, false);
+	single.setGravity(9.82f);
+	single.addForce(XMFLOAT4(7.f, 2.f, -1.f, 0.f));
+
+	// Ranges not aligned to the batch width, as when split between threads
+	for (unsigned int step = 0; step < 3; ++step)
+	{
+		storage.integrate(0, 3, 0.02f);
+		storage.integrate(3, storage.getMovableCount(), 0.02f);
+		for (size_t i = 0; i < storage.getMovableCount(); ++i)
+		{
+			if (!storage[i].getIsSleeping())
+				storage[i].applyIntegratedMotion();
+		}
+		single.update(0.02f);
+	}
+
+	Body& batched = *storage.find(handles[7]);
+	BOOST_CHECK_EQUAL(batched.getPosition().x, single.getPosition().x);
+	BOOST_CHECK_EQUAL(batched.getPosition().y, single.getPosition().y);
+	BOOST_CHECK_EQUAL(batched.getPosition().z, single.getPosition().z);
+	BOOST_CHECK_EQUAL(batched.getVelocity().y, single.getVelocity().y);
+	BOOST_CHECK_EQUAL(batched.getACC().x, single.getACC().x);
+	BOOST_CHECK_EQUAL(batched.getVolume()->getPosition().y, single.getVolume()->getPosition().y);
+
+	Body& sleeping = *storage.find(handles[2]);
+	BOOST_CHECK_EQUAL(sleeping.getPosition().x, 2.f);
+	BOOST_CHECK_EQUAL(sleeping.getPosition().y, 0.f);
+
+	Body& massless = *storage.find(handles[4]);
+	BOOST_CHECK_EQUAL(massless.getPosition().y, 0.f);
+	BOOST_CHECK_EQUAL(massless.getACC().y, 0.f);
+
+	// The motion follows the bodies when the dense array is reordered
+	storage.remove(handles[0]);
+	BOOST_CHECK_EQUAL(storage.find(handles[7])->getPosition().y, single.getPosition().y);
+	BOOST_CHECK(storage.find(handles[2])->getIsSleeping());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
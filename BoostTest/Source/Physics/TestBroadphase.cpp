@@ -0,0 +1,110 @@
+#include <boost\test\unit_test.hpp>
+#include "..\..\Physics\Source\Broadphase.h"
+#include "..\..\Physics\include\Sphere.h"
+
+#include <iterator>
+#include <set>
+
+using namespace DirectX;
+
+BOOST_AUTO_TEST_SUITE(TestBroadphase)
+
+BOOST_AUTO_TEST_CASE(TestBroadphaseAddRemove)
+{
+	Broadphase broadphase;
+
+	BOOST_CHECK_EQUAL(broadphase.getBodyCount(), 0);
+
+	Sphere sphere(1.f, XMFLOAT4(0.f, 0.f, 0.f, 1.f));
+	Sphere sphere2(1.f, XMFLOAT4(5.f, 0.f, 0.f, 1.f));
+
+	broadphase.addBody(1, &sphere);
+	broadphase.addBody(2, &sphere2);
+	BOOST_CHECK_EQUAL(broadphase.getBodyCount(), 2);
+
+	broadphase.removeBody(1);
+	BOOST_CHECK_EQUAL(broadphase.getBodyCount(), 1);
+
+	broadphase.removeBody(1);
+	BOOST_CHECK_EQUAL(broadphase.getBodyCount(), 1);
+
+	broadphase.reset();
+	BOOST_CHECK_EQUAL(broadphase.getBodyCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestBroadphaseUniquePairs)
+{
+	Broadphase broadphase;
+
+	Sphere sphere(1.f, XMFLOAT4(0.f, 0.f, 0.f, 1.f));
+	Sphere sphere2(1.f, XMFLOAT4(1.5f, 0.f, 0.f, 1.f));
+	Sphere sphere3(1.f, XMFLOAT4(1.5f, 5.f, 0.f, 1.f));
+	Sphere sphere4(1.f, XMFLOAT4(20.f, 0.f, 0.f, 1.f));
+
+	broadphase.addBody(4, &sphere);
+	broadphase.addBody(2, &sphere2);
+	broadphase.addBody(3, &sphere3);
+	broadphase.addBody(1, &sphere4);
+
+	std::vector<Broadphase::Pair> pairs;
+	broadphase.update();
+	broadphase.findPairs(pairs);
+
+	BOOST_REQUIRE_EQUAL(pairs.size(), 1);
+	BOOST_CHECK_EQUAL(pairs[0].first, 2);
+	BOOST_CHECK_EQUAL(pairs[0].second, 4);
+}
+
+BOOST_AUTO_TEST_CASE(TestBroadphaseUpdateMovedBodies)
+{
+	Broadphase broadphase;
+
+	Sphere sphere(1.f, XMFLOAT4(0.f, 0.f, 0.f, 1.f));
+	Sphere sphere2(1.f, XMFLOAT4(10.f, 0.f, 0.f, 1.f));
+	Sphere sphere3(1.f, XMFLOAT4(20.f, 0.f, 0.f, 1.f));
+
+	broadphase.addBody(1, &sphere);
+	broadphase.addBody(2, &sphere2);
+	broadphase.addBody(3, &sphere3);
+
+	std::vector<Broadphase::Pair> pairs;
+	broadphase.update();
+	broadphase.findPairs(pairs);
+	BOOST_CHECK(pairs.empty());
+
+	sphere.setPosition(XMVectorSet(19.f, 0.f, 0.f, 1.f));
+	sphere3.setPosition(XMVectorSet(-5.f, 0.f, 0.f, 1.f));
+
+	broadphase.update();
+	broadphase.findPairs(pairs);
+	BOOST_CHECK(pairs.empty());
+
+	sphere2.setPosition(XMVectorSet(18.f, 0.f, 0.f, 1.f));
+
+	broadphase.update();
+	broadphase.findPairs(pairs);
+	BOOST_REQUIRE_EQUAL(pairs.size(), 1);
+	BOOST_CHECK_EQUAL(pairs[0].first, 1);
+	BOOST_CHECK_EQUAL(pairs[0].second, 2);
+}
+
+BOOST_AUTO_TEST_CASE(TestBroadphaseFind)
+{
+	Broadphase broadphase;
+
+	Sphere sphere(1.f, XMFLOAT4(0.f, 0.f, 0.f, 1.f));
+	Sphere sphere2(1.f, XMFLOAT4(10.f, 0.f, 0.f, 1.f));
+
+	broadphase.addBody(1, &sphere);
+	broadphase.addBody(2, &sphere2);
+	broadphase.update();
+
+	Sphere query(2.f, XMFLOAT4(11.f, 1.f, 0.f, 1.f));
+	std::set<Broadphase::BodyHandle> potentialColliders;
+	broadphase.findPotentialIntersections(&query, std::inserter(potentialColliders, potentialColliders.end()));
+
+	BOOST_CHECK_EQUAL(potentialColliders.size(), 1);
+	BOOST_CHECK(potentialColliders.find(2) != potentialColliders.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
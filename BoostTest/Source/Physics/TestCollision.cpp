@@ -575,6 +575,128 @@ BOOST_AUTO_TEST_CASE(HullvsOBB)
 		
 }
 
+BOOST_AUTO_TEST_CASE(SeparatingAxisCacheBoxVsBox)
+{
+	OBB obb1 = OBB(DirectX::XMFLOAT4(0.f, 0.f, 0.f, 1.f), DirectX::XMFLOAT4(1.f, 1.f, 1.f, 0.f));
+	OBB obb2 = OBB(DirectX::XMFLOAT4(2.5f, 0.f, 0.f, 1.f), DirectX::XMFLOAT4(1.f, 1.f, 1.f, 0.f));
+	SeparatingAxisCache cache;
+
+	HitData hd = Collision::boundingVolumeVsBoundingVolume(obb1, obb2, &cache);
+	BOOST_CHECK(!hd.intersect);
+	BOOST_CHECK_NE(cache.boxAxis, SeparatingAxisCache::noAxis);
+
+	const unsigned int exits = Collision::getCachedAxisExitCount();
+	hd = Collision::boundingVolumeVsBoundingVolume(obb1, obb2, &cache);
+	BOOST_CHECK(!hd.intersect);
+	BOOST_CHECK_EQUAL(Collision::getCachedAxisExitCount(), exits + 1);
+
+	// A cached axis that no longer separates the boxes gives the same hit as no cache
+	obb2.setPosition(DirectX::XMVectorSet(1.5f, 0.2f, 0.f, 1.f));
+	HitData uncached = Collision::boundingVolumeVsBoundingVolume(obb1, obb2);
+	hd = Collision::boundingVolumeVsBoundingVolume(obb1, obb2, &cache);
+	BOOST_CHECK(hd.intersect);
+	BOOST_CHECK_EQUAL(Collision::getCachedAxisExitCount(), exits + 1);
+	BOOST_CHECK_EQUAL(hd.colLength, uncached.colLength);
+	BOOST_CHECK_EQUAL(hd.colNorm.x, uncached.colNorm.x);
+	BOOST_CHECK_EQUAL(hd.colNorm.y, uncached.colNorm.y);
+	BOOST_CHECK_EQUAL(hd.colNorm.z, uncached.colNorm.z);
+}
+
+BOOST_AUTO_TEST_CASE(SeparatingAxisCacheBoxVsHull)
+{
+	std::vector<Triangle> triangles;
+	triangles.push_back(Triangle(Vector4(-1.f, -1.f, -1.f, 1.f), Vector4(-1.f, 1.f, -1.f, 1.f), Vector4(1.f, 1.f, -1.f, 1.f)));
+	triangles.push_back(Triangle(Vector4(-1.f, -1.f, -1.f, 1.f), Vector4(1.f, 1.f, -1.f, 1.f), Vector4(1.f, -1.f, -1.f, 1.f)));
+	Hull h = Hull(triangles);
+
+	// Turned so that its bounds overlap a corner of the hull while the box itself does not
+	OBB obb = OBB(DirectX::XMFLOAT4(2.2f, 2.2f, -1.f, 1.f), DirectX::XMFLOAT4(1.f, 1.f, 1.f, 0.f));
+	obb.setRotation(DirectX::XMMatrixRotationZ(DirectX::XM_PIDIV4));
+	SeparatingAxisCache cache;
+
+	HitData hd = Collision::boundingVolumeVsBoundingVolume(obb, h, &cache);
+	BOOST_CHECK(!hd.intersect);
+	BOOST_CHECK_EQUAL(cache.triangleAxes.size(), 2);
+
+	const unsigned int exits = Collision::getCachedAxisExitCount();
+	hd = Collision::boundingVolumeVsBoundingVolume(obb, h, &cache);
+	BOOST_CHECK(!hd.intersect);
+	BOOST_CHECK_EQUAL(Collision::getCachedAxisExitCount(), exits + 2);
+
+	obb.setPosition(DirectX::XMVectorSet(0.f, 0.f, -1.5f, 1.f));
+	HitData uncached = Collision::boundingVolumeVsBoundingVolume(obb, h);
+	hd = Collision::boundingVolumeVsBoundingVolume(obb, h, &cache);
+	BOOST_CHECK(hd.intersect);
+	BOOST_CHECK_EQUAL(hd.colLength, uncached.colLength);
+	BOOST_CHECK(cache.triangleAxes.empty());
+}
+
+BOOST_AUTO_TEST_CASE(SweptSphereVsSphere)
+{
+	Sphere moving = Sphere(1.f, DirectX::XMFLOAT4(-10.f, 0.f, 0.f, 1.f));
+	Sphere target = Sphere(1.f, DirectX::XMFLOAT4(0.f, 0.f, 0.f, 1.f));
+	DirectX::XMFLOAT4 normal;
+
+	float t = Collision::sweptSphereVsBoundingVolume(moving, DirectX::XMFLOAT4(20.f, 0.f, 0.f, 0.f), target, normal);
+	BOOST_CHECK_CLOSE_FRACTION(t, 0.4f, 0.001f);
+	BOOST_CHECK_CLOSE_FRACTION(normal.x, -1.f, 0.001f);
+	BOOST_CHECK_SMALL(normal.y, 0.001f);
+
+	t = Collision::sweptSphereVsBoundingVolume(moving, DirectX::XMFLOAT4(0.f, 20.f, 0.f, 0.f), target, normal);
+	BOOST_CHECK_LT(t, 0.f);
+
+	t = Collision::sweptSphereVsBoundingVolume(moving, DirectX::XMFLOAT4(5.f, 0.f, 0.f, 0.f), target, normal);
+	BOOST_CHECK_LT(t, 0.f);
+}
+
+BOOST_AUTO_TEST_CASE(SweptSphereVsBox)
+{
+	Sphere moving = Sphere(0.5f, DirectX::XMFLOAT4(0.f, 0.f, -10.f, 1.f));
+	OBB wall = OBB(DirectX::XMFLOAT4(0.f, 0.f, 0.f, 1.f), DirectX::XMFLOAT4(5.f, 5.f, 0.05f, 0.f));
+	AABB aabb = AABB(DirectX::XMFLOAT4(0.f, 0.f, 0.f, 1.f), DirectX::XMFLOAT4(5.f, 5.f, 0.05f, 0.f));
+	DirectX::XMFLOAT4 normal;
+
+	float t = Collision::sweptSphereVsBoundingVolume(moving, DirectX::XMFLOAT4(0.f, 0.f, 20.f, 0.f), wall, normal);
+	BOOST_CHECK_CLOSE_FRACTION(t, 9.45f / 20.f, 0.001f);
+	BOOST_CHECK_CLOSE_FRACTION(normal.z, -1.f, 0.001f);
+
+	t = Collision::sweptSphereVsBoundingVolume(moving, DirectX::XMFLOAT4(0.f, 0.f, 20.f, 0.f), aabb, normal);
+	BOOST_CHECK_CLOSE_FRACTION(t, 9.45f / 20.f, 0.001f);
+	BOOST_CHECK_CLOSE_FRACTION(normal.z, -1.f, 0.001f);
+
+	t = Collision::sweptSphereVsBoundingVolume(moving, DirectX::XMFLOAT4(10.f, 0.f, 0.f, 0.f), wall, normal);
+	BOOST_CHECK_LT(t, 0.f);
+
+	Sphere inside = Sphere(0.5f, DirectX::XMFLOAT4(0.f, 0.f, 0.f, 1.f));
+	t = Collision::sweptSphereVsBoundingVolume(inside, DirectX::XMFLOAT4(0.f, 0.f, 20.f, 0.f), wall, normal);
+	BOOST_CHECK_LT(t, 0.f);
+}
+
+BOOST_AUTO_TEST_CASE(SweptSphereVsThinHull)
+{
+	std::vector<Triangle> triangles;
+	triangles.push_back(Triangle(Vector4(-1.f, -1.f, 0.f, 1.f), Vector4(-1.f, 1.f, 0.f, 1.f), Vector4(1.f, 1.f, 0.f, 1.f)));
+	triangles.push_back(Triangle(Vector4(-1.f, -1.f, 0.f, 1.f), Vector4(1.f, 1.f, 0.f, 1.f), Vector4(1.f, -1.f, 0.f, 1.f)));
+	Hull h = Hull(triangles);
+	DirectX::XMFLOAT4 normal;
+
+	// Moves from one side of the wall to the other in a single step
+	Sphere moving = Sphere(0.1f, DirectX::XMFLOAT4(0.f, 0.f, -2.f, 1.f));
+	float t = Collision::sweptSphereVsBoundingVolume(moving, DirectX::XMFLOAT4(0.f, 0.f, 4.f, 0.f), h, normal);
+	BOOST_CHECK_CLOSE_FRACTION(t, 1.9f / 4.f, 0.001f);
+	BOOST_CHECK_CLOSE_FRACTION(normal.z, -1.f, 0.001f);
+
+	// Passes the edge of the wall
+	moving = Sphere(0.1f, DirectX::XMFLOAT4(1.05f, 0.f, -2.f, 1.f));
+	t = Collision::sweptSphereVsBoundingVolume(moving, DirectX::XMFLOAT4(0.f, 0.f, 4.f, 0.f), h, normal);
+	BOOST_CHECK_GE(t, 0.f);
+	BOOST_CHECK_LT(t, 0.5f);
+
+	moving = Sphere(0.1f, DirectX::XMFLOAT4(1.5f, 0.f, -2.f, 1.f));
+	t = Collision::sweptSphereVsBoundingVolume(moving, DirectX::XMFLOAT4(0.f, 0.f, 4.f, 0.f), h, normal);
+	BOOST_CHECK_LT(t, 0.f);
+}
+
 BOOST_AUTO_TEST_CASE(CollisionTypeNotFound)
 {
 	DummyBoundingVolume fakeVolume = DummyBoundingVolume();
@@ -0,0 +1,50 @@
+#include <boost\test\unit_test.hpp>
+#include "..\..\Physics\Source\ContactBuffer.h"
+
+BOOST_AUTO_TEST_SUITE(TestContactBuffer)
+
+BOOST_AUTO_TEST_CASE(TestContactBufferAdd)
+{
+	ContactBuffer buffer(2);
+
+	BOOST_CHECK_EQUAL(buffer.size(), 0);
+	BOOST_CHECK_EQUAL(buffer.capacity(), 2);
+	BOOST_CHECK_THROW(buffer.at(0), std::out_of_range);
+
+	HitData hit;
+	hit.collider = 1;
+	buffer.add(hit);
+	hit.collider = 2;
+	buffer.add(hit);
+	hit.collider = 3;
+	buffer.add(hit);
+
+	BOOST_CHECK_EQUAL(buffer.size(), 3);
+	BOOST_CHECK(buffer.capacity() >= 3);
+	BOOST_CHECK_EQUAL(buffer.at(0).collider, 1);
+	BOOST_CHECK_EQUAL(buffer.at(2).collider, 3);
+}
+
+BOOST_AUTO_TEST_CASE(TestContactBufferClearKeepsStorage)
+{
+	ContactBuffer buffer;
+
+	HitData hit;
+	for (unsigned int i = 0; i < 20; ++i)
+	{
+		buffer.add(hit);
+	}
+	const size_t capacity = buffer.capacity();
+
+	buffer.clear();
+	BOOST_CHECK_EQUAL(buffer.size(), 0);
+	BOOST_CHECK_EQUAL(buffer.capacity(), capacity);
+
+	for (unsigned int i = 0; i < 20; ++i)
+	{
+		buffer.add(hit);
+	}
+	BOOST_CHECK_EQUAL(buffer.capacity(), capacity);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
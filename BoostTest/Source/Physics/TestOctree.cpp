@@ -4,6 +4,7 @@
 
 #include <iterator>
 #include <set>
+#include <vector>
 
 using namespace DirectX;
 
@@ -109,4 +110,96 @@ BOOST_AUTO_TEST_CASE(TestOctreeFind)
 	BOOST_CHECK(potentialColliders.find(1) != potentialColliders.end());
 }
 
+BOOST_AUTO_TEST_CASE(TestOctreeCastRayClosestFirst)
+{
+	static const size_t fillNum = 40;
+	Octree tree;
+	Sphere spheres[fillNum];
+	for (size_t i = 0; i < fillNum; ++i)
+	{
+		spheres[i] = Sphere(1.f, XMFLOAT4((float)i * 5.f, 0.f, 0.f, 1.f));
+		tree.addBody(i + 1, &spheres[i]);
+	}
+
+	std::set<Octree::BodyHandle> visited;
+	float closest = -1.f;
+	tree.castRay(XMFLOAT4(-10.f, 0.f, 0.f, 1.f), XMFLOAT4(1.f, 0.f, 0.f, 0.f), 1000.f,
+		[&] (Octree::BodyHandle p_Body) -> float
+		{
+			visited.insert(p_Body);
+			const float distance = Collision::raySphereIntersect(spheres[p_Body - 1],
+				XMFLOAT4(1.f, 0.f, 0.f, 0.f), XMFLOAT4(-10.f, 0.f, 0.f, 1.f));
+			if (distance > 0.f && (closest < 0.f || distance < closest))
+				closest = distance;
+			return distance;
+		});
+
+	BOOST_CHECK_CLOSE(closest, 9.f, 0.001f);
+	BOOST_CHECK(visited.count(1) == 1);
+	BOOST_CHECK_LT(visited.size(), fillNum);
+
+	visited.clear();
+	tree.castRay(XMFLOAT4(-10.f, 50.f, 0.f, 1.f), XMFLOAT4(1.f, 0.f, 0.f, 0.f), 1000.f,
+		[&] (Octree::BodyHandle p_Body) -> float
+		{
+			visited.insert(p_Body);
+			return -1.f;
+		});
+	BOOST_CHECK(visited.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestOctreeBulkBuild)
+{
+	static const size_t gridSize = 10;
+	static const size_t fillNum = gridSize * gridSize * gridSize;
+	std::vector<Sphere> spheres(fillNum + 1);
+	std::vector<Octree::BodyHandle> handles(fillNum + 1);
+	std::vector<const Sphere*> spherePointers(fillNum + 1);
+	for (size_t i = 0; i < fillNum; ++i)
+	{
+		spheres[i] = Sphere(1.f, XMFLOAT4((float)(i % gridSize) * 4.f, (float)(i / gridSize % gridSize) * 4.f, (float)(i / gridSize / gridSize) * 4.f, 1.f));
+	}
+	spheres[fillNum] = Sphere(100.f, XMFLOAT4(0.f, -100.f, 0.f, 1.f));
+	for (size_t i = 0; i < spheres.size(); ++i)
+	{
+		handles[i] = i + 1;
+		spherePointers[i] = &spheres[i];
+	}
+
+	Octree tree;
+	tree.addBodies(handles.data(), spherePointers.data(), spheres.size());
+	BOOST_CHECK_EQUAL(tree.getBodyCount(), spheres.size());
+	BOOST_CHECK_EQUAL(tree.getNumUnsortedBodies(), 0);
+
+	const Sphere query(3.f, XMFLOAT4(10.f, 10.f, 10.f, 1.f));
+	std::set<Octree::BodyHandle> found;
+	tree.findPotentialIntersections(&query, std::inserter(found, found.end()));
+	for (size_t i = 0; i < spheres.size(); ++i)
+	{
+		if (Collision::surroundingSphereVsSphere(spheres[i], query))
+		{
+			BOOST_CHECK(found.count(handles[i]) == 1);
+		}
+	}
+	BOOST_CHECK_LT(found.size(), fillNum / 4);
+
+	tree.removeBody(handles[555], &spheres[555]);
+	BOOST_CHECK_EQUAL(tree.getBodyCount(), spheres.size() - 1);
+	found.clear();
+	tree.findPotentialIntersections(&spheres[555], std::inserter(found, found.end()));
+	BOOST_CHECK(found.count(handles[555]) == 0);
+
+	Sphere added(1.f, XMFLOAT4(50.f, 50.f, 50.f, 1.f));
+	tree.addBody(5000, &added);
+	BOOST_CHECK_EQUAL(tree.getNumUnsortedBodies(), 1);
+	tree.rebuild();
+	BOOST_CHECK_EQUAL(tree.getNumUnsortedBodies(), 0);
+	BOOST_CHECK_EQUAL(tree.getBodyCount(), spheres.size());
+
+	found.clear();
+	tree.findPotentialIntersections(&added, std::inserter(found, found.end()));
+	BOOST_CHECK(found.count(5000) == 1);
+	BOOST_CHECK(found.count(handles[555]) == 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
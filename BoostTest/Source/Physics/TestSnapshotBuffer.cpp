@@ -0,0 +1,44 @@
+#include <boost\test\unit_test.hpp>
+#include "..\..\Physics\Source\SnapshotBuffer.h"
+
+BOOST_AUTO_TEST_SUITE(TestSnapshotBuffer)
+
+BOOST_AUTO_TEST_CASE(TestSnapshotBufferEmpty)
+{
+	SnapshotBuffer buffer;
+	BOOST_CHECK_EQUAL(buffer.getCapacity(), 0);
+	BOOST_CHECK(buffer.find(0) == nullptr);
+	BOOST_CHECK(buffer.find(1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotBufferWrap)
+{
+	SnapshotBuffer buffer;
+	buffer.reserve(3, 10);
+	BOOST_CHECK_EQUAL(buffer.getCapacity(), 3);
+
+	unsigned int ids[4];
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		SnapshotBuffer::Snapshot& snapshot = buffer.beginSnapshot();
+		BOOST_CHECK(snapshot.bodies.empty());
+		BOOST_CHECK_GE(snapshot.bodies.capacity(), 10);
+		snapshot.leftOverTime = (float)i;
+		ids[i] = snapshot.id;
+	}
+
+	BOOST_CHECK_NE(ids[0], 0);
+	BOOST_CHECK(buffer.find(ids[0]) == nullptr);
+	for (unsigned int i = 1; i < 4; ++i)
+	{
+		const SnapshotBuffer::Snapshot* snapshot = buffer.find(ids[i]);
+		BOOST_REQUIRE(snapshot != nullptr);
+		BOOST_CHECK_EQUAL(snapshot->id, ids[i]);
+		BOOST_CHECK_EQUAL(snapshot->leftOverTime, (float)i);
+	}
+
+	buffer.reserve(3, 10);
+	BOOST_CHECK(buffer.find(ids[3]) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
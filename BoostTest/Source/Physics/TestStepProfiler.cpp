@@ -0,0 +1,60 @@
+#include <boost\test\unit_test.hpp>
+#include "..\..\Physics\Source\StepProfiler.h"
+
+static void recordStep(StepProfiler& p_Profiler, unsigned int p_NumHits)
+{
+	PhysicsStepStats counters;
+	counters.hits = p_NumHits;
+
+	p_Profiler.beginStep();
+	p_Profiler.endPhase(&PhysicsStepStats::integrationTime);
+	p_Profiler.endStep(counters);
+}
+
+BOOST_AUTO_TEST_SUITE(TestStepProfiler)
+
+BOOST_AUTO_TEST_CASE(TestStepProfilerDisabled)
+{
+	StepProfiler profiler;
+	BOOST_CHECK(!profiler.isEnabled());
+
+	recordStep(profiler, 1);
+	BOOST_CHECK_EQUAL(profiler.getNumSteps(), 0);
+	BOOST_CHECK_EQUAL(profiler.getStep(0).hits, 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestStepProfilerNewestFirst)
+{
+	StepProfiler profiler;
+	profiler.setEnabled(true);
+
+	recordStep(profiler, 1);
+	recordStep(profiler, 2);
+	recordStep(profiler, 3);
+
+	BOOST_REQUIRE_EQUAL(profiler.getNumSteps(), 3);
+	BOOST_CHECK_EQUAL(profiler.getStep(0).hits, 3);
+	BOOST_CHECK_EQUAL(profiler.getStep(1).hits, 2);
+	BOOST_CHECK_EQUAL(profiler.getStep(2).hits, 1);
+	BOOST_CHECK_GE(profiler.getStep(0).totalTime, profiler.getStep(0).integrationTime);
+
+	profiler.clear();
+	BOOST_CHECK_EQUAL(profiler.getNumSteps(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestStepProfilerWraps)
+{
+	StepProfiler profiler;
+	profiler.setEnabled(true);
+
+	for (unsigned int i = 0; i < StepProfiler::maxSteps + 10; ++i)
+	{
+		recordStep(profiler, i);
+	}
+
+	BOOST_REQUIRE_EQUAL(profiler.getNumSteps(), StepProfiler::maxSteps);
+	BOOST_CHECK_EQUAL(profiler.getStep(0).hits, StepProfiler::maxSteps + 9);
+	BOOST_CHECK_EQUAL(profiler.getStep(StepProfiler::maxSteps - 1).hits, 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
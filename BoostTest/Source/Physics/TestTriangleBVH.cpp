@@ -0,0 +1,107 @@
+#include <boost\test\unit_test.hpp>
+#include "..\..\Physics\include\Hull.h"
+#include "..\..\Physics\include\TriangleBVH.h"
+
+#include <algorithm>
+#include <vector>
+
+static std::vector<Triangle> createTriangleRow(unsigned int p_NumTriangles)
+{
+	std::vector<Triangle> triangles;
+	for (unsigned int i = 0; i < p_NumTriangles; ++i)
+	{
+		const float x = (float)i * 2.f;
+		triangles.push_back(Triangle(Vector4(x, 0.f, 0.f, 1.f), Vector4(x + 1.f, 0.f, 0.f, 1.f), Vector4(x, 1.f, 0.f, 1.f)));
+	}
+
+	return triangles;
+}
+
+BOOST_AUTO_TEST_SUITE(TestTriangleBVH)
+
+BOOST_AUTO_TEST_CASE(TestTriangleBVHFindsAllOverlapping)
+{
+	TriangleBVH bvh;
+	bvh.build(createTriangleRow(100));
+
+	BOOST_CHECK_GT(bvh.getNodes().size(), 1);
+	BOOST_CHECK_EQUAL(bvh.getTriangleIndices().size(), 100);
+
+	std::vector<unsigned int> found;
+	bvh.findTriangles(DirectX::XMFLOAT3(9.5f, -1.f, -1.f), DirectX::XMFLOAT3(12.5f, 1.f, 1.f),
+		[&found] (unsigned int p_Triangle) { found.push_back(p_Triangle); });
+	std::sort(found.begin(), found.end());
+
+	BOOST_REQUIRE_EQUAL(found.size(), 2);
+	BOOST_CHECK_EQUAL(found[0], 5);
+	BOOST_CHECK_EQUAL(found[1], 6);
+
+	found.clear();
+	bvh.findTriangles(DirectX::XMFLOAT3(-5.f, 2.f, -1.f), DirectX::XMFLOAT3(500.f, 3.f, 1.f),
+		[&found] (unsigned int p_Triangle) { found.push_back(p_Triangle); });
+	BOOST_CHECK(found.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestTriangleBVHEmpty)
+{
+	TriangleBVH bvh;
+	bvh.build(std::vector<Triangle>());
+
+	unsigned int numFound = 0;
+	bvh.findTriangles(DirectX::XMFLOAT3(-1.f, -1.f, -1.f), DirectX::XMFLOAT3(1.f, 1.f, 1.f),
+		[&numFound] (unsigned int) { ++numFound; });
+	BOOST_CHECK_EQUAL(numFound, 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestTriangleBVHHullWorldBox)
+{
+	Hull hull(createTriangleRow(50));
+	hull.setPosition(DirectX::XMVectorSet(0.f, 10.f, 0.f, 1.f));
+
+	std::vector<unsigned int> found;
+	hull.findTrianglesInBox(DirectX::XMVectorSet(0.2f, 10.2f, -0.5f, 1.f), DirectX::XMVectorSet(0.4f, 10.4f, 0.5f, 1.f),
+		[&found] (unsigned int p_Triangle) { found.push_back(p_Triangle); });
+	BOOST_REQUIRE_EQUAL(found.size(), 1);
+	BOOST_CHECK_EQUAL(found[0], 0);
+
+	found.clear();
+	hull.findTrianglesInBox(DirectX::XMVectorSet(0.2f, 0.2f, -0.5f, 1.f), DirectX::XMVectorSet(0.4f, 0.4f, 0.5f, 1.f),
+		[&found] (unsigned int p_Triangle) { found.push_back(p_Triangle); });
+	BOOST_CHECK(found.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestTriangleBVHCastRay)
+{
+	std::vector<Triangle> triangles;
+	for (unsigned int i = 0; i < 64; ++i)
+	{
+		const float z = (float)i;
+		triangles.push_back(Triangle(Vector4(-1.f, -1.f, z, 1.f), Vector4(1.f, -1.f, z, 1.f), Vector4(0.f, 1.f, z, 1.f)));
+	}
+	std::random_shuffle(triangles.begin(), triangles.end());
+
+	TriangleBVH bvh;
+	bvh.build(triangles);
+
+	std::vector<unsigned int> tested;
+	bvh.castRay(DirectX::XMFLOAT3(0.f, 0.f, 10.5f), DirectX::XMFLOAT3(0.f, 0.f, 1.f), 1000.f,
+		[&] (unsigned int p_Triangle) -> float
+		{
+			tested.push_back(p_Triangle);
+			return triangles[p_Triangle].corners[0].z - 10.5f;
+		});
+
+	BOOST_REQUIRE(!tested.empty());
+	BOOST_CHECK_LT(tested.size(), triangles.size() / 2);
+
+	float closest = 1000.f;
+	for (unsigned int triangle : tested)
+	{
+		const float distance = triangles[triangle].corners[0].z - 10.5f;
+		if (distance > 0.f)
+			closest = std::min(closest, distance);
+	}
+	BOOST_CHECK_EQUAL(closest, 0.5f);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
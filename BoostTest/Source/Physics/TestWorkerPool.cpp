@@ -0,0 +1,57 @@
+#include <boost\test\unit_test.hpp>
+#include "..\..\Physics\Source\WorkerPool.h"
+
+#include <stdexcept>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(TestWorkerPool)
+
+BOOST_AUTO_TEST_CASE(TestWorkerPoolRunsAllItems)
+{
+	WorkerPool pool;
+	pool.start(4);
+	BOOST_CHECK_EQUAL(pool.getNumThreads(), 4);
+
+	std::vector<unsigned int> results(100, 0);
+	for (unsigned int run = 1; run <= 3; ++run)
+	{
+		pool.run((unsigned int)results.size(), [&results, run] (unsigned int p_Item) { results[p_Item] = p_Item * run; });
+
+		for (unsigned int i = 0; i < results.size(); ++i)
+		{
+			BOOST_CHECK_EQUAL(results[i], i * run);
+		}
+	}
+
+	pool.stop();
+	BOOST_CHECK_EQUAL(pool.getNumThreads(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestWorkerPoolSingleThread)
+{
+	WorkerPool pool;
+	pool.start(1);
+
+	unsigned int sum = 0;
+	pool.run(10, [&sum] (unsigned int p_Item) { sum += p_Item; });
+
+	BOOST_CHECK_EQUAL(sum, 45);
+}
+
+BOOST_AUTO_TEST_CASE(TestWorkerPoolRethrows)
+{
+	WorkerPool pool;
+	pool.start(2);
+
+	BOOST_CHECK_THROW(pool.run(8, [] (unsigned int p_Item)
+	{
+		if (p_Item == 5)
+			throw std::runtime_error("Task failed");
+	}), std::runtime_error);
+
+	unsigned int count = 0;
+	pool.run(1, [&count] (unsigned int) { ++count; });
+	BOOST_CHECK_EQUAL(count, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -395,6 +395,30 @@ void BaseGameApp::updateDebugInfo()
 		info.updateDebugInfo("FPS", buffer);
 		std::sprintf(buffer, "%.1f ms", m_DeltaTime * 1000.f);
 		info.updateDebugInfo("DeltaTime", buffer);
+
+		// Only pay for profiling the physics while someone is looking at the result
+		m_Physics->setProfilingEnabled(hud_Scene->isDebugInfoShown());
+		const unsigned int numSteps = m_Physics->getNumProfiledSteps();
+		if (numSteps > 0)
+		{
+			float totalTime = 0.f;
+			float collisionTime = 0.f;
+			unsigned int triangleTests = 0;
+			for (unsigned int i = 0; i < numSteps; ++i)
+			{
+				const PhysicsStepStats step = m_Physics->getProfiledStep(i);
+				totalTime += step.totalTime;
+				collisionTime += step.staticCollisionTime + step.broadphaseTime + step.pairCollisionTime;
+				triangleTests += step.triangleTests;
+			}
+
+			char physicsBuffer[32];
+			std::sprintf(physicsBuffer, "%.3f ms", totalTime / numSteps);
+			info.updateDebugInfo("Physics step", physicsBuffer);
+			std::sprintf(physicsBuffer, "%.3f ms", collisionTime / numSteps);
+			info.updateDebugInfo("Physics collision", physicsBuffer);
+			info.updateDebugInfo("Physics triangle tests", std::to_string(triangleTests / numSteps));
+		}
 	}
 }
 
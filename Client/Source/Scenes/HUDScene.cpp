@@ -330,6 +330,11 @@ DebugInfo& HUDScene::getDebugInfo()
 	return m_DebugInfo;
 }
 
+bool HUDScene::isDebugInfoShown() const
+{
+	return m_ShowDebugInfo;
+}
+
 void HUDScene::createGUIElement(std::string p_GUIIdentifier, int p_Id)
 {
 	if(m_GUI.count(p_GUIIdentifier) > 0)
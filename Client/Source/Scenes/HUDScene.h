@@ -83,6 +83,12 @@ public:
 	 * @return the debug info object used to print info to the hud
 	 */
 	DebugInfo& getDebugInfo();
+	/**
+	 * Check whether the debug info is currently shown.
+	 *
+	 * @return true if the debug info is rendered to the hud
+	 */
+	bool isDebugInfoShown() const;
 
 private:
 	void createGUIElement(std::string p_GUIIdentifier, int p_Id);
@@ -48,6 +48,11 @@ void ActorFactory::setPhysics(IPhysics* p_Physics)
 	m_Physics = p_Physics;
 }
 
+IPhysics* ActorFactory::getPhysics()
+{
+	return m_Physics;
+}
+
 void ActorFactory::setEventManager(EventManager* p_EventManager)
 {
 	m_EventManager = p_EventManager;
@@ -35,6 +35,14 @@ bool Level::loadLevel(std::istream& p_LevelData, ActorList::ptr p_ActorOut)
 	levelLoader.readStreamData(p_LevelData);	
 
 	std::vector<InstanceBinaryLoader::ModelData> m_LevelData = levelLoader.getModelData();
+
+	// The level geometry is sorted into the octree once, after every instance has been placed
+	IPhysics* physics = m_ActorFactory->getPhysics();
+	if (physics)
+	{
+		physics->beginBodyBatch();
+	}
+
 	for(unsigned int i = 0; i < m_LevelData.size(); i++)
 	{
 		InstanceBinaryLoader::ModelData& model = m_LevelData.at(i);
@@ -83,6 +91,11 @@ bool Level::loadLevel(std::istream& p_LevelData, ActorList::ptr p_ActorOut)
 			p_ActorOut->addActor(m_ActorFactory->createInstanceActor(instModel, volumes, edges));
 		}
 	}
+
+	if (physics)
+	{
+		physics->endBodyBatch();
+	}
 	
 	p_LevelData.seekg(0, p_LevelData.beg);
 		
@@ -90,6 +90,8 @@ void PlayerBodyComponent::postInit()
 	m_Physics->setBodyVolumeCollisionResponse(m_Body, 2, false);
 	m_Physics->setBodyVolumeCollisionResponse(m_Body, 3, false);
 	m_Physics->addSphereToBody(m_Body, m_Owner->getPosition() + m_OffsetPositionSphereHead, m_RadiusHead);
+	// Spell explosions can throw players fast enough to pass through thin walls in one step
+	m_Physics->setBodyContinuousCollision(m_Body, true);
 
 	using namespace DirectX;
 	Vector3 ownerRot = m_Owner->getRotation();
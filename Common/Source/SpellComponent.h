@@ -82,6 +82,7 @@ public:
 		m_Physics->setBodyRotationMatrix(m_Body, rot);
 
 		m_Physics->setBodyCollisionResponse(m_Body, false);
+		m_Physics->setBodyContinuousCollision(m_Body, true);
 		m_Physics->setBodyVelocity(m_Body, m_SpellInstance->getVelocity());
 
 		std::weak_ptr<ModelInterface> asdff = m_Owner->getComponent<ModelInterface>(ModelInterface::m_ComponentId);
@@ -5,8 +5,16 @@
 
 Connection::Connection( boost::asio::ip::tcp::socket&& p_Socket) 
 		:   m_Socket(std::move(p_Socket)),
-			m_LockWriting(),
-			m_ReadBuffer(sizeof(Header)),
+			m_WriteTimer(m_Socket.get_io_service()),
+			m_ReadStrand(m_Socket.get_io_service()),
+			m_ReadPaused(false),
+			m_Writing(false),
+			m_WriteTimerPending(false),
+			m_MaxWriteBytes(64 * 1024),
+			m_MaxWriteDelayMs(0),
+			m_NumWrites(0),
+			m_WaitingBytes(0),
+			m_ReadBuffer(),
 			m_SaveData(),
 			m_State(State::CONNECTED)
 {
@@ -24,6 +32,7 @@ void Connection::disconnect()
 		m_SaveData = saveDataFunction();
 		m_State = State::UNCONNECTED;
 
+		m_WriteTimer.cancel();
 		m_Socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both);
 		m_Socket.close();
 	}
@@ -34,18 +43,32 @@ bool Connection::hasError() const
 	return m_State == State::INVALID;
 }
 
-void Connection::doWrite(const Header& p_Header, const std::string& p_Buffer)
+void Connection::flushWrites()
 {
 	NetworkLogger::log(NetworkLogger::Level::TRACE, "Starting a write on a connection");
 
-	m_WriteHeader = p_Header;
-	m_WriteBuffer = p_Buffer;
+	// Gather the waiting messages into one write, always at least one message
+	size_t numBytes = 0;
+	while (!m_WaitingToWrite.empty()
+		&& (m_Writes.empty() || numBytes + m_WaitingToWrite.front().first.m_Size <= m_MaxWriteBytes))
+	{
+		numBytes += m_WaitingToWrite.front().first.m_Size;
+		m_Writes.push_back(std::move(m_WaitingToWrite.front()));
+		m_WaitingToWrite.pop_front();
+	}
+	m_WaitingBytes -= numBytes;
 
-	std::vector<boost::asio::const_buffer> buffers;
-	buffers.push_back(boost::asio::buffer(&m_WriteHeader, sizeof(m_WriteHeader)));
-	buffers.push_back(boost::asio::buffer(m_WriteBuffer));
+	// The headers and buffers are kept alive in m_Writes until the write has completed
+	m_WriteBuffers.clear();
+	for (const auto& message : m_Writes)
+	{
+		m_WriteBuffers.push_back(boost::asio::buffer(&message.first, sizeof(message.first)));
+		m_WriteBuffers.push_back(boost::asio::buffer(*message.second));
+	}
+	m_Writing = true;
+	++m_NumWrites;
 
-	boost::asio::async_write(m_Socket, buffers,
+	boost::asio::async_write(m_Socket, m_WriteBuffers,
 		std::bind(&Connection::handleWrite, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
 }
 
@@ -67,14 +90,28 @@ void Connection::handleWrite(const boost::system::error_code& p_Error, std::size
 	}
 
 	std::lock_guard<std::mutex> lock(m_WriteQueueLock);
+	m_Writes.clear();
+	m_Writing = false;
+
+	// Messages queued during the write have already waited, send them without delay
 	if (!m_WaitingToWrite.empty())
 	{
-		doWrite(m_WaitingToWrite[0].first, m_WaitingToWrite[0].second);
-		m_WaitingToWrite.erase(m_WaitingToWrite.begin());
+		flushWrites();
 	}
-	else
+}
+
+void Connection::handleWriteTimer(const boost::system::error_code& p_Error)
+{
+	std::lock_guard<std::mutex> lock(m_WriteQueueLock);
+	m_WriteTimerPending = false;
+
+	if (p_Error == boost::asio::error::operation_aborted)
+		return;
+
+	// The queue may already have been flushed by reaching the byte limit
+	if (!m_Writing && !m_WaitingToWrite.empty())
 	{
-		m_LockWriting.clear();
+		flushWrites();
 	}
 }
 
@@ -84,8 +121,8 @@ void Connection::readHeader()
 
 	boost::asio::async_read(
 		m_Socket,
-		boost::asio::buffer(m_ReadBuffer, sizeof(Header)),
-		std::bind(&Connection::handleReadHeader, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+		boost::asio::buffer(&m_ReadHeader, sizeof(Header)),
+		m_ReadStrand.wrap(std::bind(&Connection::handleReadHeader, shared_from_this(), std::placeholders::_1, std::placeholders::_2)));
 }
 
 void Connection::handleReadHeader(const boost::system::error_code& p_Error, std::size_t /*p_BytesTransferred*/)
@@ -115,18 +152,18 @@ void Connection::handleReadHeader(const boost::system::error_code& p_Error, std:
 		}
 	}
 
-	Header header;
-	header = *((Header*)m_ReadBuffer.data());
-	size_t dataSize = header.m_Size - sizeof(Header);
-
-	if (m_ReadBuffer.size() < header.m_Size)
+	if (m_ReadHeader.m_Size < sizeof(Header))
 	{
-		m_ReadBuffer.resize(header.m_Size);
+		m_State = State::INVALID;
+		throw NetworkError("Received a package header with an invalid size", __LINE__, __FILE__);
 	}
 
+	// The body is read into a buffer of its own, so the package can keep it instead of copying it
+	m_ReadBuffer.resize(m_ReadHeader.m_Size - sizeof(Header));
+
 	boost::asio::async_read(m_Socket,
-		boost::asio::buffer(m_ReadBuffer.data() + sizeof(Header), dataSize),
-		std::bind(&Connection::handleReadData, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+		boost::asio::buffer(m_ReadBuffer),
+		m_ReadStrand.wrap(std::bind(&Connection::handleReadData, shared_from_this(), std::placeholders::_1, std::placeholders::_2)));
 }
 
 void Connection::handleReadData(const boost::system::error_code& p_Error, std::size_t /*p_BytesTransferred*/) 
@@ -158,33 +195,78 @@ void Connection::handleReadData(const boost::system::error_code& p_Error, std::s
 
 	if (m_SaveData)
 	{
-		Header* header = (Header*)m_ReadBuffer.data();
-		std::string data(m_ReadBuffer.data() + sizeof(Header), header->m_Size - sizeof(Header));
-		m_SaveData(header->m_TypeID, data);
+		m_SaveData(m_ReadHeader.m_TypeID, m_ReadBuffer);
 	}
 
-	readHeader();
+	if (!m_ReadPaused)
+	{
+		readHeader();
+	}
+}
+
+void Connection::handleResumeReading()
+{
+	if (m_ReadPaused && isConnected())
+	{
+		m_ReadPaused = false;
+		readHeader();
+	}
+}
+
+void Connection::handlePost(const std::function<void()>& p_Handler)
+{
+	if (isConnected())
+	{
+		p_Handler();
+	}
 }
 
 void Connection::writeData(const std::string& p_Buffer, uint16_t p_ID)
+{
+	writeSharedData(std::make_shared<const std::string>(p_Buffer), p_ID);
+}
+
+void Connection::writeSharedData(std::shared_ptr<const std::string> p_Buffer, uint16_t p_ID)
 {
 	NetworkLogger::log(NetworkLogger::Level::TRACE, "Connection received data to send");
 
 	Header header;
-	header.m_Size = static_cast<uint32_t>(p_Buffer.size() + sizeof(Header));
+	header.m_Size = static_cast<uint32_t>(p_Buffer->size() + sizeof(Header));
 	header.m_TypeID = p_ID;
 
-	if(!m_LockWriting.test_and_set())
+	std::lock_guard<std::mutex> lock(m_WriteQueueLock);
+	m_WaitingToWrite.push_back(std::make_pair(header, std::move(p_Buffer)));
+	m_WaitingBytes += header.m_Size;
+
+	// A write in flight flushes the queue when it completes
+	if (m_Writing)
+		return;
+
+	if (m_MaxWriteDelayMs == 0 || m_WaitingBytes >= m_MaxWriteBytes)
 	{
-		doWrite(header, p_Buffer);
+		flushWrites();
 	}
-	else
+	else if (!m_WriteTimerPending)
 	{
-		std::lock_guard<std::mutex> lock(m_WriteQueueLock);
-		m_WaitingToWrite.push_back(std::make_pair(header, p_Buffer));
+		m_WriteTimerPending = true;
+		m_WriteTimer.expires_from_now(boost::posix_time::milliseconds(m_MaxWriteDelayMs));
+		m_WriteTimer.async_wait(std::bind(&Connection::handleWriteTimer, shared_from_this(), std::placeholders::_1));
 	}
 }
 
+void Connection::setWriteBatching(size_t p_MaxBytes, unsigned int p_MaxDelayMs)
+{
+	std::lock_guard<std::mutex> lock(m_WriteQueueLock);
+	m_MaxWriteBytes = p_MaxBytes;
+	m_MaxWriteDelayMs = p_MaxDelayMs;
+}
+
+unsigned int Connection::getNumWrites()
+{
+	std::lock_guard<std::mutex> lock(m_WriteQueueLock);
+	return m_NumWrites;
+}
+
 void Connection::setSaveData(saveDataFunction p_SaveData)
 {
 	m_SaveData = p_SaveData;
@@ -205,6 +287,23 @@ void Connection::startReading()
 	readHeader();
 }
 
+void Connection::pauseReading()
+{
+	NetworkLogger::log(NetworkLogger::Level::DEBUG_L, "Connection pausing reading");
+
+	m_ReadPaused = true;
+}
+
+void Connection::resumeReading()
+{
+	m_ReadStrand.post(std::bind(&Connection::handleResumeReading, shared_from_this()));
+}
+
+void Connection::post(std::function<void()> p_Handler)
+{
+	m_ReadStrand.post(std::bind(&Connection::handlePost, shared_from_this(), std::move(p_Handler)));
+}
+
 std::string Connection::formatError(const boost::system::error_code& p_Error)
 {
 	return "error: " + std::to_string(p_Error.value()) + ": " + p_Error.message();
@@ -6,10 +6,10 @@
 
 #include "IConnection.h"
 
-#include <atomic>
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 
 /**
@@ -30,15 +30,26 @@ protected:
 	State m_State;
 
 	boost::asio::ip::tcp::socket m_Socket;
+	boost::asio::deadline_timer m_WriteTimer;
+	boost::asio::io_service::strand m_ReadStrand;	// Runs the read handlers and posted handlers one at a time
+	bool m_ReadPaused;								// Only used on the read strand
 
-	std::atomic_flag m_LockWriting;
-	std::mutex m_WriteQueueLock;
+	typedef std::shared_ptr<const std::string> buffer_t;
+	typedef std::pair<Header, buffer_t> message_t;
 
-	Header m_WriteHeader;
-	std::string m_WriteBuffer;
-	std::vector<char> m_ReadBuffer;
+	std::mutex m_WriteQueueLock;
+	bool m_Writing;					// A write is in flight
+	bool m_WriteTimerPending;		// A delayed flush is waiting
+	size_t m_MaxWriteBytes;
+	unsigned int m_MaxWriteDelayMs;
+	unsigned int m_NumWrites;
 
-	std::vector<std::pair<Header, std::string>> m_WaitingToWrite;
+	std::vector<message_t> m_Writes;				// The messages of the write in flight
+	std::vector<boost::asio::const_buffer> m_WriteBuffers;
+	std::deque<message_t> m_WaitingToWrite;
+	size_t m_WaitingBytes;
+	Header m_ReadHeader;
+	std::vector<char> m_ReadBuffer;		// The body of the package being read, handed over to m_SaveData
 
 	saveDataFunction m_SaveData;
 	disconnectedCallback_t m_Disconnected;
@@ -59,9 +70,21 @@ public:
 	bool hasError() const override;
 
 	void writeData(const std::string& p_Buffer, uint16_t p_ID) override;
+	void writeSharedData(std::shared_ptr<const std::string> p_Buffer, uint16_t p_ID) override;
 	void setSaveData(saveDataFunction p_SaveData) override;
 	void setDisconnectedCallback(disconnectedCallback_t p_DisconnectedCallback) override;
 	void startReading() override;
+	void pauseReading() override;
+	void resumeReading() override;
+	void post(std::function<void()> p_Handler) override;
+	void setWriteBatching(size_t p_MaxBytes, unsigned int p_MaxDelayMs) override;
+
+	/**
+	 * Get the number of writes issued to the socket, to see how well messages are gathered.
+	 *
+	 * @return the number of writes since the connection was created
+	 */
+	unsigned int getNumWrites();
 
 	/**
 	 * Get the socket from the connection.
@@ -71,11 +94,14 @@ public:
 	virtual boost::asio::ip::tcp::socket& getSocket();
 
 private:
-	void doWrite(const Header& p_Header, const std::string& p_Buffer);
+	void flushWrites();
 	void handleWrite(const boost::system::error_code& p_Error, std::size_t p_BytesTransferred);
+	void handleWriteTimer(const boost::system::error_code& p_Error);
 	void handleReadHeader(const boost::system::error_code& p_Error, std::size_t p_BytesTransferred);
 	void handleReadData(const boost::system::error_code& p_Error, std::size_t p_BytesTransferred);
 	void readHeader();
+	void handleResumeReading();
+	void handlePost(const std::function<void()>& p_Handler);
 
 	static std::string formatError(const boost::system::error_code& p_Error);
 };
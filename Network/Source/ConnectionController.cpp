@@ -1,18 +1,49 @@
 #include "ConnectionController.h"
 
+#include "NetworkExceptions.h"
 #include "NetworkLogger.h"
+#include "UnreliableChannel.h"
+
+#include <algorithm>
 
 ConnectionController::ConnectionController(IConnection::ptr p_Connection, const std::vector<PackageBase::ptr>& p_Prototypes)
 	:	m_PackagePrototypes(p_Prototypes),
-		m_Connection(std::move(p_Connection))
+		m_Connection(std::move(p_Connection)),
+		m_ReceivedPackages(maxReceivedPackages),
+		m_ConsumedPackages(maxReceivedPackages),
+		m_NumVisible(0),
+		m_ReadingPaused(false),
+		m_UnreliableToken(0),
+		m_UnreliableSequence(0),
+		m_UnreliablePackages(maxUnreliablePackages),
+		m_FreeUnreliableBuffers(maxUnreliablePackages),
+		m_UnreliablePosted(false),
+		m_AcknowledgedSnapshot(0),
+		m_ReceivedSnapshot(0)
 {
 	NetworkLogger::log(NetworkLogger::Level::DEBUG_L, "Creating a connection controller");
 
+	for (const PackageBase::ptr& prototype : m_PackagePrototypes)
+	{
+		const size_t type = (size_t)prototype->getType();
+		if (type >= m_PackageDispatch.size())
+		{
+			m_PackageDispatch.resize(type + 1, nullptr);
+		}
+		m_PackageDispatch[type] = prototype.get();
+	}
+	m_PackagePools.resize(m_PackageDispatch.size());
+	m_LastUnreliableSequence.resize(m_PackageDispatch.size(), 0);
+
 	m_Connection->setSaveData(std::bind(&ConnectionController::savePackageCallBack, this, std::placeholders::_1, std::placeholders::_2));
 }
 
 ConnectionController::~ConnectionController()
 {
+	if (m_Unreliable)
+	{
+		m_Unreliable->removePeer(m_UnreliableToken);
+	}
 	m_Connection->disconnect();
 }
 
@@ -26,6 +57,11 @@ bool ConnectionController::hasError() const
 	return m_Connection->hasError();
 }
 
+void ConnectionController::setWriteBatching(unsigned int p_MaxBytes, unsigned int p_MaxDelayMs)
+{
+	m_Connection->setWriteBatching(p_MaxBytes, p_MaxDelayMs);
+}
+
 void ConnectionController::startListening()
 {
 	m_Connection->startReading();
@@ -33,8 +69,8 @@ void ConnectionController::startListening()
 
 unsigned int ConnectionController::getNumPackages()
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	return m_ReceivedPackages.size();
+	m_NumVisible = (unsigned int)m_ReceivedPackages.getNumAvailable();
+	return m_NumVisible;
 }
 
 Package ConnectionController::getPackage(unsigned int p_Index)
@@ -44,15 +80,27 @@ Package ConnectionController::getPackage(unsigned int p_Index)
 
 void ConnectionController::clearPackages(unsigned int p_NumPackages)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	m_ReceivedPackages.erase(m_ReceivedPackages.begin(), m_ReceivedPackages.begin() + p_NumPackages);
+	const unsigned int numPackages = std::min(p_NumPackages, m_NumVisible);
+	for (unsigned int i = 0; i < numPackages; ++i)
+	{
+		PackageBase::ptr package;
+		m_ReceivedPackages.pop(package);
+
+		// Dropped if the network thread is behind on taking consumed packages back
+		m_ConsumedPackages.push(package);
+	}
+	m_NumVisible -= numPackages;
+
+	if (m_ReadingPaused)
+	{
+		m_Connection->post(std::bind(&ConnectionController::resumeReceiving, this));
+	}
 }
 
 PackageType ConnectionController::getPackageType(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	if (m_ReceivedPackages.size() > p_Package)
-		return m_ReceivedPackages[p_Package]->getType();
+	if (m_NumVisible > p_Package)
+		return getReceivedPackage(p_Package)->getType();
 	else
 		return PackageType::RESERVED;
 }
@@ -62,7 +110,7 @@ void ConnectionController::sendCreateObjects(const ObjectInstance* p_Instances,
 	CreateObjects package;
 	for (unsigned int i = 0; i < p_NumInstances; ++i)
 	{
-		package.m_Object1.push_back(std::make_pair(std::string(p_Instances[i].m_Description), p_Instances[i].m_Id));
+		package.m_Object1.push_back(std::make_pair(FlatString(p_Instances[i].m_Description), p_Instances[i].m_Id));
 	}
 
 	writeData(package.getData(), (uint16_t)package.getType());
@@ -70,15 +118,13 @@ void ConnectionController::sendCreateObjects(const ObjectInstance* p_Instances,
 
 unsigned int ConnectionController::getNumCreateObjects(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	CreateObjects* createObjects = static_cast<CreateObjects*>(m_ReceivedPackages[p_Package].get());
+	CreateObjects* createObjects = static_cast<CreateObjects*>(getReceivedPackage(p_Package));
 	return createObjects->m_Object1.size();
 }
 
 ObjectInstance ConnectionController::getCreateObjectDescription(Package p_Package, unsigned int p_Description)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	CreateObjects* createObjects = static_cast<CreateObjects*>(m_ReceivedPackages[p_Package].get());
+	CreateObjects* createObjects = static_cast<CreateObjects*>(getReceivedPackage(p_Package));
 	ObjectInstance inst;
 	inst.m_Description = createObjects->m_Object1[p_Description].first.c_str();
 	inst.m_Id = createObjects->m_Object1[p_Description].second;
@@ -88,43 +134,165 @@ ObjectInstance ConnectionController::getCreateObjectDescription(Package p_Packag
 void ConnectionController::sendUpdateObjects(const UpdateObjectData* p_ObjectData, unsigned int p_NumObjects, const char** p_ExtraData, unsigned int p_NumExtraData)
 {
 	UpdateObjects package;
-	for (unsigned int i = 0; i < p_NumExtraData; ++i)
+	encodeUpdateObjects(package, p_ObjectData, p_NumObjects, p_ExtraData, p_NumExtraData);
+
+	writeData(package.getData(), (uint16_t)package.getType());
+}
+
+void IConnectionController::broadcastUpdateObjects(IConnectionController* const* p_Connections, unsigned int p_NumConnections,
+	const UpdateObjectData* p_ObjectData, unsigned int p_NumObjects, const char** p_ExtraData, unsigned int p_NumExtraData)
+{
+	// Every controller handed out by the network library is a ConnectionController
+	std::vector<ConnectionController*> unreliable;
+	std::vector<ConnectionController*> waiting;
+	for (unsigned int i = 0; i < p_NumConnections; ++i)
 	{
-		package.m_Object2.push_back(std::string(p_ExtraData[i]));
+		ConnectionController* connection = static_cast<ConnectionController*>(p_Connections[i]);
+		if (connection->hasUnreliableChannel())
+		{
+			unreliable.push_back(connection);
+		}
+		else
+		{
+			waiting.push_back(connection);
+		}
 	}
-	package.m_Object1.assign(p_ObjectData, p_ObjectData + p_NumObjects);
 
-	writeData(package.getData(), (uint16_t)package.getType());
+	// A datagram may be lost, so unreliable updates are encoded against the last snapshot the client
+	// acknowledged, and clients that acknowledged the same snapshot share the package.
+	// Connections fall back to the reliable package if the snapshot does not fit in a datagram.
+	while (!unreliable.empty())
+	{
+		ConnectionController* encoder = unreliable.front();
+		const SnapshotBaseline::ptr baseline = encoder->getAcknowledgedUpdates();
+		const auto sharing = std::stable_partition(unreliable.begin(), unreliable.end(),
+			[encoder, &baseline] (ConnectionController* p_Connection)
+			{
+				return !p_Connection->sharesUpdatePrecision(*encoder) || p_Connection->getAcknowledgedUpdates() != baseline;
+			});
+
+		UpdateObjects package;
+		const SnapshotBaseline::ptr snapshot = encoder->encodeUnreliableUpdateObjects(package, baseline,
+			p_ObjectData, p_NumObjects, p_ExtraData, p_NumExtraData);
+
+		const std::string data(package.getData());
+		for (auto it = sharing; it != unreliable.end(); ++it)
+		{
+			if ((*it)->writeUnreliableData(data, (uint16_t)package.getType()))
+			{
+				(*it)->recordUnreliableUpdates(snapshot);
+			}
+			else
+			{
+				waiting.push_back(*it);
+			}
+		}
+		unreliable.erase(sharing, unreliable.end());
+	}
+
+	// Connections that have been sent the same updates can share one encoded package,
+	// which is all of them except the players that joined since the last broadcast
+	while (!waiting.empty())
+	{
+		ConnectionController* encoder = waiting.front();
+		const auto sharing = std::stable_partition(waiting.begin(), waiting.end(),
+			[encoder] (ConnectionController* p_Connection)
+			{
+				return !p_Connection->sharesUpdateBaseline(*encoder);
+			});
+
+		UpdateObjects package;
+		encoder->encodeUpdateObjects(package, p_ObjectData, p_NumObjects, p_ExtraData, p_NumExtraData);
+
+		const std::shared_ptr<const std::string> data = std::make_shared<const std::string>(package.getData());
+		for (auto it = sharing; it != waiting.end(); ++it)
+		{
+			(*it)->copyUpdateBaseline(*encoder);
+			(*it)->writeSharedData(data, (uint16_t)package.getType());
+		}
+		waiting.erase(sharing, waiting.end());
+	}
 }
 
 unsigned int ConnectionController::getNumUpdateObjectData(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	UpdateObjects* createObjects = static_cast<UpdateObjects*>(m_ReceivedPackages[p_Package].get());
+	UpdateObjects* createObjects = static_cast<UpdateObjects*>(getReceivedPackage(p_Package));
 	return createObjects->m_Object1.size();
 }
 
 const UpdateObjectData* ConnectionController::getUpdateObjectData(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	UpdateObjects* createObjects = static_cast<UpdateObjects*>(m_ReceivedPackages[p_Package].get());
+	UpdateObjects* createObjects = static_cast<UpdateObjects*>(getReceivedPackage(p_Package));
 	return createObjects->m_Object1.data();
 }
 
 unsigned int ConnectionController::getNumUpdateObjectExtraData(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	UpdateObjects* createObjects = static_cast<UpdateObjects*>(m_ReceivedPackages[p_Package].get());
+	UpdateObjects* createObjects = static_cast<UpdateObjects*>(getReceivedPackage(p_Package));
 	return createObjects->m_Object2.size();
 }
 
 const char* ConnectionController::getUpdateObjectExtraData(Package p_Package, unsigned int p_ExtraData)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	UpdateObjects* createObjects = static_cast<UpdateObjects*>(m_ReceivedPackages[p_Package].get());
+	UpdateObjects* createObjects = static_cast<UpdateObjects*>(getReceivedPackage(p_Package));
 	return createObjects->m_Object2[p_ExtraData].c_str();
 }
 
+void ConnectionController::setUpdateObjectPrecision(const UpdateObjectPrecision& p_Precision)
+{
+	m_UpdatePrecision = p_Precision;
+}
+
+void ConnectionController::encodeUpdateObjects(UpdateObjects& p_Package, const UpdateObjectData* p_ObjectData, unsigned int p_NumObjects,
+	const char** p_ExtraData, unsigned int p_NumExtraData)
+{
+	std::vector<uint8_t> snapshot;
+	m_SentUpdates = SnapshotCodec::encode(p_ObjectData, p_NumObjects, p_ExtraData, p_NumExtraData,
+		m_UpdatePrecision, m_SentUpdates, snapshot);
+	p_Package.m_Snapshot.assign(std::move(snapshot));
+}
+
+SnapshotBaseline::ptr ConnectionController::encodeUnreliableUpdateObjects(UpdateObjects& p_Package, SnapshotBaseline::ptr p_Baseline,
+	const UpdateObjectData* p_ObjectData, unsigned int p_NumObjects, const char** p_ExtraData, unsigned int p_NumExtraData) const
+{
+	std::vector<uint8_t> snapshot;
+	SnapshotBaseline::ptr sent = SnapshotCodec::encode(p_ObjectData, p_NumObjects, p_ExtraData, p_NumExtraData,
+		m_UpdatePrecision, std::move(p_Baseline), snapshot);
+	p_Package.m_Snapshot.assign(std::move(snapshot));
+	return sent;
+}
+
+SnapshotBaseline::ptr ConnectionController::getAcknowledgedUpdates() const
+{
+	const uint32_t acknowledged = m_AcknowledgedSnapshot;
+	return acknowledged != 0 ? m_SentUnreliableUpdates.find(acknowledged) : nullptr;
+}
+
+void ConnectionController::recordUnreliableUpdates(SnapshotBaseline::ptr p_Snapshot)
+{
+	// Snapshots without objects do not change the baseline and are already recorded
+	if (p_Snapshot && !m_SentUnreliableUpdates.find(p_Snapshot->m_Id))
+	{
+		m_SentUnreliableUpdates.add(std::move(p_Snapshot));
+	}
+}
+
+bool ConnectionController::sharesUpdatePrecision(const ConnectionController& p_Other) const
+{
+	return SnapshotCodec::isSamePrecision(m_UpdatePrecision, p_Other.m_UpdatePrecision);
+}
+
+bool ConnectionController::sharesUpdateBaseline(const ConnectionController& p_Other) const
+{
+	return m_SentUpdates == p_Other.m_SentUpdates
+		&& SnapshotCodec::isSamePrecision(m_UpdatePrecision, p_Other.m_UpdatePrecision);
+}
+
+void ConnectionController::copyUpdateBaseline(const ConnectionController& p_Other)
+{
+	m_SentUpdates = p_Other.m_SentUpdates;
+}
+
 void ConnectionController::sendRemoveObjects(const uint32_t* p_Objects, unsigned int p_NumObjects)
 {
 	RemoveObjects package;
@@ -135,15 +303,13 @@ void ConnectionController::sendRemoveObjects(const uint32_t* p_Objects, unsigned
 
 unsigned int ConnectionController::getNumRemoveObjectRefs(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	RemoveObjects* removeObjects = static_cast<RemoveObjects*>(m_ReceivedPackages[p_Package].get());
+	RemoveObjects* removeObjects = static_cast<RemoveObjects*>(getReceivedPackage(p_Package));
 	return removeObjects->m_Object1.size();
 }
 
 const uint32_t* ConnectionController::getRemoveObjectRefs(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	RemoveObjects* removeObjects = static_cast<RemoveObjects*>(m_ReceivedPackages[p_Package].get());
+	RemoveObjects* removeObjects = static_cast<RemoveObjects*>(getReceivedPackage(p_Package));
 	return removeObjects->m_Object1.data();
 }
 
@@ -158,15 +324,13 @@ void ConnectionController::sendObjectAction(uint32_t p_ObjectId, const char* p_A
 
 uint32_t ConnectionController::getObjectActionId(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	ObjectAction* objectAction = static_cast<ObjectAction*>(m_ReceivedPackages[p_Package].get());
+	ObjectAction* objectAction = static_cast<ObjectAction*>(getReceivedPackage(p_Package));
 	return objectAction->m_Object1;
 }
 
 const char* ConnectionController::getObjectActionAction(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	ObjectAction* objectAction = static_cast<ObjectAction*>(m_ReceivedPackages[p_Package].get());
+	ObjectAction* objectAction = static_cast<ObjectAction*>(getReceivedPackage(p_Package));
 	return objectAction->m_Object2.c_str();
 }
 
@@ -180,8 +344,7 @@ void ConnectionController::sendAssignPlayer(uint32_t p_ObjectId)
 
 uint32_t ConnectionController::getAssignPlayerObject(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	AssignPlayer* assignPlayer = static_cast<AssignPlayer*>(m_ReceivedPackages[p_Package].get());
+	AssignPlayer* assignPlayer = static_cast<AssignPlayer*>(getReceivedPackage(p_Package));
 	return assignPlayer->m_Object1;
 }
 
@@ -189,14 +352,23 @@ void ConnectionController::sendPlayerControl(PlayerControlData p_Data)
 {
 	PlayerControl package;
 	package.m_Object1 = p_Data;
+	package.m_Object2 = m_ReceivedSnapshot;
 
-	writeData(package.getData(), (uint16_t)package.getType());
+	const std::string data(package.getData());
+	if (!writeUnreliableData(data, (uint16_t)package.getType()))
+	{
+		writeData(data, (uint16_t)package.getType());
+	}
+}
+
+bool ConnectionController::hasUnreliableChannel()
+{
+	return m_Unreliable && m_UnreliableToken != 0 && m_Unreliable->canSend(m_UnreliableToken);
 }
 
 PlayerControlData ConnectionController::getPlayerControlData(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	PlayerControl* playerControl = static_cast<PlayerControl*>(m_ReceivedPackages[p_Package].get());
+	PlayerControl* playerControl = static_cast<PlayerControl*>(getReceivedPackage(p_Package));
 	return playerControl->m_Object1;
 }
 
@@ -219,43 +391,37 @@ void ConnectionController::sendJoinGame(const char* p_Game, const char* p_Userna
 
 const char* ConnectionController::getJoinGameName(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	JoinGame* joinGame = static_cast<JoinGame*>(m_ReceivedPackages[p_Package].get());
+	JoinGame* joinGame = static_cast<JoinGame*>(getReceivedPackage(p_Package));
 	return joinGame->m_Object1.game.c_str();
 }
 
 const char* ConnectionController::getJoinGameUsername(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	JoinGame* joinGame = static_cast<JoinGame*>(m_ReceivedPackages[p_Package].get());
+	JoinGame* joinGame = static_cast<JoinGame*>(getReceivedPackage(p_Package));
 	return joinGame->m_Object1.username.c_str();
 }
 
 const char* ConnectionController::getJoinGameCharacterName(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	JoinGame* joinGame = static_cast<JoinGame*>(m_ReceivedPackages[p_Package].get());
+	JoinGame* joinGame = static_cast<JoinGame*>(getReceivedPackage(p_Package));
 	return joinGame->m_Object1.characterName.c_str();
 }
 
 const char* ConnectionController::getJoinGameCharacterStyle(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	JoinGame* joinGame = static_cast<JoinGame*>(m_ReceivedPackages[p_Package].get());
+	JoinGame* joinGame = static_cast<JoinGame*>(getReceivedPackage(p_Package));
 	return joinGame->m_Object1.characterStyle.c_str();
 }
 
 const char* ConnectionController::getLevelData(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	LevelData* levelData = static_cast<LevelData*>(m_ReceivedPackages[p_Package].get());
+	LevelData* levelData = static_cast<LevelData*>(getReceivedPackage(p_Package));
 	return levelData->m_Object1.c_str();
 }
 
 const size_t ConnectionController::getLevelDataSize(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	LevelData* levelData = static_cast<LevelData*>(m_ReceivedPackages[p_Package].get());
+	LevelData* levelData = static_cast<LevelData*>(getReceivedPackage(p_Package));
 	return levelData->m_Object1.size();
 }
 
@@ -264,22 +430,20 @@ void ConnectionController::sendRacePosition(const char** p_ExtraData, unsigned i
 	GamePositions package;
 	for(unsigned int i = 0; i < p_NumExtraData; i++)
 	{
-		package.m_Object1.push_back(std::string(p_ExtraData[i]));
+		package.m_Object1.push_back(FlatString(p_ExtraData[i]));
 	}
 	writeData(package.getData(), (uint16_t)package.getType());
 }
 
 unsigned int ConnectionController::getNumRacePositionsData(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	GamePositions* createObjects = static_cast<GamePositions*>(m_ReceivedPackages[p_Package].get());
+	GamePositions* createObjects = static_cast<GamePositions*>(getReceivedPackage(p_Package));
 	return createObjects->m_Object1.size();
 }
 
 const char* ConnectionController::getRacePositionsData(Package p_Package, unsigned int p_ExtraData)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	GamePositions* createObjects = static_cast<GamePositions*>(m_ReceivedPackages[p_Package].get());
+	GamePositions* createObjects = static_cast<GamePositions*>(getReceivedPackage(p_Package));
 	return createObjects->m_Object1[p_ExtraData].c_str();
 }
 
@@ -288,22 +452,20 @@ void ConnectionController::sendGameResult(const char** p_ExtraData, unsigned int
 	ResultData package;
 	for (unsigned int i = 0; i < p_NumExtraData; ++i)
 	{
-		package.m_Object1.push_back(std::string(p_ExtraData[i]));
+		package.m_Object1.push_back(FlatString(p_ExtraData[i]));
 	}
 	writeData(package.getData(), (uint16_t)package.getType());
 }
 
 unsigned int ConnectionController::getNumGameResultData(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	ResultData* createObjects = static_cast<ResultData*>(m_ReceivedPackages[p_Package].get());
+	ResultData* createObjects = static_cast<ResultData*>(getReceivedPackage(p_Package));
 	return createObjects->m_Object1.size();
 }
 
 const char* ConnectionController::getGameResultData(Package p_Package, unsigned int p_ExtraData)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	ResultData* createObjects = static_cast<ResultData*>(m_ReceivedPackages[p_Package].get());
+	ResultData* createObjects = static_cast<ResultData*>(getReceivedPackage(p_Package));
 	return createObjects->m_Object1[p_ExtraData].c_str();
 }
 
@@ -316,8 +478,7 @@ void ConnectionController::sendNrOfCheckpoints(unsigned int p_NrOfCheckpoints)
 
 unsigned int ConnectionController::getNrOfCheckpoints(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	NumberOfCheckpoints* number = static_cast<NumberOfCheckpoints*>(m_ReceivedPackages[p_Package].get());
+	NumberOfCheckpoints* number = static_cast<NumberOfCheckpoints*>(getReceivedPackage(p_Package));
 	return number->m_Object1;
 }
 
@@ -330,15 +491,14 @@ void ConnectionController::sendTakenCheckpoints(unsigned int p_TakenChekpoints)
 
 unsigned int ConnectionController::getTakenCheckpoints(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	TakenCheckpoints* number = static_cast<TakenCheckpoints*>(m_ReceivedPackages[p_Package].get());
+	TakenCheckpoints* number = static_cast<TakenCheckpoints*>(getReceivedPackage(p_Package));
 	return number->m_Object1;
 }
 
 void ConnectionController::sendLevelData(const char* p_Stream, size_t p_Size)
 {
 	LevelData package;
-	package.m_Object1 = std::string(p_Stream, p_Size);
+	package.m_Object1 = FlatString(p_Stream, p_Size);
 	writeData(package.getData(), (uint16_t)package.getType());
 }
 
@@ -351,8 +511,7 @@ void ConnectionController::sendCurrentCheckpoint(Vector3 p_Position)
 
 Vector3 ConnectionController::getCurrentCheckpoint(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	CurrentCheckpoint* checkpoint = static_cast<CurrentCheckpoint*>(m_ReceivedPackages[p_Package].get());
+	CurrentCheckpoint* checkpoint = static_cast<CurrentCheckpoint*>(getReceivedPackage(p_Package));
 	return checkpoint->m_Object1;
 }
 
@@ -371,8 +530,7 @@ void ConnectionController::sendSetSpawnPosition(Vector3 p_Position)
 
 Vector3 ConnectionController::getSetSpawnPositionData(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	SetSpawnPosition* setSpawn = static_cast<SetSpawnPosition*>(m_ReceivedPackages[p_Package].get());
+	SetSpawnPosition* setSpawn = static_cast<SetSpawnPosition*>(getReceivedPackage(p_Package));
 	return setSpawn->m_Object1;
 }
 
@@ -389,22 +547,19 @@ void ConnectionController::sendThrowSpell(const char* p_SpellName, Vector3 p_Sta
 
 const char* ConnectionController::getThrowSpellName(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	ThrowSpell* throwSpell = static_cast<ThrowSpell*>(m_ReceivedPackages[p_Package].get());
+	ThrowSpell* throwSpell = static_cast<ThrowSpell*>(getReceivedPackage(p_Package));
 	return throwSpell->m_Object1.spellName.c_str();
 }
 
 Vector3 ConnectionController::getThrowSpellStartPosition(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	ThrowSpell* throwSpell = static_cast<ThrowSpell*>(m_ReceivedPackages[p_Package].get());
+	ThrowSpell* throwSpell = static_cast<ThrowSpell*>(getReceivedPackage(p_Package));
 	return throwSpell->m_Object1.position;
 }
 
 Vector3 ConnectionController::getThrowSpellDirection(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	ThrowSpell* throwSpell = static_cast<ThrowSpell*>(m_ReceivedPackages[p_Package].get());
+	ThrowSpell* throwSpell = static_cast<ThrowSpell*>(getReceivedPackage(p_Package));
 	return throwSpell->m_Object1.direction;
 }
 
@@ -446,15 +601,13 @@ void ConnectionController::sendGameList(const AvailableGameData* p_Games, unsign
 
 unsigned int ConnectionController::getNumGameListGames(Package p_Package)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	GameList* gameList = static_cast<GameList*>(m_ReceivedPackages[p_Package].get());
+	GameList* gameList = static_cast<GameList*>(getReceivedPackage(p_Package));
 	return gameList->m_Object1.size();
 }
 
 AvailableGameData ConnectionController::getGameListGame(Package p_Package, unsigned int p_GameIdx)
 {
-	std::lock_guard<std::mutex> lock(m_ReceivedLock);
-	GameList* gameList = static_cast<GameList*>(m_ReceivedPackages[p_Package].get());
+	GameList* gameList = static_cast<GameList*>(getReceivedPackage(p_Package));
 	const AvailableGame& game = gameList->m_Object1[p_GameIdx];
 
 	AvailableGameData data;
@@ -478,20 +631,215 @@ void ConnectionController::writeData(const std::string& p_Buffer, uint16_t p_ID)
 	}
 }
 
-void ConnectionController::savePackageCallBack(uint16_t p_ID, const std::string& p_Data)
+bool ConnectionController::writeUnreliableData(const std::string& p_Buffer, uint16_t p_ID)
 {
-	for(const PackageBase::ptr& p : m_PackagePrototypes)
+	const uint32_t token = m_UnreliableToken;
+	if (!m_Unreliable || token == 0)
 	{
-		if(p->getType() == (PackageType)p_ID)
+		return false;
+	}
+
+	return m_Unreliable->send(token, ++m_UnreliableSequence, p_ID, p_Buffer);
+}
+
+void ConnectionController::offerUnreliableChannel(std::shared_ptr<UnreliableChannel> p_Channel)
+{
+	m_Unreliable = std::move(p_Channel);
+	m_UnreliableToken = m_Unreliable->addPeer(std::bind(&ConnectionController::saveUnreliablePackage, this,
+		std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+
+	UnreliableChannelToken package;
+	package.m_Object1 = m_UnreliableToken;
+	writeData(package.getData(), (uint16_t)package.getType());
+}
+
+void ConnectionController::acceptUnreliableChannel(std::shared_ptr<UnreliableChannel> p_Channel)
+{
+	m_Unreliable = std::move(p_Channel);
+}
+
+void ConnectionController::writeSharedData(std::shared_ptr<const std::string> p_Buffer, uint16_t p_ID)
+{
+	if (m_Connection)
+	{
+		m_Connection->writeSharedData(std::move(p_Buffer), p_ID);
+	}
+}
+
+void ConnectionController::savePackageCallBack(uint16_t p_ID, std::vector<char>& p_Data)
+{
+	if (p_ID == (uint16_t)PackageType::UNRELIABLE_CHANNEL)
+	{
+		if (m_Unreliable && m_UnreliableToken == 0)
 		{
-			PackageBase::ptr package = p->createPackage(p_Data);
-			std::lock_guard<std::mutex> lock(m_ReceivedLock);
-			m_ReceivedPackages.push_back(std::move(package));
-			return;
+			UnreliableChannelToken package;
+			package.readPackage(p_Data);
+
+			// The channel says hello until the server answers, packages go over the connection until then
+			m_UnreliableToken = package.m_Object1;
+			m_Unreliable->addPeer(package.m_Object1, std::bind(&ConnectionController::saveUnreliablePackage, this,
+				std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
 		}
- 	}
+		return;
+	}
+
+	if (p_ID >= m_PackageDispatch.size() || !m_PackageDispatch[p_ID])
+	{
+		std::string msg("Received unregistered package type: " + std::to_string(p_ID));
+		NetworkLogger::log(NetworkLogger::Level::WARNING, msg);
+		return;
+	}
+
+	receivePackage(p_ID, p_Data, true);
+}
+
+void ConnectionController::saveUnreliablePackage(uint16_t p_ID, uint32_t p_Sequence, std::vector<char>& p_Data)
+{
+	// Only state that is replaced by newer packages may arrive unreliably
+	if (!isUnreliableType((PackageType)p_ID) || p_ID >= m_PackageDispatch.size() || !m_PackageDispatch[p_ID])
+	{
+		return;
+	}
+
+	// Datagrams are received one at a time, so the sequences need no lock
+	uint32_t& lastSequence = m_LastUnreliableSequence[p_ID];
+	if (lastSequence != 0 && (int32_t)(p_Sequence - lastSequence) <= 0)
+	{
+		return;
+	}
+	lastSequence = p_Sequence;
 
-	std::string msg("Received unregistered package type: " + std::to_string(p_ID));
-	NetworkLogger::log(NetworkLogger::Level::WARNING, msg);
+	// Only the read strand of the connection fills the received packages. The datagram is swapped
+	// with a buffer it has finished with, so that the channel keeps its capacity for the next one.
+	UnreliablePackage package;
+	package.m_ID = p_ID;
+	if (m_FreeUnreliableBuffers.getNumAvailable() > 0)
+	{
+		m_FreeUnreliableBuffers.pop(package.m_Data);
+	}
+	std::swap(package.m_Data, p_Data);
+	if (!m_UnreliablePackages.push(package))
+	{
+		return;
+	}
+
+	if (!m_UnreliablePosted.exchange(true))
+	{
+		m_Connection->post([this] () { receiveUnreliablePackages(); });
+	}
+}
+
+void ConnectionController::receiveUnreliablePackages()
+{
+	// Cleared before looking, so a datagram handed over after the last look posts again
+	m_UnreliablePosted = false;
+
+	UnreliablePackage package;
+	while (m_UnreliablePackages.getNumAvailable() > 0)
+	{
+		m_UnreliablePackages.pop(package);
+		try
+		{
+			receivePackage(package.m_ID, package.m_Data, false);
+		}
+		catch (NetworkError& err)
+		{
+			NetworkLogger::log(NetworkLogger::Level::WARNING, err.what());
+		}
+		m_FreeUnreliableBuffers.push(package.m_Data);
+	}
+}
+
+void ConnectionController::receivePackage(uint16_t p_ID, std::vector<char>& p_Data, bool p_Reliable)
+{
+	// Only unreliable packages arrive while reading is paused, and they are not worth waiting for
+	if (m_PendingPackage)
+	{
+		return;
+	}
+
+	PackageBase::ptr package;
+	for (size_t numConsumed = m_ConsumedPackages.getNumAvailable(); numConsumed > 0; --numConsumed)
+	{
+		m_ConsumedPackages.pop(package);
+		std::vector<PackageBase::ptr>& pool = m_PackagePools[(size_t)package->getType()];
+		if (pool.size() < maxPooledPackages)
+		{
+			pool.push_back(std::move(package));
+		}
+	}
+
+	package.reset();
+	std::vector<PackageBase::ptr>& pool = m_PackagePools[p_ID];
+	if (!pool.empty())
+	{
+		package = std::move(pool.back());
+		pool.pop_back();
+	}
+
+	// A recycled package hands its old buffer back to the connection to read the next package into
+	if (package)
+	{
+		package->readPackage(p_Data);
+	}
+	else
+	{
+		package = m_PackageDispatch[p_ID]->createPackage(std::move(p_Data));
+	}
+
+	if (package->getType() == PackageType::UPDATE_OBJECTS)
+	{
+		// Each transport keeps its own baselines, the sender never mixes them
+		UpdateObjects* updateObjects = static_cast<UpdateObjects*>(package.get());
+		const SnapshotBaseline::ptr received = SnapshotCodec::decode(updateObjects->m_Snapshot.data(), updateObjects->m_Snapshot.size(),
+			p_Reliable ? m_ReceivedUpdates : m_ReceivedUnreliableUpdates, updateObjects->m_Object1, updateObjects->m_Object2);
+		if (!p_Reliable && received)
+		{
+			m_ReceivedSnapshot = received->m_Id;
+		}
+	}
+	else if (package->getType() == PackageType::PLAYER_CONTROL)
+	{
+		const uint32_t acknowledged = static_cast<PlayerControl*>(package.get())->m_Object2;
+		if (acknowledged != 0 && (m_AcknowledgedSnapshot == 0 || SnapshotCodec::isNewer(acknowledged, m_AcknowledgedSnapshot)))
+		{
+			m_AcknowledgedSnapshot = acknowledged;
+		}
+	}
+
+	if (!m_ReceivedPackages.push(package) && p_Reliable)
+	{
+		// Packages can not be dropped, so the connection is not read until the reader makes room
+		NetworkLogger::log(NetworkLogger::Level::WARNING, "Received packages are not being read, pausing the connection");
+		m_PendingPackage = std::move(package);
+		m_ReadingPaused = true;
+		m_Connection->pauseReading();
+
+		// The reader may have made room before it could see that reading is paused
+		resumeReceiving();
+	}
+}
+
+void ConnectionController::resumeReceiving()
+{
+	if (!m_PendingPackage || !m_ReceivedPackages.push(m_PendingPackage))
+	{
+		return;
+	}
+
+	m_PendingPackage.reset();
+	m_ReadingPaused = false;
+	m_Connection->resumeReading();
+}
+
+bool ConnectionController::isUnreliableType(PackageType p_Type)
+{
+	return p_Type == PackageType::PLAYER_CONTROL
+		|| p_Type == PackageType::UPDATE_OBJECTS;
+}
+
+PackageBase* ConnectionController::getReceivedPackage(Package p_Package)
+{
+	return m_ReceivedPackages.at(p_Package).get();
 }
 
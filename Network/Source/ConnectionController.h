@@ -6,10 +6,14 @@
 
 #include "IConnection.h"
 #include "Packages.h"
+#include "SnapshotCodec.h"
+#include "SpscQueue.h"
 
 #include <IConnectionController.h>
 
-#include <mutex>
+#include <atomic>
+
+class UnreliableChannel;
 
 /**
  * Implementation of the IConnectionController interface.
@@ -26,8 +30,51 @@ private:
 	IConnection::ptr m_Connection;
 
 	const std::vector<PackageBase::ptr>& m_PackagePrototypes;
-	std::vector<PackageBase::ptr> m_ReceivedPackages;
-	std::mutex m_ReceivedLock;
+	std::vector<PackageBase*> m_PackageDispatch;			// Prototypes indexed by package type, null if unsupported
+	static const unsigned int maxPooledPackages = 32;
+	static const unsigned int maxReceivedPackages = 4096;
+	static const unsigned int maxUnreliablePackages = 64;
+
+	// Received packages go from the network thread to the thread reading them,
+	// and consumed packages go back to be reused. Neither side locks.
+	SpscQueue<PackageBase::ptr> m_ReceivedPackages;
+	SpscQueue<PackageBase::ptr> m_ConsumedPackages;
+	unsigned int m_NumVisible;						// Packages seen by the reader in the last getNumPackages
+	// Packages are only received on the read strand of the connection, unreliable ones are posted to it
+	std::vector<std::vector<PackageBase::ptr>> m_PackagePools;
+	PackageBase::ptr m_PendingPackage;				// Waiting for room in the received packages while reading is paused
+	std::atomic<bool> m_ReadingPaused;
+
+	std::shared_ptr<UnreliableChannel> m_Unreliable;
+	std::atomic<uint32_t> m_UnreliableToken;		// Zero until the channel has been paired
+	std::atomic<uint32_t> m_UnreliableSequence;
+	std::vector<uint32_t> m_LastUnreliableSequence;	// Indexed by package type, zero if nothing has been received
+
+	struct UnreliablePackage
+	{
+		uint16_t m_ID;
+		std::vector<char> m_Data;
+
+		UnreliablePackage& operator=(UnreliablePackage&& p_Other)
+		{
+			m_ID = p_Other.m_ID;
+			m_Data = std::move(p_Other.m_Data);
+			return *this;
+		}
+	};
+	// Datagrams go from the thread of the channel to the read strand, and their buffers come back to be
+	// swapped in for the next ones. The strand is only posted to when it is not already about to receive.
+	SpscQueue<UnreliablePackage> m_UnreliablePackages;
+	SpscQueue<std::vector<char>> m_FreeUnreliableBuffers;
+	std::atomic<bool> m_UnreliablePosted;
+
+	UpdateObjectPrecision m_UpdatePrecision;
+	SnapshotBaseline::ptr m_SentUpdates;
+	SnapshotHistory m_SentUnreliableUpdates;		// Only used by the thread broadcasting updates
+	std::atomic<uint32_t> m_AcknowledgedSnapshot;	// Newest snapshot acknowledged by the client, zero if none
+	SnapshotHistory m_ReceivedUpdates;				// Snapshots received over the connection
+	SnapshotHistory m_ReceivedUnreliableUpdates;	// Snapshots received over the unreliable channel
+	std::atomic<uint32_t> m_ReceivedSnapshot;		// Newest snapshot received unreliably, acknowledged to the server
 
 public:
 	/**
@@ -47,6 +94,7 @@ public:
 
 	bool isConnected() const override;
 	bool hasError() const override;
+	void setWriteBatching(unsigned int p_MaxBytes, unsigned int p_MaxDelayMs) override;
 
 	unsigned int getNumPackages() override;
 	Package getPackage(unsigned int p_Index) override;
@@ -63,6 +111,7 @@ public:
 	const UpdateObjectData* getUpdateObjectData(Package p_Package) override;
 	unsigned int getNumUpdateObjectExtraData(Package p_Package) override;
 	const char* getUpdateObjectExtraData(Package p_Package, unsigned int p_ExtraData) override;
+	void setUpdateObjectPrecision(const UpdateObjectPrecision& p_Precision) override;
 
 	void sendRemoveObjects(const uint32_t* p_Objects, unsigned int p_NumObjects) override;
 	unsigned int getNumRemoveObjectRefs(Package p_Package) override;
@@ -76,6 +125,7 @@ public:
 	uint32_t getAssignPlayerObject(Package p_Package) override;
 
 	void sendPlayerControl(PlayerControlData p_Data) override;
+	bool hasUnreliableChannel() override;
 	PlayerControlData getPlayerControlData(Package p_Package) override;
 
 	void sendDoneLoading() override;
@@ -126,6 +176,22 @@ public:
 	unsigned int getNumGameListGames(Package p_Package) override;
 	AvailableGameData getGameListGame(Package p_Package, unsigned int p_GameIdx) override;
 
+	/**
+	 * Pair the connection with a client's unreliable channel, as the server.
+	 * The token of the pair is sent to the client over the connection.
+	 *
+	 * @param p_Channel the unreliable channel of the server.
+	 */
+	void offerUnreliableChannel(std::shared_ptr<UnreliableChannel> p_Channel);
+
+	/**
+	 * Use an unreliable channel as a client, once the server sends the token pairing it with the connection.
+	 * Must be called before listening on the connection starts.
+	 *
+	 * @param p_Channel an unreliable channel connected to the server.
+	 */
+	void acceptUnreliableChannel(std::shared_ptr<UnreliableChannel> p_Channel);
+
 	/**
 	 * Start the listening loop on the connection.
 	 */
@@ -137,7 +203,109 @@ public:
 	 */
 	void setDisconnectedCallback(IConnection::disconnectedCallback_t p_DisconnectCallback);
 
+	/**
+	 * Send an already serialized package that can be shared with other connections.
+	 *
+	 * @param p_Buffer the serialized package, must not be modified afterwards.
+	 * @param p_ID the type of the package.
+	 */
+	void writeSharedData(std::shared_ptr<const std::string> p_Buffer, uint16_t p_ID);
+
+	/**
+	 * Encode object updates against the updates last sent on this connection.
+	 *
+	 * @param p_Package the package to encode the updates into, ready to be sent.
+	 */
+	void encodeUpdateObjects(UpdateObjects& p_Package, const UpdateObjectData* p_ObjectData, unsigned int p_NumObjects,
+		const char** p_ExtraData, unsigned int p_NumExtraData);
+
+	/**
+	 * Check if object updates encoded by this controller can be sent on another connection.
+	 *
+	 * @param p_Other the controller of the other connection.
+	 * @return true if both connections have been sent the same updates with the same precision.
+	 */
+	bool sharesUpdateBaseline(const ConnectionController& p_Other) const;
+
+	/**
+	 * Encode object updates for sending unreliably.
+	 *
+	 * @param p_Package the package to encode the updates into, ready to be sent.
+	 * @param p_Baseline a snapshot the client has acknowledged, or null to encode a full snapshot.
+	 * @return the snapshot encoded, to be recorded once it has been sent.
+	 */
+	SnapshotBaseline::ptr encodeUnreliableUpdateObjects(UpdateObjects& p_Package, SnapshotBaseline::ptr p_Baseline,
+		const UpdateObjectData* p_ObjectData, unsigned int p_NumObjects, const char** p_ExtraData, unsigned int p_NumExtraData) const;
+
+	/**
+	 * Get the newest snapshot sent unreliably that the client has acknowledged.
+	 *
+	 * @return the snapshot, or null if none of the recently sent snapshots has been acknowledged.
+	 */
+	SnapshotBaseline::ptr getAcknowledgedUpdates() const;
+
+	/**
+	 * Record that a snapshot has been sent unreliably, so that it can be used as a baseline once acknowledged.
+	 */
+	void recordUnreliableUpdates(SnapshotBaseline::ptr p_Snapshot);
+
+	/**
+	 * Check if object updates encoded by this controller are rounded the same as by another.
+	 *
+	 * @param p_Other the controller of the other connection.
+	 */
+	bool sharesUpdatePrecision(const ConnectionController& p_Other) const;
+
+	/**
+	 * Send a package over the unreliable channel, if it is open.
+	 *
+	 * @param p_Buffer the serialized package.
+	 * @param p_ID the type of the package.
+	 * @return false if the package has to be sent over the connection instead.
+	 */
+	bool writeUnreliableData(const std::string& p_Buffer, uint16_t p_ID);
+
+	/**
+	 * Record that the updates last encoded by another controller have been sent on this connection as well.
+	 *
+	 * @param p_Other a controller that shared its update baseline with this one before encoding.
+	 */
+	void copyUpdateBaseline(const ConnectionController& p_Other);
+
 protected:
 	void writeData(const std::string& p_Buffer, uint16_t p_ID);
-	void savePackageCallBack(uint16_t p_ID, const std::string& p_Data);
+	void savePackageCallBack(uint16_t p_ID, std::vector<char>& p_Data);
+	void saveUnreliablePackage(uint16_t p_ID, uint32_t p_Sequence, std::vector<char>& p_Data);
+
+private:
+	/**
+	 * Read a received package and hand it to the reader. Only called on the read strand of the connection.
+	 *
+	 * @param p_Reliable true if the package came over the connection, in order.
+	 *			If the reader falls behind, reading from the connection is paused until
+	 *			it catches up, while unreliable packages are dropped.
+	 */
+	void receivePackage(uint16_t p_ID, std::vector<char>& p_Data, bool p_Reliable);
+
+	/**
+	 * Receive the datagrams handed over by the unreliable channel. Only called on the read strand of the connection.
+	 */
+	void receiveUnreliablePackages();
+
+	/**
+	 * Hand the package that paused reading to the reader if there is room for it,
+	 * and continue reading. Only called on the read strand of the connection.
+	 */
+	void resumeReceiving();
+
+	/**
+	 * Check if a package type holds state that is replaced by each new package,
+	 * so that it can be sent unreliably.
+	 */
+	static bool isUnreliableType(PackageType p_Type);
+
+	/**
+	 * Get a received package. Only called by the thread reading packages.
+	 */
+	PackageBase* getReceivedPackage(Package p_Package);
 };
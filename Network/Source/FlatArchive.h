@@ -0,0 +1,391 @@
+/**
+ * File comment.
+ */
+
+#pragma once
+
+#include "NetworkExceptions.h"
+
+#include <CommonTypes.h>
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Types that are sent as their raw bytes. Specialize for plain structs
+ * without pointers or padding that differs between the sides.
+ */
+template <typename T>
+struct FlatIsBitwise : std::is_arithmetic<T> {};
+
+template <>
+struct FlatIsBitwise<Vector3> : std::true_type {};
+
+template <>
+struct FlatIsBitwise<PlayerControlData> : std::true_type {};
+
+template <>
+struct FlatIsBitwise<UpdateObjectData> : std::true_type {};
+
+/**
+ * A null-terminated string in a package. Strings set before sending own their
+ * characters, while received strings point into the buffer of the package.
+ */
+class FlatString
+{
+private:
+	std::string m_Owned;
+	const char* m_View;		// Null when the characters are owned
+	size_t m_ViewSize;
+
+public:
+	FlatString()
+		:	m_View(nullptr),
+			m_ViewSize(0)
+	{}
+
+	FlatString(const char* p_String)
+		:	m_Owned(p_String),
+			m_View(nullptr),
+			m_ViewSize(0)
+	{}
+
+	FlatString(const std::string& p_String)
+		:	m_Owned(p_String),
+			m_View(nullptr),
+			m_ViewSize(0)
+	{}
+
+	FlatString(const char* p_String, size_t p_Size)
+		:	m_Owned(p_String, p_Size),
+			m_View(nullptr),
+			m_ViewSize(0)
+	{}
+
+	/**
+	 * Point the string to characters owned by someone else.
+	 *
+	 * @param p_String null-terminated characters that outlive the string
+	 * @param p_Size the number of characters, without the terminator
+	 */
+	void view(const char* p_String, size_t p_Size)
+	{
+		m_Owned.clear();
+		m_View = p_String;
+		m_ViewSize = p_Size;
+	}
+
+	const char* c_str() const
+	{
+		return m_View ? m_View : m_Owned.c_str();
+	}
+
+	size_t size() const
+	{
+		return m_View ? m_ViewSize : m_Owned.size();
+	}
+};
+
+/**
+ * An array of bitwise values in a package. Arrays set before sending own their
+ * values, while received arrays point into the buffer of the package.
+ *
+ * @param <T> a type that FlatIsBitwise
+ */
+template <typename T>
+class PodArray
+{
+private:
+	std::vector<T> m_Owned;
+	const T* m_View;		// Null when the values are owned
+	size_t m_ViewSize;
+
+public:
+	PodArray()
+		:	m_View(nullptr),
+			m_ViewSize(0)
+	{}
+
+	void assign(const T* p_First, const T* p_Last)
+	{
+		m_View = nullptr;
+		m_Owned.assign(p_First, p_Last);
+	}
+
+	void assign(std::vector<T>&& p_Values)
+	{
+		m_View = nullptr;
+		m_Owned = std::move(p_Values);
+	}
+
+	/**
+	 * Point the array to values owned by someone else.
+	 *
+	 * @param p_Values values that outlive the array, aligned for T
+	 * @param p_Size the number of values
+	 */
+	void view(const T* p_Values, size_t p_Size)
+	{
+		m_Owned.clear();
+		m_View = p_Values;
+		m_ViewSize = p_Size;
+	}
+
+	const T* data() const
+	{
+		return m_View ? m_View : m_Owned.data();
+	}
+
+	size_t size() const
+	{
+		return m_View ? m_ViewSize : m_Owned.size();
+	}
+
+	const T& operator[](size_t p_Index) const
+	{
+		return data()[p_Index];
+	}
+};
+
+/**
+ * Serializes packages into the flat wire format, using the same serialize
+ * functions as the packages have always had.
+ *
+ * Bitwise values are written as their bytes. Strings are written as a 32-bit
+ * length followed by the characters and a terminator. Arrays are written as a
+ * 32-bit count followed by the elements, and arrays of bitwise values are padded
+ * to the alignment of the values, so that the receiver can use them in place.
+ */
+class FlatWriter
+{
+private:
+	std::string& m_Data;
+
+public:
+	/**
+	 * constructor.
+	 *
+	 * @param p_Data the buffer to append to. Alignment is relative to the start of it.
+	 */
+	explicit FlatWriter(std::string& p_Data)
+		: m_Data(p_Data)
+	{}
+
+	template <typename T>
+	FlatWriter& operator&(T& p_Value)
+	{
+		write(p_Value, FlatIsBitwise<T>());
+		return *this;
+	}
+
+	FlatWriter& operator&(std::string& p_Value)
+	{
+		writeString(p_Value.c_str(), p_Value.size());
+		return *this;
+	}
+
+	FlatWriter& operator&(FlatString& p_Value)
+	{
+		writeString(p_Value.c_str(), p_Value.size());
+		return *this;
+	}
+
+	template <typename T>
+	FlatWriter& operator&(PodArray<T>& p_Value)
+	{
+		writeCount(p_Value.size());
+		while (m_Data.size() % std::alignment_of<T>::value != 0)
+		{
+			m_Data.push_back('\0');
+		}
+		m_Data.append((const char*)p_Value.data(), p_Value.size() * sizeof(T));
+		return *this;
+	}
+
+	template <typename T>
+	FlatWriter& operator&(std::vector<T>& p_Value)
+	{
+		writeCount(p_Value.size());
+		for (auto& element : p_Value)
+		{
+			*this & element;
+		}
+		return *this;
+	}
+
+	template <typename First, typename Second>
+	FlatWriter& operator&(std::pair<First, Second>& p_Value)
+	{
+		*this & p_Value.first;
+		*this & p_Value.second;
+		return *this;
+	}
+
+private:
+	template <typename T>
+	void write(T& p_Value, std::true_type)
+	{
+		m_Data.append((const char*)&p_Value, sizeof(T));
+	}
+
+	template <typename T>
+	void write(T& p_Value, std::false_type)
+	{
+		p_Value.serialize(*this, 0);
+	}
+
+	void writeCount(size_t p_Count)
+	{
+		uint32_t count = (uint32_t)p_Count;
+		write(count, std::true_type());
+	}
+
+	void writeString(const char* p_String, size_t p_Size)
+	{
+		writeCount(p_Size);
+		m_Data.append(p_String, p_Size + 1);
+	}
+};
+
+/**
+ * Deserializes packages from the flat wire format written by FlatWriter.
+ * Strings and arrays of bitwise values are not copied, they point into the read buffer.
+ * Reading past the end of the buffer throws NetworkError.
+ */
+class FlatReader
+{
+private:
+	const char* m_Begin;
+	const char* m_Position;
+	const char* m_End;
+
+public:
+	/**
+	 * constructor.
+	 *
+	 * @param p_Data the buffer to read, which must outlive anything read from it.
+	 *			It must be aligned for the most aligned bitwise type in it.
+	 * @param p_Size the size of the buffer in bytes.
+	 */
+	FlatReader(const char* p_Data, size_t p_Size)
+		:	m_Begin(p_Data),
+			m_Position(p_Data),
+			m_End(p_Data + p_Size)
+	{}
+
+	template <typename T>
+	FlatReader& operator&(T& p_Value)
+	{
+		read(p_Value, FlatIsBitwise<T>());
+		return *this;
+	}
+
+	FlatReader& operator&(std::string& p_Value)
+	{
+		const size_t size = readCount();
+		const char* characters = readString(size);
+		p_Value.assign(characters, size);
+		return *this;
+	}
+
+	FlatReader& operator&(FlatString& p_Value)
+	{
+		const size_t size = readCount();
+		p_Value.view(readString(size), size);
+		return *this;
+	}
+
+	template <typename T>
+	FlatReader& operator&(PodArray<T>& p_Value)
+	{
+		const size_t count = readCount();
+		while ((m_Position - m_Begin) % std::alignment_of<T>::value != 0)
+		{
+			skip(1);
+		}
+		if ((size_t)(m_End - m_Position) / sizeof(T) < count)
+		{
+			throw NetworkError("Package ended unexpectedly", __LINE__, __FILE__);
+		}
+
+		p_Value.view((const T*)m_Position, count);
+		m_Position += count * sizeof(T);
+		return *this;
+	}
+
+	template <typename T>
+	FlatReader& operator&(std::vector<T>& p_Value)
+	{
+		// Every element takes at least a byte, which limits what a broken count can allocate
+		const size_t count = readCount();
+		if ((size_t)(m_End - m_Position) < count)
+		{
+			throw NetworkError("Package ended unexpectedly", __LINE__, __FILE__);
+		}
+
+		p_Value.resize(count);
+		for (auto& element : p_Value)
+		{
+			*this & element;
+		}
+		return *this;
+	}
+
+	template <typename First, typename Second>
+	FlatReader& operator&(std::pair<First, Second>& p_Value)
+	{
+		*this & p_Value.first;
+		*this & p_Value.second;
+		return *this;
+	}
+
+private:
+	template <typename T>
+	void read(T& p_Value, std::true_type)
+	{
+		std::memcpy(&p_Value, skip(sizeof(T)), sizeof(T));
+	}
+
+	template <typename T>
+	void read(T& p_Value, std::false_type)
+	{
+		p_Value.serialize(*this, 0);
+	}
+
+	const char* skip(size_t p_Size)
+	{
+		if ((size_t)(m_End - m_Position) < p_Size)
+		{
+			throw NetworkError("Package ended unexpectedly", __LINE__, __FILE__);
+		}
+
+		const char* position = m_Position;
+		m_Position += p_Size;
+		return position;
+	}
+
+	size_t readCount()
+	{
+		uint32_t count;
+		read(count, std::true_type());
+		return count;
+	}
+
+	const char* readString(size_t p_Size)
+	{
+		if ((size_t)(m_End - m_Position) <= p_Size)
+		{
+			throw NetworkError("Package ended unexpectedly", __LINE__, __FILE__);
+		}
+
+		const char* characters = skip(p_Size + 1);
+		if (characters[p_Size] != '\0')
+		{
+			throw NetworkError("Package contains an unterminated string", __LINE__, __FILE__);
+		}
+		return characters;
+	}
+};
@@ -7,6 +7,8 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 /**
  * Interface for a connetion to a remote computer.
@@ -18,9 +20,10 @@ public:
 	 * Callback type used to report that a data package has been received.
 	 *
 	 * First argument is the id of the package, as read from the header.
-	 * Second argument is the data as a string of bytes.
+	 * Second argument is the data as a buffer of bytes. The callback may
+	 * take the buffer by moving from it, the connection does not reuse its contents.
 	 */
-	typedef std::function<void(uint16_t, const std::string&)> saveDataFunction;
+	typedef std::function<void(uint16_t, std::vector<char>&)> saveDataFunction;
 	/**
 	 * Callback type used to report that the connection has been disconnected.
 	 */
@@ -73,6 +76,17 @@ public:
 	 */
 	virtual void writeData(const std::string& p_Buffer, uint16_t p_ID) = 0;
 
+	/**
+	 * Writes a shared buffer of data to the network stream, in order with the
+	 * data from writeData. The buffer is not copied, the connection keeps a
+	 * reference to it until it has been sent, so the same buffer can be
+	 * written to several connections.
+	 *
+	 * @param p_Buffer A buffer of data to send. Must not be modified afterwards.
+	 * @param p_ID The package ID to be associated with the data.
+	 */
+	virtual void writeSharedData(std::shared_ptr<const std::string> p_Buffer, uint16_t p_ID) = 0;
+
 	/**
 	 * Set a callback to handle data when received. Data is always a single complete package.
 	 *
@@ -86,6 +100,19 @@ public:
 	 */
 	virtual void setDisconnectedCallback(disconnectedCallback_t p_DisconnectedCallback) = 0;
 
+	/**
+	 * Set how queued messages are gathered into single writes to the socket.
+	 *
+	 * Messages queued while a write is in flight are always sent together in the next write.
+	 * A delay also holds back the first message written to an idle connection,
+	 * to let the messages that follow it join the same write.
+	 *
+	 * @param p_MaxBytes the number of bytes that is written at most in one write,
+	 *			unless a single message is larger. Reaching it also ends the delay.
+	 * @param p_MaxDelayMs the longest time in milliseconds a message is held back, 0 to send it at once.
+	 */
+	virtual void setWriteBatching(size_t p_MaxBytes, unsigned int p_MaxDelayMs) = 0;
+
 	///**
 	// * Get the socket from the connection.
 	// *
@@ -98,4 +125,23 @@ public:
 	* not be called twice on the same connection.
 	*/
 	virtual void startReading() = 0;
+
+	/**
+	 * Stop reading once the save data callback returns, until resumeReading is called.
+	 * Only called from the save data callback or a handler given to post.
+	 */
+	virtual void pauseReading() = 0;
+
+	/**
+	 * Continue reading after pauseReading. Safe to call from any thread.
+	 */
+	virtual void resumeReading() = 0;
+
+	/**
+	 * Run a handler on the thread reading the connection, never at the same time as
+	 * the save data callback. The handler is not run if the connection has been disconnected.
+	 *
+	 * @param p_Handler the function to run.
+	 */
+	virtual void post(std::function<void()> p_Handler) = 0;
 };
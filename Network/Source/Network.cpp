@@ -10,7 +10,7 @@ Network::~Network()
 {
 	NetworkLogger::log(NetworkLogger::Level::INFO, "Shutting down network");
 
-	m_ClientConnection.reset();
+	closeClientConnection();
 	m_IO_Service.stop();
 
 	if (m_IO_Thread.joinable())
@@ -66,7 +66,7 @@ void Network::connectToServer(const char* p_URL, unsigned short p_Port, actionDo
 {
 	NetworkLogger::log(NetworkLogger::Level::INFO, "Connecting to server");
 
-	m_ClientConnection.reset();
+	closeClientConnection();
 	m_ClientConnect.reset();
 	m_IO_Service.reset();
 
@@ -89,7 +89,7 @@ void Network::disconnectFromServer()
 
 	NetworkLogger::log(NetworkLogger::Level::INFO, "Disconnecting from server");
 
-	m_ClientConnection.reset();
+	closeClientConnection();
 	m_ClientConnect.reset();
 	m_IO_Service.reset();
 
@@ -172,9 +172,29 @@ void Network::IO_Run()
 
 void Network::clientConnectionDone(Result p_Result, actionDoneCallback p_DoneHandler, void* p_UserData)
 {
-	m_ClientConnection.reset(new ConnectionController(IConnection::ptr(new Connection(m_ClientConnect->releaseConnectedSocket())), m_PackagePrototypes));
+	boost::asio::ip::tcp::socket socket(m_ClientConnect->releaseConnectedSocket());
+
+	// The unreliable channel of the server has the same address and port number as its connection
+	boost::system::error_code error;
+	const boost::asio::ip::tcp::endpoint server = socket.remote_endpoint(error);
+
+	m_ClientConnection.reset(new ConnectionController(IConnection::ptr(new Connection(std::move(socket))), m_PackagePrototypes));
 	m_ClientConnection->setDisconnectedCallback(std::bind(&Network::clientDisconnected, this, p_DoneHandler, p_UserData));
 
+	if (p_Result == Result::SUCCESS && !error)
+	{
+		try
+		{
+			m_ClientChannel = std::make_shared<UnreliableChannel>(m_IO_Service, boost::asio::ip::udp::endpoint(server.address(), server.port()));
+			m_ClientChannel->startReceiving();
+			m_ClientConnection->acceptUnreliableChannel(m_ClientChannel);
+		}
+		catch (boost::system::system_error& err)
+		{
+			NetworkLogger::log(NetworkLogger::Level::WARNING, std::string("Using the reliable connection only: ") + err.what());
+		}
+	}
+
 	if (p_DoneHandler)
 	{
 		p_DoneHandler(p_Result, p_UserData);
@@ -184,6 +204,18 @@ void Network::clientConnectionDone(Result p_Result, actionDoneCallback p_DoneHan
 	m_ClientConnect.reset();
 }
 
+void Network::closeClientConnection()
+{
+	m_ClientConnection.reset();
+
+	// Pending receives keep the channel alive until the IO thread has seen it close
+	if (m_ClientChannel)
+	{
+		m_ClientChannel->close();
+		m_ClientChannel.reset();
+	}
+}
+
 void Network::clientDisconnected(actionDoneCallback p_DoneHandler, void* p_UserData)
 {
 	if (p_DoneHandler)
@@ -9,6 +9,7 @@
 #include "NetworkExceptions.h"
 #include "Packages.h"
 #include "ServerAccept.h"
+#include "UnreliableChannel.h"
 #include "../include/INetwork.h"
 
 /**
@@ -26,6 +27,7 @@ private:
 	std::unique_ptr<ServerAccept> m_ServerAcceptor;
 	std::unique_ptr<ClientConnect> m_ClientConnect;
 
+	UnreliableChannel::ptr m_ClientChannel;
 	ConnectionController::ptr m_ClientConnection;
 
 public:
@@ -61,4 +63,5 @@ private:
 	void IO_Run();
 	void clientConnectionDone(Result p_Result, actionDoneCallback p_DoneHandler, void* p_UserData);
 	void clientDisconnected(actionDoneCallback p_DoneHandler, void* p_UserData);
+	void closeClientConnection();
 };
@@ -5,23 +5,13 @@
 
 #pragma once
 
+#include "FlatArchive.h"
+
 #include <CommonTypes.h>
 
-#include <sstream>
 #include <memory>
 #include <vector>
 
-#pragma warning(push)
-#pragma warning(disable : 4244)
-#include <boost/archive/binary_iarchive.hpp>
-#include <boost/archive/binary_oarchive.hpp>
-#include <boost/serialization/is_bitwise_serializable.hpp>
-#include <boost/serialization/level.hpp>
-#include <boost/serialization/tracking.hpp>
-#include <boost/serialization/utility.hpp>
-#include <boost/serialization/vector.hpp>
-#pragma warning(pop)
-
 /**
  * Abstract base class for packages.
  */
@@ -39,25 +29,47 @@ protected:
 	 */
 	PackageType m_ID;
 
+	/**
+	 * The received data of the package, which its strings and arrays point into.
+	 */
+	std::vector<char> m_Buffer;
+
 	/**
 	 * Create a package from a byte stream.
 	 *
 	 * @param <Package> the package type to create.
-	 * @param p_Data a serialized package of the target type.
+	 * @param p_Data a serialized package of the target type, which the package takes over.
 	 * @return a new package of the target type.
 	 */
 	template <typename Package>
-	PackageBase::ptr createPackageImp(const std::string& p_Data)
+	PackageBase::ptr createPackageImp(std::vector<char> p_Data)
 	{
 		std::unique_ptr<Package> res(new Package());
+		res->m_Buffer = std::move(p_Data);
 
-		std::istringstream stream(p_Data);
-		boost::archive::binary_iarchive archive(stream, boost::archive::no_header);
-		archive >> *res;
+		FlatReader reader(res->m_Buffer.data(), res->m_Buffer.size());
+		reader & *res;
 
 		return PackageBase::ptr(res.release());
 	}
 
+	/**
+	 * Replace the contents of a package with a byte stream.
+	 *
+	 * @param <Package> the type of the package.
+	 * @param p_Package the package to read into.
+	 * @param p_Data a serialized package of the same type. It is swapped with
+	 *			the previous buffer of the package.
+	 */
+	template <typename Package>
+	void readPackageImp(Package& p_Package, std::vector<char>& p_Data)
+	{
+		p_Package.m_Buffer.swap(p_Data);
+
+		FlatReader reader(p_Package.m_Buffer.data(), p_Package.m_Buffer.size());
+		reader & p_Package;
+	}
+
 	/**
 	 * Create a byte stream from a package.
 	 *
@@ -66,13 +78,13 @@ protected:
 	 * @return a byte stream from the package.
 	 */
 	template <typename Package>
-	std::string getDataImp(const Package& p_Package)
+	std::string getDataImp(Package& p_Package)
 	{
-		std::ostringstream ostream;
-		boost::archive::binary_oarchive archive(ostream, boost::archive::no_header);
-		archive << p_Package;
+		std::string data;
+		FlatWriter writer(data);
+		writer & p_Package;
 
-		return ostream.str();
+		return data;
 	}
 
 public:
@@ -95,10 +107,20 @@ public:
 	/**
 	 * Create a package of the same type from a byte stream.
 	 *
-	 * @param p_Data a serialized package data stream.
+	 * @param p_Data a serialized package data stream, which the new package takes over
+	 *			and reads its strings and arrays from in place.
 	 * @return a new deserialized package.
 	 */
-	virtual PackageBase::ptr createPackage(const std::string& p_Data) = 0;
+	virtual PackageBase::ptr createPackage(std::vector<char> p_Data) = 0;
+
+	/**
+	 * Reuse the package for another received package of the same type,
+	 * keeping the memory it has already allocated.
+	 *
+	 * @param p_Data a serialized package data stream, which the package takes over.
+	 *			It receives the previous buffer of the package, whose capacity can be reused.
+	 */
+	virtual void readPackage(std::vector<char>& p_Data) = 0;
 
 	/**
 	 * Get the serialized data from the package.
@@ -123,9 +145,14 @@ public:
 		: PackageBase(p_Type)
 	{}
 
-	PackageBase::ptr createPackage(const std::string& p_Data) override
+	PackageBase::ptr createPackage(std::vector<char> p_Data) override
 	{
-		return createPackageImp<Package>(p_Data);
+		return createPackageImp<Package>(std::move(p_Data));
+	}
+
+	void readPackage(std::vector<char>& p_Data) override
+	{
+		readPackageImp<Package>(*(Package*)this, p_Data);
 	}
 
 	std::string getData() override
@@ -294,45 +321,16 @@ typedef Signal<PackageType::DONE_COUNTDOWN> DoneCountdown;
  */
 typedef Signal<PackageType::REQUEST_GAMES> RequestGames;
 
-BOOST_CLASS_IMPLEMENTATION(RequestGames, boost::serialization::object_serializable)
-BOOST_CLASS_TRACKING(RequestGames, boost::serialization::track_never)
-
 /**
  * A package representing the removal of objects in the game world.
  */
-typedef Package1Obj<PackageType::REMOVE_OBJECTS, std::vector<uint32_t>> RemoveObjects;
+typedef Package1Obj<PackageType::REMOVE_OBJECTS, PodArray<uint32_t>> RemoveObjects;
 
 /**
  * A package representing assigning a player to an object.
  */
 typedef Package1Obj<PackageType::ASSIGN_PLAYER, uint32_t> AssignPlayer;
 
-BOOST_IS_BITWISE_SERIALIZABLE(PlayerControlData)
-
-namespace boost
-{
-	namespace serialization
-	{
-		template <typename Archive>
-		inline void serialize(Archive& ar, Vector3& m_Data, const unsigned int /*version*/)
-		{
-			ar & m_Data.x;
-			ar & m_Data.y;
-			ar & m_Data.z;
-		}
-
-		template <typename Archive>
-		inline void serialize(Archive& ar, PlayerControlData& m_Data, const unsigned int /*version*/)
-		{
-			ar & m_Data.m_Position;
-			ar & m_Data.m_Velocity;
-			ar & m_Data.m_Rotation;
-			ar & m_Data.m_Forward;
-			ar & m_Data.m_Up;
-		}
-	}
-}
-
 /**
  * A package representing the number of checkpoints.
  */
@@ -344,19 +342,26 @@ typedef Package1Obj<PackageType::NUMBER_OF_CHECKPOINTS, unsigned int> NumberOfCh
 typedef Package1Obj<PackageType::TAKEN_CHECKPOINTS, unsigned int> TakenCheckpoints;
 
 /**
- * A package representing the player controlling its object.
+ * A package representing the player controlling its object, along with the id of the
+ * last update objects snapshot the client received unreliably, or zero if none.
+ */
+typedef Package2Obj<PackageType::PLAYER_CONTROL, PlayerControlData, uint32_t> PlayerControl;
+
+/**
+ * A package giving the client the token that pairs its unreliable channel
+ * with the connection. Handled by the network library itself.
  */
-typedef Package1Obj<PackageType::PLAYER_CONTROL, PlayerControlData> PlayerControl;
+typedef Package1Obj<PackageType::UNRELIABLE_CHANNEL, uint32_t> UnreliableChannelToken;
 
 /**
  * A package representing the level data.
  */
-typedef Package1Obj<PackageType::LEVEL_DATA, std::string> LevelData;
+typedef Package1Obj<PackageType::LEVEL_DATA, FlatString> LevelData;
 
 /**
  * A package representing the game result.
  */
-typedef Package1Obj<PackageType::RESULT_GAME, std::vector<std::string>> ResultData;
+typedef Package1Obj<PackageType::RESULT_GAME, std::vector<FlatString>> ResultData;
 
 /**
  * A package representing the current checkpoint.
@@ -366,12 +371,12 @@ typedef Package1Obj<PackageType::CURRENT_CHECKPOINT, Vector3> CurrentCheckpoint;
 /**
  * A package representing the players positions.
  */
-typedef Package1Obj<PackageType::GAME_POSITIONS, std::vector<std::string>> GamePositions;
+typedef Package1Obj<PackageType::GAME_POSITIONS, std::vector<FlatString>> GamePositions;
 
 /**
  * A package representing the addition of new objects to the game world.
  */
-typedef Package1Obj<PackageType::CREATE_OBJECTS, std::vector<std::pair<std::string, uint32_t>>> CreateObjects;
+typedef Package1Obj<PackageType::CREATE_OBJECTS, std::vector<std::pair<FlatString, uint32_t>>> CreateObjects;
 
 /**
  * A package representing setting the respawn position of a player.
@@ -380,7 +385,7 @@ typedef Package1Obj<PackageType::SET_SPAWN, Vector3> SetSpawnPosition;
 
 struct ThrowSpellData
 {
-	std::string spellName;
+	FlatString spellName;
 	Vector3 position;
 	Vector3 direction;
 
@@ -400,7 +405,7 @@ typedef Package1Obj<PackageType::THROW_SPELL, ThrowSpellData> ThrowSpell;
 
 struct AvailableGame
 {
-	std::string levelName;
+	FlatString levelName;
 	uint16_t waitingPlayers;
 	uint16_t maxPlayers;
 
@@ -413,28 +418,17 @@ struct AvailableGame
 	}
 };
 
-BOOST_CLASS_IMPLEMENTATION(AvailableGame, boost::serialization::object_serializable)
-BOOST_CLASS_TRACKING(AvailableGame, boost::serialization::track_never)
-
-BOOST_CLASS_IMPLEMENTATION(std::vector<AvailableGame>, boost::serialization::object_serializable)
-BOOST_CLASS_TRACKING(std::vector<AvailableGame>, boost::serialization::track_never)
-
 /**
  * List of available games in the server.
  */
  typedef Package1Obj<PackageType::GAME_LIST, std::vector<AvailableGame>> GameList;
 
-BOOST_CLASS_IMPLEMENTATION(GameList, boost::serialization::object_serializable)
-BOOST_CLASS_TRACKING(GameList, boost::serialization::track_never)
-
-BOOST_IS_BITWISE_SERIALIZABLE(UpdateObjectData)
-
 struct JoinGameData
 {
-	std::string game;
-	std::string username;
-	std::string characterName;
-	std::string characterStyle;
+	FlatString game;
+	FlatString username;
+	FlatString characterName;
+	FlatString characterStyle;
 
 	template <typename Archive>
 	void  serialize(Archive& ar, const unsigned int /*version*/)
@@ -453,10 +447,41 @@ typedef Package1Obj<PackageType::JOIN_GAME, JoinGameData> JoinGame;
 
 /**
  * A package representing the update of objects in the game world.
+ *
+ * Only the snapshot encoded by SnapshotCodec is serialized. The receiving
+ * connection controller decodes it into the object updates and extra data.
  */
- typedef Package2Obj<PackageType::UPDATE_OBJECTS, std::vector<UpdateObjectData>, std::vector<std::string>> UpdateObjects;
+class UpdateObjects : public PackageHelper<UpdateObjects>
+{
+public:
+	std::vector<UpdateObjectData> m_Object1;
+	std::vector<std::string> m_Object2;
+	PodArray<uint8_t> m_Snapshot;
+
+public:
+	/**
+	 * constructor.
+	 */
+	UpdateObjects()
+		: PackageHelper<UpdateObjects>(PackageType::UPDATE_OBJECTS)
+	{}
+
+	/**
+	 * Serialize the package to or from an archive.
+	 *
+	 * @param <Archive> the archive type to serialize with.
+	 *			Can be either input or output archives.
+	 * @param ar the archive used.
+	 * @param version the desired or given archive version. Ignored.
+	 */
+	template <typename Archive>
+	void serialize(Archive& ar, const unsigned int /*version*/)
+	{
+		ar & m_Snapshot;
+	}
+};
 
 /**
  * A package representing one objects action in the game world.
  */
-typedef Package2Obj<PackageType::OBJECT_ACTION, uint32_t, std::string> ObjectAction;
+typedef Package2Obj<PackageType::OBJECT_ACTION, uint32_t, FlatString> ObjectAction;
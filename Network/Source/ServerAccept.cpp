@@ -7,6 +7,7 @@
 ServerAccept::ServerAccept(boost::asio::io_service& p_IO_Service, unsigned short p_Port, std::vector<PackageBase::ptr>& p_Prototypes) 
 		:	m_Acceptor(m_IO_Service, boost::asio::ip::tcp::endpoint( boost::asio::ip::tcp::v4(), p_Port)),
 			m_AcceptSocket(m_IO_Service),
+			m_UnreliableChannel(std::make_shared<UnreliableChannel>(p_IO_Service, p_Port)),
 			m_HasError(false),
 			m_Running(false),
 			m_PortNumber(p_Port),
@@ -35,6 +36,7 @@ void ServerAccept::startServer(unsigned int p_NumThreads)
 	try
 	{
 		m_Acceptor.async_accept(m_AcceptSocket, std::bind( &ServerAccept::handleAccept, this, std::placeholders::_1));
+		m_UnreliableChannel->startReceiving();
 		startThreads(p_NumThreads);
 	}
 	catch (boost::system::system_error& err)
@@ -56,6 +58,8 @@ void ServerAccept::stopServer()
 		m_ConnectedClients.clear();
 	}
 
+	m_UnreliableChannel->close();
+
 	m_Running = false;
 	m_IO_Service.stop();
 
@@ -97,6 +101,7 @@ void ServerAccept::handleAccept( const boost::system::error_code& error)
 	ConnectionController::ptr clientConnection(new ConnectionController(std::move(connection), m_PackagePrototypes));
 
 	clientConnection->setDisconnectedCallback(std::bind(&ServerAccept::handleDisconnectCallback, this, clientConnection.get()));
+	clientConnection->offerUnreliableChannel(m_UnreliableChannel);
 
 	if (m_ClientConnected)
 	{
@@ -10,6 +10,7 @@
 #include "Connection.h"
 #include "ConnectionController.h"
 #include "Packages.h"
+#include "UnreliableChannel.h"
 
 #include <atomic>
 #include <boost/asio.hpp>
@@ -30,6 +31,7 @@ private:
 	boost::asio::io_service& m_IO_Service;
 	boost::asio::ip::tcp::acceptor m_Acceptor;
 	boost::asio::ip::tcp::socket m_AcceptSocket;
+	UnreliableChannel::ptr m_UnreliableChannel;
 
 	std::vector<boost::thread> m_WorkerThreads;
 
@@ -71,7 +73,8 @@ public:
 	 * Start the server.
 	 *
 	 * Starts accepting clients. For each client, a connection
-	 * is established and communication is started.
+	 * is established and communication is started. The clients
+	 * are offered an unreliable channel on the same port number.
 	 * Worker threads are started to handle the communication.
 	 *
 	 * @param p_NumThreads the number of worker threads to service client connections.
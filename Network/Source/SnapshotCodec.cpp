@@ -0,0 +1,523 @@
+#include "SnapshotCodec.h"
+
+#include "NetworkExceptions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static const unsigned int numVectors = 4;
+static const double maxQuantized = (double)((1 << 30) - 1);	// Keeps the differences within 32 bits
+
+// Ids are unique within the process, so connections can share encoded snapshots
+static std::atomic<uint32_t> lastSnapshotId(0);
+
+static uint32_t createSnapshotId()
+{
+	uint32_t id = ++lastSnapshotId;
+	while (id == 0)
+	{
+		id = ++lastSnapshotId;
+	}
+	return id;
+}
+
+/**
+ * Appends values to a buffer bit by bit, least significant bit first.
+ */
+class BitWriter
+{
+private:
+	std::vector<uint8_t>& m_Data;
+	unsigned int m_NumBits;
+
+public:
+	explicit BitWriter(std::vector<uint8_t>& p_Data)
+		:	m_Data(p_Data),
+			m_NumBits(0)
+	{
+		m_Data.clear();
+	}
+
+	void write(uint32_t p_Value, unsigned int p_NumBits)
+	{
+		for (unsigned int i = 0; i < p_NumBits; ++i)
+		{
+			if (m_NumBits % 8 == 0)
+			{
+				m_Data.push_back(0);
+			}
+			m_Data.back() |= (uint8_t)(((p_Value >> i) & 1) << (m_NumBits % 8));
+			++m_NumBits;
+		}
+	}
+
+	void writeBit(bool p_Bit)
+	{
+		write(p_Bit ? 1 : 0, 1);
+	}
+
+	/**
+	 * Write a value larger than zero as its number of bits followed by
+	 * the bits below the highest set bit, which is implied.
+	 */
+	void writeVarUInt(uint32_t p_Value)
+	{
+		unsigned int numBits = 1;
+		while (numBits < 32 && (p_Value >> numBits) != 0)
+		{
+			++numBits;
+		}
+		write(numBits - 1, 5);
+		write(p_Value, numBits - 1);
+	}
+
+	void writeCount(unsigned int p_Count)
+	{
+		writeVarUInt(p_Count + 1);
+	}
+
+	void writeFloat(float p_Value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &p_Value, sizeof(bits));
+		write(bits, 32);
+	}
+};
+
+/**
+ * Reads values written by a BitWriter. Reading past the end of the buffer throws NetworkError.
+ */
+class BitReader
+{
+private:
+	const uint8_t* m_Data;
+	size_t m_Size;
+	size_t m_NumBits;
+
+public:
+	BitReader(const uint8_t* p_Data, size_t p_Size)
+		:	m_Data(p_Data),
+			m_Size(p_Size),
+			m_NumBits(0)
+	{
+	}
+
+	size_t getBitsLeft() const
+	{
+		return m_Size * 8 - m_NumBits;
+	}
+
+	uint32_t read(unsigned int p_NumBits)
+	{
+		if (getBitsLeft() < p_NumBits)
+		{
+			throw NetworkError("Snapshot ended unexpectedly", __LINE__, __FILE__);
+		}
+
+		uint32_t value = 0;
+		for (unsigned int i = 0; i < p_NumBits; ++i)
+		{
+			const uint32_t bit = (m_Data[m_NumBits / 8] >> (m_NumBits % 8)) & 1;
+			value |= bit << i;
+			++m_NumBits;
+		}
+		return value;
+	}
+
+	bool readBit()
+	{
+		return read(1) != 0;
+	}
+
+	uint32_t readVarUInt()
+	{
+		const unsigned int numBits = read(5) + 1;
+		return read(numBits - 1) | (1u << (numBits - 1));
+	}
+
+	unsigned int readCount()
+	{
+		return readVarUInt() - 1;
+	}
+
+	float readFloat()
+	{
+		const uint32_t bits = read(32);
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+};
+
+static float getSteps(const UpdateObjectPrecision& p_Precision, unsigned int p_Vector)
+{
+	switch (p_Vector)
+	{
+	case 0:
+		return p_Precision.m_PositionSteps;
+	case 1:
+		return p_Precision.m_VelocitySteps;
+	case 2:
+		return p_Precision.m_RotationSteps;
+	default:
+		return p_Precision.m_RotationVelocitySteps;
+	}
+}
+
+static Vector3 UpdateObjectData::* const vectors[numVectors] =
+{
+	&UpdateObjectData::m_Position,
+	&UpdateObjectData::m_Velocity,
+	&UpdateObjectData::m_Rotation,
+	&UpdateObjectData::m_RotationVelocity,
+};
+
+static const float* getComponents(const Vector3& p_Vector)
+{
+	return &p_Vector.x;
+}
+
+static float* getComponents(Vector3& p_Vector)
+{
+	return &p_Vector.x;
+}
+
+static int32_t quantize(float p_Value, float p_Steps)
+{
+	const double scaled = std::floor((double)p_Value * p_Steps + 0.5);
+	return (int32_t)std::max(-maxQuantized, std::min(maxQuantized, scaled));
+}
+
+static float dequantize(int32_t p_Value, float p_Steps)
+{
+	return (float)(p_Value / (double)p_Steps);
+}
+
+static uint32_t zigzag(int32_t p_Value)
+{
+	return ((uint32_t)p_Value << 1) ^ (uint32_t)(p_Value >> 31);
+}
+
+static int32_t unzigzag(uint32_t p_Value)
+{
+	return (int32_t)((p_Value >> 1) ^ (0u - (p_Value & 1)));
+}
+
+static const SnapshotBaseline::Object* findObject(const SnapshotBaseline* p_Baseline, uint32_t p_Id)
+{
+	if (!p_Baseline)
+		return nullptr;
+
+	for (const auto& object : p_Baseline->m_Objects)
+	{
+		if (object.m_Id == p_Id)
+		{
+			return &object;
+		}
+	}
+	return nullptr;
+}
+
+static int32_t getPreviousValue(const SnapshotBaseline::Object* p_Previous, unsigned int p_Value)
+{
+	return p_Previous ? p_Previous->m_Values[p_Value] : 0;
+}
+
+SnapshotHistory::SnapshotHistory()
+	:	m_Snapshots(maxSnapshots),
+		m_Next(0)
+{
+}
+
+void SnapshotHistory::add(SnapshotBaseline::ptr p_Baseline)
+{
+	m_Snapshots[m_Next] = std::move(p_Baseline);
+	m_Next = (m_Next + 1) % maxSnapshots;
+}
+
+SnapshotBaseline::ptr SnapshotHistory::find(uint32_t p_Id) const
+{
+	for (const SnapshotBaseline::ptr& snapshot : m_Snapshots)
+	{
+		if (snapshot && snapshot->m_Id == p_Id)
+		{
+			return snapshot;
+		}
+	}
+	return nullptr;
+}
+
+void SnapshotHistory::clear()
+{
+	std::fill(m_Snapshots.begin(), m_Snapshots.end(), nullptr);
+	m_Next = 0;
+}
+
+SnapshotBaseline::ptr SnapshotCodec::encode(const UpdateObjectData* p_Objects, unsigned int p_NumObjects,
+	const char** p_ExtraData, unsigned int p_NumExtraData, const UpdateObjectPrecision& p_Precision,
+	SnapshotBaseline::ptr p_Baseline, std::vector<uint8_t>& p_Snapshot)
+{
+	BitWriter writer(p_Snapshot);
+
+	// Snapshots without objects are sent in full and leave the baseline as it was
+	const bool updatesBaseline = p_NumObjects > 0;
+	const bool isDelta = updatesBaseline && p_Baseline && isSamePrecision(p_Baseline->m_Precision, p_Precision);
+	const SnapshotBaseline* reference = isDelta ? p_Baseline.get() : nullptr;
+
+	std::shared_ptr<SnapshotBaseline> next = std::make_shared<SnapshotBaseline>();
+	next->m_Id = updatesBaseline ? createSnapshotId() : 0;
+	next->m_Precision = p_Precision;
+
+	writer.writeBit(isDelta);
+	writer.writeCount(p_NumObjects);
+	if (updatesBaseline)
+	{
+		writer.write(next->m_Id, 32);
+	}
+	if (isDelta)
+	{
+		writer.write(reference->m_Id, 32);
+	}
+	else if (updatesBaseline)
+	{
+		for (unsigned int v = 0; v < numVectors; ++v)
+		{
+			writer.writeFloat(getSteps(p_Precision, v));
+		}
+	}
+
+	next->m_Objects.resize(p_NumObjects);
+
+	for (unsigned int i = 0; i < p_NumObjects; ++i)
+	{
+		SnapshotBaseline::Object& object = next->m_Objects[i];
+		object.m_Id = p_Objects[i].m_Id;
+
+		for (unsigned int v = 0; v < numVectors; ++v)
+		{
+			const float* components = getComponents(p_Objects[i].*vectors[v]);
+			for (unsigned int c = 0; c < 3; ++c)
+			{
+				object.m_Values[v * 3 + c] = quantize(components[c], getSteps(p_Precision, v));
+			}
+		}
+
+		// Objects are usually sent in the same order every time
+		const bool sameId = reference && i < reference->m_Objects.size() && reference->m_Objects[i].m_Id == object.m_Id;
+		writer.writeBit(sameId);
+		if (!sameId)
+		{
+			writer.write(object.m_Id, 32);
+		}
+		const SnapshotBaseline::Object* previous = sameId ? &reference->m_Objects[i] : findObject(reference, object.m_Id);
+
+		for (unsigned int v = 0; v < numVectors; ++v)
+		{
+			bool changed = false;
+			for (unsigned int c = v * 3; c < v * 3 + 3; ++c)
+			{
+				changed = changed || object.m_Values[c] != getPreviousValue(previous, c);
+			}
+
+			writer.writeBit(changed);
+			if (!changed)
+				continue;
+
+			for (unsigned int c = v * 3; c < v * 3 + 3; ++c)
+			{
+				const int32_t difference = object.m_Values[c] - getPreviousValue(previous, c);
+				writer.writeBit(difference != 0);
+				if (difference != 0)
+				{
+					writer.writeVarUInt(zigzag(difference));
+				}
+			}
+		}
+	}
+
+	writer.writeCount(p_NumExtraData);
+	for (unsigned int i = 0; i < p_NumExtraData; ++i)
+	{
+		const bool same = reference && i < reference->m_ExtraData.size() && reference->m_ExtraData[i] == p_ExtraData[i];
+		writer.writeBit(same);
+		if (!same)
+		{
+			const unsigned int length = (unsigned int)std::strlen(p_ExtraData[i]);
+			writer.writeCount(length);
+			for (unsigned int c = 0; c < length; ++c)
+			{
+				writer.write((uint8_t)p_ExtraData[i][c], 8);
+			}
+		}
+
+		if (updatesBaseline)
+		{
+			next->m_ExtraData.push_back(p_ExtraData[i]);
+		}
+	}
+
+	return updatesBaseline ? next : p_Baseline;
+}
+
+SnapshotBaseline::ptr SnapshotCodec::decode(const uint8_t* p_Snapshot, size_t p_Size, SnapshotHistory& p_History,
+	std::vector<UpdateObjectData>& p_Objects, std::vector<std::string>& p_ExtraData)
+{
+	BitReader reader(p_Snapshot, p_Size);
+
+	const bool isDelta = reader.readBit();
+	const unsigned int numObjects = reader.readCount();
+	const bool updatesBaseline = numObjects > 0;
+	if (isDelta && !updatesBaseline)
+	{
+		throw NetworkError("Received a delta snapshot without objects", __LINE__, __FILE__);
+	}
+
+	std::shared_ptr<SnapshotBaseline> next = std::make_shared<SnapshotBaseline>();
+	next->m_Id = updatesBaseline ? reader.read(32) : 0;
+	if (updatesBaseline && next->m_Id == 0)
+	{
+		throw NetworkError("Received a snapshot without an id", __LINE__, __FILE__);
+	}
+
+	SnapshotBaseline::ptr baseline;
+	if (isDelta)
+	{
+		baseline = p_History.find(reader.read(32));
+		if (!baseline)
+		{
+			throw NetworkError("Received a snapshot without its baseline", __LINE__, __FILE__);
+		}
+	}
+	const SnapshotBaseline* reference = baseline.get();
+
+	if (isDelta)
+	{
+		next->m_Precision = baseline->m_Precision;
+	}
+	else if (updatesBaseline)
+	{
+		next->m_Precision.m_PositionSteps = reader.readFloat();
+		next->m_Precision.m_VelocitySteps = reader.readFloat();
+		next->m_Precision.m_RotationSteps = reader.readFloat();
+		next->m_Precision.m_RotationVelocitySteps = reader.readFloat();
+		for (unsigned int v = 0; v < numVectors; ++v)
+		{
+			if (!(getSteps(next->m_Precision, v) > 0.f))
+			{
+				throw NetworkError("Received a snapshot with an invalid precision", __LINE__, __FILE__);
+			}
+		}
+	}
+
+	// Every object needs at least five bits
+	if (reader.getBitsLeft() / 5 < numObjects)
+	{
+		throw NetworkError("Snapshot ended unexpectedly", __LINE__, __FILE__);
+	}
+	next->m_Objects.resize(numObjects);
+	p_Objects.resize(numObjects);
+
+	for (unsigned int i = 0; i < numObjects; ++i)
+	{
+		SnapshotBaseline::Object& object = next->m_Objects[i];
+
+		const SnapshotBaseline::Object* previous;
+		if (reader.readBit())
+		{
+			if (!reference || i >= reference->m_Objects.size())
+			{
+				throw NetworkError("Received a snapshot referring to a missing object", __LINE__, __FILE__);
+			}
+			previous = &reference->m_Objects[i];
+			object.m_Id = previous->m_Id;
+		}
+		else
+		{
+			object.m_Id = reader.read(32);
+			previous = findObject(reference, object.m_Id);
+		}
+
+		for (unsigned int v = 0; v < numVectors; ++v)
+		{
+			const bool changed = reader.readBit();
+			for (unsigned int c = v * 3; c < v * 3 + 3; ++c)
+			{
+				int32_t value = getPreviousValue(previous, c);
+				if (changed && reader.readBit())
+				{
+					value += unzigzag(reader.readVarUInt());
+				}
+				object.m_Values[c] = value;
+			}
+		}
+
+		UpdateObjectData& data = p_Objects[i];
+		data.m_Id = object.m_Id;
+		for (unsigned int v = 0; v < numVectors; ++v)
+		{
+			float* components = getComponents(data.*vectors[v]);
+			for (unsigned int c = 0; c < 3; ++c)
+			{
+				components[c] = dequantize(object.m_Values[v * 3 + c], getSteps(next->m_Precision, v));
+			}
+		}
+	}
+
+	const unsigned int numExtraData = reader.readCount();
+	if (reader.getBitsLeft() < numExtraData)
+	{
+		throw NetworkError("Snapshot ended unexpectedly", __LINE__, __FILE__);
+	}
+	p_ExtraData.resize(numExtraData);
+
+	for (unsigned int i = 0; i < numExtraData; ++i)
+	{
+		std::string& extraData = p_ExtraData[i];
+		if (reader.readBit())
+		{
+			if (!reference || i >= reference->m_ExtraData.size())
+			{
+				throw NetworkError("Received a snapshot referring to missing extra data", __LINE__, __FILE__);
+			}
+			extraData = reference->m_ExtraData[i];
+		}
+		else
+		{
+			const unsigned int length = reader.readCount();
+			if (reader.getBitsLeft() / 8 < length)
+			{
+				throw NetworkError("Snapshot ended unexpectedly", __LINE__, __FILE__);
+			}
+
+			extraData.resize(length);
+			for (unsigned int c = 0; c < length; ++c)
+			{
+				extraData[c] = (char)reader.read(8);
+			}
+		}
+	}
+
+	if (!updatesBaseline)
+	{
+		return nullptr;
+	}
+
+	next->m_ExtraData = p_ExtraData;
+	p_History.add(next);
+	return next;
+}
+
+bool SnapshotCodec::isNewer(uint32_t p_Id, uint32_t p_Other)
+{
+	return (int32_t)(p_Id - p_Other) > 0;
+}
+
+bool SnapshotCodec::isSamePrecision(const UpdateObjectPrecision& p_Left, const UpdateObjectPrecision& p_Right)
+{
+	return p_Left.m_PositionSteps == p_Right.m_PositionSteps
+		&& p_Left.m_VelocitySteps == p_Right.m_VelocitySteps
+		&& p_Left.m_RotationSteps == p_Right.m_RotationSteps
+		&& p_Left.m_RotationVelocitySteps == p_Right.m_RotationVelocitySteps;
+}
@@ -0,0 +1,140 @@
+/**
+ * File comment.
+ */
+
+#pragma once
+
+#include <CommonTypes.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * The object updates of a snapshot sent or received on a connection, as they were quantized.
+ * Later snapshots on the connection only encode how they differ from a baseline the receiver has.
+ */
+struct SnapshotBaseline
+{
+	/**
+	 * Baselines are shared by the connections that have been sent the same snapshots.
+	 */
+	typedef std::shared_ptr<const SnapshotBaseline> ptr;
+
+	/**
+	 * The quantized position, velocity, rotation and rotation velocity of an object.
+	 */
+	struct Object
+	{
+		uint32_t m_Id;
+		int32_t m_Values[12];
+	};
+
+	uint32_t m_Id;					// Identifies the snapshot to the receiver, never zero
+	UpdateObjectPrecision m_Precision;
+	std::vector<Object> m_Objects;
+	std::vector<std::string> m_ExtraData;
+};
+
+/**
+ * The most recent baselines received on a connection, looked up by the id
+ * that a snapshot refers to its baseline with.
+ */
+class SnapshotHistory
+{
+public:
+	/**
+	 * The number of baselines kept. A snapshot encoded against an older
+	 * baseline can not be decoded.
+	 */
+	static const unsigned int maxSnapshots = 32;
+
+private:
+	std::vector<SnapshotBaseline::ptr> m_Snapshots;	// Ring buffer, oldest replaced first
+	unsigned int m_Next;
+
+public:
+	/**
+	 * constructor.
+	 */
+	SnapshotHistory();
+
+	/**
+	 * Keep a baseline, forgetting the oldest one if the history is full.
+	 */
+	void add(SnapshotBaseline::ptr p_Baseline);
+
+	/**
+	 * Find a kept baseline.
+	 *
+	 * @param p_Id the id of the baseline
+	 * @return the baseline, or null if it is not kept
+	 */
+	SnapshotBaseline::ptr find(uint32_t p_Id) const;
+
+	/**
+	 * Forget all baselines.
+	 */
+	void clear();
+};
+
+/**
+ * Encodes Update Objects packages as bit-packed changes from a baseline snapshot.
+ *
+ * Every snapshot carries an id and the id of its baseline, so that it can be decoded
+ * whatever order it arrives in, as long as the receiver still has the baseline.
+ * Over an ordered connection the baseline is simply the previously sent snapshot.
+ * Over a transport that may lose snapshots, the receiver acknowledges the ids it
+ * decoded and the sender encodes against the last acknowledged snapshot, or in full
+ * until a snapshot has been acknowledged.
+ *
+ * Values are rounded to the precision of the sender. Only the values that changed
+ * after rounding are sent, and extra data strings are only sent when they changed.
+ * A snapshot without objects, such as one carrying only extra data, is encoded in
+ * full and leaves the baseline as it was.
+ */
+class SnapshotCodec
+{
+public:
+	/**
+	 * Encode a snapshot.
+	 *
+	 * @param p_Objects array of object updates
+	 * @param p_NumObjects the number of object updates in the array
+	 * @param p_ExtraData array of null-terminated extra data strings
+	 * @param p_NumExtraData the number of extra data strings
+	 * @param p_Precision the precision to round the updates to. Changing it sends a full snapshot.
+	 * @param p_Baseline a baseline the receiver has, or null to encode a full snapshot
+	 * @param p_Snapshot receives the encoded snapshot
+	 * @return the baseline of the receiver after it has decoded the snapshot, with a new id
+	 *			unless the snapshot has no objects and leaves the baseline as it was
+	 */
+	static SnapshotBaseline::ptr encode(const UpdateObjectData* p_Objects, unsigned int p_NumObjects,
+		const char** p_ExtraData, unsigned int p_NumExtraData, const UpdateObjectPrecision& p_Precision,
+		SnapshotBaseline::ptr p_Baseline, std::vector<uint8_t>& p_Snapshot);
+
+	/**
+	 * Decode a snapshot. Throws NetworkError if the snapshot is malformed
+	 * or its baseline is no longer in the history.
+	 *
+	 * @param p_Snapshot an encoded snapshot
+	 * @param p_Size the size of the snapshot in bytes
+	 * @param p_History the baselines received before, the snapshot is added to it if it has objects
+	 * @param p_Objects receives the object updates, rounded to the precision of the sender
+	 * @param p_ExtraData receives the extra data strings
+	 * @return the baseline decoded from the snapshot, whose id is acknowledged to the sender,
+	 *			or null if the snapshot has no objects
+	 */
+	static SnapshotBaseline::ptr decode(const uint8_t* p_Snapshot, size_t p_Size, SnapshotHistory& p_History,
+		std::vector<UpdateObjectData>& p_Objects, std::vector<std::string>& p_ExtraData);
+
+	/**
+	 * Check if a snapshot id is newer than another, allowing the ids to wrap around.
+	 */
+	static bool isNewer(uint32_t p_Id, uint32_t p_Other);
+
+	/**
+	 * Check if two precisions round every value the same.
+	 */
+	static bool isSamePrecision(const UpdateObjectPrecision& p_Left, const UpdateObjectPrecision& p_Right);
+};
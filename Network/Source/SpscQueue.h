@@ -0,0 +1,101 @@
+/**
+ * File comment.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+/**
+ * A bounded lock-free queue for passing values from one producer thread
+ * to one consumer thread.
+ *
+ * The consumer can access every value that has been made available to it
+ * in place, in the order they were pushed, before popping them.
+ *
+ * @param <T> the type of the values, default constructible and movable.
+ */
+template <typename T>
+class SpscQueue
+{
+private:
+	std::vector<T> m_Slots;
+	size_t m_Mask;
+
+	// The producer and consumer positions are on separate cache lines
+	char m_Padding0[64];
+	std::atomic<size_t> m_Head;		// Number of popped values, written by the consumer
+	char m_Padding1[64];
+	std::atomic<size_t> m_Tail;		// Number of pushed values, written by the producer
+	char m_Padding2[64];
+
+public:
+	/**
+	 * constructor.
+	 *
+	 * @param p_Capacity the maximum number of values in the queue, a power of two.
+	 */
+	explicit SpscQueue(size_t p_Capacity)
+		:	m_Slots(p_Capacity),
+			m_Mask(p_Capacity - 1),
+			m_Head(0),
+			m_Tail(0)
+	{
+	}
+
+	/**
+	 * Push a value. Only called by the producer.
+	 *
+	 * @param p_Value the value to push. It is left untouched if the queue is full.
+	 * @return true if the value was pushed, false if the queue is full.
+	 */
+	bool push(T& p_Value)
+	{
+		const size_t tail = m_Tail.load(std::memory_order_relaxed);
+		if (tail - m_Head.load(std::memory_order_acquire) == m_Slots.size())
+		{
+			return false;
+		}
+
+		m_Slots[tail & m_Mask] = std::move(p_Value);
+		m_Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Get the number of values that the consumer can access. Only called by the consumer.
+	 */
+	size_t getNumAvailable() const
+	{
+		return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Access an available value. Only called by the consumer.
+	 *
+	 * @param p_Index the index of the value counted from the oldest one,
+	 *			less than the last result of getNumAvailable.
+	 */
+	T& at(size_t p_Index)
+	{
+		return m_Slots[(m_Head.load(std::memory_order_relaxed) + p_Index) & m_Mask];
+	}
+
+	/**
+	 * Remove the oldest value and give its slot back to the producer.
+	 * Only called by the consumer, when a value is available.
+	 *
+	 * @param p_Value receives the removed value.
+	 */
+	void pop(T& p_Value)
+	{
+		const size_t head = m_Head.load(std::memory_order_relaxed);
+		p_Value = std::move(m_Slots[head & m_Mask]);
+		m_Head.store(head + 1, std::memory_order_release);
+	}
+
+private:
+	SpscQueue(const SpscQueue&);
+	SpscQueue& operator=(const SpscQueue&);
+};
@@ -0,0 +1,253 @@
+#include "UnreliableChannel.h"
+
+#include "NetworkLogger.h"
+
+#include <array>
+#include <cstring>
+
+using boost::asio::ip::udp;
+
+UnreliableChannel::UnreliableChannel(boost::asio::io_service& p_IO_Service, unsigned short p_Port)
+	:	m_Socket(p_IO_Service, udp::endpoint(udp::v4(), p_Port)),
+		m_HelloTimer(p_IO_Service),
+		m_IsClient(false),
+		m_TokenGenerator(std::random_device()()),
+		m_ReceiveBuffer(sizeof(Header) + maxPackageSize)
+{
+	NetworkLogger::log(NetworkLogger::Level::DEBUG_L, "Creating the unreliable channel of the server");
+}
+
+UnreliableChannel::UnreliableChannel(boost::asio::io_service& p_IO_Service, const udp::endpoint& p_Server)
+	:	m_Socket(p_IO_Service, udp::endpoint(udp::v4(), 0)),
+		m_HelloTimer(p_IO_Service),
+		m_IsClient(true),
+		m_ReceiveBuffer(sizeof(Header) + maxPackageSize)
+{
+	NetworkLogger::log(NetworkLogger::Level::DEBUG_L, "Creating an unreliable channel to the server");
+
+	m_Socket.connect(p_Server);
+}
+
+void UnreliableChannel::startReceiving()
+{
+	receive();
+}
+
+void UnreliableChannel::close()
+{
+	m_Socket.get_io_service().post(std::bind(&UnreliableChannel::handleClose, shared_from_this()));
+}
+
+uint32_t UnreliableChannel::addPeer(receiveFunction_t p_Receive)
+{
+	std::lock_guard<std::mutex> lock(m_PeerLock);
+
+	uint32_t token;
+	do
+	{
+		token = m_TokenGenerator();
+	} while (token == 0 || m_Peers.count(token) != 0);
+
+	Peer& peer = m_Peers[token];
+	peer.m_Receive = std::make_shared<receiveFunction_t>(std::move(p_Receive));
+	peer.m_HasEndpoint = false;
+	peer.m_HasReceived = false;
+
+	return token;
+}
+
+void UnreliableChannel::addPeer(uint32_t p_Token, receiveFunction_t p_Receive)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_PeerLock);
+
+		// The socket of a client is connected, so it already knows where to send
+		Peer& peer = m_Peers[p_Token];
+		peer.m_Receive = std::make_shared<receiveFunction_t>(std::move(p_Receive));
+		peer.m_HasEndpoint = true;
+		peer.m_HasReceived = false;
+	}
+
+	m_Socket.get_io_service().post(std::bind(&UnreliableChannel::handleHello, shared_from_this(), boost::system::error_code(), p_Token, 0u));
+}
+
+void UnreliableChannel::removePeer(uint32_t p_Token)
+{
+	std::lock_guard<std::mutex> receiveLock(m_ReceiveLock);
+	std::lock_guard<std::mutex> lock(m_PeerLock);
+	m_Peers.erase(p_Token);
+}
+
+bool UnreliableChannel::canSend(uint32_t p_Token)
+{
+	std::lock_guard<std::mutex> lock(m_PeerLock);
+	auto peer = m_Peers.find(p_Token);
+	return peer != m_Peers.end() && peer->second.m_HasReceived;
+}
+
+bool UnreliableChannel::send(uint32_t p_Token, uint32_t p_Sequence, uint16_t p_ID, const std::string& p_Data)
+{
+	if (p_Data.size() > maxPackageSize)
+	{
+		return false;
+	}
+
+	udp::endpoint endpoint;
+	{
+		std::lock_guard<std::mutex> lock(m_PeerLock);
+		auto peer = m_Peers.find(p_Token);
+		if (peer == m_Peers.end() || !peer->second.m_HasReceived)
+		{
+			return false;
+		}
+		endpoint = peer->second.m_Endpoint;
+	}
+
+	sendDatagram(p_Token, p_Sequence, p_ID, p_Data, endpoint);
+	return true;
+}
+
+void UnreliableChannel::setLossFunction(lossFunction_t p_Loss)
+{
+	std::lock_guard<std::mutex> lock(m_SendLock);
+	m_Loss = p_Loss;
+}
+
+void UnreliableChannel::sendDatagram(uint32_t p_Token, uint32_t p_Sequence, uint16_t p_ID, const std::string& p_Data,
+	const udp::endpoint& p_Endpoint)
+{
+	Header header;
+	header.m_Token = p_Token;
+	header.m_Sequence = p_Sequence;
+	header.m_TypeID = p_ID;
+
+	std::array<boost::asio::const_buffer, 2> buffers =
+	{{
+		boost::asio::buffer(&header, sizeof(header)),
+		boost::asio::buffer(p_Data)
+	}};
+
+	std::lock_guard<std::mutex> lock(m_SendLock);
+	if (m_Loss && m_Loss())
+	{
+		return;
+	}
+
+	// Failing to send is no different from the datagram being lost on the way
+	boost::system::error_code error;
+	if (m_IsClient)
+	{
+		m_Socket.send(buffers, 0, error);
+	}
+	else
+	{
+		m_Socket.send_to(buffers, p_Endpoint, 0, error);
+	}
+	if (error)
+	{
+		NetworkLogger::log(NetworkLogger::Level::TRACE, "Failed to send a datagram: " + error.message());
+	}
+}
+
+void UnreliableChannel::receive()
+{
+	m_Socket.async_receive_from(
+		boost::asio::buffer(m_ReceiveBuffer),
+		m_Sender,
+		std::bind(&UnreliableChannel::handleReceive, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+}
+
+void UnreliableChannel::handleReceive(const boost::system::error_code& p_Error, std::size_t p_BytesTransferred)
+{
+	if (p_Error == boost::asio::error::operation_aborted || !m_Socket.is_open())
+	{
+		return;
+	}
+
+	// Errors such as an unreachable client only concern a single datagram
+	if (p_Error)
+	{
+		NetworkLogger::log(NetworkLogger::Level::TRACE, "Failed to receive a datagram: " + p_Error.message());
+	}
+	else if (p_BytesTransferred >= sizeof(Header))
+	{
+		Header header;
+		std::memcpy(&header, m_ReceiveBuffer.data(), sizeof(Header));
+
+		// Sending and pairing may go on while the callback runs, only removing the peer waits for it
+		std::lock_guard<std::mutex> receiveLock(m_ReceiveLock);
+		std::shared_ptr<receiveFunction_t> receiveFunction;
+		{
+			std::lock_guard<std::mutex> lock(m_PeerLock);
+			auto peer = m_Peers.find(header.m_Token);
+			if (peer != m_Peers.end())
+			{
+				// The token could be overheard, so a peer can not be taken over from another endpoint
+				if (!m_IsClient && !peer->second.m_HasEndpoint)
+				{
+					peer->second.m_Endpoint = m_Sender;
+					peer->second.m_HasEndpoint = true;
+				}
+
+				if (m_IsClient || peer->second.m_Endpoint == m_Sender)
+				{
+					peer->second.m_HasReceived = true;
+					receiveFunction = peer->second.m_Receive;
+				}
+			}
+		}
+
+		if (receiveFunction)
+		{
+			if (header.m_TypeID == helloID)
+			{
+				if (!m_IsClient)
+				{
+					sendDatagram(header.m_Token, 0, helloID, std::string(), m_Sender);
+				}
+			}
+			else
+			{
+				m_ReceivedData.assign(m_ReceiveBuffer.data() + sizeof(Header), m_ReceiveBuffer.data() + p_BytesTransferred);
+				(*receiveFunction)(header.m_TypeID, header.m_Sequence, m_ReceivedData);
+			}
+		}
+	}
+
+	receive();
+}
+
+void UnreliableChannel::handleHello(const boost::system::error_code& p_Error, uint32_t p_Token, unsigned int p_NumSent)
+{
+	if (p_Error == boost::asio::error::operation_aborted || !m_Socket.is_open())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_PeerLock);
+		auto peer = m_Peers.find(p_Token);
+		if (peer == m_Peers.end() || peer->second.m_HasReceived)
+		{
+			return;
+		}
+	}
+
+	if (p_NumSent == maxHellos)
+	{
+		NetworkLogger::log(NetworkLogger::Level::INFO, "The server never answered, packages are sent over the connection only");
+		return;
+	}
+
+	sendDatagram(p_Token, 0, helloID, std::string(), udp::endpoint());
+
+	m_HelloTimer.expires_from_now(boost::posix_time::milliseconds((long)helloIntervalMs));
+	m_HelloTimer.async_wait(std::bind(&UnreliableChannel::handleHello, shared_from_this(), std::placeholders::_1, p_Token, p_NumSent + 1));
+}
+
+void UnreliableChannel::handleClose()
+{
+	boost::system::error_code error;
+	m_HelloTimer.cancel(error);
+	m_Socket.close(error);
+}
@@ -0,0 +1,201 @@
+/**
+ * File comment.
+ */
+
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * A UDP socket carrying sequenced, unreliable packages for connections
+ * that also have a reliable TCP connection.
+ *
+ * Each connection is a peer identified by a random token, which the server
+ * hands out over the reliable connection. The server has one channel for all
+ * clients and learns the endpoint of a client from the first datagram it sends.
+ * A client has a channel of its own, connected to the server.
+ *
+ * A client keeps sending hellos until the server answers one, so that packages
+ * only go over the channel once datagrams are known to get through both ways.
+ * Until then the connections use the reliable connection.
+ *
+ * Datagrams may be lost, duplicated or reordered. The receiver uses the
+ * sequence numbers to keep only the newest package of each type.
+ */
+class UnreliableChannel : public std::enable_shared_from_this<UnreliableChannel>
+{
+public:
+	/**
+	 * Shared pointer type for unreliable channels.
+	 */
+	typedef std::shared_ptr<UnreliableChannel> ptr;
+
+	/**
+	 * Callback type used to report that a package has been received from a peer.
+	 *
+	 * First argument is the id of the package. Second argument is the sequence
+	 * number given by the sender. Third argument is the package data, which
+	 * the callback may take by moving from it.
+	 */
+	typedef std::function<void(uint16_t, uint32_t, std::vector<char>&)> receiveFunction_t;
+
+	/**
+	 * Callback type deciding if a datagram about to be sent should be dropped,
+	 * used to test how the game behaves on a lossy network.
+	 */
+	typedef std::function<bool()> lossFunction_t;
+
+	/**
+	 * The largest package that is sent unreliably. Larger packages have to use
+	 * the reliable connection, so that datagrams are not fragmented.
+	 */
+	static const size_t maxPackageSize = 8192;
+
+	/**
+	 * The type of the hellos the channel exchanges itself, which are never passed to a peer.
+	 * The same as the reserved package type.
+	 */
+	static const uint16_t helloID = 0;
+
+	/**
+	 * How often a client repeats its hello, and how many it sends before giving up.
+	 */
+	static const unsigned int helloIntervalMs = 250;
+	static const unsigned int maxHellos = 40;
+
+private:
+#pragma pack(push, 1)
+	struct Header
+	{
+		uint32_t m_Token;
+		uint32_t m_Sequence;
+		uint16_t m_TypeID;
+	};
+#pragma pack(pop)
+
+	struct Peer
+	{
+		std::shared_ptr<receiveFunction_t> m_Receive;	// Shared so that taking it out of the lock does not copy the function
+		boost::asio::ip::udp::endpoint m_Endpoint;
+		bool m_HasEndpoint;
+		bool m_HasReceived;					// A datagram has arrived from the peer
+	};
+
+	boost::asio::ip::udp::socket m_Socket;
+	boost::asio::deadline_timer m_HelloTimer;
+	bool m_IsClient;
+
+	std::mutex m_ReceiveLock;				// Held while calling the callback of a peer, so that removePeer can wait for it
+	std::mutex m_PeerLock;
+	std::map<uint32_t, Peer> m_Peers;
+	std::mt19937 m_TokenGenerator;
+
+	std::mutex m_SendLock;
+	lossFunction_t m_Loss;
+
+	std::vector<char> m_ReceiveBuffer;
+	std::vector<char> m_ReceivedData;		// Handed to the peer, which may swap in a buffer of its own
+	boost::asio::ip::udp::endpoint m_Sender;
+
+public:
+	/**
+	 * constructor.
+	 *
+	 * Creates the channel of a server, receiving from all clients.
+	 *
+	 * @param p_IO_Service the io service to run the asynchronous operations on.
+	 * @param p_Port the port number to receive on, normally the same as the server accepts connections on.
+	 */
+	UnreliableChannel(boost::asio::io_service& p_IO_Service, unsigned short p_Port);
+
+	/**
+	 * constructor.
+	 *
+	 * Creates the channel of a client, exchanging datagrams with one server only.
+	 *
+	 * @param p_IO_Service the io service to run the asynchronous operations on.
+	 * @param p_Server the endpoint of the channel of the server.
+	 */
+	UnreliableChannel(boost::asio::io_service& p_IO_Service, const boost::asio::ip::udp::endpoint& p_Server);
+
+	/**
+	 * Start receiving datagrams. The channel is kept alive until it is closed.
+	 */
+	void startReceiving();
+
+	/**
+	 * Close the socket, stopping any outstanding receive. Safe to call from any thread.
+	 */
+	void close();
+
+	/**
+	 * Add a peer on the server, to be paired with a client.
+	 *
+	 * @param p_Receive callback for packages received from the peer.
+	 * @return a new token to give to the client over the reliable connection.
+	 */
+	uint32_t addPeer(receiveFunction_t p_Receive);
+
+	/**
+	 * Add the server as the peer of a client, and start sending hellos to it.
+	 *
+	 * @param p_Token the token the server gave the client.
+	 * @param p_Receive callback for packages received from the server.
+	 */
+	void addPeer(uint32_t p_Token, receiveFunction_t p_Receive);
+
+	/**
+	 * Remove a peer. When this returns, the callback of the peer is not called anymore.
+	 *
+	 * @param p_Token the token of the peer.
+	 */
+	void removePeer(uint32_t p_Token);
+
+	/**
+	 * Check if packages can be sent to a peer, which is once a datagram
+	 * has been received from it.
+	 *
+	 * @param p_Token the token of the peer.
+	 */
+	bool canSend(uint32_t p_Token);
+
+	/**
+	 * Send a package to a peer. Nothing tells if it arrives.
+	 *
+	 * @param p_Token the token of the peer.
+	 * @param p_Sequence the sequence number of the package, increasing for every package sent to the peer.
+	 * @param p_ID the type of the package.
+	 * @param p_Data the serialized package.
+	 * @return false if the package could not be sent, because nothing has been received
+	 *			from the peer yet or the package is larger than maxPackageSize.
+	 */
+	bool send(uint32_t p_Token, uint32_t p_Sequence, uint16_t p_ID, const std::string& p_Data);
+
+	/**
+	 * Drop outgoing datagrams on purpose.
+	 *
+	 * @param p_Loss called for every datagram about to be sent, returning true to drop it.
+	 *			Use the empty function to send every datagram.
+	 */
+	void setLossFunction(lossFunction_t p_Loss);
+
+private:
+	UnreliableChannel(const UnreliableChannel&);
+	UnreliableChannel& operator=(const UnreliableChannel&);
+
+	void sendDatagram(uint32_t p_Token, uint32_t p_Sequence, uint16_t p_ID, const std::string& p_Data,
+		const boost::asio::ip::udp::endpoint& p_Endpoint);
+	void receive();
+	void handleReceive(const boost::system::error_code& p_Error, std::size_t p_BytesTransferred);
+	void handleHello(const boost::system::error_code& p_Error, uint32_t p_Token, unsigned int p_NumSent);
+	void handleClose();
+};
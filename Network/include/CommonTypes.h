@@ -42,6 +42,7 @@ enum class PackageType : uint16_t
 	THROW_SPELL,
 	START_COUNTDOWN,
 	DONE_COUNTDOWN,
+	UNRELIABLE_CHANNEL,
 };
 
 struct ObjectInstance
@@ -59,6 +60,25 @@ struct UpdateObjectData
 	uint32_t m_Id;
 };
 
+/**
+ * How finely object updates are rounded before they are sent,
+ * as the number of steps per unit of each value.
+ */
+struct UpdateObjectPrecision
+{
+	float m_PositionSteps;			// Steps per cm
+	float m_VelocitySteps;			// Steps per cm/s
+	float m_RotationSteps;			// Steps per radian
+	float m_RotationVelocitySteps;	// Steps per radian/s
+
+	UpdateObjectPrecision()
+		:	m_PositionSteps(10.f),
+			m_VelocitySteps(10.f),
+			m_RotationSteps(2000.f),
+			m_RotationVelocitySteps(2000.f)
+	{}
+};
+
 struct PlayerControlData
 {
 	Vector3 m_Position;
@@ -32,6 +32,19 @@ public:
 	 */
 	virtual bool hasError() const = 0;
 
+	/**
+	 * Set how packages sent over the connection are gathered into single writes.
+	 *
+	 * Packages sent while a write is in flight are always gathered into the next write.
+	 * A delay also holds back the first package sent on an idle connection, to let the
+	 * packages that follow it join the same write, such as the burst when a level starts.
+	 *
+	 * @param p_MaxBytes the number of bytes that is written at most in one write,
+	 *			unless a single package is larger. Reaching it also ends the delay.
+	 * @param p_MaxDelayMs the longest time in milliseconds a package is held back, 0 to send it at once.
+	 */
+	virtual void setWriteBatching(unsigned int p_MaxBytes, unsigned int p_MaxDelayMs) = 0;
+
 	/**
 	 * Get the number of packages currently stored. Use with caution,
 	 * as it is updated asynchronously.
@@ -102,6 +115,38 @@ public:
 	 */
 	virtual void sendUpdateObjects(const UpdateObjectData* p_ObjectData, unsigned int p_NumObjects, const char** p_ExtraData, unsigned int p_NumExtraData) = 0;
 
+	/**
+	 * Set how finely the object updates sent on this connection are rounded.
+	 * Only the rounded values that changed since the previous Update Objects
+	 * package are sent. The default is 0.1 cm and 0.0005 radians.
+	 *
+	 * @param p_Precision the number of steps per unit of each value
+	 */
+	virtual void setUpdateObjectPrecision(const UpdateObjectPrecision& p_Precision) = 0;
+
+	/**
+	 * Send the same Update Objects package to several connections.
+	 *
+	 * The package is serialized once and every connection sends the same buffer,
+	 * instead of serializing a copy per connection as sendUpdateObjects would.
+	 * Connections that have been sent different updates before, such as a player
+	 * that just joined, are sent their own package.
+	 *
+	 * Connections with an open unreliable channel are sent the package over it instead,
+	 * which may be lost. It is encoded against the last package the client acknowledged
+	 * in its Player Control packages, or in full until it has acknowledged one.
+	 * Use sendUpdateObjects for updates that must arrive.
+	 *
+	 * @param p_Connections array of connections created by the network library
+	 * @param p_NumConnections the number of connections in the array
+	 * @param p_ObjectData array of object updates to send
+	 * @param p_NumObjects the number of object updates in the array
+	 * @param p_ExtraData array of null-terminated string with extra data
+	 * @param p_NumExtraData the number of extra data strings
+	 */
+	__declspec(dllexport) static void broadcastUpdateObjects(IConnectionController* const* p_Connections, unsigned int p_NumConnections,
+		const UpdateObjectData* p_ObjectData, unsigned int p_NumObjects, const char** p_ExtraData, unsigned int p_NumExtraData);
+
 	/**
 	 * Get the number of object updates in the package.
 	 *
@@ -199,10 +244,23 @@ public:
 	/**
 	 * Send a Player Control package, controlling the players object.
 	 *
+	 * The package is sent over the unreliable channel when it is open, so it may
+	 * be lost. A package older than one already received is dropped. It also
+	 * acknowledges the last update objects package received over the channel.
+	 *
 	 * @param p_Data the data to send
 	 */
 	virtual void sendPlayerControl(PlayerControlData p_Data) = 0;
 
+	/**
+	 * Check if the unreliable channel paired with the connection is open,
+	 * which is once a datagram has been received from the other side.
+	 * Until it is, all packages are sent over the reliable connection.
+	 *
+	 * @return true if state packages can be sent unreliably to the other side.
+	 */
+	virtual bool hasUnreliableChannel() = 0;
+
 	/**
 	 * Get the player control data from a package
 	 *
@@ -1,8 +1,32 @@
 #include "BVLoader.h"
+#include <cstring>
 #include <sstream>
 
-BVLoader::BVLoader(void)
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define INVALID_HANDLE_VALUE nullptr
+#endif
+
+BVLoader::BVLoader(void) :
+	m_File(INVALID_HANDLE_VALUE),
+	m_FileMapping(nullptr),
+	m_MappedView(nullptr),
+	m_MappedSize(0),
+	m_MappedCorners(nullptr),
+	m_MappedNodes(nullptr),
+	m_MappedTriangleIndices(nullptr),
+	m_NumMappedNodes(0),
+	m_NumMappedTriangleIndices(0)
 {
+	clearData();
 }
 
 
@@ -21,6 +45,28 @@ bool BVLoader::loadBinaryFile(std::string p_FilePath)
 {
 	clearData();
 
+	if(p_FilePath.length() >= 5 && p_FilePath.substr(p_FilePath.length() - 5, 5) == ".btxc")
+	{
+		return mapCollisionMesh(p_FilePath);
+	}
+
+	//Prefer a converted file next to the text file
+	if(p_FilePath.length() >= 4 && p_FilePath.substr(p_FilePath.length() - 4, 4) == ".txc")
+	{
+		std::string binaryPath = p_FilePath.substr(0, p_FilePath.length() - 3) + "btxc";
+		if(mapCollisionMesh(binaryPath))
+		{
+			return true;
+		}
+	}
+
+	return loadTextFile(p_FilePath);
+}
+
+bool BVLoader::loadTextFile(std::string p_FilePath)
+{
+	clearData();
+
 	//Pick out file extension
 	std::string type = p_FilePath.substr( p_FilePath.length() - 3, 3);
 
@@ -49,6 +95,193 @@ bool BVLoader::loadBinaryFile(std::string p_FilePath)
 	return true;
 }
 
+bool BVLoader::mapCollisionMesh(const std::string& p_FilePath)
+{
+	if(!mapFile(p_FilePath))
+	{
+		return false;
+	}
+
+	if(m_MappedSize < sizeof(CollisionMeshFormat::Header))
+	{
+		unmapFile();
+		return false;
+	}
+
+	const CollisionMeshFormat::Header& header = *(const CollisionMeshFormat::Header*)m_MappedView;
+	if(memcmp(header.magic, CollisionMeshFormat::fileMagic, sizeof(header.magic)) != 0 ||
+		header.version != CollisionMeshFormat::fileVersion ||
+		CollisionMeshFormat::getFileSize(header) != (uint64_t)m_MappedSize)
+	{
+		unmapFile();
+		return false;
+	}
+
+	const char* data = m_MappedView + sizeof(CollisionMeshFormat::Header);
+	m_MappedCorners = (const BoundingVolume*)data;
+	data += header.numTriangles * 3 * sizeof(BoundingVolume);
+
+	//A broken hierarchy is only a missed optimization, the triangles are still usable
+	if(header.numNodes > 0 && validateHierarchy(header))
+	{
+		m_MappedNodes = (const TriangleBVH::Node*)data;
+		m_NumMappedNodes = header.numNodes;
+		m_MappedTriangleIndices = (const unsigned int*)(data + header.numNodes * sizeof(TriangleBVH::Node));
+		m_NumMappedTriangleIndices = header.numTriangleIndices;
+	}
+
+	m_FileHeader.m_modelName.assign(header.meshName, strnlen(header.meshName, sizeof(header.meshName)));
+	m_FileHeader.m_numMaterial = 0;
+	m_FileHeader.m_numVertex = header.numTriangles * 3;
+	m_FileHeader.m_numFaces = header.numTriangles;
+
+	return true;
+}
+
+bool BVLoader::validateHierarchy(const CollisionMeshFormat::Header& p_Header) const
+{
+	if(p_Header.numTriangleIndices != p_Header.numTriangles)
+	{
+		return false;
+	}
+
+	const char* data = m_MappedView + sizeof(CollisionMeshFormat::Header) + p_Header.numTriangles * 3 * sizeof(BoundingVolume);
+	const TriangleBVH::Node* nodes = (const TriangleBVH::Node*)data;
+	const unsigned int* indices = (const unsigned int*)(data + p_Header.numNodes * sizeof(TriangleBVH::Node));
+
+	for(unsigned int i = 0; i < p_Header.numTriangleIndices; i++)
+	{
+		if(indices[i] >= p_Header.numTriangles)
+		{
+			return false;
+		}
+	}
+
+	//Children always come after their parent, so the depth of every node is known when it is reached
+	std::vector<unsigned int> depth(p_Header.numNodes, 0);
+	for(unsigned int i = 0; i < p_Header.numNodes; i++)
+	{
+		const TriangleBVH::Node& node = nodes[i];
+		if(depth[i] + 2 > TriangleBVH::maxDepth)
+		{
+			return false;
+		}
+
+		if(node.isLeaf())
+		{
+			if(node.first > p_Header.numTriangleIndices || node.count > p_Header.numTriangleIndices - node.first)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			if(i + 1 >= p_Header.numNodes || node.first <= i + 1 || node.first >= p_Header.numNodes)
+			{
+				return false;
+			}
+			depth[i + 1] = depth[i] + 1;
+			depth[node.first] = depth[i] + 1;
+		}
+	}
+
+	return true;
+}
+
+#ifdef _WIN32
+bool BVLoader::mapFile(const std::string& p_FilePath)
+{
+	m_File = CreateFileA(p_FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(m_File == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(m_File, &fileSize) || fileSize.QuadPart == 0)
+	{
+		unmapFile();
+		return false;
+	}
+
+	m_FileMapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(!m_FileMapping)
+	{
+		unmapFile();
+		return false;
+	}
+
+	m_MappedView = (const char*)MapViewOfFile(m_FileMapping, FILE_MAP_READ, 0, 0, 0);
+	if(!m_MappedView)
+	{
+		unmapFile();
+		return false;
+	}
+	m_MappedSize = (size_t)fileSize.QuadPart;
+
+	return true;
+}
+#else
+bool BVLoader::mapFile(const std::string& p_FilePath)
+{
+	const int file = open(p_FilePath.c_str(), O_RDONLY);
+	if(file == -1)
+	{
+		return false;
+	}
+
+	//The mapping stays valid after the file is closed
+	struct stat fileStat;
+	if(fstat(file, &fileStat) == 0 && fileStat.st_size > 0)
+	{
+		void* view = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if(view != MAP_FAILED)
+		{
+			m_MappedView = (const char*)view;
+			m_MappedSize = (size_t)fileStat.st_size;
+		}
+	}
+	close(file);
+
+	return m_MappedView != nullptr;
+}
+#endif
+
+void BVLoader::unmapFile()
+{
+#ifdef _WIN32
+	if(m_MappedView)
+	{
+		UnmapViewOfFile(m_MappedView);
+		m_MappedView = nullptr;
+	}
+	if(m_FileMapping)
+	{
+		CloseHandle(m_FileMapping);
+		m_FileMapping = nullptr;
+	}
+	if(m_File != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_File);
+		m_File = INVALID_HANDLE_VALUE;
+	}
+#else
+	if(m_MappedView)
+	{
+		munmap((void*)m_MappedView, m_MappedSize);
+		m_MappedView = nullptr;
+	}
+#endif
+	m_MappedSize = 0;
+
+	m_MappedCorners = nullptr;
+	m_MappedNodes = nullptr;
+	m_MappedTriangleIndices = nullptr;
+	m_NumMappedNodes = 0;
+	m_NumMappedTriangleIndices = 0;
+}
+
 void BVLoader::readHeader(std::istream* p_Input)
 {
 	Header tempHeader;
@@ -154,11 +387,57 @@ BVLoader::Header BVLoader::getLevelHeader()
 
 const std::vector<BVLoader::BoundingVolume>& BVLoader::getBoundingVolumes()
 {
+	if(m_MappedCorners && m_BoundingVolume.empty())
+	{
+		m_BoundingVolume.assign(m_MappedCorners, m_MappedCorners + getNumCorners());
+	}
+
 	return m_BoundingVolume;
 }
 
+const BVLoader::BoundingVolume* BVLoader::getCorners() const
+{
+	if(m_MappedCorners)
+	{
+		return m_MappedCorners;
+	}
+
+	return m_BoundingVolume.data();
+}
+
+unsigned int BVLoader::getNumCorners() const
+{
+	if(m_MappedCorners)
+	{
+		return m_FileHeader.m_numFaces * 3;
+	}
+
+	return m_BoundingVolume.size();
+}
+
+const TriangleBVH::Node* BVLoader::getBVHNodes() const
+{
+	return m_MappedNodes;
+}
+
+unsigned int BVLoader::getNumBVHNodes() const
+{
+	return m_NumMappedNodes;
+}
+
+const unsigned int* BVLoader::getBVHTriangleIndices() const
+{
+	return m_MappedTriangleIndices;
+}
+
+unsigned int BVLoader::getNumBVHTriangleIndices() const
+{
+	return m_NumMappedTriangleIndices;
+}
+
 void BVLoader::clearData()
 {
+	unmapFile();
 	m_FileHeader.m_modelName = "";
 	m_FileHeader.m_numFaces = 0;
 	m_FileHeader.m_numMaterial = 0;
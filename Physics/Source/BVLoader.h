@@ -1,4 +1,5 @@
 #pragma once
+#include "CollisionMeshFormat.h"
 #include <fstream>
 #include <DirectXMath.h>
 #include <vector>
@@ -23,16 +24,36 @@ public:
 private:	
 	std::vector<BoundingVolume> m_BoundingVolume;
 	Header m_FileHeader;
+
+	void* m_File;
+	void* m_FileMapping;
+	const char* m_MappedView;
+	size_t m_MappedSize;
+	const BoundingVolume* m_MappedCorners;
+	const TriangleBVH::Node* m_MappedNodes;
+	const unsigned int* m_MappedTriangleIndices;
+	unsigned int m_NumMappedNodes;
+	unsigned int m_NumMappedTriangleIndices;
+
 public:
 	BVLoader(void);
 	~BVLoader(void);
 
 	/**
-	 * Opens a binary file then reads the information stream and saves the information in vectors of structs.
+	 * Opens a bounding volume file. Binary .btxc files are mapped into memory and used
+	 * without parsing. For a text .txc file a .btxc file with the same name is used
+	 * if it exists, otherwise the text file is parsed.
 	 * 
 	 * @param p_FilePath, the absolut path to the source file.
 	 */
 	bool loadBinaryFile(std::string p_FilePath);
+
+	/**
+	 * Parses a text .txc file, ignoring any binary file with the same name.
+	 * 
+	 * @param p_FilePath, the absolut path to the source file.
+	 */
+	bool loadTextFile(std::string p_FilePath);
 	
 	/**
 	 * Use this function to de-allocate the memory in loader vectors.
@@ -52,6 +73,43 @@ public:
 	 * @returns a vector of the struct BoundingVolume.
 	 */
 	const std::vector<BVLoader::BoundingVolume>& getBoundingVolumes();
+
+	/**
+	 * Returns the corners of the loaded triangles, three per triangle, without copying them
+	 * out of a mapped file. Valid until the loader is cleared or loads another file.
+	 *
+	 * @returns a pointer to the first corner.
+	 */
+	const BVLoader::BoundingVolume* getCorners() const;
+
+	/**
+	 * @returns the number of corners returned by getCorners.
+	 */
+	unsigned int getNumCorners() const;
+
+	/**
+	 * Returns the nodes of a triangle hierarchy stored in a binary file.
+	 *
+	 * @returns a pointer to the first node, or nullptr if the file has no hierarchy.
+	 */
+	const TriangleBVH::Node* getBVHNodes() const;
+
+	/**
+	 * @returns the number of nodes returned by getBVHNodes.
+	 */
+	unsigned int getNumBVHNodes() const;
+
+	/**
+	 * Returns the triangle indices of a triangle hierarchy stored in a binary file.
+	 *
+	 * @returns a pointer to the first index, or nullptr if the file has no hierarchy.
+	 */
+	const unsigned int* getBVHTriangleIndices() const;
+
+	/**
+	 * @returns the number of indices returned by getBVHTriangleIndices.
+	 */
+	unsigned int getNumBVHTriangleIndices() const;
 	//void byteToInt(std::istream* p_Input, int& p_Return);
 	//void byteToString(std::istream* p_Input, std::string& p_Return);
 
@@ -60,4 +118,11 @@ public:
 
 private:
 	void clearData();
+	bool mapCollisionMesh(const std::string& p_FilePath);
+	bool mapFile(const std::string& p_FilePath);
+	bool validateHierarchy(const CollisionMeshFormat::Header& p_Header) const;
+	void unmapFile();
+
+	BVLoader(const BVLoader&);
+	BVLoader& operator=(const BVLoader&);
 };
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "Body.h"
 #include "PhysicsExceptions.h"
 
+#include <algorithm>
+
 using namespace DirectX;
 
 Body::BodyHandle Body::m_NextHandle = 1;
@@ -14,77 +16,88 @@ void Body::resetBodyHandleCounter()
 	m_NextHandle = 1;
 }
 
+Body::Body()
+	: m_Motion(nullptr),
+	  m_MotionRow(0)
+{
+}
+
 Body::Body(float p_mass, BoundingVolume::ptr p_BoundingVolume, bool p_IsImmovable, bool p_IsEdge)
-	: m_Handle(getNextHandle())
+	: m_Handle(getNextHandle()),
+	  m_OwnMotion(new MotionArrays)
 {
+	// All motion starts out zero
+	m_Motion = m_OwnMotion.get();
+	m_MotionRow = m_Motion->addRow();
+
 	if(!p_BoundingVolume)
-		m_Position = XMFLOAT4(0.f, 0.f, 0.f, 1.f);
+		motion(MotionArrays::POSITION_W) = 1.f;
 	else
 	{
 		m_Volumes.push_back(std::move(p_BoundingVolume));
 		m_Volumes.at(0)->setBodyHandle(m_Handle);
-		m_Position = m_Volumes.at(0)->getPosition();
+		const XMFLOAT4 position = m_Volumes.at(0)->getPosition();
+		storeMotion(MotionArrays::POSITION_X, position);
+		motion(MotionArrays::POSITION_W) = position.w;
 		updateSurroundingSphere(m_Volumes.back()->getSurroundingSphere());
 	}
-		
 
-	m_Mass				= p_mass;	
-	m_NetForce			= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-	m_Velocity			= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
+	motion(MotionArrays::MASS)		= p_mass;
+	motion(MotionArrays::AWAKE)		= 1.f;
 	m_Acceleration		= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-	m_LastAcceleration	= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-	m_AvgAcceleration	= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-	m_NewAcceleration	= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-	m_Gravity			= 0.f;
 	m_InAir				= true;
 	m_OnSomething		= false;
 	m_IsImmovable		= p_IsImmovable;
 	m_IsEdge			= p_IsEdge;
 	m_Landed			= false;
+	m_GroundContact		= false;
 
 	m_ForceCollisionNormal	= false;
+
+	m_RestTime			= 0.f;
+
+	storeMotion(MotionArrays::PREVIOUS_X, getPosition());
+	m_ContinuousCollision	= false;
 }
 
 Body::Body(Body &&p_Other)
 	: m_Handle(p_Other.m_Handle),
-	  m_Volumes(std::move(p_Other.m_Volumes)),
-	  m_Mass(p_Other.m_Mass),
-	  m_Position(p_Other.m_Position),
-	  m_NetForce(p_Other.m_NetForce),
-	  m_Velocity(p_Other.m_Velocity),
+	  m_SurroundingSphere(p_Other.m_SurroundingSphere),
+	  m_Motion(p_Other.m_Motion),
+	  m_MotionRow(p_Other.m_MotionRow),
+	  m_OwnMotion(std::move(p_Other.m_OwnMotion)),
 	  m_Acceleration(p_Other.m_Acceleration),
-	  m_LastAcceleration(p_Other.m_LastAcceleration),
-	  m_AvgAcceleration(p_Other.m_AvgAcceleration),
-	  m_NewAcceleration(p_Other.m_NewAcceleration),
-	  m_Gravity(p_Other.m_Gravity),
 	  m_InAir(p_Other.m_InAir),
 	  m_OnSomething(p_Other.m_OnSomething),
 	  m_IsImmovable(p_Other.m_IsImmovable),
 	  m_IsEdge(p_Other.m_IsEdge),
 	  m_Landed(p_Other.m_Landed),
+	  m_GroundContact(p_Other.m_GroundContact),
 	  m_ForceCollisionNormal(p_Other.m_ForceCollisionNormal),
-	  m_SurroundingSphere(p_Other.m_SurroundingSphere)
+	  m_RestTime(p_Other.m_RestTime),
+	  m_ContinuousCollision(p_Other.m_ContinuousCollision),
+	  m_Volumes(std::move(p_Other.m_Volumes)),
+	  m_SeparatingAxisCaches(std::move(p_Other.m_SeparatingAxisCaches))
 {}
 
 Body& Body::operator=(Body&& p_Other)
 {
 	std::swap(m_Handle, p_Other.m_Handle);
 	std::swap(m_Volumes, p_Other.m_Volumes);
-	std::swap(m_Mass, p_Other.m_Mass);
-	std::swap(m_Position, p_Other.m_Position);
-	std::swap(m_NetForce, p_Other.m_NetForce);
-	std::swap(m_Velocity, p_Other.m_Velocity);
+	std::swap(m_Motion, p_Other.m_Motion);
+	std::swap(m_MotionRow, p_Other.m_MotionRow);
+	std::swap(m_OwnMotion, p_Other.m_OwnMotion);
 	std::swap(m_Acceleration, p_Other.m_Acceleration);
-	std::swap(m_LastAcceleration, p_Other.m_LastAcceleration);
-	std::swap(m_AvgAcceleration, p_Other.m_AvgAcceleration);
-	std::swap(m_NewAcceleration, p_Other.m_NewAcceleration);
-	std::swap(m_Gravity, p_Other.m_Gravity);
 	std::swap(m_InAir, p_Other.m_InAir);
 	std::swap(m_OnSomething, p_Other.m_OnSomething);
 	std::swap(m_IsImmovable, p_Other.m_IsImmovable);
 	std::swap(m_IsEdge, p_Other.m_IsEdge);
 	std::swap(m_Landed, p_Other.m_Landed);
+	std::swap(m_GroundContact, p_Other.m_GroundContact);
 	std::swap(m_ForceCollisionNormal, p_Other.m_ForceCollisionNormal);
+	std::swap(m_RestTime, p_Other.m_RestTime);
+	std::swap(m_ContinuousCollision, p_Other.m_ContinuousCollision);
+	std::swap(m_SeparatingAxisCaches, p_Other.m_SeparatingAxisCaches);
 	std::swap(m_SurroundingSphere, p_Other.m_SurroundingSphere);
 
 	return *this;
@@ -94,26 +107,30 @@ Body::~Body()
 {
 }
 
-void Body::addForce(XMFLOAT4 p_Force)
+void Body::setHandle(BodyHandle p_Handle)
 {
-	XMVECTOR tempForce, tempNetForce;
-	tempForce = XMLoadFloat4(&p_Force);
-	tempNetForce = XMLoadFloat4(&m_NetForce);
+	m_Handle = p_Handle;
 
-	tempNetForce += tempForce;
+	for (auto& volume : m_Volumes)
+		volume->setBodyHandle(m_Handle);
+}
 
-	XMStoreFloat4(&m_NetForce, tempNetForce);
+void Body::addForce(XMFLOAT4 p_Force)
+{
+	motion(MotionArrays::NET_FORCE_X) += p_Force.x;
+	motion(MotionArrays::NET_FORCE_Y) += p_Force.y;
+	motion(MotionArrays::NET_FORCE_Z) += p_Force.z;
 }
 
 void Body::addImpulse(DirectX::XMFLOAT4 p_Impulse)
 {
-	if (m_Mass == 0.f)
+	const float mass = motion(MotionArrays::MASS);
+	if (mass == 0.f)
 		return;
 
-	XMVECTOR vVelocity = XMLoadFloat4(&m_Velocity);
-	XMVECTOR impulse = XMLoadFloat4(&p_Impulse);
-	vVelocity += impulse / m_Mass;
-	XMStoreFloat4(&m_Velocity, vVelocity);
+	motion(MotionArrays::VELOCITY_X) += p_Impulse.x / mass;
+	motion(MotionArrays::VELOCITY_Y) += p_Impulse.y / mass;
+	motion(MotionArrays::VELOCITY_Z) += p_Impulse.z / mass;
 }
 
 void Body::addVolume(BoundingVolume::ptr p_Volume)
@@ -126,84 +143,58 @@ void Body::addVolume(BoundingVolume::ptr p_Volume)
 
 void Body::update(float p_DeltaTime)
 {
-	if(m_IsImmovable)
+	if(m_IsImmovable || getIsSleeping())
 		return;
 
-	m_LastAcceleration = m_AvgAcceleration;
-
-	XMFLOAT4 relativePos = XMFLOAT4(0.f, 0.f, 0.f, 0.f);	// cm
-
-	relativePos.x = m_Velocity.x * p_DeltaTime + (0.5f * m_LastAcceleration.x * (p_DeltaTime*p_DeltaTime));
-	relativePos.y = m_Velocity.y * p_DeltaTime + (0.5f * m_LastAcceleration.y * (p_DeltaTime*p_DeltaTime));
-	relativePos.z = m_Velocity.z * p_DeltaTime + (0.5f * m_LastAcceleration.z * (p_DeltaTime*p_DeltaTime));
-
-	m_Position.x += relativePos.x;
-	m_Position.y += relativePos.y;
-	m_Position.z += relativePos.z;
-
-	m_NewAcceleration = calculateAcceleration();
-
-	XMVECTOR tempAvg, tempNew, tempLast;	// m/s^2
-	tempAvg = XMVectorSet(0.f, 0.f, 0.f, 0.f);
-	
-	tempNew = XMLoadFloat4(&m_NewAcceleration);
-	tempLast = XMLoadFloat4(&m_LastAcceleration);
-
-	tempAvg = (tempLast + tempNew) * 0.5f;
+	m_Motion->integrate(m_MotionRow, m_MotionRow + 1, p_DeltaTime);
+	applyIntegratedMotion();
+}
 
-	XMStoreFloat4(&m_AvgAcceleration, tempAvg);
+void Body::applyIntegratedMotion()
+{
+	const XMFLOAT4 translation = loadMotion(MotionArrays::TRANSLATION_X, 0.f);
+	translateVolumes(XMLoadFloat4(&translation));
+}
 
-	m_Velocity.x += m_AvgAcceleration.x * p_DeltaTime;
-	m_Velocity.y += m_AvgAcceleration.y * p_DeltaTime;
-	m_Velocity.z += m_AvgAcceleration.z * p_DeltaTime;
+void Body::moveMotion(MotionArrays& p_Motion, size_t p_Row)
+{
+	p_Motion.copyRow(p_Row, *m_Motion, m_MotionRow);
+	m_Motion = &p_Motion;
+	m_MotionRow = p_Row;
+	m_OwnMotion.reset();
+}
 
-	updateBoundingVolumePosition(relativePos);
+void Body::setMotionRow(size_t p_Row)
+{
+	m_MotionRow = p_Row;
 }
 
 void Body::updateBoundingVolumePosition(DirectX::XMFLOAT4 p_Position)
 {
-	XMMATRIX matTrans = XMMatrixTranslation(p_Position.x, p_Position.y, p_Position.z);
-	XMFLOAT4X4 tempTrans;
-
-	XMStoreFloat4x4(&tempTrans, matTrans);
-
-	for(auto &v : m_Volumes)
-		v->updatePosition(tempTrans);
-
-	m_SurroundingSphere.setPosition(XMLoadFloat4(&m_Position));
+	translateVolumes(XMLoadFloat4(&p_Position));
 }
 
-XMFLOAT4 Body::calculateAcceleration()
+void Body::translateVolumes(DirectX::FXMVECTOR p_Translation)
 {
-	XMFLOAT4 acc;	// m/s^2
-
-	if(m_Mass == 0)
-	{
-		return XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-	}
-	else
-	{
-		acc.x = m_NetForce.x/m_Mass;
-		acc.y = m_NetForce.y/m_Mass - m_Gravity;
-		acc.z = m_NetForce.z/m_Mass;
-	}
-
+	for(auto &v : m_Volumes)
+		v->translate(p_Translation);
 
-	acc.w = 0.f;
-	return acc;
+	const XMFLOAT4 position = getPosition();
+	m_SurroundingSphere.setPosition(XMLoadFloat4(&position));
 }
 
 void Body::updateSurroundingSphere(const Sphere* p_ChangedVolumeSphere)
 {
-	m_SurroundingSphere.setPosition(XMLoadFloat4(&m_Position));
+	const XMFLOAT4 position = getPosition();
+	m_SurroundingSphere.setPosition(XMLoadFloat4(&position));
 	const float currentRadius = m_SurroundingSphere.getRadius();
 	const float changedRadius = p_ChangedVolumeSphere->getRadius();
 	
 	const XMFLOAT4 changedSpherePos = p_ChangedVolumeSphere->getPosition();
 	const XMFLOAT3 diffPos(
-		m_Position.x - changedSpherePos.x,
-		m_Position.y - changedSpherePos.y,
-		m_Position.z - changedSpherePos.z);
+		position.x - changedSpherePos.x,
+		position.y - changedSpherePos.y,
+		position.z - changedSpherePos.z);
 
 	const float diffSq = diffPos.x * diffPos.x + diffPos.y * diffPos.y + diffPos.z * diffPos.z;
 	const float diff = sqrtf(diffSq);
@@ -216,7 +207,7 @@ void Body::updateSurroundingSphere(const Sphere* p_ChangedVolumeSphere)
 
 void Body::setGravity(float p_Gravity)
 {
-	m_Gravity = p_Gravity;
+	motion(MotionArrays::GRAVITY) = p_Gravity;
 }
 
 bool Body::getInAir()
@@ -255,6 +246,16 @@ void Body::setLanded(bool p_bool)
 	m_Landed = p_bool;
 }
 
+bool Body::getGroundContact() const
+{
+	return m_GroundContact;
+}
+
+void Body::setGroundContact(bool p_bool)
+{
+	m_GroundContact = p_bool;
+}
+
 bool Body::getIsImmovable() const
 {
 	return m_IsImmovable;
@@ -311,55 +312,56 @@ void Body::setVolumePosition(unsigned p_Volume, DirectX::XMVECTOR const &p_Posit
 
 XMFLOAT4 Body::getVelocity()
 {
-	return m_Velocity;
+	return loadMotion(MotionArrays::VELOCITY_X, 0.f);
 }
 
 void Body::setVelocity(XMFLOAT4 p_Velocity)
 {
-	m_Velocity.x = p_Velocity.x;
-	m_Velocity.y = p_Velocity.y;
-	m_Velocity.z = p_Velocity.z;
+	storeMotion(MotionArrays::VELOCITY_X, p_Velocity);
 }
 
 XMFLOAT4 Body::getPosition()
 {
-	return m_Position;
+	return loadMotion(MotionArrays::POSITION_X, motion(MotionArrays::POSITION_W));
 }
 
 void Body::setPosition(XMFLOAT4 p_Position)
 {
-	XMFLOAT4 diffPos(p_Position.x - m_Position.x, p_Position.y - m_Position.y, p_Position.z - m_Position.z, p_Position.w - m_Position.w);
-	m_Position = p_Position;
+	const XMFLOAT4 position = getPosition();
+	XMFLOAT4 diffPos(p_Position.x - position.x, p_Position.y - position.y, p_Position.z - position.z, p_Position.w - position.w);
+	storeMotion(MotionArrays::POSITION_X, p_Position);
+	motion(MotionArrays::POSITION_W) = p_Position.w;
 	updateBoundingVolumePosition(diffPos);
 }
 
 DirectX::XMFLOAT4 Body::getNetForce()
 {
-	return m_NetForce;
+	return loadMotion(MotionArrays::NET_FORCE_X, 0.f);
 }
 
 DirectX::XMFLOAT4 Body::getACC()
 {
-	return m_NewAcceleration;
+	return loadMotion(MotionArrays::NEW_ACC_X, 0.f);
 }
 
 float Body::getGravity() const
 {
-	return m_Gravity;
+	return motion(MotionArrays::GRAVITY);
 }
 
 DirectX::XMFLOAT4 Body::getLastACC()
 {
-	return m_LastAcceleration;
+	return loadMotion(MotionArrays::LAST_ACC_X, 0.f);
 }
 
 void Body::resetForce()
 {
-	m_NetForce			= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-	m_Velocity			= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-	m_Acceleration		= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-	m_AvgAcceleration	= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-	m_NewAcceleration	= XMFLOAT4(0.f, 0.f, 0.f, 0.f);
+	const XMFLOAT4 zero(0.f, 0.f, 0.f, 0.f);
+	storeMotion(MotionArrays::NET_FORCE_X, zero);
+	storeMotion(MotionArrays::VELOCITY_X, zero);
+	storeMotion(MotionArrays::AVG_ACC_X, zero);
+	storeMotion(MotionArrays::NEW_ACC_X, zero);
+	m_Acceleration		= zero;
 }
 
 void Body::setForceCollisionNormal(bool p_Bool)
@@ -375,3 +377,136 @@ const Sphere* Body::getSurroundingSphere() const
 {
 	return getVolume()->getSurroundingSphere();
 }
+
+bool Body::getIsSleeping() const
+{
+	return motion(MotionArrays::AWAKE) == 0.f;
+}
+
+void Body::sleep()
+{
+	motion(MotionArrays::AWAKE) = 0.f;
+	storeMotion(MotionArrays::VELOCITY_X, XMFLOAT4(0.f, 0.f, 0.f, 0.f));
+}
+
+void Body::wake()
+{
+	motion(MotionArrays::AWAKE) = 1.f;
+	m_RestTime = 0.f;
+}
+
+float Body::getRestTime() const
+{
+	return m_RestTime;
+}
+
+void Body::setRestTime(float p_RestTime)
+{
+	m_RestTime = p_RestTime;
+}
+
+DirectX::XMFLOAT4 Body::getPreviousPosition() const
+{
+	return loadMotion(MotionArrays::PREVIOUS_X, motion(MotionArrays::POSITION_W));
+}
+
+bool Body::getContinuousCollision() const
+{
+	return m_ContinuousCollision;
+}
+
+void Body::setContinuousCollision(bool p_Enabled)
+{
+	m_ContinuousCollision = p_Enabled;
+}
+
+SeparatingAxisCache* Body::getSeparatingAxisCache(BodyHandle p_Victim, unsigned int p_Volume, unsigned int p_VictimVolume, unsigned int p_Step)
+{
+	// A body is only near a few other volumes at a time, so a linear search is enough
+	for (auto& pair : m_SeparatingAxisCaches)
+	{
+		if (pair.victim == p_Victim && pair.volume == p_Volume && pair.victimVolume == p_VictimVolume)
+		{
+			pair.lastStep = p_Step;
+			return &pair.cache;
+		}
+	}
+
+	CachedVolumePair pair;
+	pair.victim = p_Victim;
+	pair.volume = p_Volume;
+	pair.victimVolume = p_VictimVolume;
+	pair.lastStep = p_Step;
+	m_SeparatingAxisCaches.push_back(pair);
+
+	return &m_SeparatingAxisCaches.back().cache;
+}
+
+void Body::evictSeparatingAxisCaches(unsigned int p_Step)
+{
+	m_SeparatingAxisCaches.erase(std::remove_if(m_SeparatingAxisCaches.begin(), m_SeparatingAxisCaches.end(),
+		[p_Step] (const CachedVolumePair& p_Pair) { return p_Pair.lastStep != p_Step; }),
+		m_SeparatingAxisCaches.end());
+}
+
+void Body::saveState(BodyState& p_State) const
+{
+	p_State.handle				= m_Handle;
+	p_State.position			= loadMotion(MotionArrays::POSITION_X, motion(MotionArrays::POSITION_W));
+	p_State.velocity			= loadMotion(MotionArrays::VELOCITY_X, 0.f);
+	p_State.netForce			= loadMotion(MotionArrays::NET_FORCE_X, 0.f);
+	p_State.acceleration		= m_Acceleration;
+	p_State.lastAcceleration	= loadMotion(MotionArrays::LAST_ACC_X, 0.f);
+	p_State.avgAcceleration		= loadMotion(MotionArrays::AVG_ACC_X, 0.f);
+	p_State.newAcceleration		= loadMotion(MotionArrays::NEW_ACC_X, 0.f);
+	p_State.restTime			= m_RestTime;
+	p_State.inAir				= m_InAir;
+	p_State.onSomething			= m_OnSomething;
+	p_State.landed				= m_Landed;
+	p_State.groundContact		= m_GroundContact;
+	p_State.sleeping			= getIsSleeping();
+}
+
+void Body::loadState(const BodyState& p_State)
+{
+	setPosition(p_State.position);
+	storeMotion(MotionArrays::PREVIOUS_X, p_State.position);
+	storeMotion(MotionArrays::VELOCITY_X, p_State.velocity);
+	storeMotion(MotionArrays::NET_FORCE_X, p_State.netForce);
+	m_Acceleration		= p_State.acceleration;
+	storeMotion(MotionArrays::LAST_ACC_X, p_State.lastAcceleration);
+	storeMotion(MotionArrays::AVG_ACC_X, p_State.avgAcceleration);
+	storeMotion(MotionArrays::NEW_ACC_X, p_State.newAcceleration);
+	m_RestTime			= p_State.restTime;
+	m_InAir				= p_State.inAir;
+	m_OnSomething		= p_State.onSomething;
+	m_Landed			= p_State.landed;
+	m_GroundContact		= p_State.groundContact;
+	motion(MotionArrays::AWAKE)	= p_State.sleeping ? 0.f : 1.f;
+}
+
+float& Body::motion(MotionArrays::Column p_Column)
+{
+	return m_Motion->at(p_Column, m_MotionRow);
+}
+
+float Body::motion(MotionArrays::Column p_Column) const
+{
+	return m_Motion->at(p_Column, m_MotionRow);
+}
+
+XMFLOAT4 Body::loadMotion(MotionArrays::Column p_X, float p_W) const
+{
+	return XMFLOAT4(
+		m_Motion->at(p_X, m_MotionRow),
+		m_Motion->at((MotionArrays::Column)(p_X + 1), m_MotionRow),
+		m_Motion->at((MotionArrays::Column)(p_X + 2), m_MotionRow),
+		p_W);
+}
+
+void Body::storeMotion(MotionArrays::Column p_X, const XMFLOAT4& p_Value)
+{
+	m_Motion->at(p_X, m_MotionRow) = p_Value.x;
+	m_Motion->at((MotionArrays::Column)(p_X + 1), m_MotionRow) = p_Value.y;
+	m_Motion->at((MotionArrays::Column)(p_X + 2), m_MotionRow) = p_Value.z;
+}
@@ -1,10 +1,35 @@
 #pragma once
 #include <DirectXMath.h>
 #include "BoundingVolume.h"
+#include "MotionArrays.h"
+#include "SeparatingAxisCache.h"
 #include <Sphere.h>
 
+#include <memory>
 #include <vector>
 
+/**
+ * The simulated state of a movable body, everything a step changes.
+ * Volumes and geometry are not included, a body keeps its own.
+ */
+struct BodyState
+{
+	BodyHandle			handle;
+	DirectX::XMFLOAT4	position;			// m
+	DirectX::XMFLOAT4	velocity;			// m/s
+	DirectX::XMFLOAT4	netForce;			// kg*m/s^2
+	DirectX::XMFLOAT4	acceleration;		// m/s^2
+	DirectX::XMFLOAT4	lastAcceleration;	// m/s^2
+	DirectX::XMFLOAT4	avgAcceleration;	// m/s^2
+	DirectX::XMFLOAT4	newAcceleration;	// m/s^2
+	float				restTime;			// s
+	bool				inAir;
+	bool				onSomething;
+	bool				landed;
+	bool				groundContact;
+	bool				sleeping;
+};
+
 class Body
 {
 protected:
@@ -17,25 +42,29 @@ protected:
 	BodyHandle m_Handle;
 	Sphere m_SurroundingSphere;
 
-	DirectX::XMFLOAT4	m_NetForce;			// kg*m/s^2
-	DirectX::XMFLOAT4	m_Position;			// m
-	DirectX::XMFLOAT4	m_Velocity;			// m/s
+	// Position, velocity, forces, mass, gravity and sleeping are kept in a row of the motion
+	// arrays, owned by the body until it is added to a storage that integrates many bodies at once
+	MotionArrays*		m_Motion;
+	size_t				m_MotionRow;
+	std::unique_ptr<MotionArrays> m_OwnMotion;
+
 	DirectX::XMFLOAT4	m_Acceleration;		// m/s^2
-	DirectX::XMFLOAT4	m_LastAcceleration;	// m/s^2
-	DirectX::XMFLOAT4	m_AvgAcceleration;	// m/s^2
-	DirectX::XMFLOAT4	m_NewAcceleration;	// m/s^2
-	float				m_Mass;				// kg
-	float				m_Gravity;			// m/s^2
 	bool				m_InAir;
 	bool				m_OnSomething;
 
 	bool				m_IsImmovable;
 	bool				m_IsEdge;
 	bool				m_Landed;
+	bool				m_GroundContact;
 
 	bool				m_ForceCollisionNormal;
 
+	float				m_RestTime;			// s
+
+	bool				m_ContinuousCollision;
+
 	std::vector<BoundingVolume::ptr> m_Volumes;
+	std::vector<CachedVolumePair> m_SeparatingAxisCaches;
 public:
 	/**
 	* Body Constructor, initialize all variables.
@@ -54,7 +83,7 @@ public:
 	 */
 	Body& operator=(Body&& p_Other);
 	
-	Body(){};
+	Body();
 	~Body();
 
 	/**
@@ -75,9 +104,27 @@ public:
 	* Update loop for a body. Updates acceleration, velocity and position.
 	*/
 	void update(float p_DeltaTime);
+	/**
+	 * Move the volumes of the body by the translation of its last integration.
+	 * Used after the motion arrays have integrated many bodies as one batch.
+	 */
+	void applyIntegratedMotion();
+	/**
+	 * Copy the motion of the body to a row of other arrays and keep it there from now on.
+	 *
+	 * @param p_Motion the arrays to keep the motion in, must outlive the body
+	 * @param p_Row the row of the body in the arrays
+	 */
+	void moveMotion(MotionArrays& p_Motion, size_t p_Row);
+	/**
+	 * Tell the body that its row in the motion arrays has been moved.
+	 *
+	 * @param p_Row the new row of the body
+	 */
+	void setMotionRow(size_t p_Row);
 	/**
 	* Updates the body's BoundingVolumes position with relative coordinates.
-	* @p_Position, relative position in cm.
+	* @p_Position, relative position in m.
 	*/
 	virtual void updateBoundingVolumePosition(DirectX::XMFLOAT4 p_Position);
 	/**
@@ -118,6 +165,16 @@ public:
 	* @p_Bool, sets the bool to this parameter.
 	*/
 	void setLanded(bool p_Bool);
+	/**
+	* Get the bool for if the body has touched ground during the current step.
+	* @return true if a collision this step pushed the body upwards, otherwise false.
+	*/
+	bool getGroundContact() const;
+	/**
+	* Sets the bool for if the body has touched ground during the current step.
+	* @p_Bool, sets the bool to this parameter.
+	*/
+	void setGroundContact(bool p_Bool);
 
 	/**
 	* Is the body immovable(static)?
@@ -206,6 +263,11 @@ public:
 	* @return m_Handle;
 	*/
 	virtual BodyHandle getHandle() const { return m_Handle; }
+	/**
+	* Give the body a new handle, also used by all its volumes.
+	* @p_Handle, the new handle.
+	*/
+	void setHandle(BodyHandle p_Handle);
 	/*
 	* reset the BodyHandleCounter. Only use when clearing the body list in physics
 	*/
@@ -230,11 +292,93 @@ public:
 
 	const Sphere* getSurroundingSphere() const;
 
+	/**
+	 * Check if the body has been put to sleep, sleeping bodies are not simulated.
+	 *
+	 * @return true if the body is sleeping, otherwise false
+	 */
+	bool getIsSleeping() const;
+	/**
+	 * Stop simulating the body until it is woken. The velocity is cleared.
+	 */
+	void sleep();
+	/**
+	 * Start simulating the body again.
+	 */
+	void wake();
+	/**
+	 * Get how long the body has been moving slowly enough to be put to sleep.
+	 *
+	 * @return the time in seconds
+	 */
+	float getRestTime() const;
+	/**
+	 * Set how long the body has been moving slowly enough to be put to sleep.
+	 *
+	 * @param p_RestTime the time in seconds
+	 */
+	void setRestTime(float p_RestTime);
+
+	/**
+	 * Get the position of the body before it was last updated.
+	 *
+	 * @return the position in m
+	 */
+	DirectX::XMFLOAT4 getPreviousPosition() const;
+	/**
+	 * Check if the movement of the body is swept against the static geometry every step.
+	 *
+	 * @return true if continuous collision is used, otherwise false
+	 */
+	bool getContinuousCollision() const;
+	/**
+	 * Sweep the movement of the body against the static geometry every step,
+	 * so that fast bodies can not pass through thin geometry.
+	 *
+	 * @param p_Enabled true to use continuous collision
+	 */
+	void setContinuousCollision(bool p_Enabled);
+
+	/**
+	 * Get the separating axis cache for a pair of volumes, creating it if the pair has none.
+	 *
+	 * @param p_Victim the body the other volume belongs to
+	 * @param p_Volume the index of the volume in this body
+	 * @param p_VictimVolume the index of the volume in the other body
+	 * @param p_Step the current step, marks the cache as used
+	 * @return the cache of the pair, valid until the caches of this body are changed
+	 */
+	SeparatingAxisCache* getSeparatingAxisCache(BodyHandle p_Victim, unsigned int p_Volume, unsigned int p_VictimVolume, unsigned int p_Step);
+	/**
+	 * Remove the separating axis caches of the pairs that were not tested in a step.
+	 *
+	 * @param p_Step the step to keep the caches of
+	 */
+	void evictSeparatingAxisCaches(unsigned int p_Step);
+
+	/**
+	 * Copy the simulated state of the body.
+	 *
+	 * @param p_State set to the current state
+	 */
+	void saveState(BodyState& p_State) const;
+	/**
+	 * Return the body to a saved state, moving its volumes along.
+	 *
+	 * @param p_State a state saved from this body
+	 */
+	void loadState(const BodyState& p_State);
+
 private:
+	float& motion(MotionArrays::Column p_Column);
+	float motion(MotionArrays::Column p_Column) const;
+	DirectX::XMFLOAT4 loadMotion(MotionArrays::Column p_X, float p_W) const;
+	void storeMotion(MotionArrays::Column p_X, const DirectX::XMFLOAT4& p_Value);
 	/**
-	 * Calculates the new acceleration in m/s^2.
+	 * Move all volumes and the surrounding sphere.
+	 * @p_Translation, the relative movement in m.
 	 */
-	DirectX::XMFLOAT4 calculateAcceleration();
+	void translateVolumes(DirectX::FXMVECTOR p_Translation);
 	void addGravity();
 
 	void updateSurroundingSphere(const Sphere* p_ChangedVolumeSphere);
@@ -0,0 +1,182 @@
+#include "BodyStorage.h"
+#include "PhysicsExceptions.h"
+
+#include <utility>
+
+BodyStorage::BodyStorage() :
+	m_NumMovable(0)
+{
+}
+
+void BodyStorage::clear()
+{
+	m_Bodies.clear();
+	m_Motion.clear();
+	m_DenseToSlot.clear();
+	m_FreeSlots.clear();
+	m_NumMovable = 0;
+
+	// Free the slots in reverse order so that the lowest slots are reused first
+	for (size_t i = m_Slots.size(); i > 0; --i)
+	{
+		Slot& slot = m_Slots[i - 1];
+		if (slot.used)
+		{
+			slot.used = false;
+			slot.generation = (slot.generation + 1) & generationMask;
+		}
+		m_FreeSlots.push_back((unsigned int)(i - 1));
+	}
+}
+
+void BodyStorage::reserve(size_t p_NumBodies)
+{
+	m_Bodies.reserve(p_NumBodies);
+	m_Motion.reserve(p_NumBodies);
+	m_DenseToSlot.reserve(p_NumBodies);
+	m_Slots.reserve(p_NumBodies);
+}
+
+BodyStorage::BodyHandle BodyStorage::add(Body&& p_Body)
+{
+	unsigned int slotIndex;
+	if (!m_FreeSlots.empty())
+	{
+		slotIndex = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+	}
+	else
+	{
+		if (m_Slots.size() >= maxBodies)
+			throw PhysicsException("Error! Too many bodies in the physics world!", __LINE__, __FILE__);
+
+		slotIndex = (unsigned int)m_Slots.size();
+		Slot newSlot = { 0, 0, false };
+		m_Slots.push_back(newSlot);
+	}
+
+	Slot& slot = m_Slots[slotIndex];
+	slot.used = true;
+	slot.denseIndex = (unsigned int)m_Bodies.size();
+
+	const BodyHandle handle = makeHandle(slotIndex, slot.generation);
+	const bool isMovable = !p_Body.getIsImmovable();
+
+	p_Body.setHandle(handle);
+	p_Body.moveMotion(m_Motion, m_Motion.addRow());
+	m_Bodies.push_back(std::move(p_Body));
+	m_DenseToSlot.push_back(slotIndex);
+
+	if (isMovable)
+	{
+		swapDense(slot.denseIndex, m_NumMovable);
+		++m_NumMovable;
+	}
+
+	return handle;
+}
+
+bool BodyStorage::remove(BodyHandle p_Body)
+{
+	const Slot* foundSlot = findSlot(p_Body);
+	if (!foundSlot)
+		return false;
+
+	const unsigned int slotIndex = (p_Body & indexMask) - 1;
+	size_t denseIndex = foundSlot->denseIndex;
+
+	// Keep the movable bodies packed by first moving the body to the end of the movable range
+	if (denseIndex < m_NumMovable)
+	{
+		--m_NumMovable;
+		swapDense(denseIndex, m_NumMovable);
+		denseIndex = m_NumMovable;
+	}
+
+	swapDense(denseIndex, m_Bodies.size() - 1);
+	m_Bodies.pop_back();
+	m_Motion.popRow();
+	m_DenseToSlot.pop_back();
+
+	Slot& slot = m_Slots[slotIndex];
+	slot.used = false;
+	slot.generation = (slot.generation + 1) & generationMask;
+	m_FreeSlots.push_back(slotIndex);
+
+	return true;
+}
+
+Body* BodyStorage::find(BodyHandle p_Body)
+{
+	const Slot* slot = findSlot(p_Body);
+	if (!slot)
+		return nullptr;
+
+	return &m_Bodies[slot->denseIndex];
+}
+
+const Body* BodyStorage::find(BodyHandle p_Body) const
+{
+	const Slot* slot = findSlot(p_Body);
+	if (!slot)
+		return nullptr;
+
+	return &m_Bodies[slot->denseIndex];
+}
+
+size_t BodyStorage::size() const
+{
+	return m_Bodies.size();
+}
+
+size_t BodyStorage::getMovableCount() const
+{
+	return m_NumMovable;
+}
+
+Body& BodyStorage::operator[](size_t p_DenseIndex)
+{
+	return m_Bodies[p_DenseIndex];
+}
+
+const Body& BodyStorage::operator[](size_t p_DenseIndex) const
+{
+	return m_Bodies[p_DenseIndex];
+}
+
+void BodyStorage::integrate(size_t p_First, size_t p_Last, float p_DeltaTime)
+{
+	m_Motion.integrate(p_First, p_Last, p_DeltaTime);
+}
+
+BodyStorage::BodyHandle BodyStorage::makeHandle(unsigned int p_Slot, unsigned int p_Generation)
+{
+	return (p_Generation << indexBits) | (p_Slot + 1);
+}
+
+const BodyStorage::Slot* BodyStorage::findSlot(BodyHandle p_Body) const
+{
+	const unsigned int slotNumber = p_Body & indexMask;
+	if (slotNumber == 0 || slotNumber > m_Slots.size())
+		return nullptr;
+
+	const Slot& slot = m_Slots[slotNumber - 1];
+	if (!slot.used || slot.generation != (p_Body >> indexBits))
+		return nullptr;
+
+	return &slot;
+}
+
+void BodyStorage::swapDense(size_t p_First, size_t p_Second)
+{
+	if (p_First == p_Second)
+		return;
+
+	std::swap(m_Bodies[p_First], m_Bodies[p_Second]);
+	m_Motion.swapRows(p_First, p_Second);
+	m_Bodies[p_First].setMotionRow(p_First);
+	m_Bodies[p_Second].setMotionRow(p_Second);
+	std::swap(m_DenseToSlot[p_First], m_DenseToSlot[p_Second]);
+	m_Slots[m_DenseToSlot[p_First]].denseIndex = (unsigned int)p_First;
+	m_Slots[m_DenseToSlot[p_Second]].denseIndex = (unsigned int)p_Second;
+}
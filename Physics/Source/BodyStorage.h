@@ -0,0 +1,125 @@
+#pragma once
+#include "Body.h"
+#include "MotionArrays.h"
+
+#include <vector>
+
+/**
+ * Dense storage for the bodies of a physics world.
+ *
+ * Bodies are kept in one contiguous array with all movable bodies packed at
+ * the front, so the step can stream through them without chasing pointers.
+ * Handles refer to a slot that knows where the body currently lives in the
+ * array, and carry the generation of the slot so that the handle of a
+ * released body never finds the body reusing its slot.
+ *
+ * The low bits of a handle is the slot index plus one and the high bits the
+ * generation, so a new world hands out 1, 2, 3... and 0 is never a valid handle.
+ *
+ * The motion of the bodies is kept in motion arrays with the same order as the
+ * dense array, so the movable bodies can be integrated in batches.
+ */
+class BodyStorage
+{
+public:
+	typedef unsigned int BodyHandle;
+
+	static const unsigned int indexBits = 20;
+	static const unsigned int indexMask = (1u << indexBits) - 1;
+	static const unsigned int generationMask = (1u << (32 - indexBits)) - 1;
+	/**
+	 * The largest number of bodies that can exist at the same time.
+	 * One less than the index mask so that (BodyHandle)-1 is never a valid handle.
+	 */
+	static const unsigned int maxBodies = indexMask - 1;
+
+private:
+	struct Slot
+	{
+		unsigned int denseIndex;
+		unsigned int generation;
+		bool used;
+	};
+
+	std::vector<Body> m_Bodies;
+	MotionArrays m_Motion;
+	std::vector<unsigned int> m_DenseToSlot;
+	std::vector<Slot> m_Slots;
+	std::vector<unsigned int> m_FreeSlots;
+	size_t m_NumMovable;
+
+public:
+	BodyStorage();
+
+	/**
+	 * Release all bodies. Handles to the released bodies stay invalid.
+	 */
+	void clear();
+
+	/**
+	 * Make room for more bodies, so that adding them does not move the stored bodies more than once.
+	 *
+	 * @param p_NumBodies the total number of bodies to make room for
+	 */
+	void reserve(size_t p_NumBodies);
+
+	/**
+	 * Take ownership of a body and assign it a handle.
+	 * Adding or removing bodies invalidates pointers to stored bodies.
+	 *
+	 * @param p_Body the body to add
+	 * @return the new handle of the body
+	 */
+	BodyHandle add(Body&& p_Body);
+
+	/**
+	 * Remove a body.
+	 *
+	 * @param p_Body the handle of the body to remove
+	 * @return true if the body existed, otherwise false
+	 */
+	bool remove(BodyHandle p_Body);
+
+	/**
+	 * @param p_Body the handle of the body to find
+	 * @return the body or nullptr if the handle is not valid
+	 */
+	Body* find(BodyHandle p_Body);
+	const Body* find(BodyHandle p_Body) const;
+
+	/**
+	 * @return the number of bodies
+	 */
+	size_t size() const;
+
+	/**
+	 * @return the number of movable bodies, stored at the dense indices [0, getMovableCount())
+	 */
+	size_t getMovableCount() const;
+
+	/**
+	 * Get a body from its position in the dense array.
+	 */
+	Body& operator[](size_t p_DenseIndex);
+	const Body& operator[](size_t p_DenseIndex) const;
+
+	/**
+	 * Integrate the motion of the awake movable bodies in a range as one batch.
+	 * The volumes are not moved, call Body::applyIntegratedMotion on each awake body afterwards.
+	 *
+	 * @param p_First the dense index of the first body
+	 * @param p_Last one past the dense index of the last body, at most getMovableCount()
+	 * @param p_DeltaTime the time to advance, in s
+	 */
+	void integrate(size_t p_First, size_t p_Last, float p_DeltaTime);
+
+private:
+	// The bodies point to the motion arrays of the storage
+	BodyStorage(const BodyStorage&);
+	BodyStorage& operator=(const BodyStorage&);
+
+
+	static BodyHandle makeHandle(unsigned int p_Slot, unsigned int p_Generation);
+	const Slot* findSlot(BodyHandle p_Body) const;
+	void swapDense(size_t p_First, size_t p_Second);
+};
@@ -0,0 +1,95 @@
+#include "Broadphase.h"
+
+#include <algorithm>
+
+Broadphase::Broadphase()
+{
+}
+
+void Broadphase::reset()
+{
+	m_Proxies.clear();
+}
+
+void Broadphase::addBody(BodyHandle p_Body, const Sphere* p_Sphere)
+{
+	Proxy proxy(p_Body, p_Sphere);
+	updateBounds(proxy);
+
+	auto insertPos = std::upper_bound(m_Proxies.begin(), m_Proxies.end(), proxy,
+		[] (const Proxy& p_Lhs, const Proxy& p_Rhs) { return p_Lhs.minX < p_Rhs.minX; });
+	m_Proxies.insert(insertPos, proxy);
+}
+
+void Broadphase::removeBody(BodyHandle p_Body)
+{
+	auto removeIt = std::find_if(m_Proxies.begin(), m_Proxies.end(),
+		[p_Body] (const Proxy& p_Proxy) { return p_Proxy.handle == p_Body; });
+
+	if (removeIt != m_Proxies.end())
+	{
+		m_Proxies.erase(removeIt);
+	}
+}
+
+size_t Broadphase::getBodyCount() const
+{
+	return m_Proxies.size();
+}
+
+void Broadphase::update()
+{
+	for (auto& proxy : m_Proxies)
+	{
+		updateBounds(proxy);
+	}
+
+	// Insertion sort, the order from the last step is almost always still valid
+	for (size_t i = 1; i < m_Proxies.size(); ++i)
+	{
+		const Proxy current = m_Proxies[i];
+		size_t j = i;
+		while (j > 0 && m_Proxies[j - 1].minX > current.minX)
+		{
+			m_Proxies[j] = m_Proxies[j - 1];
+			--j;
+		}
+		m_Proxies[j] = current;
+	}
+}
+
+void Broadphase::findPairs(std::vector<Pair>& p_Pairs) const
+{
+	p_Pairs.clear();
+
+	for (size_t i = 0; i < m_Proxies.size(); ++i)
+	{
+		const Proxy& first = m_Proxies[i];
+
+		for (size_t j = i + 1; j < m_Proxies.size(); ++j)
+		{
+			const Proxy& second = m_Proxies[j];
+			if (second.minX > first.maxX)
+				break;
+
+			if (!Collision::surroundingSphereVsSphere(*first.sphere, *second.sphere))
+				continue;
+
+			if (first.handle < second.handle)
+				p_Pairs.push_back(Pair(first.handle, second.handle));
+			else
+				p_Pairs.push_back(Pair(second.handle, first.handle));
+		}
+	}
+
+	std::sort(p_Pairs.begin(), p_Pairs.end());
+}
+
+void Broadphase::updateBounds(Proxy& p_Proxy)
+{
+	const float centerX = p_Proxy.sphere->getPosition().x;
+	const float radius = p_Proxy.sphere->getRadius();
+
+	p_Proxy.minX = centerX - radius;
+	p_Proxy.maxX = centerX + radius;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Collision.h"
+#include "Sphere.h"
+
+#include <utility>
+#include <vector>
+
+/**
+ * Sweep and prune broadphase for movable bodies.
+ *
+ * Every proxy is projected onto the x-axis using the surrounding sphere of the body.
+ * The proxy list is kept sorted on the lower bound and is re-sorted with an insertion
+ * sort each step, which is close to linear since bodies move little between steps.
+ */
+class Broadphase
+{
+public:
+	typedef unsigned int BodyHandle;
+	typedef std::pair<BodyHandle, BodyHandle> Pair;
+
+private:
+	struct Proxy
+	{
+		BodyHandle handle;
+		const Sphere* sphere;
+		float minX;
+		float maxX;
+
+		Proxy() :
+			handle(0),
+			sphere(nullptr),
+			minX(0.f),
+			maxX(0.f)
+		{
+		}
+
+		Proxy(BodyHandle p_Handle, const Sphere* p_Sphere) :
+			handle(p_Handle),
+			sphere(p_Sphere),
+			minX(0.f),
+			maxX(0.f)
+		{
+		}
+	};
+
+	std::vector<Proxy> m_Proxies;
+
+public:
+	Broadphase();
+
+	void reset();
+
+	/**
+	 * Add a body to the broadphase. The sphere must stay valid until the body is removed.
+	 *
+	 * @param p_Body the handle of the body
+	 * @param p_Sphere the sphere surrounding the body
+	 */
+	void addBody(BodyHandle p_Body, const Sphere* p_Sphere);
+	void removeBody(BodyHandle p_Body);
+
+	size_t getBodyCount() const;
+
+	/**
+	 * Refresh the bounds of all proxies and restore the sort order.
+	 * Call once per step after the bodies have been moved.
+	 */
+	void update();
+
+	/**
+	 * Find all pairs of bodies whose surrounding spheres overlap.
+	 * Each pair is only reported once, with the lower handle first,
+	 * and the pairs are sorted on the handles.
+	 *
+	 * @param p_Pairs cleared and filled with the overlapping pairs
+	 */
+	void findPairs(std::vector<Pair>& p_Pairs) const;
+
+	/**
+	 * Find all bodies whose surrounding spheres overlap a sphere.
+	 * Requires that update has been called since the bodies last moved.
+	 */
+	template <typename OutIt>
+	void findPotentialIntersections(const Sphere* p_Sphere, OutIt p_Output) const
+	{
+		const float minX = p_Sphere->getPosition().x - p_Sphere->getRadius();
+		const float maxX = p_Sphere->getPosition().x + p_Sphere->getRadius();
+
+		for (const auto& proxy : m_Proxies)
+		{
+			if (proxy.minX > maxX)
+				break;
+
+			if (proxy.maxX < minX)
+				continue;
+
+			if (Collision::surroundingSphereVsSphere(*proxy.sphere, *p_Sphere))
+			{
+				*p_Output++ = proxy.handle;
+			}
+		}
+	}
+
+private:
+	static void updateBounds(Proxy& p_Proxy);
+};
@@ -1,12 +1,50 @@
 #include "Collision.h"
 #include "PhysicsExceptions.h"
 #include "PhysicsLogger.h"
+
+#include <algorithm>
+#include <cfloat>
+
 #define EPSILON XMVectorGetX(g_XMEpsilon)
 using namespace DirectX;
 
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+// Counted per thread, since the static collision checks run on several threads
+static THREAD_LOCAL unsigned int g_TriangleTestCount = 0;
+static THREAD_LOCAL unsigned int g_CachedAxisExitCount = 0;
+
+unsigned int Collision::getTriangleTestCount()
+{
+	return g_TriangleTestCount;
+}
+
+unsigned int Collision::getCachedAxisExitCount()
+{
+	return g_CachedAxisExitCount;
+}
+
+bool Collision::usesSeparatingAxes(BoundingVolume const &p_Volume1, BoundingVolume const &p_Volume2)
+{
+	const BoundingVolume::Type type1 = p_Volume1.getType();
+	const BoundingVolume::Type type2 = p_Volume2.getType();
+
+	if (type1 == BoundingVolume::Type::OBB)
+		return type2 == BoundingVolume::Type::OBB || type2 == BoundingVolume::Type::AABBOX || type2 == BoundingVolume::Type::HULL;
+	if (type2 == BoundingVolume::Type::OBB)
+		return type1 == BoundingVolume::Type::AABBOX || type1 == BoundingVolume::Type::HULL;
+
+	return false;
+}
+
 
 
-HitData Collision::boundingVolumeVsBoundingVolume(BoundingVolume const &p_Volume1, BoundingVolume const &p_Volume2)
+HitData Collision::boundingVolumeVsBoundingVolume(BoundingVolume const &p_Volume1, BoundingVolume const &p_Volume2,
+	SeparatingAxisCache *p_Cache)
 {
 	if(p_Volume1.getBodyHandle() == p_Volume2.getBodyHandle())
 		if(p_Volume1.getBodyHandle() != 0)
@@ -17,13 +55,13 @@ HitData Collision::boundingVolumeVsBoundingVolume(BoundingVolume const &p_Volume
 	switch(type)
 	{		
 	case BoundingVolume::Type::AABBOX:
-		return boundingVolumeVsAABB(p_Volume1, (AABB&)p_Volume2);
+		return boundingVolumeVsAABB(p_Volume1, (AABB&)p_Volume2, p_Cache);
 	case BoundingVolume::Type::SPHERE:
 		return boundingVolumeVsSphere(p_Volume1, (Sphere&) p_Volume2);
 	case BoundingVolume::Type::OBB:
-		return boundingVolumeVsOBB(p_Volume1, (OBB&)p_Volume2);
+		return boundingVolumeVsOBB(p_Volume1, (OBB&)p_Volume2, p_Cache);
 	case BoundingVolume::Type::HULL:
-		return boundingVolumeVsHull(p_Volume1, (Hull&)p_Volume2);
+		return boundingVolumeVsHull(p_Volume1, (Hull&)p_Volume2, p_Cache);
 	default:
 		throw CollisionException("Collision error! Bounding volume type does not exist!", __LINE__, __FILE__);
 	}
@@ -48,7 +86,7 @@ HitData Collision::boundingVolumeVsSphere(BoundingVolume const &p_Volume, Sphere
 	}
 }
 
-HitData Collision::boundingVolumeVsAABB(BoundingVolume const &p_Volume, AABB const &p_AABB)
+HitData Collision::boundingVolumeVsAABB(BoundingVolume const &p_Volume, AABB const &p_AABB, SeparatingAxisCache *p_Cache)
 {
 	BoundingVolume::Type type = p_Volume.getType();
 	switch(type)
@@ -58,31 +96,31 @@ HitData Collision::boundingVolumeVsAABB(BoundingVolume const &p_Volume, AABB con
 	case BoundingVolume::Type::SPHERE:
 		return AABBvsSphere(p_AABB, (Sphere&)p_Volume);
 	case BoundingVolume::Type::OBB:
-		return OBBvsAABB((OBB&)p_Volume, p_AABB);
+		return OBBvsAABB((OBB&)p_Volume, p_AABB, p_Cache);
 	default:
 		throw CollisionException("Collision error! Bounding volume type does not exist!", __LINE__, __FILE__);
 	}
 }
 
-HitData Collision::boundingVolumeVsOBB(BoundingVolume const &p_Volume, OBB const &p_OBB)
+HitData Collision::boundingVolumeVsOBB(BoundingVolume const &p_Volume, OBB const &p_OBB, SeparatingAxisCache *p_Cache)
 {
 	BoundingVolume::Type type = p_Volume.getType();
 	switch(type)
 	{
 	case BoundingVolume::Type::AABBOX:
-		return OBBvsAABB(p_OBB, (AABB&)p_Volume);
+		return OBBvsAABB(p_OBB, (AABB&)p_Volume, p_Cache);
 	case BoundingVolume::Type::SPHERE:
 		return OBBvsSphere(p_OBB, (Sphere&)p_Volume);
 	case BoundingVolume::Type::OBB:
-		return OBBvsOBB((OBB&)p_Volume, p_OBB);
+		return OBBvsOBB((OBB&)p_Volume, p_OBB, p_Cache);
 	case BoundingVolume::Type::HULL:
-		return OBBVsHull(p_OBB, (Hull&)p_Volume);
+		return OBBVsHull(p_OBB, (Hull&)p_Volume, p_Cache);
 	default:
 		throw CollisionException("Collision error! Bounding volume type does not exist!", __LINE__, __FILE__);
 	}
 }
 
-HitData Collision::boundingVolumeVsHull(BoundingVolume const &p_Volume, Hull const &p_Hull)
+HitData Collision::boundingVolumeVsHull(BoundingVolume const &p_Volume, Hull const &p_Hull, SeparatingAxisCache *p_Cache)
 {
 	BoundingVolume::Type type = p_Volume.getType();
 	switch(type)
@@ -90,7 +128,7 @@ HitData Collision::boundingVolumeVsHull(BoundingVolume const &p_Volume, Hull con
 	case BoundingVolume::Type::SPHERE:
 			return HullVsSphere(p_Hull, (Sphere&)p_Volume);
 	case BoundingVolume::Type::OBB:
-		return OBBVsHull((OBB&)p_Volume, p_Hull);
+		return OBBVsHull((OBB&)p_Volume, p_Hull, p_Cache);
 	default:
 		throw CollisionException("Collision error! Bounding volume type does not exist!", __LINE__, __FILE__);
 	}
@@ -102,7 +140,7 @@ bool Collision::surroundingSphereVsSphere(Sphere const &p_Sphere1, Sphere const
 	XMFLOAT4 s2Pos = p_Sphere2.getPosition();
 	XMVECTOR CDiff = XMVectorSet(s2Pos.x - s1Pos.x, s2Pos.y - s1Pos.y, s2Pos.z - s1Pos.z, s2Pos.w - s1Pos.w);
 	
-	float c = XMVector3LengthSq(CDiff).m128_f32[0]; // m^2
+	float c = XMVectorGetX(XMVector3LengthSq(CDiff)); // m^2
 	float rSum = p_Sphere2.getRadius() + p_Sphere1.getRadius();	// m
     float rSumSqr = rSum*rSum;	// m^2
 
@@ -338,49 +376,49 @@ bool Collision::AABBInsideSphere(XMFLOAT4 p_Min, XMFLOAT4 p_Max, Sphere const &p
 
 	//xyz
 	XMVECTOR v = XMVectorSet(p_Min.x - spherePos.x, p_Min.y - spherePos.y, p_Min.z - spherePos.z, 0.f);
-	float l = XMVector3Length(v).m128_f32[0];
+	float l = XMVectorGetX(XMVector3Length(v));
 	if(l > radius)
 		return false;
 
 	//Xyz
 	v = XMVectorSet(p_Max.x - spherePos.x, p_Min.y - spherePos.y, p_Min.z - spherePos.z, 0.f);
-	l = XMVector3Length(v).m128_f32[0];
+	l = XMVectorGetX(XMVector3Length(v));
 	if(l > radius)
 		return false;
 	
 	//xYz
 	v = XMVectorSet(p_Min.x - spherePos.x, p_Max.y - spherePos.y, p_Min.z - spherePos.z, 0.f);
-	l = XMVector3Length(v).m128_f32[0];
+	l = XMVectorGetX(XMVector3Length(v));
 	if(l > radius)
 		return false;
 
 	//XYz
 	v = XMVectorSet(p_Max.x - spherePos.x, p_Max.y - spherePos.y, p_Min.z - spherePos.z, 0.f);
-	l = XMVector3Length(v).m128_f32[0];
+	l = XMVectorGetX(XMVector3Length(v));
 	if(l > radius)
 		return false;
 
 	//xyZ
 	v = XMVectorSet(p_Min.x - spherePos.x, p_Min.y - spherePos.y, p_Max.z - spherePos.z, 0.f);
-	l = XMVector3Length(v).m128_f32[0];
+	l = XMVectorGetX(XMVector3Length(v));
 	if(l > radius)
 		return false;
 
 	//XyZ
 	v = XMVectorSet(p_Max.x - spherePos.x, p_Min.y - spherePos.y, p_Max.z - spherePos.z, 0.f);
-	l = XMVector3Length(v).m128_f32[0];
+	l = XMVectorGetX(XMVector3Length(v));
 	if(l > radius)
 		return false;
 
 	//xYZ
 	v = XMVectorSet(p_Min.x - spherePos.x, p_Max.y - spherePos.y, p_Max.z - spherePos.z, 0.f);
-	l = XMVector3Length(v).m128_f32[0];
+	l = XMVectorGetX(XMVector3Length(v));
 	if(l > radius)
 		return false;
 
 	//XYZ
 	v = XMVectorSet(p_Max.x - spherePos.x, p_Max.y - spherePos.y, p_Max.z - spherePos.z, 0.f);
-	l = XMVector3Length(v).m128_f32[0];
+	l = XMVectorGetX(XMVector3Length(v));
 	if(l > radius)
 		return false;
 
@@ -402,12 +440,12 @@ bool Collision::SphereInsideAABB(XMFLOAT4 p_Min, XMFLOAT4 p_Max, Sphere const &p
 	return true;
 }
 
-HitData Collision::OBBvsOBB(OBB const &p_OBB1, OBB const &p_OBB2)
+HitData Collision::OBBvsOBB(OBB const &p_OBB1, OBB const &p_OBB2, SeparatingAxisCache *p_Cache)
 {
 	if(!surroundingSphereVsSphere(p_OBB1.getSphere(), p_OBB2.getSphere()))
 		return HitData();
 
-	return SATBoxVsBox(p_OBB1, p_OBB2);
+	return SATBoxVsBox(p_OBB1, p_OBB2, p_Cache);
 }
 
 HitData Collision::OBBvsSphere(OBB const &p_OBB, Sphere const &p_Sphere)
@@ -444,27 +482,27 @@ HitData Collision::OBBvsSphere(OBB const &p_OBB, Sphere const &p_Sphere)
 		}
 			
 		
-		hit.colLength = (p_Sphere.getRadius() - sqrtf(vv.m128_f32[0]));
+		hit.colLength = (p_Sphere.getRadius() - sqrtf(XMVectorGetX(vv)));
 		hit.colType = Type::OBBVSSPHERE;
 	}
 
 	return hit;
 }
 
-HitData Collision::OBBvsAABB(OBB const &p_OBB, AABB const &p_AABB)
+HitData Collision::OBBvsAABB(OBB const &p_OBB, AABB const &p_AABB, SeparatingAxisCache *p_Cache)
 {
 	if(!surroundingSphereVsSphere(p_OBB.getSphere(), p_AABB.getSphere()))
 		return HitData();
 
-	return SATBoxVsBox(p_OBB, p_AABB);
+	return SATBoxVsBox(p_OBB, p_AABB, p_Cache);
 }
 
-HitData Collision::OBBVsHull(OBB const &p_OBB, Hull const &p_Hull)
+HitData Collision::OBBVsHull(OBB const &p_OBB, Hull const &p_Hull, SeparatingAxisCache *p_Cache)
 {
 	if(!surroundingSphereVsSphere(p_OBB.getSphere(), p_Hull.getSphere()))
 		return HitData();
 
-	return SATBoxVsHull(p_OBB, p_Hull);
+	return SATBoxVsHull(p_OBB, p_Hull, p_Cache);
 }
 
 HitData Collision::HullVsSphere(Hull const &p_Hull, Sphere const &p_Sphere)
@@ -477,25 +515,31 @@ HitData Collision::HullVsSphere(Hull const &p_Hull, Sphere const &p_Sphere)
 	XMVECTOR spherePos = XMLoadFloat4(&XMSpherePos);
 
 	float distance = FLT_MAX;
+	unsigned int closestTriangle = 0;
 	XMVECTOR closestPoint = g_XMZero;
-	unsigned int nrTriangles = p_Hull.getTriangleListSize();
-	for(unsigned int i = 0; i < nrTriangles; i++)
+	const float sqrRadius = p_Sphere.getSqrRadius();
+	const XMVECTOR radius = XMVectorReplicate(p_Sphere.getRadius());
+
+	//Only the triangles near the sphere are tested, on equal distance the last triangle in the hull is used
+	p_Hull.findTrianglesInBox(spherePos - radius, spherePos + radius, [&] (unsigned int p_Triangle)
 	{
-		XMVECTOR point = p_Hull.findClosestPointOnTriangle(XMSpherePos, i);
+		++g_TriangleTestCount;
+		XMVECTOR point = p_Hull.findClosestPointOnTriangle(XMSpherePos, p_Triangle);
 		XMVECTOR v = point - spherePos;
 
 		float vv = XMVectorGetX(XMVector4Dot(v, v));
 
-		if(vv <= p_Sphere.getSqrRadius())
+		if(vv <= sqrRadius)
 		{
-			hit.intersect = true;
-			if(vv <= distance)
+			if(!hit.intersect || vv < distance || (vv == distance && p_Triangle > closestTriangle))
 			{
 				distance = vv;
+				closestTriangle = p_Triangle;
 				closestPoint = point;
 			}
+			hit.intersect = true;
 		}
-	}
+	});
 
 	if(hit.intersect)
 	{
@@ -523,31 +567,36 @@ HitData Collision::HullVsSphere(Hull const &p_Hull, Sphere const &p_Sphere)
 	return hit;
 }
 
-HitData Collision::SATBoxVsBox(OBB const &p_OBB, BoundingVolume const &p_vol)
+HitData Collision::SATBoxVsBox(OBB const &p_OBB, BoundingVolume const &p_vol, SeparatingAxisCache *p_Cache)
 {
 	HitData miss;
 	float r, ra, rb, overlap = FLT_MAX;
 
-	XMMATRIX R, AbsR;
+	XMFLOAT4X4 R, AbsR;	// b in the coordinate frame of a
 	XMVECTOR b_Center, b_Extents; // m
 	XMMATRIX b_Axes;
-	XMVECTOR least;
+	const XMFLOAT4X4 aAxes = p_OBB.getAxes();
+	const XMFLOAT4 aExtents4 = p_OBB.getExtents();
 	const XMVECTOR a_Center = XMLoadFloat4(&p_OBB.getPosition());
-	const XMMATRIX a_Axes = XMLoadFloat4x4(&p_OBB.getAxes());
-	const XMVECTOR a_Extents = XMLoadFloat4(&p_OBB.getExtents()); 
+	const XMMATRIX a_Axes = XMLoadFloat4x4(&aAxes);
+	const XMVECTOR a_Extents = XMLoadFloat4(&aExtents4); 
+	XMVECTOR least = a_Axes.r[0];
 
 
 	if(p_vol.getType() == BoundingVolume::Type::OBB)
 	{
+		const XMFLOAT4X4 bAxes = ((OBB&)p_vol).getAxes();
+		const XMFLOAT4 bExtents4 = ((OBB&)p_vol).getExtents();
 		b_Center = XMLoadFloat4(&((OBB&)p_vol).getPosition());
-		b_Axes = XMLoadFloat4x4(&((OBB&)p_vol).getAxes());
-		b_Extents = XMLoadFloat4(&((OBB&)p_vol).getExtents());
+		b_Axes = XMLoadFloat4x4(&bAxes);
+		b_Extents = XMLoadFloat4(&bExtents4);
 	}
 	else
 	{
+		const XMFLOAT4 bHalfDiagonal = ((AABB&)p_vol).getHalfDiagonal();
 		b_Center = XMLoadFloat4(&((AABB&)p_vol).getPosition());
 		b_Axes = XMMatrixIdentity();
-		b_Extents = XMLoadFloat4(&((AABB&)p_vol).getHalfDiagonal());
+		b_Extents = XMLoadFloat4(&bHalfDiagonal);
 	}
 	//Compute rotation matrix expressing b in a's coordinate frame
 	for (int i = 0; i < 3; i++)
@@ -555,19 +604,22 @@ HitData Collision::SATBoxVsBox(OBB const &p_OBB, BoundingVolume const &p_vol)
 		for (int j = 0; j < 3; j++)
 		{
 			XMVECTOR dotResult = XMVector3Dot(a_Axes.r[i], b_Axes.r[j]);
-			R.r[i].m128_f32[j] = XMVectorGetX(dotResult);
+			R.m[i][j] = XMVectorGetX(dotResult);
 		}
 	}
 
 	// Compute translation vector t
-	XMVECTOR t = b_Center - a_Center;	// m
-	XMVECTOR tVec = t;
+	XMVECTOR tVec = b_Center - a_Center;	// m
 	
 	// Bring translation into as coordinate frame
-	XMVECTOR dotResult = XMVector3Dot(t, a_Axes.r[0]); 
-	XMVECTOR dotResult1 = XMVector3Dot(t, a_Axes.r[1]); 
-	XMVECTOR dotResult2 = XMVector3Dot(t, a_Axes.r[2]); 
-	t = XMVectorSet(XMVectorGetX(dotResult), XMVectorGetX(dotResult1), XMVectorGetX(dotResult2), 0.f);
+	XMVECTOR dotResult = XMVector3Dot(tVec, a_Axes.r[0]); 
+	XMVECTOR dotResult1 = XMVector3Dot(tVec, a_Axes.r[1]); 
+	XMVECTOR dotResult2 = XMVector3Dot(tVec, a_Axes.r[2]); 
+	const float t[3] = { XMVectorGetX(dotResult), XMVectorGetX(dotResult1), XMVectorGetX(dotResult2) };
+
+	XMFLOAT3 aExtents, bExtents;
+	XMStoreFloat3(&aExtents, a_Extents);
+	XMStoreFloat3(&bExtents, b_Extents);
 
 	// Compute common subexpressions. Add in an epsilon term to
 	// counteract arithmetic errors when two edges are parallel and
@@ -576,122 +628,46 @@ HitData Collision::SATBoxVsBox(OBB const &p_OBB, BoundingVolume const &p_vol)
 	{
 		for (int j = 0; j < 3; j++)
 		{
-			AbsR.r[i].m128_f32[j] = fabs(R.r[i].m128_f32[j]) + EPSILON;
+			AbsR.m[i][j] = fabs(R.m[i][j]) + EPSILON;
 		}
 	}
 
-	// Test axes L = A0, L = A1, L = A2
-	for (int i = 0; i < 3; i++) 
+	// The axis that separated the boxes last time most likely still does
+	if (p_Cache && p_Cache->boxAxis < numBoxAxes &&
+		boxAxisSeparates(p_Cache->boxAxis, R, AbsR, t, &aExtents.x, &bExtents.x, ra, rb, r))
 	{
-		ra = a_Extents.m128_f32[i]; 
-		rb = XMVectorGetX(b_Extents) * XMVectorGetX(AbsR.r[i]) + XMVectorGetY(b_Extents) * XMVectorGetY(AbsR.r[i]) + XMVectorGetZ(b_Extents) * XMVectorGetZ(AbsR.r[i]);
-		float r = t.m128_f32[i];
-		if(fabs(r) > ra + rb)
-			return miss;
-		checkCollisionDepth(ra, rb, r, overlap, a_Axes.r[i], least);
-		
+		++g_CachedAxisExitCount;
+		return miss;
 	}
 
-	//Test axes L = B0, L = B1, L = B2
-	for (int i = 0; i < 3; i++) 
+	// Test axes L = A0, A1, A2, L = B0, B1, B2 and L = Ai x Bj
+	unsigned int leastAxis = 0;
+	for (unsigned int i = 0; i < numBoxAxes; i++)
 	{
-		ra = XMVectorGetX(a_Extents) * AbsR.r[0].m128_f32[i] + XMVectorGetY(a_Extents) * AbsR.r[1].m128_f32[i] + XMVectorGetZ(a_Extents) * AbsR.r[2].m128_f32[i];
-		rb = b_Extents.m128_f32[i]; 
-		r  = XMVectorGetX(t) * R.r[0].m128_f32[i] + XMVectorGetY(t) * R.r[1].m128_f32[i] + XMVectorGetZ(t) * R.r[2].m128_f32[i];
-		if(fabs(r) > ra + rb)
+		if (boxAxisSeparates(i, R, AbsR, t, &aExtents.x, &bExtents.x, ra, rb, r))
+		{
+			if (p_Cache)
+				p_Cache->boxAxis = i;
 			return miss;
-		checkCollisionDepth(ra, rb, r, overlap, b_Axes.r[i], least);
-	}
-
-	// Test axis L = A0 x B0
-	ra		= XMVectorGetY(a_Extents) * XMVectorGetX(AbsR.r[2]) + XMVectorGetZ(a_Extents) * XMVectorGetX(AbsR.r[1]);
-	rb		= XMVectorGetY(b_Extents) * XMVectorGetZ(AbsR.r[0]) + XMVectorGetZ(b_Extents) * XMVectorGetY(AbsR.r[0]);
-	r		= XMVectorGetZ(t) * XMVectorGetX(R.r[1]) - XMVectorGetY(t) * XMVectorGetX(R.r[2]);
-	if (fabs(r) > ra + rb)
-		return miss;
-
-	XMVECTOR L = XMVector3Cross(a_Axes.r[0], b_Axes.r[0]);
-	checkCollisionDepth(ra, rb, r, overlap, L, least);
-
-	// Test axis L = A0 x B1
- 	ra		= XMVectorGetY(a_Extents)	* XMVectorGetY(AbsR.r[2]) + XMVectorGetZ(a_Extents) * XMVectorGetY(AbsR.r[1]);
-	rb		= XMVectorGetX(b_Extents)	* XMVectorGetZ(AbsR.r[0]) + XMVectorGetZ(b_Extents) * XMVectorGetX(AbsR.r[0]);
-	r		= XMVectorGetZ(t) * XMVectorGetY(R.r[1]) - XMVectorGetY(t) * XMVectorGetY(R.r[2]);
-	if (fabs(r) > ra + rb) 
-		return miss;
-
-	L = XMVector3Cross(a_Axes.r[0], b_Axes.r[1]);
-	checkCollisionDepth(ra, rb, r, overlap, L, least);
-
-	// Test axis L = A0 x B2
-	ra		= XMVectorGetY(a_Extents)	* XMVectorGetZ(AbsR.r[2]) + XMVectorGetZ(a_Extents) * XMVectorGetZ(AbsR.r[1]);
-	rb		= XMVectorGetX(b_Extents)	* XMVectorGetY(AbsR.r[0]) + XMVectorGetY(b_Extents) * XMVectorGetX(AbsR.r[0]);
-	r		= XMVectorGetZ(t) * XMVectorGetZ(R.r[1]) - XMVectorGetY(t) * XMVectorGetZ(R.r[2]);
-	if (fabs(r) > ra + rb) 
-		return miss;
-
-	L = XMVector3Cross(a_Axes.r[0], b_Axes.r[2]);
-	checkCollisionDepth(ra, rb, r, overlap, L, least);
-
-	// Test axis L = A1 x B0
-	ra		= XMVectorGetX(a_Extents)	* XMVectorGetX(AbsR.r[2]) + XMVectorGetZ(a_Extents) * XMVectorGetX(AbsR.r[0]);
-	rb		= XMVectorGetY(b_Extents)	* XMVectorGetZ(AbsR.r[1]) + XMVectorGetZ(b_Extents) * XMVectorGetY(AbsR.r[1]);
-	r		= XMVectorGetX(t) * XMVectorGetX(R.r[2]) - XMVectorGetZ(t) * XMVectorGetX(R.r[0]);
-	if (fabs(r) > ra + rb) 
-		return miss;
-
-	L = XMVector3Cross(a_Axes.r[1], b_Axes.r[0]);
-	checkCollisionDepth(ra, rb, r, overlap, L, least);
-
-	// Test axis L = A1 x B1
-	ra		= XMVectorGetX(a_Extents)	* XMVectorGetY(AbsR.r[2]) + XMVectorGetZ(a_Extents) * XMVectorGetY(AbsR.r[0]);
-	rb		= XMVectorGetX(b_Extents)	* XMVectorGetZ(AbsR.r[1]) + XMVectorGetZ(b_Extents) * XMVectorGetX(AbsR.r[1]);
-	r		= XMVectorGetX(t) * XMVectorGetY(R.r[2]) - XMVectorGetZ(t) * XMVectorGetY(R.r[0]);
-	if (fabs(r) > ra + rb) 
-		return miss;
-
-	L = XMVector3Cross(a_Axes.r[1], b_Axes.r[1]);
-	checkCollisionDepth(ra, rb, r, overlap, L, least);
-
-	// Test axis L = A1 x B2
-	ra		= XMVectorGetX(a_Extents)	* XMVectorGetZ(AbsR.r[2]) + XMVectorGetZ(a_Extents) * XMVectorGetZ(AbsR.r[0]);
-	rb		= XMVectorGetX(b_Extents)	* XMVectorGetY(AbsR.r[1]) + XMVectorGetY(b_Extents) * XMVectorGetX(AbsR.r[1]);
-	r		= XMVectorGetX(t) * XMVectorGetZ(R.r[2]) - XMVectorGetZ(t) * XMVectorGetZ(R.r[0]);
-	if (fabs(r) > ra + rb) 
-		return miss;
-
-	L = XMVector3Cross(a_Axes.r[1], b_Axes.r[2]);
-	checkCollisionDepth(ra, rb, r, overlap, L, least);
-
-	// Test axis L = A2 x B0 
-	ra		= XMVectorGetX(a_Extents)	* XMVectorGetX(AbsR.r[1]) + XMVectorGetY(a_Extents) * XMVectorGetX(AbsR.r[0]);
-	rb		= XMVectorGetY(b_Extents)	* XMVectorGetZ(AbsR.r[2]) + XMVectorGetZ(b_Extents) * XMVectorGetY(AbsR.r[2]);
-	r		= XMVectorGetY(t) * XMVectorGetX(R.r[0]) - XMVectorGetX(t) * XMVectorGetX(R.r[1]);
-	if(fabs(r) > ra + rb)
-		return miss;
-
-	L = XMVector3Cross(a_Axes.r[2], b_Axes.r[0]);
-	checkCollisionDepth(ra, rb, r, overlap, L, least);
-
-	// Test axis L = A2 x B1
-	ra		= XMVectorGetX(a_Extents)	* XMVectorGetY(AbsR.r[1]) + XMVectorGetY(a_Extents) * XMVectorGetY(AbsR.r[0]);
-	rb		= XMVectorGetX(b_Extents)	* XMVectorGetZ(AbsR.r[2]) + XMVectorGetZ(b_Extents) * XMVectorGetX(AbsR.r[2]);
-	r		= XMVectorGetY(t) * XMVectorGetY(R.r[0]) - XMVectorGetX(t) * XMVectorGetY(R.r[1]);
-	if (fabs(r) > ra + rb) 
-		return miss;
+		}
 
-	L = XMVector3Cross(a_Axes.r[2], b_Axes.r[1]);
-	checkCollisionDepth(ra, rb, r, overlap, L, least);
+		XMVECTOR L;
+		if (i < 3)
+			L = a_Axes.r[i];
+		else if (i < 6)
+			L = b_Axes.r[i - 3];
+		else
+			L = XMVector3Cross(a_Axes.r[(i - 6) / 3], b_Axes.r[(i - 6) % 3]);
 
-	// Test axis L = A2 x B2
-	ra		= XMVectorGetX(a_Extents)	* XMVectorGetZ(AbsR.r[1]) + XMVectorGetY(a_Extents) * XMVectorGetZ(AbsR.r[0]);
-	rb		= XMVectorGetX(b_Extents)	* XMVectorGetY(AbsR.r[2]) + XMVectorGetY(b_Extents) * XMVectorGetX(AbsR.r[2]);
-	r		= XMVectorGetY(t) * XMVectorGetZ(R.r[0]) - XMVectorGetX(t) * XMVectorGetZ(R.r[1]);
-	if (fabs(r) > ra + rb) 
-		return miss;
+		const float previousOverlap = overlap;
+		checkCollisionDepth(ra, rb, r, overlap, L, least);
+		if (overlap != previousOverlap)
+			leastAxis = i;
+	}
 
-	L = XMVector3Cross(a_Axes.r[2], b_Axes.r[2]);
-	checkCollisionDepth(ra, rb, r, overlap, L, least);
+	// Pushing the boxes apart along the axis of least overlap is likely to separate them on it
+	if (p_Cache)
+		p_Cache->boxAxis = leastAxis;
 	
 	float temp = XMVectorGetX(XMVector4Dot(tVec, least));
 
@@ -710,22 +686,88 @@ HitData Collision::SATBoxVsBox(OBB const &p_OBB, BoundingVolume const &p_vol)
  	return hit;
 }
 
-HitData Collision::SATBoxVsHull(OBB const &p_OBB, Hull const &p_Hull)
+bool Collision::boxAxisSeparates(unsigned int p_Axis, const XMFLOAT4X4 &p_R, const XMFLOAT4X4 &p_AbsR,
+	const float *p_T, const float *p_AExtents, const float *p_BExtents,
+	float &p_RA, float &p_RB, float &p_Distance)
+{
+	const float* a = p_AExtents;
+	const float* b = p_BExtents;
+	const float* t = p_T;
+
+	if (p_Axis < 3)
+	{
+		// L = Ai
+		const unsigned int i = p_Axis;
+		p_RA = a[i];
+		p_RB = b[0] * p_AbsR.m[i][0] + b[1] * p_AbsR.m[i][1] + b[2] * p_AbsR.m[i][2];
+		p_Distance = t[i];
+	}
+	else if (p_Axis < 6)
+	{
+		// L = Bj
+		const unsigned int j = p_Axis - 3;
+		p_RA = a[0] * p_AbsR.m[0][j] + a[1] * p_AbsR.m[1][j] + a[2] * p_AbsR.m[2][j];
+		p_RB = b[j];
+		p_Distance = t[0] * p_R.m[0][j] + t[1] * p_R.m[1][j] + t[2] * p_R.m[2][j];
+	}
+	else
+	{
+		// L = Ai x Bj
+		const unsigned int i = (p_Axis - 6) / 3;
+		const unsigned int j = (p_Axis - 6) % 3;
+		const unsigned int i1 = (i + 1) % 3;
+		const unsigned int i2 = (i + 2) % 3;
+		const unsigned int j1 = (j + 1) % 3;
+		const unsigned int j2 = (j + 2) % 3;
+		p_RA = a[i1] * p_AbsR.m[i2][j] + a[i2] * p_AbsR.m[i1][j];
+		p_RB = b[j1] * p_AbsR.m[i][j2] + b[j2] * p_AbsR.m[i][j1];
+		p_Distance = t[i2] * p_R.m[i1][j] - t[i1] * p_R.m[i2][j];
+	}
+
+	return fabs(p_Distance) > p_RA + p_RB;
+}
+
+HitData Collision::SATBoxVsHull(OBB const &p_OBB, Hull const &p_Hull, SeparatingAxisCache *p_Cache)
 {
 	HitData hit;
 
 	//Box center
 	const XMVECTOR C = XMLoadFloat4(&p_OBB.getPosition());
 	//Box local axes
-	const XMMATRIX A = XMLoadFloat4x4(&p_OBB.getAxes());
+	const XMFLOAT4X4 axes = p_OBB.getAxes();
+	const XMMATRIX A = XMLoadFloat4x4(&axes);
 	//Box halfsize
-	const XMVECTOR a = XMLoadFloat4(&p_OBB.getExtents());
+	const XMFLOAT4 extents = p_OBB.getExtents();
+	const XMVECTOR a = XMLoadFloat4(&extents);
 	//Minimum translation vector
 	XMVECTOR MTV = g_XMZero;
 	//Stores the minimum translation vector for all triangles hit in a hull
 	std::vector<XMFLOAT4> MTVs;
 
-	for(unsigned int i = 0; i < p_Hull.getTriangleListSize(); i++)
+	//Only test the triangles near the box, in the order they have in the hull
+	const XMVECTOR boxHalfSize = XMVectorAbs(A.r[0]) * XMVectorGetX(a)
+		+ XMVectorAbs(A.r[1]) * XMVectorGetY(a)
+		+ XMVectorAbs(A.r[2]) * XMVectorGetZ(a);
+	std::vector<unsigned int> nearTriangles;
+	p_Hull.findTrianglesInBox(C - boxHalfSize, C + boxHalfSize,
+		[&nearTriangles] (unsigned int p_Triangle) { nearTriangles.push_back(p_Triangle); });
+	std::sort(nearTriangles.begin(), nearTriangles.end());
+	g_TriangleTestCount += nearTriangles.size();
+
+	//The axes separating the triangles this time, replaces the cached axes when done
+	std::vector<SeparatingAxisCache::TriangleAxis> separatingAxes;
+	std::vector<SeparatingAxisCache::TriangleAxis>::const_iterator cachedAxis;
+	if(p_Cache)
+	{
+		separatingAxes.reserve(nearTriangles.size());
+		cachedAxis = p_Cache->triangleAxes.begin();
+	}
+
+	BoxTriangle boxTriangle;
+	boxTriangle.boxAxes = A;
+	boxTriangle.halfSize = a;
+
+	for(unsigned int i : nearTriangles)
 	{
 		//Triangle Vertices U0, U1 and U2.
 		Triangle triangle = p_Hull.getTriangleInWorldCoord(i);
@@ -734,134 +776,61 @@ HitData Collision::SATBoxVsHull(OBB const &p_OBB, Hull const &p_Hull)
 		XMVECTOR U2 = Vector4ToXMVECTOR(&triangle.corners[2]);
 
 		//Triangle egdes E0, E1, E2
-		XMVECTOR E0 = U1 - U0;
-		XMVECTOR E1 = U2 - U0;
-		XMVECTOR E2 = E1 - E0;
+		boxTriangle.edges[0] = U1 - U0;
+		boxTriangle.edges[1] = U2 - U0;
+		boxTriangle.edges[2] = boxTriangle.edges[1] - boxTriangle.edges[0];
 
 		//Triangle Normal
-		XMVECTOR N = XMVector3Cross(E0, E1);
+		boxTriangle.normal = XMVector3Cross(boxTriangle.edges[0], boxTriangle.edges[1]);
 
 		//Vector from a box center to the fisrt vertex in the triangle
-		XMVECTOR D = U0 - C;
+		boxTriangle.toTriangle = U0 - C;
 
 		float overlap = FLT_MAX;
 
 		//Least separating axis
 		XMVECTOR least;
-		
-		//Axis L, Axis to test
-		XMVECTOR L = N;
-
-		//Triangle vertex projection on axis
-		float p0 = XMVector3Dot(N, D).m128_f32[0];
-		float p1;
-
-		//Box projection on axis, the box interval on the axis is [-R, R]
-		float R = XMVectorGetX(a) * fabs(XMVectorGetX(XMVector3Dot(N, A.r[0]))) 
-				+ XMVectorGetY(a) * fabs(XMVectorGetX(XMVector3Dot(N, A.r[1])))
-				+ XMVectorGetZ(a) * fabs(XMVectorGetX(XMVector3Dot(N, A.r[2])));
 
+		//Try the axis that separated this triangle from the box last time first.
+		//Both lists are sorted on triangle, so the cached axes are walked alongside the near triangles.
+		if(p_Cache)
+		{
+			while(cachedAxis != p_Cache->triangleAxes.end() && cachedAxis->triangle < i)
+				++cachedAxis;
 
+			if(cachedAxis != p_Cache->triangleAxes.end() && cachedAxis->triangle == i)
+			{
+				float cachedOverlap = FLT_MAX;
+				XMVECTOR cachedLeast;
+				if(!boxTriangleAxisOverlaps(cachedAxis->axis, boxTriangle, cachedOverlap, cachedLeast))
+				{
+					++g_CachedAxisExitCount;
+					separatingAxes.push_back(*cachedAxis);
+					continue;
+				}
+			}
+		}
 
 		//If the triangles projection interval [min, max] is outside the box interval [-R, R]
-		//a separating axis is found which means no collision
-		if(!checkCollision(L, p0, p0, R, overlap, least))
-			continue;
-
-
-		//Axis A0, A1, A2, The box local axes
-		bool miss = false;
-		for(int j = 0; j < 3; j++)
+		//on any axis, a separating axis is found which means no collision
+		unsigned int separatingAxis = SeparatingAxisCache::noAxis;
+		for(unsigned int j = 0; j < numTriangleAxes; j++)
 		{
-			L = A.r[j];
-			p0 = XMVectorGetX(XMVector3Dot(L, D));
-			p1 = p0 + XMVectorGetX(XMVector3Dot(L, E0));
-			float p2 = p0 + XMVectorGetX(XMVector3Dot(L, E1));
-			R = a.m128_f32[j];
-			float max = XMMax(p0, XMMax(p1,p2));
-			float min = XMMin(p0, XMMin(p1,p2));
-			
-
-			if(!checkCollision(L, min, max, R, overlap, least))
+			if(!boxTriangleAxisOverlaps(j, boxTriangle, overlap, least))
 			{
-				miss = true;
+				separatingAxis = j;
 				break;
 			}
 		}
-		if(miss)
-			continue;
-
-		//L = A0 x E0
-		L = XMVector3Cross(A.r[0], E0);
-		p0 = XMVector3Dot(L, D).m128_f32[0];
-		p1 = p0 + XMVector3Dot(A.r[0], N).m128_f32[0];
-		R = XMVectorGetY(a) * fabs(XMVector3Dot(A.r[2], E0).m128_f32[0]) + XMVectorGetZ(a) * fabs(XMVector3Dot(A.r[1], E0).m128_f32[0]);
-		if(!checkCollision(L, p0, p1, R, overlap, least))
-			continue;
-
-		// L = A0 x E1
-		L = XMVector3Cross(A.r[0], E1);
-		p0 = XMVector3Dot(L, D).m128_f32[0];
-		p1 = p0 - XMVector3Dot(A.r[0], N).m128_f32[0];
-		R = XMVectorGetY(a) * fabs(XMVector3Dot(A.r[2], E1).m128_f32[0]) + XMVectorGetZ(a) * fabs(XMVector3Dot(A.r[1], E1).m128_f32[0]);
-		if(!checkCollision(L, p0, p1, R, overlap, least))
-			continue;
-
-		// L = A0 x E2
-		L = XMVector3Cross(A.r[0], E2);
-		p0 = XMVector3Dot(L, D).m128_f32[0];
-		p1 = p0 - XMVector3Dot(A.r[0], N).m128_f32[0];
-		R = XMVectorGetY(a) * fabs(XMVector3Dot(A.r[2], E2).m128_f32[0]) + XMVectorGetZ(a) * fabs(XMVector3Dot(A.r[1], E2).m128_f32[0]);
-		if(!checkCollision(L, p0, p1, R, overlap, least))
-			continue;
-
-		// L = A1 x E0
-		L = XMVector3Cross(A.r[1], E0);
-		p0 = XMVector3Dot(L, D).m128_f32[0];
-		p1 = p0 + XMVector3Dot(A.r[1], N).m128_f32[0];
-		R = XMVectorGetX(a) * fabs(XMVector3Dot(A.r[2], E0).m128_f32[0]) + XMVectorGetZ(a) * fabs(XMVector3Dot(A.r[0], E0).m128_f32[0]);
-		if(!checkCollision(L, p0, p1, R, overlap, least))
-			continue;
-
-		// L = A1 x E1
-		L = XMVector3Cross(A.r[1], E1);
-		p0 = XMVector3Dot(L, D).m128_f32[0];
-		p1 = p0 - XMVector3Dot(A.r[1], N).m128_f32[0];
-		R = XMVectorGetX(a) * fabs(XMVector3Dot(A.r[2], E1).m128_f32[0]) + XMVectorGetZ(a) * fabs(XMVector3Dot(A.r[0], E1).m128_f32[0]);
-		if(!checkCollision(L, p0, p1, R, overlap, least))
-			continue;
-
-		// L = A1 x E2
-		L = XMVector3Cross(A.r[1], E2);
-		p0 = XMVector3Dot(L, D).m128_f32[0];
-		p1 = p0 - XMVector3Dot(A.r[1], N).m128_f32[0];
-		R = XMVectorGetX(a) * fabs(XMVector3Dot(A.r[2], E2).m128_f32[0]) + XMVectorGetZ(a) * fabs(XMVector3Dot(A.r[0], E2).m128_f32[0]);
-		if(!checkCollision(L, p0, p1, R, overlap, least))
-			continue;
-
-		// A2 x E0
-		L = XMVector3Cross(A.r[2], E0);
-		p0 = XMVector3Dot(L, D).m128_f32[0];
-		p1 = p0 + XMVector3Dot(A.r[2], N).m128_f32[0];
-		R = XMVectorGetX(a) * fabs(XMVector3Dot(A.r[1], E0).m128_f32[0]) + XMVectorGetY(a) * fabs(XMVector3Dot(A.r[0], E0).m128_f32[0]);
-		if(!checkCollision(L, p0, p1, R, overlap, least))
-			continue;
-
-		// A2 x E1
-		L = XMVector3Cross(A.r[2], E1);
-		p0 = XMVector3Dot(L, D).m128_f32[0];
-		p1 = p0 - XMVector3Dot(A.r[2], N).m128_f32[0];
-		R = XMVectorGetX(a) * fabs(XMVector3Dot(A.r[1], E1).m128_f32[0]) + XMVectorGetY(a) * fabs(XMVector3Dot(A.r[0], E1).m128_f32[0]);
-		if(!checkCollision(L, p0, p1, R, overlap, least))
-			continue;
-
-		// A2 x E2
-		L = XMVector3Cross(A.r[2], E2);
-		p0 = XMVector3Dot(L, D).m128_f32[0];
-		p1 = p0 - XMVector3Dot(A.r[2], N).m128_f32[0];
-		R = XMVectorGetX(a) * fabs(XMVector3Dot(A.r[1], E2).m128_f32[0]) + XMVectorGetY(a) * fabs(XMVector3Dot(A.r[0], E2).m128_f32[0]);
-		if(!checkCollision(L, p0, p1, R, overlap, least))
+		if(separatingAxis != SeparatingAxisCache::noAxis)
+		{
+			if(p_Cache)
+			{
+				SeparatingAxisCache::TriangleAxis triangleAxis = { i, separatingAxis };
+				separatingAxes.push_back(triangleAxis);
+			}
 			continue;
+		}
 
 		//Check if the triangle and box are side by side, if they are, it counts as no collision
 		if (overlap == 0.f)
@@ -910,6 +879,9 @@ HitData Collision::SATBoxVsHull(OBB const &p_OBB, Hull const &p_Hull)
 		MTV += triangleMTV;
 	}
 
+	if(p_Cache)
+		p_Cache->triangleAxes.swap(separatingAxes);
+
 	if(hit.intersect)
 	{
 		//the length of the MTV is our collision depth
@@ -925,6 +897,58 @@ HitData Collision::SATBoxVsHull(OBB const &p_OBB, Hull const &p_Hull)
 
 }
 
+bool Collision::boxTriangleAxisOverlaps(unsigned int p_Axis, const BoxTriangle &p_BoxTriangle, float &p_Overlap, XMVECTOR &p_Least)
+{
+	const XMMATRIX& A = p_BoxTriangle.boxAxes;
+	const XMVECTOR& a = p_BoxTriangle.halfSize;
+	const XMVECTOR& D = p_BoxTriangle.toTriangle;
+	const XMVECTOR& N = p_BoxTriangle.normal;
+
+	if(p_Axis == 0)
+	{
+		//Axis N, the triangle normal. Every triangle vertex has the same projection on it,
+		//the box interval on the axis is [-R, R]
+		float p0 = XMVectorGetX(XMVector3Dot(N, D));
+		float R = XMVectorGetX(a) * fabs(XMVectorGetX(XMVector3Dot(N, A.r[0]))) 
+				+ XMVectorGetY(a) * fabs(XMVectorGetX(XMVector3Dot(N, A.r[1])))
+				+ XMVectorGetZ(a) * fabs(XMVectorGetX(XMVector3Dot(N, A.r[2])));
+
+		return checkCollision(N, p0, p0, R, p_Overlap, p_Least);
+	}
+
+	if(p_Axis < 4)
+	{
+		//Axis A0, A1, A2, The box local axes
+		const unsigned int j = p_Axis - 1;
+		XMVECTOR L = A.r[j];
+		float p0 = XMVectorGetX(XMVector3Dot(L, D));
+		float p1 = p0 + XMVectorGetX(XMVector3Dot(L, p_BoxTriangle.edges[0]));
+		float p2 = p0 + XMVectorGetX(XMVector3Dot(L, p_BoxTriangle.edges[1]));
+		float R = XMVectorGetByIndex(a, j);
+		float max = XMMax(p0, XMMax(p1,p2));
+		float min = XMMin(p0, XMMin(p1,p2));
+
+		return checkCollision(L, min, max, R, p_Overlap, p_Least);
+	}
+
+	//L = Ai x Ej, two of the triangle vertices have the same projection on these axes
+	const unsigned int i = (p_Axis - 4) / 3;
+	const unsigned int j = (p_Axis - 4) % 3;
+	//The two box axes other than Ai, in order
+	const unsigned int u = (i == 0) ? 1 : 0;
+	const unsigned int v = (i == 2) ? 1 : 2;
+	const XMVECTOR& E = p_BoxTriangle.edges[j];
+
+	XMVECTOR L = XMVector3Cross(A.r[i], E);
+	float p0 = XMVectorGetX(XMVector3Dot(L, D));
+	float p1 = (j == 0)
+		? p0 + XMVectorGetX(XMVector3Dot(A.r[i], N))
+		: p0 - XMVectorGetX(XMVector3Dot(A.r[i], N));
+	float R = XMVectorGetByIndex(a, u) * fabs(XMVectorGetX(XMVector3Dot(A.r[v], E))) + XMVectorGetByIndex(a, v) * fabs(XMVectorGetX(XMVector3Dot(A.r[u], E)));
+
+	return checkCollision(L, p0, p1, R, p_Overlap, p_Least);
+}
+
 void Collision::checkCollisionDepth(float p_RA, float p_RB, float p_R, float &p_Overlap, XMVECTOR p_L, XMVECTOR &p_Least)
 {
 	float lLength = XMVectorGetX(XMVector4LengthSq(p_L));
@@ -981,9 +1005,9 @@ float Collision::raySphereIntersect(const Sphere &p_Sphere, const XMFLOAT4 &p_Ra
 
 	const XMVECTOR length = spherePos - rayOrigin;
 	////projection of lenght onto ray direction
-	float s = XMVector3Dot(length, rayDir).m128_f32[0];
+	float s = XMVectorGetX(XMVector3Dot(length, rayDir));
 
-	float lengthSquared = XMVector3Dot(length, length).m128_f32[0];
+	float lengthSquared = XMVectorGetX(XMVector3Dot(length, length));
 	float radiusSquared = p_Sphere.getSqrRadius();
 
 	if(s < 0 && lengthSquared > radiusSquared)
@@ -1011,52 +1035,357 @@ float Collision::raySphereIntersect(const Sphere &p_Sphere, const XMFLOAT4 &p_Ra
 	return t;
 }
 
+float Collision::raySphereIntersect(const Sphere &p_Sphere, const XMFLOAT4 &p_RayDirection, const XMFLOAT4 &p_RayOrigin,
+	XMFLOAT4 &p_Normal)
+{
+	const float t = raySphereIntersect(p_Sphere, p_RayDirection, p_RayOrigin);
+	if(t < 0.f)
+		return t;
+
+	const XMVECTOR hitPoint = XMLoadFloat4(&p_RayOrigin) + XMLoadFloat4(&p_RayDirection) * t;
+	const XMVECTOR normal = XMVector3Normalize(XMVectorSetW(hitPoint - XMLoadFloat4(&p_Sphere.getPosition()), 0.f));
+	XMStoreFloat4(&p_Normal, normal);
+
+	return t;
+}
+
 float Collision::rayTriangleIntersect(const Hull &p_Hull, const XMFLOAT4 &p_RayDirection, const XMFLOAT4 &p_RayOrigin)
 {
-	XMVECTOR RayDir = XMLoadFloat4(&p_RayDirection);
-	XMVECTOR RayOrigin = XMLoadFloat4(&p_RayOrigin);
+	XMFLOAT4 normal;
+	return rayTriangleIntersect(p_Hull, p_RayDirection, p_RayOrigin, normal);
+}
+
+float Collision::rayTriangleIntersect(const Hull &p_Hull, const XMFLOAT4 &p_RayDirection, const XMFLOAT4 &p_RayOrigin,
+	XMFLOAT4 &p_Normal)
+{
+	const XMVECTOR RayDir = XMVectorSetW(XMLoadFloat4(&p_RayDirection), 0.f);
+	const XMVECTOR RayOrigin = XMVectorSetW(XMLoadFloat4(&p_RayOrigin), 0.f);
 	float dist = FLT_MAX;
+	XMVECTOR hitNormal = g_XMZero;
 
-	for(unsigned int i = 0; i < p_Hull.getTriangleListSize(); i++)
+	//The hierarchy is built over the shared shape, so the ray is moved into its space instead.
+	//The direction is not normalized there, which keeps the distances along the ray.
+	XMFLOAT3 localOrigin, localDirection;
+	XMStoreFloat3(&localOrigin, p_Hull.toShapeSpace(RayOrigin));
+	XMStoreFloat3(&localDirection, p_Hull.toShapeDirection(RayDir));
+
+	p_Hull.getBVH().castRay(localOrigin, localDirection, FLT_MAX, [&] (unsigned int p_Triangle) -> float
 	{
-		float tempDist = 0.f;
 		//Triangle Vertices 
-		Triangle triangle = p_Hull.getTriangleInWorldCoord(i);
-		const XMVECTOR p0 = Vector4ToXMVECTOR(&triangle.corners[0]);
-		const XMVECTOR p1 = Vector4ToXMVECTOR(&triangle.corners[1]);
-		const XMVECTOR p2 = Vector4ToXMVECTOR(&triangle.corners[2]);
+		const Triangle triangle = p_Hull.getTriangleInWorldCoord(p_Triangle);
+		const XMVECTOR p0 = XMVectorSetW(Vector4ToXMVECTOR(&triangle.corners[0]), 0.f);
+		const XMVECTOR p1 = XMVectorSetW(Vector4ToXMVECTOR(&triangle.corners[1]), 0.f);
+		const XMVECTOR p2 = XMVectorSetW(Vector4ToXMVECTOR(&triangle.corners[2]), 0.f);
 
 		//Triangle egdes 
 		const XMVECTOR e1 = p1 - p0;
 		const XMVECTOR e2 = p2 - p0;
 
 		XMVECTOR q = XMVector3Cross(RayDir, e2);
-		float a = XMVector3Dot(e1, q).m128_f32[0];
+		float a = XMVectorGetX(XMVector3Dot(e1, q));
 		if(a > -EPSILON && a < EPSILON)
-			continue;
+			return -1.f;
 
 		float f = 1/a; //because math!
 
 		XMVECTOR s = RayOrigin - p0;
-		float u = f * XMVector3Dot(s, q).m128_f32[0];
+		float u = f * XMVectorGetX(XMVector3Dot(s, q));
 		if(u < 0.f)
-			continue;
+			return -1.f;
 
 		XMVECTOR r = XMVector3Cross(s, e1);
-		float v = f * XMVector3Dot(RayDir, r).m128_f32[0];
+		float v = f * XMVectorGetX(XMVector3Dot(RayDir, r));
 		if(v < 0.f || (u + v) > 1.f)
-			continue;
+			return -1.f;
 
-		float t = f * XMVector3Dot(e2, r).m128_f32[0];
+		float t = f * XMVectorGetX(XMVector3Dot(e2, r));
 
 		if(t > 0.f && t < dist)
 		{
 			dist = t;
+
+			//Let the normal face the ray origin
+			hitNormal = XMVector3Normalize(XMVector3Cross(e1, e2));
+			if(XMVectorGetX(XMVector3Dot(hitNormal, RayDir)) > 0.f)
+				hitNormal = -hitNormal;
 		}
-	}
+
+		return t;
+	});
 
 	if(dist == FLT_MAX)
 		return -1.f;
-	else
-		return dist;
-}
\ No newline at end of file
+
+	XMStoreFloat4(&p_Normal, hitNormal);
+	return dist;
+}
+
+bool Collision::rayAABBIntersect(const XMFLOAT4 &p_RayOrigin, const XMFLOAT4 &p_InvDirection,
+	const XMFLOAT4 &p_Min, const XMFLOAT4 &p_Max, float p_MaxDistance, float &p_EntryDistance)
+{
+	const float tx0 = (p_Min.x - p_RayOrigin.x) * p_InvDirection.x;
+	const float tx1 = (p_Max.x - p_RayOrigin.x) * p_InvDirection.x;
+	const float ty0 = (p_Min.y - p_RayOrigin.y) * p_InvDirection.y;
+	const float ty1 = (p_Max.y - p_RayOrigin.y) * p_InvDirection.y;
+	const float tz0 = (p_Min.z - p_RayOrigin.z) * p_InvDirection.z;
+	const float tz1 = (p_Max.z - p_RayOrigin.z) * p_InvDirection.z;
+
+	const float entry = std::max(std::max(0.f, std::min(tx0, tx1)), std::max(std::min(ty0, ty1), std::min(tz0, tz1)));
+	const float exit = std::min(std::min(p_MaxDistance, std::max(tx0, tx1)), std::min(std::max(ty0, ty1), std::max(tz0, tz1)));
+
+	p_EntryDistance = entry;
+	return entry <= exit;
+}
+
+float Collision::sweptSphereVsBoundingVolume(const Sphere &p_Sphere, const XMFLOAT4 &p_Movement,
+	const BoundingVolume &p_Volume, XMFLOAT4 &p_Normal)
+{
+	const XMVECTOR movement = XMVectorSetW(XMLoadFloat4(&p_Movement), 0.f);
+	XMVECTOR normal = g_XMZero;
+	float t = -1.f;
+
+	switch(p_Volume.getType())
+	{
+	case BoundingVolume::Type::SPHERE:
+		t = sweptSphereVsSphere(p_Sphere, movement, (const Sphere&)p_Volume, normal);
+		break;
+	case BoundingVolume::Type::AABBOX:
+		{
+			const AABB& aabb = (const AABB&)p_Volume;
+			t = sweptSphereVsBox(p_Sphere, movement, XMLoadFloat4(&aabb.getPosition()), XMMatrixIdentity(),
+				aabb.getHalfDiagonal(), normal);
+		}
+		break;
+	case BoundingVolume::Type::OBB:
+		{
+			const OBB& obb = (const OBB&)p_Volume;
+			const XMFLOAT4X4 axes = obb.getAxes();
+			t = sweptSphereVsBox(p_Sphere, movement, XMLoadFloat4(&obb.getPosition()), XMLoadFloat4x4(&axes),
+				obb.getExtents(), normal);
+		}
+		break;
+	case BoundingVolume::Type::HULL:
+		return sweptSphereVsHull(p_Sphere, p_Movement, (const Hull&)p_Volume, p_Normal);
+	default:
+		throw CollisionException("Collision error! Bounding volume type does not exist!", __LINE__, __FILE__);
+	}
+
+	if(t >= 0.f)
+		XMStoreFloat4(&p_Normal, normal);
+
+	return t;
+}
+
+float Collision::sweptSphereVsHull(const Sphere &p_Sphere, const XMFLOAT4 &p_Movement,
+	const Hull &p_Hull, XMFLOAT4 &p_Normal)
+{
+	const XMVECTOR center = XMVectorSetW(XMLoadFloat4(&p_Sphere.getPosition()), 1.f);
+	const XMVECTOR movement = XMVectorSetW(XMLoadFloat4(&p_Movement), 0.f);
+
+	//Cheap check against the sphere surrounding the whole path before looking at any triangles
+	XMFLOAT4 pathCenter;
+	XMStoreFloat4(&pathCenter, center + movement * 0.5f);
+	const Sphere path(p_Sphere.getRadius() + XMVectorGetX(XMVector3Length(movement)) * 0.5f, pathCenter);
+	if(!surroundingSphereVsSphere(*p_Hull.getSurroundingSphere(), path))
+		return -1.f;
+
+	const XMVECTOR radius = XMVectorReplicate(p_Sphere.getRadius());
+	const XMVECTOR end = center + movement;
+	const XMVECTOR pathMin = XMVectorMin(center, end) - radius;
+	const XMVECTOR pathMax = XMVectorMax(center, end) + radius;
+
+	float closest = FLT_MAX;
+	XMVECTOR closestNormal = g_XMZero;
+
+	p_Hull.findTrianglesInBox(pathMin, pathMax, [&] (unsigned int p_Triangle)
+	{
+		++g_TriangleTestCount;
+
+		XMVECTOR normal;
+		const float t = sweptSphereVsTriangle(center, p_Sphere.getRadius(), movement, p_Hull.getTriangleInWorldCoord(p_Triangle), normal);
+		if(t >= 0.f && t < closest)
+		{
+			closest = t;
+			closestNormal = normal;
+		}
+	});
+
+	if(closest == FLT_MAX)
+		return -1.f;
+
+	XMStoreFloat4(&p_Normal, closestNormal);
+	return closest;
+}
+
+float Collision::sweptSphereVsSphere(const Sphere &p_Sphere, FXMVECTOR p_Movement, const Sphere &p_Target, XMVECTOR &p_Normal)
+{
+	const XMVECTOR offset = XMVectorSetW(XMLoadFloat4(&p_Sphere.getPosition()) - XMLoadFloat4(&p_Target.getPosition()), 0.f);
+	const float t = sweptPointVsSphere(offset, p_Movement, p_Sphere.getRadius() + p_Target.getRadius());
+	if(t < 0.f)
+		return t;
+
+	p_Normal = XMVector3Normalize(offset + p_Movement * t);
+	return t;
+}
+
+float Collision::sweptSphereVsBox(const Sphere &p_Sphere, FXMVECTOR p_Movement, FXMVECTOR p_Center,
+	CXMMATRIX p_Axes, const XMFLOAT4 &p_Extents, XMVECTOR &p_Normal)
+{
+	//Sweep the center of the sphere against the box grown by the radius, in the space of the box
+	const XMVECTOR offset = XMVectorSetW(XMLoadFloat4(&p_Sphere.getPosition()) - p_Center, 0.f);
+	const float radius = p_Sphere.getRadius();
+	const float extents[3] = { p_Extents.x + radius, p_Extents.y + radius, p_Extents.z + radius };
+
+	float entry = 0.f;
+	float exit = 1.f;
+	int entryAxis = -1;
+	float entrySign = 0.f;
+
+	for(int i = 0; i < 3; i++)
+	{
+		const float start = XMVectorGetX(XMVector3Dot(offset, p_Axes.r[i]));
+		const float move = XMVectorGetX(XMVector3Dot(p_Movement, p_Axes.r[i]));
+
+		if(fabs(move) < EPSILON)
+		{
+			if(start < -extents[i] || start > extents[i])
+				return -1.f;
+			continue;
+		}
+
+		float t0 = (-extents[i] - start) / move;
+		float t1 = (extents[i] - start) / move;
+		float sign = -1.f;
+		if(t0 > t1)
+		{
+			std::swap(t0, t1);
+			sign = 1.f;
+		}
+
+		if(t0 > entry)
+		{
+			entry = t0;
+			entryAxis = i;
+			entrySign = sign;
+		}
+		exit = std::min(exit, t1);
+
+		if(entry > exit)
+			return -1.f;
+	}
+
+	//The sphere starts inside the grown box
+	if(entryAxis < 0)
+		return -1.f;
+
+	p_Normal = p_Axes.r[entryAxis] * entrySign;
+	return entry;
+}
+
+float Collision::sweptSphereVsTriangle(FXMVECTOR p_Center, float p_Radius, FXMVECTOR p_Movement,
+	const Triangle &p_Triangle, XMVECTOR &p_Normal)
+{
+	const XMVECTOR p0 = XMVectorSetW(Vector4ToXMVECTOR(&p_Triangle.corners[0]), 0.f);
+	const XMVECTOR p1 = XMVectorSetW(Vector4ToXMVECTOR(&p_Triangle.corners[1]), 0.f);
+	const XMVECTOR p2 = XMVectorSetW(Vector4ToXMVECTOR(&p_Triangle.corners[2]), 0.f);
+	const XMVECTOR center = XMVectorSetW(p_Center, 0.f);
+
+	XMVECTOR normal = XMVector3Cross(p1 - p0, p2 - p0);
+	if(XMVectorGetX(XMVector3LengthSq(normal)) < EPSILON * EPSILON)
+		return -1.f;
+	normal = XMVector3Normalize(normal);
+
+	//Both sides of the triangle are solid, use the side the sphere starts on
+	float startDistance = XMVectorGetX(XMVector3Dot(center - p0, normal));
+	if(startDistance < 0.f)
+	{
+		normal = -normal;
+		startDistance = -startDistance;
+	}
+
+	const float approachSpeed = -XMVectorGetX(XMVector3Dot(p_Movement, normal));
+	if(startDistance <= p_Radius || approachSpeed <= 0.f)
+		return -1.f;
+
+	//The sphere first touches the plane of the triangle, if that point is inside the triangle it is the hit
+	const float planeT = (startDistance - p_Radius) / approachSpeed;
+	if(planeT > 1.f)
+		return -1.f;
+
+	const XMVECTOR planePoint = center + p_Movement * planeT - normal * p_Radius;
+	const XMVECTOR c0 = XMVector3Cross(p1 - p0, planePoint - p0);
+	const XMVECTOR c1 = XMVector3Cross(p2 - p1, planePoint - p1);
+	const XMVECTOR c2 = XMVector3Cross(p0 - p2, planePoint - p2);
+	if(XMVectorGetX(XMVector3Dot(c0, normal)) >= 0.f &&
+		XMVectorGetX(XMVector3Dot(c1, normal)) >= 0.f &&
+		XMVectorGetX(XMVector3Dot(c2, normal)) >= 0.f)
+	{
+		p_Normal = normal;
+		return planeT;
+	}
+
+	//Otherwise the sphere can only hit an edge or a corner
+	float closest = FLT_MAX;
+	XMVECTOR closestPoint = g_XMZero;
+
+	const XMVECTOR corners[3] = { p0, p1, p2 };
+	for(int i = 0; i < 3; i++)
+	{
+		const float t = sweptPointVsSphere(center - corners[i], p_Movement, p_Radius);
+		if(t >= 0.f && t < closest)
+		{
+			closest = t;
+			closestPoint = corners[i];
+		}
+
+		//The edge is treated as a cylinder, the hit must be between the corners
+		const XMVECTOR edge = corners[(i + 1) % 3] - corners[i];
+		const float edgeLength = XMVectorGetX(XMVector3Length(edge));
+		if(edgeLength < EPSILON)
+			continue;
+
+		const XMVECTOR edgeDir = edge / edgeLength;
+		const XMVECTOR offset = center - corners[i];
+		const XMVECTOR perpOffset = offset - edgeDir * XMVector3Dot(offset, edgeDir);
+		const XMVECTOR perpMovement = p_Movement - edgeDir * XMVector3Dot(p_Movement, edgeDir);
+
+		const float edgeT = sweptPointVsSphere(perpOffset, perpMovement, p_Radius);
+		if(edgeT < 0.f || edgeT >= closest)
+			continue;
+
+		const float along = XMVectorGetX(XMVector3Dot(offset + p_Movement * edgeT, edgeDir));
+		if(along >= 0.f && along <= edgeLength)
+		{
+			closest = edgeT;
+			closestPoint = corners[i] + edgeDir * along;
+		}
+	}
+
+	if(closest == FLT_MAX)
+		return -1.f;
+
+	p_Normal = XMVector3Normalize(center + p_Movement * closest - closestPoint);
+	return closest;
+}
+
+float Collision::sweptPointVsSphere(FXMVECTOR p_Offset, FXMVECTOR p_Movement, float p_Radius)
+{
+	//Solve |offset + movement * t| = radius for the first t in [0, 1]
+	const float a = XMVectorGetX(XMVector3Dot(p_Movement, p_Movement));
+	const float b = 2.f * XMVectorGetX(XMVector3Dot(p_Offset, p_Movement));
+	const float c = XMVectorGetX(XMVector3Dot(p_Offset, p_Offset)) - p_Radius * p_Radius;
+
+	//Already touching, or not moving closer
+	if(c <= 0.f || b >= 0.f || a < EPSILON * EPSILON)
+		return -1.f;
+
+	const float discriminant = b * b - 4.f * a * c;
+	if(discriminant < 0.f)
+		return -1.f;
+
+	const float t = (-b - sqrtf(discriminant)) / (2.f * a);
+	if(t > 1.f)
+		return -1.f;
+
+	return t;
+}
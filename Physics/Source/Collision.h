@@ -1,15 +1,18 @@
 #pragma once
 #include "VolumeIncludeAll.h"
-#include "..\include\PhysicsTypes.h"
+#include "../include/PhysicsTypes.h"
+#include "SeparatingAxisCache.h"
 
 class Collision
 {
 public:
 	/**
 	* Redirect to the appropriate check, when neither BoundingVolumes' type is known.
+	* @param p_Cache the separating axes from the last test of the same pair, updated by the test. May be nullptr.
 	* @return HitData, see HitData definition.
 	*/
-	static HitData boundingVolumeVsBoundingVolume(BoundingVolume const &p_Volume1, BoundingVolume const &p_Volume2);
+	static HitData boundingVolumeVsBoundingVolume(BoundingVolume const &p_Volume1, BoundingVolume const &p_Volume2,
+		SeparatingAxisCache *p_Cache = nullptr);
 	/**
 	* Check for the appropriate collision, a BoundingVolume versus a sphere.
 	* @return HitData, see HitData definition.
@@ -19,19 +22,39 @@ public:
 	* Check for the appropriate collision, a BoundingVolume versus an AABB.
 	* @return HitData, see HitData definition.
 	*/
-	static HitData boundingVolumeVsAABB(BoundingVolume const &p_Volume, const AABB &p_AABB);
+	static HitData boundingVolumeVsAABB(BoundingVolume const &p_Volume, const AABB &p_AABB, SeparatingAxisCache *p_Cache = nullptr);
 	/**
 	* Check for the appropriate collision, a BoundingVolume versus an OBB.
 	* @return HitData, see HitData definition.
 	*/
-	static HitData boundingVolumeVsOBB(BoundingVolume const &p_Volume, const OBB &p_OBB);
+	static HitData boundingVolumeVsOBB(BoundingVolume const &p_Volume, const OBB &p_OBB, SeparatingAxisCache *p_Cache = nullptr);
 	/**
 	* Check for the appropriate collision, a BoundingVolume versus a Triangle.
 	* @return HitData, see HitData definition.
 	*/
-	static HitData boundingVolumeVsHull(BoundingVolume const &p_Volume, Hull const &p_Hull);
+	static HitData boundingVolumeVsHull(BoundingVolume const &p_Volume, Hull const &p_Hull, SeparatingAxisCache *p_Cache = nullptr);
 	
-	static bool Collision::surroundingSphereVsSphere(Sphere const &p_Sphere1, Sphere const &p_Sphere2);
+	static bool surroundingSphereVsSphere(Sphere const &p_Sphere1, Sphere const &p_Sphere2);
+
+	/**
+	 * Get the number of hull triangles tested against other volumes by the calling thread.
+	 * The count only ever grows, compare two calls to count the tests in between.
+	 * @return the number of triangle tests made by the calling thread
+	 */
+	static unsigned int getTriangleTestCount();
+
+	/**
+	 * Get the number of separating axis tests the calling thread ended on a cached axis.
+	 * The count only ever grows, compare two calls to count the exits in between.
+	 * @return the number of cached axis exits made by the calling thread
+	 */
+	static unsigned int getCachedAxisExitCount();
+
+	/**
+	 * Check if a pair of volumes is tested with the separating axis test, and can use a SeparatingAxisCache.
+	 * @return true if one volume is an OBB and the other is an OBB, an AABB or a hull
+	 */
+	static bool usesSeparatingAxes(BoundingVolume const &p_Volume1, BoundingVolume const &p_Volume2);
 
 	/**
 	* Sphere versus Sphere collision
@@ -64,7 +87,7 @@ public:
 	* the actual AABBvsAABB collision check. ##
 	* @return HitData, see HitData definition.
 	*/
-	static HitData OBBvsOBB(OBB const &p_OBB1, OBB const &p_OBB2);
+	static HitData OBBvsOBB(OBB const &p_OBB1, OBB const &p_OBB2, SeparatingAxisCache *p_Cache = nullptr);
 	/**
 	* OBB versus Sphere collision test
 	* Uses Seperating axes test to check for collision
@@ -76,14 +99,14 @@ public:
 	* Uses Seperating axes test to check for collision
 	* @return HitData, see HitData definition.
 	*/
-	static HitData OBBvsAABB(OBB const &p_OBB, AABB const &p_AABB);
+	static HitData OBBvsAABB(OBB const &p_OBB, AABB const &p_AABB, SeparatingAxisCache *p_Cache = nullptr);
 
 	/**
 	 * OBB Versus Hull collision test
 	 * Uses seperating axis test to check for collision
 	 * @return HitData, see HitData definition.
 	 */
-	static HitData OBBVsHull(OBB const &p_OBB, Hull const &p_Hull);
+	static HitData OBBVsHull(OBB const &p_OBB, Hull const &p_Hull, SeparatingAxisCache *p_Cache = nullptr);
 	/**
 	* Triangle versus Sphere collision test
 	* @return HitData, see HitData definition.
@@ -107,11 +130,95 @@ public:
 	 * @param, p_RayOrigin origin of the ray in world space
 	 * @returns true if there an intersection otherwise false
 	 */
-	static float Collision::rayTriangleIntersect(const Hull &p_Hull, const DirectX::XMFLOAT4 &p_RayDirection, const DirectX::XMFLOAT4 &p_RayOrigin);
+	static float rayTriangleIntersect(const Hull &p_Hull, const DirectX::XMFLOAT4 &p_RayDirection, const DirectX::XMFLOAT4 &p_RayOrigin);
+
+	/**
+	 * Find the closest point where a ray hits a sphere.
+	 * @param p_Normal set to the sphere normal at the hit point if the ray hits
+	 * @returns the distance along the ray to the hit, or a negative value if the ray misses
+	 */
+	static float raySphereIntersect(const Sphere &p_Sphere, const DirectX::XMFLOAT4 &p_RayDirection, const DirectX::XMFLOAT4 &p_RayOrigin,
+		DirectX::XMFLOAT4 &p_Normal);
+
+	/**
+	 * Find the closest point where a ray hits a triangle in a hull.
+	 * Only the triangles along the ray are tested, using the triangle hierarchy of the hull.
+	 * @param p_Normal set to the normal of the hit triangle, facing the ray origin, if the ray hits
+	 * @returns the distance along the ray to the hit, or a negative value if the ray misses
+	 */
+	static float rayTriangleIntersect(const Hull &p_Hull, const DirectX::XMFLOAT4 &p_RayDirection, const DirectX::XMFLOAT4 &p_RayOrigin,
+		DirectX::XMFLOAT4 &p_Normal);
+
+	/**
+	 * Check if a ray hits an axis aligned box before a given distance.
+	 * @param p_InvDirection the reciprocal of each component of the ray direction
+	 * @param p_MaxDistance the length of the ray, in lengths of the direction
+	 * @param p_EntryDistance set to the distance where the ray enters the box, 0 if it starts inside
+	 * @returns true if the ray hits the box
+	 */
+	static bool rayAABBIntersect(const DirectX::XMFLOAT4 &p_RayOrigin, const DirectX::XMFLOAT4 &p_InvDirection,
+		const DirectX::XMFLOAT4 &p_Min, const DirectX::XMFLOAT4 &p_Max, float p_MaxDistance, float &p_EntryDistance);
+
+	/**
+	 * Find when a moving sphere first touches a bounding volume.
+	 * Volumes the sphere already overlaps at the start are ignored, the discrete tests handle those.
+	 * Boxes are swept as boxes grown by the radius of the sphere, which touches a little early at the corners.
+	 * @param p_Sphere the sphere at the start of the movement
+	 * @param p_Movement how far the sphere moves, in m
+	 * @param p_Volume the volume that is not moving
+	 * @param p_Normal set to the normal of the touched surface, facing the sphere, if the sphere touches the volume
+	 * @returns the fraction of the movement done when the sphere touches the volume, or a negative value if it never does
+	 */
+	static float sweptSphereVsBoundingVolume(const Sphere &p_Sphere, const DirectX::XMFLOAT4 &p_Movement,
+		const BoundingVolume &p_Volume, DirectX::XMFLOAT4 &p_Normal);
+
+	/**
+	 * Find when a moving sphere first touches a triangle in a hull.
+	 * Only the triangles near the path of the sphere are tested, using the triangle hierarchy of the hull.
+	 * @see sweptSphereVsBoundingVolume
+	 */
+	static float sweptSphereVsHull(const Sphere &p_Sphere, const DirectX::XMFLOAT4 &p_Movement,
+		const Hull &p_Hull, DirectX::XMFLOAT4 &p_Normal);
 
 private:
-	static HitData SATBoxVsBox(OBB const &p_OBB, BoundingVolume const &p_vol);
-	static HitData SATBoxVsHull(OBB const &p_OBB, Hull const &p_Hull);
+	static float sweptSphereVsSphere(const Sphere &p_Sphere, DirectX::FXMVECTOR p_Movement, const Sphere &p_Target, DirectX::XMVECTOR &p_Normal);
+	static float sweptSphereVsBox(const Sphere &p_Sphere, DirectX::FXMVECTOR p_Movement, DirectX::FXMVECTOR p_Center,
+		DirectX::CXMMATRIX p_Axes, const DirectX::XMFLOAT4 &p_Extents, DirectX::XMVECTOR &p_Normal);
+	static float sweptSphereVsTriangle(DirectX::FXMVECTOR p_Center, float p_Radius, DirectX::FXMVECTOR p_Movement,
+		const Triangle &p_Triangle, DirectX::XMVECTOR &p_Normal);
+	static float sweptPointVsSphere(DirectX::FXMVECTOR p_Offset, DirectX::FXMVECTOR p_Movement, float p_Radius);
+
+	static const unsigned int numBoxAxes = 15;
+	static const unsigned int numTriangleAxes = 13;
+
+	/**
+	 * The box and triangle of a box versus triangle test, relative to the box center.
+	 */
+	struct BoxTriangle
+	{
+		DirectX::XMMATRIX boxAxes;
+		DirectX::XMVECTOR halfSize;
+		DirectX::XMVECTOR toTriangle;	// From the box center to the first corner
+		DirectX::XMVECTOR normal;
+		DirectX::XMVECTOR edges[3];
+	};
+
+	static HitData SATBoxVsBox(OBB const &p_OBB, BoundingVolume const &p_vol, SeparatingAxisCache *p_Cache);
+	static HitData SATBoxVsHull(OBB const &p_OBB, Hull const &p_Hull, SeparatingAxisCache *p_Cache);
+	/**
+	 * Project two boxes on one of the 15 separating axes, the three axes of the first box,
+	 * the three axes of the second box and the nine cross products of the axes.
+	 * @return true if the boxes are separated on the axis
+	 */
+	static bool boxAxisSeparates(unsigned int p_Axis, const DirectX::XMFLOAT4X4 &p_R, const DirectX::XMFLOAT4X4 &p_AbsR,
+		const float *p_T, const float *p_AExtents, const float *p_BExtents,
+		float &p_RA, float &p_RB, float &p_Distance);
+	/**
+	 * Project a box and a triangle on one of the 13 separating axes, the triangle normal,
+	 * the three box axes and the nine cross products of the box axes and the triangle edges.
+	 * @return true if the box and the triangle overlap on the axis
+	 */
+	static bool boxTriangleAxisOverlaps(unsigned int p_Axis, const BoxTriangle &p_BoxTriangle, float &p_Overlap, DirectX::XMVECTOR &p_Least);
 	static void checkCollisionDepth(float p_RA, float p_RB, float p_R, float &p_Overlap, DirectX::XMVECTOR p_L, DirectX::XMVECTOR &p_Least);
 	static bool checkCollision(DirectX::XMVECTOR p_Axis, float p_TriangleProjection0, float p_TriangleProjection1,
 							   float p_BoxProjection, float &p_Overlap, DirectX::XMVECTOR &p_Least);
@@ -0,0 +1,43 @@
+#pragma once
+#include "../include/TriangleBVH.h"
+
+#include <cstdint>
+
+/**
+ * Layout of the binary collision mesh files (.btxc) written by the BinaryConverter.
+ *
+ * A file starts with a Header, followed by the corners of every triangle as
+ * DirectX::XMFLOAT4, three per triangle. If the header has any nodes the nodes of the
+ * triangle hierarchy follow, and after them the triangle indices of the hierarchy.
+ * The corners are stored in the same units and handedness as BVLoader gives from a
+ * text file, so the arrays can be used straight from a mapped view of the file.
+ */
+namespace CollisionMeshFormat
+{
+	static const char fileMagic[4] = { 'B', 'T', 'X', 'C' };
+	static const uint32_t fileVersion = 1;
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t numTriangles;
+		uint32_t numNodes;
+		uint32_t numTriangleIndices;
+		char meshName[44]; // Zero terminated
+	};
+
+	/**
+	 * Get the size of a file with the given contents.
+	 *
+	 * @param p_Header the header of the file
+	 * @return the size of the whole file in bytes
+	 */
+	inline uint64_t getFileSize(const Header& p_Header)
+	{
+		return sizeof(Header)
+			+ (uint64_t)p_Header.numTriangles * 3 * sizeof(DirectX::XMFLOAT4)
+			+ (uint64_t)p_Header.numNodes * sizeof(TriangleBVH::Node)
+			+ (uint64_t)p_Header.numTriangleIndices * sizeof(uint32_t);
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "PhysicsTypes.h"
+
+#include <stdexcept>
+#include <vector>
+
+/**
+ * Storage for the hit data produced during physics steps.
+ *
+ * Clearing the buffer only resets the count, the storage is kept and only
+ * grows when a step produces more contacts than any step before it.
+ */
+class ContactBuffer
+{
+private:
+	std::vector<HitData> m_Contacts;
+	size_t m_NumContacts;
+
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param p_Capacity the number of contacts to preallocate storage for
+	 */
+	explicit ContactBuffer(size_t p_Capacity = 0) :
+		m_Contacts(p_Capacity),
+		m_NumContacts(0)
+	{
+	}
+
+	/**
+	 * Make sure there is storage for at least the given number of contacts.
+	 */
+	void reserve(size_t p_Capacity)
+	{
+		if (p_Capacity > m_Contacts.size())
+		{
+			m_Contacts.resize(p_Capacity);
+		}
+	}
+
+	/**
+	 * Remove all contacts without releasing the storage.
+	 */
+	void clear()
+	{
+		m_NumContacts = 0;
+	}
+
+	void add(const HitData& p_Hit)
+	{
+		if (m_NumContacts == m_Contacts.size())
+		{
+			m_Contacts.resize(m_Contacts.empty() ? 16 : m_Contacts.size() * 2);
+		}
+
+		m_Contacts[m_NumContacts] = p_Hit;
+		++m_NumContacts;
+	}
+
+	/**
+	 * Add all contacts from another buffer, keeping their order.
+	 */
+	void append(const ContactBuffer& p_Other)
+	{
+		reserve(m_NumContacts + p_Other.m_NumContacts);
+
+		for (size_t i = 0; i < p_Other.m_NumContacts; ++i)
+		{
+			m_Contacts[m_NumContacts + i] = p_Other.m_Contacts[i];
+		}
+		m_NumContacts += p_Other.m_NumContacts;
+	}
+
+	size_t size() const
+	{
+		return m_NumContacts;
+	}
+
+	size_t capacity() const
+	{
+		return m_Contacts.size();
+	}
+
+	/**
+	 * Get a contact.
+	 *
+	 * @param p_Index the index of the contact, throws std::out_of_range if invalid
+	 */
+	const HitData& at(size_t p_Index) const
+	{
+		if (p_Index >= m_NumContacts)
+			throw std::out_of_range("Contact index out of range");
+
+		return m_Contacts[p_Index];
+	}
+
+	const HitData& operator[](size_t p_Index) const
+	{
+		return m_Contacts[p_Index];
+	}
+};
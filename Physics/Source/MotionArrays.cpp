@@ -0,0 +1,202 @@
+#include "MotionArrays.h"
+
+#include <DirectXMath.h>
+
+#include <algorithm>
+
+using namespace DirectX;
+
+MotionArrays::MotionArrays() :
+	m_NumRows(0),
+	m_Capacity(0)
+{
+}
+
+size_t MotionArrays::size() const
+{
+	return m_NumRows;
+}
+
+void MotionArrays::reserve(size_t p_NumRows)
+{
+	if (p_NumRows > m_Capacity)
+		grow(p_NumRows);
+}
+
+void MotionArrays::clear()
+{
+	m_NumRows = 0;
+}
+
+size_t MotionArrays::addRow()
+{
+	if (m_NumRows == m_Capacity)
+		grow(std::max(m_Capacity * 2, (size_t)batchWidth));
+
+	const size_t row = m_NumRows++;
+	for (unsigned int i = 0; i < NUM_COLUMNS; ++i)
+		column((Column)i)[row] = 0.f;
+
+	return row;
+}
+
+void MotionArrays::popRow()
+{
+	--m_NumRows;
+}
+
+void MotionArrays::copyRow(size_t p_Row, const MotionArrays& p_Source, size_t p_SourceRow)
+{
+	for (unsigned int i = 0; i < NUM_COLUMNS; ++i)
+		column((Column)i)[p_Row] = p_Source.at((Column)i, p_SourceRow);
+}
+
+void MotionArrays::swapRows(size_t p_First, size_t p_Second)
+{
+	for (unsigned int i = 0; i < NUM_COLUMNS; ++i)
+	{
+		float* values = column((Column)i);
+		std::swap(values[p_First], values[p_Second]);
+	}
+}
+
+float& MotionArrays::at(Column p_Column, size_t p_Row)
+{
+	return m_Data[p_Column * m_Capacity + p_Row];
+}
+
+float MotionArrays::at(Column p_Column, size_t p_Row) const
+{
+	return m_Data[p_Column * m_Capacity + p_Row];
+}
+
+void MotionArrays::integrate(size_t p_First, size_t p_Last, float p_DeltaTime)
+{
+	// Only batches aligned to the batch width are integrated as vectors, so that a batch
+	// never straddles the boundary between the ranges of two threads
+	const size_t firstBatch = std::min((p_First + batchWidth - 1) / batchWidth * batchWidth, p_Last);
+
+	size_t row = p_First;
+	for (; row < firstBatch; ++row)
+		integrateRow(row, p_DeltaTime);
+
+	for (; row + batchWidth <= p_Last; row += batchWidth)
+		integrateBatch(row, p_DeltaTime);
+
+	for (; row < p_Last; ++row)
+		integrateRow(row, p_DeltaTime);
+}
+
+float* MotionArrays::column(Column p_Column)
+{
+	return m_Data.data() + p_Column * m_Capacity;
+}
+
+void MotionArrays::grow(size_t p_Capacity)
+{
+	// Whole batches always fit, even at the end of the arrays
+	const size_t capacity = (p_Capacity + batchWidth - 1) / batchWidth * batchWidth;
+
+	std::vector<float> data(NUM_COLUMNS * capacity, 0.f);
+	for (unsigned int i = 0; i < NUM_COLUMNS; ++i)
+	{
+		const float* oldColumn = column((Column)i);
+		std::copy(oldColumn, oldColumn + m_NumRows, data.begin() + i * capacity);
+	}
+
+	m_Data.swap(data);
+	m_Capacity = capacity;
+}
+
+void MotionArrays::integrateRow(size_t p_Row, float p_DeltaTime)
+{
+	if (at(AWAKE, p_Row) == 0.f)
+		return;
+
+	// Same operations in the same order as the batch, so both give the same result
+	const float halfDeltaTimeSq = 0.5f * p_DeltaTime * p_DeltaTime;
+	const float mass = at(MASS, p_Row);
+
+	for (unsigned int axis = 0; axis < 3; ++axis)
+	{
+		float& position = at((Column)(POSITION_X + axis), p_Row);
+		float& velocity = at((Column)(VELOCITY_X + axis), p_Row);
+		float& avgAcc = at((Column)(AVG_ACC_X + axis), p_Row);
+
+		const float lastAcc = avgAcc;
+		const float relativePos = lastAcc * halfDeltaTimeSq + velocity * p_DeltaTime;
+
+		float newAcc = 0.f;
+		if (mass != 0.f)
+		{
+			newAcc = at((Column)(NET_FORCE_X + axis), p_Row) / mass;
+			if (axis == 1)
+				newAcc -= at(GRAVITY, p_Row);
+		}
+
+		at((Column)(PREVIOUS_X + axis), p_Row) = position;
+		at((Column)(TRANSLATION_X + axis), p_Row) = relativePos;
+		at((Column)(LAST_ACC_X + axis), p_Row) = lastAcc;
+		at((Column)(NEW_ACC_X + axis), p_Row) = newAcc;
+
+		position += relativePos;
+		avgAcc = (lastAcc + newAcc) * 0.5f;
+		velocity = avgAcc * p_DeltaTime + velocity;
+	}
+}
+
+static XMVECTOR loadBatch(const float* p_Values)
+{
+	return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p_Values));
+}
+
+/**
+ * Store the lanes of a new value that are set in the mask, keeping the old value in the other lanes.
+ */
+static void storeBatch(float* p_Values, FXMVECTOR p_OldValue, FXMVECTOR p_NewValue, FXMVECTOR p_Mask)
+{
+	XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(p_Values), XMVectorSelect(p_OldValue, p_NewValue, p_Mask));
+}
+
+void MotionArrays::integrateBatch(size_t p_FirstRow, float p_DeltaTime)
+{
+	// Each lane of a vector holds the same component of a different body
+	const XMVECTOR deltaTime = XMVectorReplicate(p_DeltaTime);
+	const XMVECTOR halfDeltaTimeSq = XMVectorReplicate(0.5f * p_DeltaTime * p_DeltaTime);
+
+	const XMVECTOR awake = XMVectorGreater(loadBatch(column(AWAKE) + p_FirstRow), g_XMZero);
+	const XMVECTOR mass = loadBatch(column(MASS) + p_FirstRow);
+	const XMVECTOR hasMass = XMVectorNotEqual(mass, g_XMZero);
+
+	for (unsigned int axis = 0; axis < 3; ++axis)
+	{
+		float* position = column((Column)(POSITION_X + axis)) + p_FirstRow;
+		float* velocity = column((Column)(VELOCITY_X + axis)) + p_FirstRow;
+		float* avgAcc = column((Column)(AVG_ACC_X + axis)) + p_FirstRow;
+		float* previous = column((Column)(PREVIOUS_X + axis)) + p_FirstRow;
+		float* translation = column((Column)(TRANSLATION_X + axis)) + p_FirstRow;
+		float* lastAcc = column((Column)(LAST_ACC_X + axis)) + p_FirstRow;
+		float* newAcc = column((Column)(NEW_ACC_X + axis)) + p_FirstRow;
+
+		const XMVECTOR vPosition = loadBatch(position);
+		const XMVECTOR vVelocity = loadBatch(velocity);
+		const XMVECTOR vLastAcc = loadBatch(avgAcc);
+
+		const XMVECTOR relativePos = XMVectorMultiplyAdd(vLastAcc, halfDeltaTimeSq, XMVectorMultiply(vVelocity, deltaTime));
+
+		XMVECTOR vNewAcc = XMVectorDivide(loadBatch(column((Column)(NET_FORCE_X + axis)) + p_FirstRow), mass);
+		if (axis == 1)
+			vNewAcc = XMVectorSubtract(vNewAcc, loadBatch(column(GRAVITY) + p_FirstRow));
+		vNewAcc = XMVectorSelect(g_XMZero, vNewAcc, hasMass);
+
+		const XMVECTOR vAvgAcc = XMVectorMultiply(XMVectorAdd(vLastAcc, vNewAcc), g_XMOneHalf);
+
+		storeBatch(previous, loadBatch(previous), vPosition, awake);
+		storeBatch(translation, loadBatch(translation), relativePos, awake);
+		storeBatch(lastAcc, loadBatch(lastAcc), vLastAcc, awake);
+		storeBatch(newAcc, loadBatch(newAcc), vNewAcc, awake);
+		storeBatch(position, vPosition, XMVectorAdd(vPosition, relativePos), awake);
+		storeBatch(avgAcc, vLastAcc, vAvgAcc, awake);
+		storeBatch(velocity, vVelocity, XMVectorMultiplyAdd(vAvgAcc, deltaTime, vVelocity), awake);
+	}
+}
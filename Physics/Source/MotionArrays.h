@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * The state of bodies that is changed by the integration, stored as one array
+ * per vector component (structure of arrays) instead of per body.
+ *
+ * Each row holds the motion of one body. Storing the components in separate
+ * arrays lets the integrator load the same component of several bodies into
+ * one SIMD register, so all lanes of the vector units do useful work.
+ */
+class MotionArrays
+{
+public:
+	/**
+	 * The columns of the arrays. Vectors without w are stored as
+	 * three columns, their w component is always 0.
+	 */
+	enum Column
+	{
+		POSITION_X, POSITION_Y, POSITION_Z, POSITION_W,		// m
+		PREVIOUS_X, PREVIOUS_Y, PREVIOUS_Z,					// m, before the last update
+		VELOCITY_X, VELOCITY_Y, VELOCITY_Z,					// m/s
+		NET_FORCE_X, NET_FORCE_Y, NET_FORCE_Z,				// kg*m/s^2
+		LAST_ACC_X, LAST_ACC_Y, LAST_ACC_Z,					// m/s^2
+		AVG_ACC_X, AVG_ACC_Y, AVG_ACC_Z,					// m/s^2
+		NEW_ACC_X, NEW_ACC_Y, NEW_ACC_Z,					// m/s^2
+		TRANSLATION_X, TRANSLATION_Y, TRANSLATION_Z,		// m, moved by the last update
+		MASS,												// kg
+		GRAVITY,											// m/s^2
+		AWAKE,												// 1 if the row is integrated, 0 if sleeping
+
+		NUM_COLUMNS
+	};
+
+	/**
+	 * The number of rows integrated at a time by the vectorized kernel.
+	 */
+	static const size_t batchWidth = 4;
+
+private:
+	std::vector<float> m_Data;
+	size_t m_NumRows;
+	size_t m_Capacity;
+
+public:
+	MotionArrays();
+
+	/**
+	 * @return the number of rows
+	 */
+	size_t size() const;
+
+	/**
+	 * Make room for more rows, so that adding them does not move the stored rows more than once.
+	 *
+	 * @param p_NumRows the total number of rows to make room for
+	 */
+	void reserve(size_t p_NumRows);
+
+	/**
+	 * Remove all rows.
+	 */
+	void clear();
+
+	/**
+	 * Add a row with all columns set to zero.
+	 *
+	 * @return the index of the new row
+	 */
+	size_t addRow();
+
+	/**
+	 * Remove the last row.
+	 */
+	void popRow();
+
+	/**
+	 * Copy all columns of a row from other arrays.
+	 *
+	 * @param p_Row the row to overwrite
+	 * @param p_Source the arrays to copy from
+	 * @param p_SourceRow the row to copy
+	 */
+	void copyRow(size_t p_Row, const MotionArrays& p_Source, size_t p_SourceRow);
+
+	/**
+	 * Exchange the contents of two rows.
+	 */
+	void swapRows(size_t p_First, size_t p_Second);
+
+	/**
+	 * Access one value.
+	 *
+	 * @param p_Column the column of the value
+	 * @param p_Row the row of the value
+	 */
+	float& at(Column p_Column, size_t p_Row);
+	float at(Column p_Column, size_t p_Row) const;
+
+	/**
+	 * Advance the awake rows in a range with velocity Verlet integration.
+	 * Rows in the range that are sleeping are left untouched.
+	 *
+	 * The range is split so that only whole batches of rows are loaded
+	 * into vector registers, which lets several threads integrate
+	 * neighbouring ranges at the same time.
+	 *
+	 * @param p_First the first row to integrate
+	 * @param p_Last one past the last row to integrate
+	 * @param p_DeltaTime the time to advance, in s
+	 */
+	void integrate(size_t p_First, size_t p_Last, float p_DeltaTime);
+
+private:
+	float* column(Column p_Column);
+	void grow(size_t p_Capacity);
+	void integrateRow(size_t p_Row, float p_DeltaTime);
+	void integrateBatch(size_t p_FirstRow, float p_DeltaTime);
+};
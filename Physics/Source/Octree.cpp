@@ -3,14 +3,31 @@
 #include "Collision.h"
 #include "Sphere.h"
 
+#include <algorithm>
+
 using namespace DirectX;
 
+static unsigned int spreadMortonBits(unsigned int p_Value)
+{
+	p_Value &= 0x3ff;
+	p_Value = (p_Value | (p_Value << 16)) & 0x030000ff;
+	p_Value = (p_Value | (p_Value << 8)) & 0x0300f00f;
+	p_Value = (p_Value | (p_Value << 4)) & 0x030c30c3;
+	p_Value = (p_Value | (p_Value << 2)) & 0x09249249;
+	return p_Value;
+}
+
+static unsigned int getOctant(unsigned int p_Code, unsigned int p_Depth, unsigned int p_BitsPerAxis)
+{
+	return (p_Code >> (3 * (p_BitsPerAxis - 1 - p_Depth))) & 7;
+}
+
 Octree::Node::Node(const DirectX::XMFLOAT4& p_MinPos, const DirectX::XMFLOAT4& p_MaxPos) :
-	m_IsLeaf(true),
 	m_MinPos(p_MinPos),
 	m_MaxPos(p_MaxPos),
-	m_LargeBodies(0),
-	m_NumBodies(0)
+	m_IsLeaf(true),
+	m_NumBodies(0),
+	m_LargeBodies(0)
 {
 }
 
@@ -122,6 +139,23 @@ void Octree::Node::removeBody(BodyHandle p_Body, const Sphere* p_Sphere)
 	}
 }
 
+void Octree::Node::collectBodies(std::vector<Volume>& p_Bodies) const
+{
+	p_Bodies.insert(p_Bodies.end(), m_LargeBodies.begin(), m_LargeBodies.end());
+
+	if (m_IsLeaf)
+	{
+		p_Bodies.insert(p_Bodies.end(), m_Bodies.begin(), m_Bodies.begin() + m_NumBodies);
+	}
+	else
+	{
+		for (const auto& childNode : m_Children)
+		{
+			childNode->collectBodies(p_Bodies);
+		}
+	}
+}
+
 void Octree::Node::expand()
 {
 	createChildren();
@@ -179,17 +213,27 @@ bool Octree::Node::isLarge(const Volume& p_Body)
 	return Collision::AABBInsideSphere(m_MinPos, m_MaxPos, *p_Body.sphere);
 }
 
-Octree::Octree()
+Octree::Octree() :
+	m_NumTreeBodies(0),
+	m_NumLinearBodies(0)
 {
 }
 
 void Octree::reset()
 {
 	m_RootNode.reset();
+	m_NumTreeBodies = 0;
+
+	m_LinearNodes.clear();
+	m_LinearBodies.clear();
+	m_LinearLargeBodies.clear();
+	m_NumLinearBodies = 0;
 }
 
 void Octree::addBody(BodyHandle p_Body, const Sphere* p_Sphere)
 {
+	++m_NumTreeBodies;
+
 	if (!m_RootNode)
 	{
 		const XMFLOAT4 center = p_Sphere->getPosition();
@@ -210,10 +254,56 @@ void Octree::addBody(BodyHandle p_Body, const Sphere* p_Sphere)
 
 void Octree::removeBody(BodyHandle p_Body, const Sphere* p_Sphere)
 {
+	if (removeLinearBody(p_Body, p_Sphere))
+		return;
+
 	if (!m_RootNode)
 		return;
 
 	m_RootNode->removeBody(p_Body, p_Sphere);
+	if (m_NumTreeBodies > 0)
+	{
+		--m_NumTreeBodies;
+	}
+}
+
+void Octree::addBodies(const BodyHandle* p_Bodies, const Sphere* const* p_Spheres, size_t p_NumBodies)
+{
+	std::vector<Volume> bodies;
+	collectLinearBodies(bodies);
+	bodies.reserve(bodies.size() + m_NumTreeBodies + p_NumBodies);
+
+	if (m_RootNode)
+	{
+		// Bodies overlapping several nodes are stored in each of them
+		const size_t firstTreeBody = bodies.size();
+		m_RootNode->collectBodies(bodies);
+		std::sort(bodies.begin() + firstTreeBody, bodies.end(),
+			[] (const Volume& p_Lhs, const Volume& p_Rhs) { return p_Lhs.handle < p_Rhs.handle; });
+		bodies.erase(std::unique(bodies.begin() + firstTreeBody, bodies.end(),
+			[] (const Volume& p_Lhs, const Volume& p_Rhs) { return p_Lhs.handle == p_Rhs.handle; }),
+			bodies.end());
+	}
+
+	for (size_t i = 0; i < p_NumBodies; ++i)
+	{
+		bodies.push_back(Volume(p_Bodies[i], p_Spheres[i]));
+	}
+
+	m_RootNode.reset();
+	m_NumTreeBodies = 0;
+
+	buildLinear(bodies);
+}
+
+void Octree::rebuild()
+{
+	addBodies(nullptr, nullptr, 0);
+}
+
+size_t Octree::getNumUnsortedBodies() const
+{
+	return m_NumTreeBodies;
 }
 
 const DirectX::XMFLOAT4& Octree::getMinPos() const
@@ -241,9 +331,9 @@ const DirectX::XMFLOAT4& Octree::getMaxPos() const
 size_t Octree::getBodyCount() const
 {
 	if (!m_RootNode)
-		return 0;
+		return m_NumLinearBodies;
 
-	return m_RootNode->getBodyCount();
+	return m_NumLinearBodies + m_RootNode->getBodyCount();
 }
 
 void Octree::increaseSize(const DirectX::XMFLOAT4& p_Target)
@@ -302,3 +392,208 @@ void Octree::increaseSize(const DirectX::XMFLOAT4& p_Target)
 	newRoot->swapRoot(m_RootNode, index);
 	std::swap(m_RootNode, newRoot);
 }
+
+void Octree::buildLinear(std::vector<Volume>& p_Bodies)
+{
+	m_LinearNodes.clear();
+	m_LinearBodies.clear();
+	m_LinearLargeBodies.clear();
+	m_NumLinearBodies = p_Bodies.size();
+
+	if (p_Bodies.empty())
+		return;
+
+	XMVECTOR minCenter = XMLoadFloat4(&p_Bodies[0].sphere->getPosition());
+	XMVECTOR maxCenter = minCenter;
+	for (const auto& body : p_Bodies)
+	{
+		const XMVECTOR center = XMLoadFloat4(&body.sphere->getPosition());
+		minCenter = XMVectorMin(minCenter, center);
+		maxCenter = XMVectorMax(maxCenter, center);
+	}
+	XMFLOAT3 extents;
+	XMStoreFloat3(&extents, XMVectorSubtract(maxCenter, minCenter));
+	const float maxExtent = std::max(extents.x, std::max(extents.y, extents.z));
+
+	// Bodies covering a large part of the level would make every node on their path as large,
+	// such as the ground, so they are kept in a list of their own
+	m_LinearBodies.reserve(p_Bodies.size());
+	for (const auto& body : p_Bodies)
+	{
+		if (maxExtent > 0.f && body.sphere->getRadius() >= maxExtent * 0.25f)
+		{
+			m_LinearLargeBodies.push_back(body);
+		}
+		else
+		{
+			m_LinearBodies.push_back(body);
+		}
+	}
+
+	if (m_LinearBodies.empty())
+		return;
+
+	const unsigned int maxCoord = (1 << mortonBitsPerAxis) - 1;
+	const float scale = maxExtent > 0.f ? (float)maxCoord / maxExtent : 0.f;
+
+	std::vector<std::pair<unsigned int, unsigned int>> sortKeys(m_LinearBodies.size());
+	for (unsigned int i = 0; i < m_LinearBodies.size(); ++i)
+	{
+		XMFLOAT3 coord;
+		XMStoreFloat3(&coord, XMVectorScale(XMVectorSubtract(XMLoadFloat4(&m_LinearBodies[i].sphere->getPosition()), minCenter), scale));
+
+		const unsigned int code =
+			(spreadMortonBits(std::min((unsigned int)coord.x, maxCoord)) << 2) |
+			(spreadMortonBits(std::min((unsigned int)coord.y, maxCoord)) << 1) |
+			spreadMortonBits(std::min((unsigned int)coord.z, maxCoord));
+		sortKeys[i] = std::make_pair(code, i);
+	}
+	std::sort(sortKeys.begin(), sortKeys.end());
+
+	std::vector<Volume> sortedBodies(m_LinearBodies.size());
+	std::vector<unsigned int> codes(m_LinearBodies.size());
+	for (unsigned int i = 0; i < sortKeys.size(); ++i)
+	{
+		codes[i] = sortKeys[i].first;
+		sortedBodies[i] = m_LinearBodies[sortKeys[i].second];
+	}
+	m_LinearBodies.swap(sortedBodies);
+
+	m_LinearNodes.reserve(2 * (m_LinearBodies.size() / linearBodiesPerLeaf + 1));
+	m_LinearNodes.resize(1);
+	buildLinearNode(0, codes, 0, (unsigned int)codes.size(), 0);
+}
+
+void Octree::buildLinearNode(unsigned int p_NodeIndex, const std::vector<unsigned int>& p_Codes,
+	unsigned int p_First, unsigned int p_Last, unsigned int p_Depth)
+{
+	// Skip the levels where all bodies fall in the same octant, the codes are sorted
+	// so it is enough to compare the first and the last
+	while (p_Depth < mortonBitsPerAxis && p_Last - p_First > linearBodiesPerLeaf &&
+		getOctant(p_Codes[p_First], p_Depth, mortonBitsPerAxis) == getOctant(p_Codes[p_Last - 1], p_Depth, mortonBitsPerAxis))
+	{
+		++p_Depth;
+	}
+
+	XMVECTOR minPos;
+	XMVECTOR maxPos;
+
+	if (p_Last - p_First <= linearBodiesPerLeaf || p_Depth == mortonBitsPerAxis)
+	{
+		const Sphere* sphere = m_LinearBodies[p_First].sphere;
+		const XMVECTOR radius = XMVectorReplicate(sphere->getRadius());
+		minPos = XMVectorSubtract(XMLoadFloat4(&sphere->getPosition()), radius);
+		maxPos = XMVectorAdd(XMLoadFloat4(&sphere->getPosition()), radius);
+		for (unsigned int i = p_First + 1; i < p_Last; ++i)
+		{
+			sphere = m_LinearBodies[i].sphere;
+			const XMVECTOR bodyRadius = XMVectorReplicate(sphere->getRadius());
+			minPos = XMVectorMin(minPos, XMVectorSubtract(XMLoadFloat4(&sphere->getPosition()), bodyRadius));
+			maxPos = XMVectorMax(maxPos, XMVectorAdd(XMLoadFloat4(&sphere->getPosition()), bodyRadius));
+		}
+
+		LinearNode& node = m_LinearNodes[p_NodeIndex];
+		node.firstChild = 0;
+		node.numChildren = 0;
+		node.firstBody = p_First;
+		node.numBodies = p_Last - p_First;
+	}
+	else
+	{
+		unsigned int childFirst[8];
+		unsigned int numChildren = 0;
+		for (unsigned int i = p_First; i < p_Last; ++i)
+		{
+			if (i == p_First ||
+				getOctant(p_Codes[i], p_Depth, mortonBitsPerAxis) != getOctant(p_Codes[i - 1], p_Depth, mortonBitsPerAxis))
+			{
+				childFirst[numChildren++] = i;
+			}
+		}
+
+		// The children are placed next to each other before any of them are built
+		const unsigned int firstChild = (unsigned int)m_LinearNodes.size();
+		m_LinearNodes.resize(m_LinearNodes.size() + numChildren);
+		for (unsigned int i = 0; i < numChildren; ++i)
+		{
+			const unsigned int childLast = i + 1 < numChildren ? childFirst[i + 1] : p_Last;
+			buildLinearNode(firstChild + i, p_Codes, childFirst[i], childLast, p_Depth + 1);
+		}
+
+		minPos = XMLoadFloat4(&m_LinearNodes[firstChild].minPos);
+		maxPos = XMLoadFloat4(&m_LinearNodes[firstChild].maxPos);
+		for (unsigned int i = firstChild + 1; i < firstChild + numChildren; ++i)
+		{
+			minPos = XMVectorMin(minPos, XMLoadFloat4(&m_LinearNodes[i].minPos));
+			maxPos = XMVectorMax(maxPos, XMLoadFloat4(&m_LinearNodes[i].maxPos));
+		}
+
+		LinearNode& node = m_LinearNodes[p_NodeIndex];
+		node.firstChild = firstChild;
+		node.numChildren = numChildren;
+		node.firstBody = 0;
+		node.numBodies = 0;
+	}
+
+	LinearNode& node = m_LinearNodes[p_NodeIndex];
+	XMStoreFloat4(&node.minPos, XMVectorSetW(minPos, 1.f));
+	XMStoreFloat4(&node.maxPos, XMVectorSetW(maxPos, 1.f));
+}
+
+void Octree::collectLinearBodies(std::vector<Volume>& p_Bodies) const
+{
+	p_Bodies.reserve(p_Bodies.size() + m_NumLinearBodies);
+	p_Bodies.insert(p_Bodies.end(), m_LinearLargeBodies.begin(), m_LinearLargeBodies.end());
+
+	for (const auto& node : m_LinearNodes)
+	{
+		p_Bodies.insert(p_Bodies.end(), m_LinearBodies.begin() + node.firstBody,
+			m_LinearBodies.begin() + node.firstBody + node.numBodies);
+	}
+}
+
+bool Octree::removeLinearBody(BodyHandle p_Body, const Sphere* p_Sphere)
+{
+	for (auto& largeBody : m_LinearLargeBodies)
+	{
+		if (largeBody.handle == p_Body)
+		{
+			std::swap(largeBody, m_LinearLargeBodies.back());
+			m_LinearLargeBodies.pop_back();
+			--m_NumLinearBodies;
+			return true;
+		}
+	}
+
+	if (m_LinearNodes.empty())
+		return false;
+
+	unsigned int stack[linearStackSize];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		LinearNode& node = m_LinearNodes[stack[--stackSize]];
+		if (!Collision::AABBvsSphereIntersect(node.minPos, node.maxPos, *p_Sphere))
+			continue;
+
+		// Removed bodies are moved past the end of their leaf, the bounds are left as they are
+		for (unsigned int i = node.firstBody; i < node.firstBody + node.numBodies; ++i)
+		{
+			if (m_LinearBodies[i].handle == p_Body)
+			{
+				std::swap(m_LinearBodies[i], m_LinearBodies[node.firstBody + node.numBodies - 1]);
+				--node.numBodies;
+				--m_NumLinearBodies;
+				return true;
+			}
+		}
+		for (unsigned int i = 0; i < node.numChildren; ++i)
+		{
+			stack[stackSize++] = node.firstChild + i;
+		}
+	}
+
+	return false;
+}
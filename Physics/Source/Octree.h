@@ -30,6 +30,27 @@ private:
 		}
 	};
 
+	/**
+	 * Node of the bulk built part of the tree.
+	 *
+	 * The nodes are stored in one array with the children of a node next to each other,
+	 * and the bodies of every leaf are a range of one array sorted along a Morton curve.
+	 * The bounds of a node are the bounds of the bodies below it.
+	 */
+	struct LinearNode
+	{
+		DirectX::XMFLOAT4 minPos;
+		DirectX::XMFLOAT4 maxPos;
+		unsigned int firstChild;
+		unsigned int numChildren;	// 0 for leaves
+		unsigned int firstBody;
+		unsigned int numBodies;		// 0 for inner nodes
+	};
+
+	static const unsigned int mortonBitsPerAxis = 10;
+	static const unsigned int linearBodiesPerLeaf = 8;
+	static const unsigned int linearStackSize = 7 * mortonBitsPerAxis + 2;
+
 	class Node
 	{
 	public:
@@ -61,6 +82,7 @@ private:
 		void addBody(const Volume& p_Body);
 		void addBodyIfIntersect(const Volume& p_Body);
 		void removeBody(BodyHandle p_Body, const Sphere* p_Sphere);
+		void collectBodies(std::vector<Volume>& p_Bodies) const;
 
 		template <typename OutIt>
 		void findPotentialIntersections(const Sphere* p_Sphere, OutIt p_Output) const
@@ -89,6 +111,57 @@ private:
 			}
 		}
 
+		template <typename Func>
+		void castRay(const DirectX::XMFLOAT4& p_Origin, const DirectX::XMFLOAT4& p_InvDirection, float& p_MaxDistance, Func& p_Func) const
+		{
+			for (const auto& largeBody : m_LargeBodies)
+			{
+				testRayBody(largeBody.handle, p_MaxDistance, p_Func);
+			}
+
+			if (m_IsLeaf)
+			{
+				for (size_t i = 0; i < m_NumBodies; ++i)
+				{
+					testRayBody(m_Bodies[i].handle, p_MaxDistance, p_Func);
+				}
+				return;
+			}
+
+			// Visit the children in the order the ray enters them
+			float entryDistances[8];
+			size_t order[8];
+			size_t numHit = 0;
+			for (size_t i = 0; i < m_Children.size(); ++i)
+			{
+				float entryDistance;
+				if (!Collision::rayAABBIntersect(p_Origin, p_InvDirection, m_Children[i]->m_MinPos, m_Children[i]->m_MaxPos,
+					p_MaxDistance, entryDistance))
+				{
+					continue;
+				}
+
+				size_t j = numHit;
+				while (j > 0 && entryDistances[j - 1] > entryDistance)
+				{
+					entryDistances[j] = entryDistances[j - 1];
+					order[j] = order[j - 1];
+					--j;
+				}
+				entryDistances[j] = entryDistance;
+				order[j] = i;
+				++numHit;
+			}
+
+			for (size_t i = 0; i < numHit; ++i)
+			{
+				if (entryDistances[i] > p_MaxDistance)
+					break;
+
+				m_Children[order[i]]->castRay(p_Origin, p_InvDirection, p_MaxDistance, p_Func);
+			}
+		}
+
 	private:
 		void expand();
 		void createChildren();
@@ -97,6 +170,12 @@ private:
 	};
 
 	Node::uPtr m_RootNode;
+	size_t m_NumTreeBodies;
+
+	std::vector<LinearNode> m_LinearNodes;
+	std::vector<Volume> m_LinearBodies;
+	std::vector<Volume> m_LinearLargeBodies;
+	size_t m_NumLinearBodies;
 
 public:
 	Octree();
@@ -106,20 +185,198 @@ public:
 	void addBody(BodyHandle p_Body, const Sphere* p_Sphere);
 	void removeBody(BodyHandle p_Body, const Sphere* p_Sphere);
 
+	/**
+	 * Add many bodies at once, such as when a level is loaded.
+	 *
+	 * The bodies already in the tree and the new bodies are sorted along a Morton curve
+	 * and stored in a tree of nodes in one array, which is much faster to search
+	 * than the tree built one body at a time.
+	 *
+	 * @param p_Bodies the handles of the bodies
+	 * @param p_Spheres the surrounding spheres of the bodies, must outlive the bodies in the tree
+	 * @param p_NumBodies the number of bodies
+	 */
+	void addBodies(const BodyHandle* p_Bodies, const Sphere* const* p_Spheres, size_t p_NumBodies);
+
+	/**
+	 * Move all bodies added one at a time into the bulk built part of the tree.
+	 */
+	void rebuild();
+
+	/**
+	 * @return the number of bodies added one at a time since the tree was last built in bulk
+	 */
+	size_t getNumUnsortedBodies() const;
+
 	const DirectX::XMFLOAT4& getMinPos() const;
 	const DirectX::XMFLOAT4& getMaxPos() const;
 
 	size_t getBodyCount() const;
 
+	/**
+	 * Find the bodies that might intersect a sphere,
+	 * a body can be found more than once.
+	 *
+	 * @param p_Sphere the sphere to search with
+	 * @param p_Output output iterator receiving the handles of the bodies
+	 */
 	template <typename OutIt>
 	void findPotentialIntersections(const Sphere* p_Sphere, OutIt p_Output) const
 	{
+		findLinearIntersections(p_Sphere, p_Output);
+
+		if (m_RootNode)
+		{
+			m_RootNode->findPotentialIntersections(p_Sphere, p_Output);
+		}
+	}
+
+	/**
+	 * Visit the bodies along a ray, closest nodes first.
+	 * Nodes further away than the closest hit so far are skipped,
+	 * a body overlapping several nodes can be visited more than once.
+	 *
+	 * @param p_Origin the origin of the ray
+	 * @param p_Direction the direction of the ray
+	 * @param p_MaxDistance the length of the ray, in lengths of the direction
+	 * @param p_Func called with each body to test, returns the distance to the hit
+	 *			along the ray or a negative value if the body was missed
+	 */
+	template <typename Func>
+	void castRay(const DirectX::XMFLOAT4& p_Origin, const DirectX::XMFLOAT4& p_Direction, float p_MaxDistance, Func p_Func) const
+	{
+		const DirectX::XMFLOAT4 invDirection(1.f / p_Direction.x, 1.f / p_Direction.y, 1.f / p_Direction.z, 0.f);
+
+		castLinearRay(p_Origin, invDirection, p_MaxDistance, p_Func);
+
 		if (!m_RootNode)
 			return;
 
-		m_RootNode->findPotentialIntersections(p_Sphere, p_Output);
+		float entryDistance;
+		if (!Collision::rayAABBIntersect(p_Origin, invDirection, m_RootNode->getMinPos(), m_RootNode->getMaxPos(),
+			p_MaxDistance, entryDistance))
+		{
+			return;
+		}
+
+		m_RootNode->castRay(p_Origin, invDirection, p_MaxDistance, p_Func);
 	}
 
 private:
 	void increaseSize(const DirectX::XMFLOAT4& p_Target);
+
+	void buildLinear(std::vector<Volume>& p_Bodies);
+	void buildLinearNode(unsigned int p_NodeIndex, const std::vector<unsigned int>& p_Codes,
+		unsigned int p_First, unsigned int p_Last, unsigned int p_Depth);
+	void collectLinearBodies(std::vector<Volume>& p_Bodies) const;
+	bool removeLinearBody(BodyHandle p_Body, const Sphere* p_Sphere);
+
+	template <typename Func>
+	static void testRayBody(BodyHandle p_Body, float& p_MaxDistance, Func& p_Func)
+	{
+		const float distance = p_Func(p_Body);
+		if (distance > 0.f && distance < p_MaxDistance)
+		{
+			p_MaxDistance = distance;
+		}
+	}
+
+	template <typename OutIt>
+	void findLinearIntersections(const Sphere* p_Sphere, OutIt& p_Output) const
+	{
+		for (const auto& largeBody : m_LinearLargeBodies)
+		{
+			if (Collision::surroundingSphereVsSphere(*largeBody.sphere, *p_Sphere))
+			{
+				*p_Output++ = largeBody.handle;
+			}
+		}
+
+		if (m_LinearNodes.empty())
+			return;
+
+		unsigned int stack[linearStackSize];
+		unsigned int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const LinearNode& node = m_LinearNodes[stack[--stackSize]];
+			if (!Collision::AABBvsSphereIntersect(node.minPos, node.maxPos, *p_Sphere))
+				continue;
+
+			for (unsigned int i = node.firstBody; i < node.firstBody + node.numBodies; ++i)
+			{
+				*p_Output++ = m_LinearBodies[i].handle;
+			}
+			for (unsigned int i = 0; i < node.numChildren; ++i)
+			{
+				stack[stackSize++] = node.firstChild + i;
+			}
+		}
+	}
+
+	template <typename Func>
+	void castLinearRay(const DirectX::XMFLOAT4& p_Origin, const DirectX::XMFLOAT4& p_InvDirection, float& p_MaxDistance, Func& p_Func) const
+	{
+		for (const auto& largeBody : m_LinearLargeBodies)
+		{
+			testRayBody(largeBody.handle, p_MaxDistance, p_Func);
+		}
+
+		if (m_LinearNodes.empty())
+			return;
+
+		struct StackEntry
+		{
+			unsigned int node;
+			float distance;
+		};
+		StackEntry stack[linearStackSize];
+		unsigned int stackSize = 0;
+
+		float entryDistance;
+		if (!Collision::rayAABBIntersect(p_Origin, p_InvDirection, m_LinearNodes[0].minPos, m_LinearNodes[0].maxPos,
+			p_MaxDistance, entryDistance))
+		{
+			return;
+		}
+		stack[stackSize].node = 0;
+		stack[stackSize].distance = entryDistance;
+		++stackSize;
+
+		while (stackSize > 0)
+		{
+			const StackEntry entry = stack[--stackSize];
+			if (entry.distance > p_MaxDistance)
+				continue;
+
+			const LinearNode& node = m_LinearNodes[entry.node];
+			for (unsigned int i = node.firstBody; i < node.firstBody + node.numBodies; ++i)
+			{
+				testRayBody(m_LinearBodies[i].handle, p_MaxDistance, p_Func);
+			}
+
+			// Push the children furthest first so the closest child is visited first
+			const unsigned int firstEntry = stackSize;
+			for (unsigned int i = node.firstChild; i < node.firstChild + node.numChildren; ++i)
+			{
+				if (!Collision::rayAABBIntersect(p_Origin, p_InvDirection, m_LinearNodes[i].minPos, m_LinearNodes[i].maxPos,
+					p_MaxDistance, entryDistance))
+				{
+					continue;
+				}
+
+				unsigned int j = stackSize;
+				while (j > firstEntry && stack[j - 1].distance < entryDistance)
+				{
+					stack[j] = stack[j - 1];
+					--j;
+				}
+				stack[j].node = i;
+				stack[j].distance = entryDistance;
+				++stackSize;
+			}
+		}
+	}
 };
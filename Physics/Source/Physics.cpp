@@ -3,10 +3,25 @@
 #include "PhysicsLogger.h"
 #include "PhysicsExceptions.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <iterator>
+
 using namespace DirectX;
 
+static const size_t initialContactCapacity = 256;
+static const size_t minBodiesPerBatch = 8;
+static const unsigned int minRaysPerBatch = 8;
+static const size_t minUnsortedStaticBodies = 64;
+static const float sleepSpeed = 0.05f;	// m/s
+static const float sleepDelay = 0.5f;	// s
+static const float wakeDistance = 0.001f;	// m
+static const float sweepSkin = 0.005f;	// m
+
 Physics::Physics(void)
-	: m_GlobalGravity(30.f)
+	: m_GlobalGravity(30.f),
+	  m_StepCount(0),
+	  m_BatchingBodies(false)
 {}
 
 Physics::~Physics()
@@ -32,16 +47,10 @@ void IPhysics::deletePhysics(IPhysics* p_Physics)
 
 Body* Physics::findBody(BodyHandle p_Body)
 {
-	auto findRes = m_Bodies.find(p_Body);
-	if (findRes == m_Bodies.end())
-	{
-		return nullptr;
-	}
-
-	return &findRes->second;
+	return m_Bodies.find(p_Body);
 }
 
-void Physics::initialize(bool p_IsServer, float p_Timestep)
+void Physics::initialize(bool p_IsServer, float p_Timestep, unsigned int p_NumThreads)
 {
 	PhysicsLogger::log(PhysicsLogger::Level::INFO, "Initializing physics");
 
@@ -50,6 +59,16 @@ void Physics::initialize(bool p_IsServer, float p_Timestep)
 	m_IsServer = p_IsServer;
 	m_Timestep = p_Timestep;
 	m_LeftOverTime = 0.f;
+	m_StepCount = 0;
+	m_HitDatas.reserve(initialContactCapacity);
+
+	const unsigned int numThreads = std::max(p_NumThreads, 1u);
+	if (numThreads > 1)
+	{
+		PhysicsLogger::log(PhysicsLogger::Level::INFO, "Using " + std::to_string(numThreads) + " physics threads");
+	}
+	m_WorkerPool.start(numThreads);
+	m_StaticCheckBatches.resize(numThreads);
 }
 
 void Physics::update(float p_DeltaTime, unsigned p_MaxSteps)
@@ -57,6 +76,13 @@ void Physics::update(float p_DeltaTime, unsigned p_MaxSteps)
 	m_LeftOverTime += p_DeltaTime;
 	unsigned int itr = 0;
 
+	// Static bodies created one at a time, such as while loading a level, are moved
+	// into the bulk built part of the octree once there are enough of them
+	if (!m_BatchingBodies && m_Octree.getNumUnsortedBodies() >= minUnsortedStaticBodies)
+	{
+		rebuildStaticOctree();
+	}
+
 	m_HitDatas.clear();
 	while (m_LeftOverTime >= m_Timestep)
 	{
@@ -68,52 +94,271 @@ void Physics::update(float p_DeltaTime, unsigned p_MaxSteps)
 		}
 
 		m_LeftOverTime -= m_Timestep;
+		++m_StepCount;
 
-		for(BodyHandle movableBodyHandle : m_MovableBodies)
-		{
-			Body& b = *findBody(movableBodyHandle);
+		m_Profiler.beginStep();
+		m_StepCounters = PhysicsStepStats();
+		const size_t firstHit = m_HitDatas.size();
+
+		integrateMovableBodies();
+		m_Profiler.endPhase(&PhysicsStepStats::integrationTime);
 
-			b.update(m_Timestep);
+		checkStaticCollisions();
+		m_Profiler.endPhase(&PhysicsStepStats::staticCollisionTime);
 
-			b.setLanded(false);
+		m_Broadphase.update();
+		m_Broadphase.findPairs(m_MovablePairs);
+		m_StepCounters.broadphaseCandidates += m_MovablePairs.size();
+		m_Profiler.endPhase(&PhysicsStepStats::broadphaseTime);
 
-			bool isOnGround = false;
+		const unsigned int firstTriangleTest = Collision::getTriangleTestCount();
+		const unsigned int firstCachedAxisExit = Collision::getCachedAxisExitCount();
+		for (const auto& movablePair : m_MovablePairs)
+		{
+			Body& b1 = *findBody(movablePair.first);
+			Body& b2 = *findBody(movablePair.second);
 
-			m_Octree.findPotentialIntersections(
-				b.getSurroundingSphere(),
-					std::inserter(m_PotentialIntersections, m_PotentialIntersections.end()));
+			if (b1.getIsSleeping() && b2.getIsSleeping())
+				continue;
 
-			for (const auto& potentialIntersection : m_PotentialIntersections)
+			pairCollisionCheck(b1, b2);
+		}
+		m_StepCounters.triangleTests += Collision::getTriangleTestCount() - firstTriangleTest;
+		m_StepCounters.cachedAxisExits += Collision::getCachedAxisExitCount() - firstCachedAxisExit;
+		m_Profiler.endPhase(&PhysicsStepStats::pairCollisionTime);
+
+		updateSleeping();
+
+		if(!m_IsServer)
+		{
+			for(size_t i = 0; i < m_Bodies.getMovableCount(); ++i)
 			{
-				if(b.getHandle() == potentialIntersection)
-					continue;
+				Body& b = m_Bodies[i];
 
-				Body& b2 = *findBody(potentialIntersection);
-				
-				singleCollisionCheck(b, b2, isOnGround);
+				b.setOnSomething(b.getGroundContact());
+				b.setInAir(!b.getGroundContact());
 			}
-			m_PotentialIntersections.clear();
+		}
 
-			for (BodyHandle otherMovableHandle : m_MovableBodies)
-			{
-				if (b.getHandle() == otherMovableHandle)
-					continue;
+		m_StepCounters.hits = m_HitDatas.size() - firstHit;
+		m_Profiler.endStep(m_StepCounters);
+	}
+}
+
+size_t Physics::getNumMovableBatches() const
+{
+	const size_t numBodies = m_Bodies.getMovableCount();
 
-				Body& b2 = *findBody(otherMovableHandle);
+	return std::min<size_t>(m_StaticCheckBatches.size(),
+		(numBodies + minBodiesPerBatch - 1) / minBodiesPerBatch);
+}
 
-				singleCollisionCheck(b, b2, isOnGround);
-			}
+void Physics::integrateMovableBodies()
+{
+	const size_t numBodies = m_Bodies.getMovableCount();
+	const size_t numBatches = getNumMovableBatches();
+
+	if (numBatches <= 1)
+	{
+		integrateBodyRange(0, numBodies);
+		return;
+	}
+
+	m_WorkerPool.run(numBatches, [this, numBodies, numBatches] (unsigned int p_Batch)
+	{
+		integrateBodyRange(numBodies * p_Batch / numBatches, numBodies * (p_Batch + 1) / numBatches);
+	});
+}
+
+void Physics::integrateBodyRange(size_t p_First, size_t p_Last)
+{
+	m_Bodies.integrate(p_First, p_Last, m_Timestep);
+
+	for(size_t i = p_First; i < p_Last; ++i)
+	{
+		Body& b = m_Bodies[i];
+
+		// Forget the volume pairs that were not tested in the last step
+		b.evictSeparatingAxisCaches(m_StepCount - 1);
+
+		if (b.getIsSleeping())
+			continue;
+
+		b.applyIntegratedMotion();
+
+		b.setLanded(false);
+		b.setGroundContact(false);
+	}
+}
+
+void Physics::checkStaticCollisions()
+{
+	const size_t numBodies = m_Bodies.getMovableCount();
+	const size_t numBatches = getNumMovableBatches();
+
+	if (numBatches <= 1)
+	{
+		const unsigned int firstTriangleTest = Collision::getTriangleTestCount();
+		const unsigned int firstCachedAxisExit = Collision::getCachedAxisExitCount();
+		for(size_t i = 0; i < numBodies; ++i)
+		{
+			staticCollisionCheck(m_Bodies[i], m_PotentialIntersections, m_HitDatas, m_StepCounters);
+		}
+		m_StepCounters.triangleTests += Collision::getTriangleTestCount() - firstTriangleTest;
+		m_StepCounters.cachedAxisExits += Collision::getCachedAxisExitCount() - firstCachedAxisExit;
+		return;
+	}
+
+	// Each movable body is only modified by the batch it belongs to and the static bodies
+	// are only read, so the batches can run in parallel. The batches are split in storage
+	// order and merged in the same order, giving the same contacts as a serial step.
+	m_WorkerPool.run(numBatches, [this, numBodies, numBatches] (unsigned int p_Batch)
+	{
+		StaticCheckBatch& batch = m_StaticCheckBatches[p_Batch];
+		batch.contacts.clear();
+		batch.counters = PhysicsStepStats();
+
+		// The triangle test and cached axis exit counts are kept per thread
+		const unsigned int firstTriangleTest = Collision::getTriangleTestCount();
+		const unsigned int firstCachedAxisExit = Collision::getCachedAxisExitCount();
+		const size_t first = numBodies * p_Batch / numBatches;
+		const size_t last = numBodies * (p_Batch + 1) / numBatches;
+		for (size_t i = first; i < last; ++i)
+		{
+			staticCollisionCheck(m_Bodies[i], batch.potentialIntersections, batch.contacts, batch.counters);
+		}
+		batch.counters.triangleTests += Collision::getTriangleTestCount() - firstTriangleTest;
+		batch.counters.cachedAxisExits += Collision::getCachedAxisExitCount() - firstCachedAxisExit;
+	});
+
+	for (size_t i = 0; i < numBatches; ++i)
+	{
+		m_HitDatas.append(m_StaticCheckBatches[i].contacts);
+		StepProfiler::addCounters(m_StepCounters, m_StaticCheckBatches[i].counters);
+	}
+}
+
+void Physics::staticCollisionCheck(Body& p_Collider, std::vector<BodyHandle>& p_PotentialIntersections, ContactBuffer& p_Contacts,
+	PhysicsStepStats& p_Counters)
+{
+	if (p_Collider.getIsSleeping())
+		return;
+
+	if (p_Collider.getContinuousCollision())
+	{
+		sweepStaticCollision(p_Collider, p_PotentialIntersections);
+	}
+
+	m_Octree.findPotentialIntersections(
+		p_Collider.getSurroundingSphere(),
+			std::back_inserter(p_PotentialIntersections));
+
+	// Bodies overlapping several octree nodes are reported once per node
+	std::sort(p_PotentialIntersections.begin(), p_PotentialIntersections.end());
+	p_PotentialIntersections.erase(
+		std::unique(p_PotentialIntersections.begin(), p_PotentialIntersections.end()),
+		p_PotentialIntersections.end());
+	p_Counters.broadphaseCandidates += p_PotentialIntersections.size();
+
+	for (const auto& potentialIntersection : p_PotentialIntersections)
+	{
+		if(p_Collider.getHandle() == potentialIntersection)
+			continue;
+
+		Body& b2 = *findBody(potentialIntersection);
+
+		singleCollisionCheck(p_Collider, b2, p_Contacts, p_Counters);
+	}
+	p_PotentialIntersections.clear();
+}
+
+void Physics::sweepStaticCollision(Body& p_Collider, std::vector<BodyHandle>& p_PotentialIntersections)
+{
+	const XMFLOAT4 previousPosition = p_Collider.getPreviousPosition();
+	const XMVECTOR start = XMLoadFloat4(&previousPosition);
+	const XMFLOAT4 position = p_Collider.getPosition();
+	const XMVECTOR movement = XMVectorSetW(XMLoadFloat4(&position) - start, 0.f);
+	const float distance = XMVectorGetX(XMVector3Length(movement));
+	const float radius = getSweepRadius(p_Collider);
+
+	// Bodies moving less than their own size in a step are caught by the discrete tests
+	if (distance <= radius)
+		return;
 
-			if(!m_IsServer)
+	XMFLOAT4 pathCenter;
+	XMStoreFloat4(&pathCenter, XMVectorSetW(start + movement * 0.5f, 1.f));
+	const Sphere path(distance * 0.5f + p_Collider.getSurroundingSphere()->getRadius(), pathCenter);
+	m_Octree.findPotentialIntersections(&path, std::back_inserter(p_PotentialIntersections));
+	std::sort(p_PotentialIntersections.begin(), p_PotentialIntersections.end());
+	p_PotentialIntersections.erase(
+		std::unique(p_PotentialIntersections.begin(), p_PotentialIntersections.end()),
+		p_PotentialIntersections.end());
+
+	XMFLOAT4 startPosition;
+	XMStoreFloat4(&startPosition, XMVectorSetW(start, 1.f));
+	const Sphere sweptSphere(radius, startPosition);
+	XMFLOAT4 fMovement;
+	XMStoreFloat4(&fMovement, movement);
+
+	float firstHit = 1.f;
+	XMFLOAT4 hitNormal(0.f, 0.f, 0.f, 0.f);
+	for (const auto& potentialIntersection : p_PotentialIntersections)
+	{
+		Body& victim = *findBody(potentialIntersection);
+		if (victim.getIsEdge())
+			continue;
+
+		for (unsigned int i = 0; i < victim.getVolumeListSize(); ++i)
+		{
+			if (!victim.getCollisionResponse(i))
+				continue;
+
+			XMFLOAT4 normal;
+			const float t = Collision::sweptSphereVsBoundingVolume(sweptSphere, fMovement, *victim.getVolume(i), normal);
+			if (t >= 0.f && t < firstHit)
 			{
-				b.setOnSomething(isOnGround);
-				b.setInAir(!isOnGround);
+				firstHit = t;
+				hitNormal = normal;
 			}
 		}
 	}
+	p_PotentialIntersections.clear();
+
+	if (firstHit >= 1.f)
+		return;
+
+	// Stop the body where it first touched, a little into the surface so the discrete tests
+	// find the contact and respond to it like any other
+	const XMVECTOR stopPosition = start + movement * firstHit - XMLoadFloat4(&hitNormal) * sweepSkin;
+	XMFLOAT4 newPosition;
+	XMStoreFloat4(&newPosition, XMVectorSetW(stopPosition, 1.f));
+	p_Collider.setPosition(newPosition);
+}
+
+float Physics::getSweepRadius(const Body& p_Body)
+{
+	// The largest sphere inside the main volume, so the sweep never stops a body that would not have touched anything
+	const BoundingVolume& volume = *p_Body.getVolume();
+	switch (volume.getType())
+	{
+	case BoundingVolume::Type::SPHERE:
+		return ((const Sphere&)volume).getRadius();
+	case BoundingVolume::Type::AABBOX:
+		{
+			const XMFLOAT4 halfDiagonal = ((const AABB&)volume).getHalfDiagonal();
+			return std::min(halfDiagonal.x, std::min(halfDiagonal.y, halfDiagonal.z));
+		}
+	case BoundingVolume::Type::OBB:
+		{
+			const XMFLOAT4 extents = ((const OBB&)volume).getExtents();
+			return std::min(extents.x, std::min(extents.y, extents.z));
+		}
+	default:
+		return 0.f;
+	}
 }
 
-void Physics::singleCollisionCheck(Body& p_Collider, Body& p_Victim, bool& p_IsOnGround)
+void Physics::singleCollisionCheck(Body& p_Collider, Body& p_Victim, ContactBuffer& p_Contacts, PhysicsStepStats& p_Counters)
 {
 	if (!Collision::surroundingSphereVsSphere(*p_Collider.getSurroundingSphere(), *p_Victim.getSurroundingSphere()))
 		return;
@@ -122,7 +367,14 @@ void Physics::singleCollisionCheck(Body& p_Collider, Body& p_Victim, bool& p_IsO
 	{
 		for(unsigned int l = 0; l < p_Victim.getVolumeListSize(); l++)
 		{
-			HitData hit = Collision::boundingVolumeVsBoundingVolume(*p_Collider.getVolume(k), *p_Victim.getVolume(l));
+			const BoundingVolume& volume = *p_Collider.getVolume(k);
+			const BoundingVolume& victimVolume = *p_Victim.getVolume(l);
+			SeparatingAxisCache* cache = Collision::usesSeparatingAxes(volume, victimVolume)
+				? p_Collider.getSeparatingAxisCache(p_Victim.getHandle(), k, l, m_StepCount)
+				: nullptr;
+
+			++p_Counters.volumeTests;
+			HitData hit = Collision::boundingVolumeVsBoundingVolume(volume, victimVolume, cache);
 	
 			if(hit.intersect)
 			{
@@ -134,23 +386,209 @@ void Physics::singleCollisionCheck(Body& p_Collider, Body& p_Victim, bool& p_IsO
 					XMFLOAT4 fBodyPos = p_Collider.getPosition();
 					XMFLOAT4 fVictimPos = p_Victim.getPosition();
 					Sphere s = ((Hull*)p_Victim.getVolume(l))->getSphere();
-					float r  = ((Sphere*)p_Collider.getVolume(0))->getRadius();
 					if((s.getRadius() < 1.55f && fVictimPos.y > fBodyPos.y - 0.35f && fVictimPos.y < fBodyPos.y))
 					{
 						//PhysicsLogger::log(PhysicsLogger::Level::INFO, "StepSize");
 						setBodyForceCollisionNormal(p_Collider.getHandle(), p_Victim.getHandle(), true);
 					}
 					else
-						handleCollision(hit, p_Collider, k, p_Victim, l, p_IsOnGround);
+						handleCollision(hit, p_Collider, k, p_Victim, l, p_Contacts);
 				}
 				else
-					handleCollision(hit, p_Collider, k, p_Victim, l, p_IsOnGround);
+					handleCollision(hit, p_Collider, k, p_Victim, l, p_Contacts);
+			}
+		}
+	}
+}
+
+/**
+ * The normal returned from a volume test points from the second volume towards
+ * the first, so that moving the first body along it separates the volumes,
+ * as long as the first volume does not have a higher order than the second.
+ */
+static int getNormalOrder(BoundingVolume::Type p_Type)
+{
+	switch (p_Type)
+	{
+	case BoundingVolume::Type::SPHERE:
+		return 0;
+	case BoundingVolume::Type::OBB:
+		return 1;
+	case BoundingVolume::Type::AABBOX:
+		return 2;
+	default:
+		return 3;
+	}
+}
+
+static HitData mirrorHit(const HitData& p_Hit)
+{
+	HitData mirrored = p_Hit;
+	mirrored.colNorm = p_Hit.colNorm * -1.f;
+	mirrored.colNorm.w = 0.f;
+
+	return mirrored;
+}
+
+void Physics::pairCollisionCheck(Body& p_Body1, Body& p_Body2)
+{
+	if (!Collision::surroundingSphereVsSphere(*p_Body1.getSurroundingSphere(), *p_Body2.getSurroundingSphere()))
+		return;
+
+	if (isCameraPlayerCollision(p_Body1, p_Body2))
+		return;
+
+	bool touching = false;
+	for (unsigned int k = 0; k < p_Body1.getVolumeListSize(); k++)
+	{
+		for (unsigned int l = 0; l < p_Body2.getVolumeListSize(); l++)
+		{
+			const BoundingVolume& volume1 = *p_Body1.getVolume(k);
+			const BoundingVolume& volume2 = *p_Body2.getVolume(l);
+
+			// Test each volume pair once and mirror the result for the other body
+			const bool swapped = getNormalOrder(volume1.getType()) > getNormalOrder(volume2.getType());
+			SeparatingAxisCache* cache = Collision::usesSeparatingAxes(volume1, volume2)
+				? p_Body1.getSeparatingAxisCache(p_Body2.getHandle(), k, l, m_StepCount)
+				: nullptr;
+			++m_StepCounters.volumeTests;
+			HitData hit = swapped
+				? Collision::boundingVolumeVsBoundingVolume(volume2, volume1, cache)
+				: Collision::boundingVolumeVsBoundingVolume(volume1, volume2, cache);
+
+			if (!hit.intersect)
+				continue;
+
+			HitData mirrored = mirrorHit(hit);
+			if (swapped)
+			{
+				std::swap(hit, mirrored);
 			}
+
+			// Both bodies are moved, so each takes half of the penetration
+			handleCollision(hit, p_Body1, k, p_Body2, l, m_HitDatas, 0.5f);
+			handleCollision(mirrored, p_Body2, l, p_Body1, k, m_HitDatas, 0.5f);
+			touching = true;
+		}
+	}
+
+	if (touching)
+	{
+		m_TouchingPairs.push_back(std::make_pair(p_Body1.getHandle(), p_Body2.getHandle()));
+	}
+}
+
+void Physics::updateSleeping()
+{
+	const size_t numBodies = m_Bodies.getMovableCount();
+
+	for (size_t i = 0; i < numBodies; ++i)
+	{
+		Body& body = m_Bodies[i];
+		if (body.getIsSleeping())
+			continue;
+
+		++m_StepCounters.bodiesIntegrated;
+
+		const XMFLOAT4 velocity = body.getVelocity();
+		const float speedSq = velocity.x * velocity.x + velocity.y * velocity.y + velocity.z * velocity.z;
+		body.setRestTime(speedSq < sleepSpeed * sleepSpeed ? body.getRestTime() + m_Timestep : 0.f);
+	}
+
+	// Touching bodies form islands that fall asleep together, and a moving body wakes
+	// every sleeping body in its island
+	m_IslandBodies.clear();
+	for (const auto& pair : m_TouchingPairs)
+	{
+		m_IslandBodies.push_back(pair.first);
+		m_IslandBodies.push_back(pair.second);
+	}
+	std::sort(m_IslandBodies.begin(), m_IslandBodies.end());
+	m_IslandBodies.erase(std::unique(m_IslandBodies.begin(), m_IslandBodies.end()), m_IslandBodies.end());
+
+	m_IslandParents.resize(m_IslandBodies.size());
+	for (unsigned int i = 0; i < m_IslandParents.size(); ++i)
+	{
+		m_IslandParents[i] = i;
+	}
+	for (const auto& pair : m_TouchingPairs)
+	{
+		const unsigned int first = (unsigned int)(std::lower_bound(m_IslandBodies.begin(), m_IslandBodies.end(), pair.first) - m_IslandBodies.begin());
+		const unsigned int second = (unsigned int)(std::lower_bound(m_IslandBodies.begin(), m_IslandBodies.end(), pair.second) - m_IslandBodies.begin());
+		m_IslandParents[findIsland(first)] = findIsland(second);
+	}
+	m_TouchingPairs.clear();
+
+	enum IslandState : unsigned char
+	{
+		RESTING = 0,
+		SETTLING = 1,	// Every body is slow but not yet for long enough
+		MOVING = 2,
+	};
+	m_IslandStates.assign(m_IslandBodies.size(), RESTING);
+	for (unsigned int i = 0; i < m_IslandBodies.size(); ++i)
+	{
+		const Body& body = *findBody(m_IslandBodies[i]);
+		if (body.getIsSleeping())
+			continue;
+
+		unsigned char& state = m_IslandStates[findIsland(i)];
+		const unsigned char bodyState = body.getRestTime() == 0.f ? MOVING : body.getRestTime() < sleepDelay ? SETTLING : RESTING;
+		state = std::max(state, bodyState);
+	}
+
+	for (size_t i = 0; i < numBodies; ++i)
+	{
+		Body& body = m_Bodies[i];
+
+		unsigned char state = body.getIsSleeping() ? RESTING : body.getRestTime() < sleepDelay ? SETTLING : RESTING;
+		const auto island = std::lower_bound(m_IslandBodies.begin(), m_IslandBodies.end(), body.getHandle());
+		if (island != m_IslandBodies.end() && *island == body.getHandle())
+		{
+			state = m_IslandStates[findIsland((unsigned int)(island - m_IslandBodies.begin()))];
+		}
+
+		if (state == RESTING && !body.getIsSleeping())
+		{
+			body.sleep();
+		}
+		else if (state == MOVING && body.getIsSleeping())
+		{
+			body.wake();
+		}
+
+		if (body.getIsSleeping())
+		{
+			++m_StepCounters.bodiesSleeping;
 		}
 	}
 }
 
-void Physics::handleCollision(HitData p_Hit, Body& p_Collider, int p_ColliderVolumeId, Body& p_Victim, int p_VictimVolumeID, bool &p_IsOnGround)
+unsigned int Physics::findIsland(unsigned int p_IslandBody)
+{
+	while (m_IslandParents[p_IslandBody] != p_IslandBody)
+	{
+		m_IslandParents[p_IslandBody] = m_IslandParents[m_IslandParents[p_IslandBody]];
+		p_IslandBody = m_IslandParents[p_IslandBody];
+	}
+
+	return p_IslandBody;
+}
+
+void Physics::wakeBodiesNear(const Body& p_Body)
+{
+	for (size_t i = 0; i < m_Bodies.getMovableCount(); ++i)
+	{
+		Body& body = m_Bodies[i];
+		if (body.getIsSleeping() && Collision::surroundingSphereVsSphere(*body.getSurroundingSphere(), *p_Body.getSurroundingSphere()))
+		{
+			body.wake();
+		}
+	}
+}
+
+void Physics::handleCollision(HitData p_Hit, Body& p_Collider, int p_ColliderVolumeId, Body& p_Victim, int p_VictimVolumeID,
+	ContactBuffer& p_Contacts, float p_PushFraction)
 {
 	Body& b = p_Collider;
 	Body& b1 = p_Victim;
@@ -158,7 +596,7 @@ void Physics::handleCollision(HitData p_Hit, Body& p_Collider, int p_ColliderVol
 	p_Hit.IDInBody = p_ColliderVolumeId;
 	p_Hit.collisionVictim = b1.getHandle();
 	p_Hit.isEdge = b1.getIsEdge();
-	m_HitDatas.push_back(p_Hit);
+	p_Contacts.add(p_Hit);
 
 	if(!m_IsServer)
 	{
@@ -180,7 +618,7 @@ void Physics::handleCollision(HitData p_Hit, Body& p_Collider, int p_ColliderVol
 					b.setLanded(true);
 				}
 
-				p_IsOnGround = true;
+				b.setGroundContact(true);
 
 				posNorm = XMVectorSet(0.f, 1.f, 0.f, 0.f);
 				vVel = vVel - XMVector3Dot(vVel, vNorm) / XMVector3Dot(posNorm, vNorm) * posNorm;
@@ -194,7 +632,8 @@ void Physics::handleCollision(HitData p_Hit, Body& p_Collider, int p_ColliderVol
 			b.setVelocity(vel);
 
 
-			temp = XMLoadFloat4(&b.getPosition()) + posNorm * p_Hit.colLength;
+			const XMFLOAT4 position = b.getPosition();
+			temp = XMLoadFloat4(&position) + posNorm * (p_Hit.colLength * p_PushFraction);
 			XMStoreFloat4(&tempPos, temp);
 
 			b.setPosition(tempPos);
@@ -210,6 +649,10 @@ void Physics::applyForce(BodyHandle p_Body, Vector3 p_Force)
 
 	XMFLOAT4 tempForce = Vector3ToXMFLOAT4(&p_Force, 0.f); // kg*m/s^2
 
+	if (tempForce.x != 0.f || tempForce.y != 0.f || tempForce.z != 0.f)
+	{
+		body->wake();
+	}
 	body->addForce(tempForce);
 }
 
@@ -220,6 +663,10 @@ void Physics::applyImpulse(BodyHandle p_Body, Vector3 p_Impulse)
 		throw PhysicsException("Error! Trying to apply impulse on a non existing body! BodyHandle =" + std::to_string(p_Body), __LINE__, __FILE__);
 
 	XMFLOAT4 fImpulse = Vector3ToXMFLOAT4(&p_Impulse, 0.f);
+	if (fImpulse.x != 0.f || fImpulse.y != 0.f || fImpulse.z != 0.f)
+	{
+		body->wake();
+	}
 	body->addImpulse(fImpulse);
 }
 
@@ -291,35 +738,14 @@ void Physics::addOBBToBody(BodyHandle p_BodyHandle, Vector3 p_CenterPos, Vector3
 
 BodyHandle Physics::createBVInstance(const char* p_VolumeID)
 {
-	std::vector<BVLoader::BoundingVolume> tempBV;
-	for(auto& bv : m_TemplateBVList)
-	{
-		if(strcmp(bv.first.c_str(), p_VolumeID) == 0)
-		{
-			tempBV = bv.second;
-			break;
-		}
-	}
-
-	if(tempBV.empty())
+	auto shape = m_HullTemplates.find(p_VolumeID);
+	if(shape == m_HullTemplates.end())
 	{	
 		PhysicsLogger::log(PhysicsLogger::Level::ERROR_L, "Bounding Volume from template is empty");
 		return (BodyHandle)0;
 	}
 
-	std::vector<Triangle> triangles;
-	Triangle triangle;
-
-	for(unsigned i = 0; i < tempBV.size() / 3; i++)
-	{
-		triangle.corners[0] = tempBV[i * 3].m_Postition;
-		triangle.corners[1] = tempBV[i * 3 + 1].m_Postition;
-		triangle.corners[2] = tempBV[i * 3 + 2].m_Postition;
-
-		triangles.push_back(triangle);
-	}
-
-	Hull *hull = new Hull(triangles);
+	Hull *hull = new Hull(shape->second);
 
 	return createBody(1.f, hull, true, false);
 
@@ -327,47 +753,72 @@ BodyHandle Physics::createBVInstance(const char* p_VolumeID)
 
 void Physics::releaseBody(BodyHandle p_Body)
 {
-	auto findIt = m_Bodies.find(p_Body);
-	if (findIt == m_Bodies.end())
+	Body* removedBody = findBody(p_Body);
+	if (!removedBody)
 		return;
 
-	Body& removedBody = findIt->second;
-	if (removedBody.getIsImmovable())
+	// Bodies resting on the removed body would otherwise float in the air
+	wakeBodiesNear(*removedBody);
+
+	if (removedBody->getIsImmovable())
 	{
-		m_Octree.removeBody(p_Body, removedBody.getSurroundingSphere());
+		removeStaticBody(*removedBody);
 	}
 	else
 	{
-		m_MovableBodies.erase(p_Body);
+		m_Broadphase.removeBody(p_Body);
 	}
 
-	m_Bodies.erase(findIt);
+	m_Bodies.remove(p_Body);
 }
 
 bool Physics::createBV(const char* p_VolumeID, const char* p_FilePath)
 {
+	if(m_HullTemplates.count(p_VolumeID) > 0)
+		return true;
+
 	if(!m_BVLoader.loadBinaryFile(p_FilePath))
 	{
 		PhysicsLogger::log(PhysicsLogger::Level::ERROR_L, "Loading Bounding Volume file error");
 		return false;
 	}
-	std::vector<BVLoader::BoundingVolume> tempBV;
-	tempBV = m_BVLoader.getBoundingVolumes();
+	const BVLoader::BoundingVolume* corners = m_BVLoader.getCorners();
+	const unsigned int numCorners = m_BVLoader.getNumCorners();
 
-	if(tempBV.empty())
+	if(numCorners == 0)
 	{
 		PhysicsLogger::log(PhysicsLogger::Level::ERROR_L, "Bounding Volume from BVLoader is empty");
+		m_BVLoader.clear();
 		return false;
 	}
 
-	for(unsigned i = 0; i < tempBV.size(); i++)
+	std::vector<Triangle> triangles;
+	triangles.reserve(numCorners / 3);
+	Triangle triangle;
+
+	for(unsigned i = 0; i < numCorners / 3; i++)
 	{
-		tempBV[i].m_Postition.x *= 0.01f;
-		tempBV[i].m_Postition.y *= 0.01f;
-		tempBV[i].m_Postition.z *= 0.01f; 
+		for(unsigned j = 0; j < 3; j++)
+		{
+			const XMFLOAT4& corner = corners[i * 3 + j].m_Postition;
+			triangle.corners[j] = Vector4(corner.x * 0.01f, corner.y * 0.01f, corner.z * 0.01f, corner.w);
+		}
+
+		triangles.push_back(triangle);
+	}
+
+	if(m_BVLoader.getNumBVHNodes() > 0)
+	{
+		TriangleBVH bvh;
+		bvh.assign(m_BVLoader.getBVHNodes(), m_BVLoader.getNumBVHNodes(),
+			m_BVLoader.getBVHTriangleIndices(), m_BVLoader.getNumBVHTriangleIndices(), 0.01f);
+		m_HullTemplates[p_VolumeID] = HullShape::create(std::move(triangles), bvh);
+	}
+	else
+	{
+		m_HullTemplates[p_VolumeID] = HullShape::create(std::move(triangles));
 	}
 
-	m_TemplateBVList.push_back(std::pair<std::string, std::vector<BVLoader::BoundingVolume>>(p_VolumeID, tempBV));
 	m_BVLoader.clear();
 	//PhysicsLogger::log(PhysicsLogger::Level::INFO, "CreateBV success");
 	return true;
@@ -375,28 +826,19 @@ bool Physics::createBV(const char* p_VolumeID, const char* p_FilePath)
 
 bool Physics::releaseBV(const char* p_VolumeID)
 {
-	for(auto bv = m_TemplateBVList.begin(); bv != m_TemplateBVList.end(); bv++)
-	{
-		const char* temp = bv->first.c_str();
-		if(strcmp(temp, p_VolumeID) == 0)
-		{
-			m_TemplateBVList.erase(bv);
-			return true;
-		}
-	}
-
-	return false;
+	// Hulls created from the template keep their own reference to the shape
+	return m_HullTemplates.erase(p_VolumeID) > 0;
 }
 
 void Physics::releaseAllBoundingVolumes(void)
 {
-	std::swap(m_Bodies, std::map<BodyHandle, Body>());
+	m_Bodies.clear();
 
 	Body::resetBodyHandleCounter();
 	m_sphereBoundingVolume.clear();
 
 	m_Octree.reset();
-	m_MovableBodies.clear();
+	m_Broadphase.reset();
 }
 
 void Physics::setBodyScale(BodyHandle p_BodyHandle, Vector3 p_Scale)
@@ -405,9 +847,12 @@ void Physics::setBodyScale(BodyHandle p_BodyHandle, Vector3 p_Scale)
 	if(!body)
 		throw PhysicsException("Error! Trying to set scale to a a non existing body! BodyHandle =" + std::to_string(p_BodyHandle), __LINE__, __FILE__);
 	
+	body->wake();
+	wakeBodiesNear(*body);
+
 	if (body->getIsImmovable())
 	{
-		m_Octree.removeBody(body->getHandle(), body->getSurroundingSphere());
+		removeStaticBody(*body);
 	}
 
 	XMVECTOR scale = Vector3ToXMVECTOR(&p_Scale, 0.f);
@@ -416,26 +861,158 @@ void Physics::setBodyScale(BodyHandle p_BodyHandle, Vector3 p_Scale)
 
 	if (body->getIsImmovable())
 	{
-		m_Octree.addBody(body->getHandle(), body->getSurroundingSphere());
+		addStaticBody(*body);
 	}
+
+	wakeBodiesNear(*body);
 }
 
 BodyHandle Physics::createBody(float p_Mass, BoundingVolume* p_BoundingVolume, bool p_IsImmovable, bool p_IsEdge)
 {
 	Body b(p_Mass, BoundingVolume::ptr(p_BoundingVolume), p_IsImmovable, p_IsEdge);
-	Body& insertedBody = m_Bodies[b.getHandle()] = std::move(b);
-	insertedBody.setGravity(m_GlobalGravity);
+	b.setGravity(m_GlobalGravity);
+
+	const BodyHandle handle = m_Bodies.add(std::move(b));
+	const Body& insertedBody = *findBody(handle);
 
 	if (p_IsImmovable)
 	{
-		m_Octree.addBody(insertedBody.getHandle(), insertedBody.getSurroundingSphere());
+		addStaticBody(insertedBody);
 	}
 	else
 	{
-		m_MovableBodies.insert(insertedBody.getHandle());
+		m_Broadphase.addBody(handle, insertedBody.getSurroundingSphere());
+	}
+
+	return handle;
+}
+
+BoundingVolume* Physics::createVolume(const BodyDescription& p_Description) const
+{
+	const XMFLOAT4 origin(0.f, 0.f, 0.f, 1.f);
+	Vector3 convExtents = p_Description.extents * 0.01f;	// m
+	const XMFLOAT4 tempExt = Vector3ToXMFLOAT4(&convExtents, 0.f);	// m
+
+	switch (p_Description.type)
+	{
+	case BoundingVolumeType::SPHERE:
+		return new Sphere(convExtents.x, origin);
+
+	case BoundingVolumeType::AABB:
+		return new AABB(origin, tempExt);
+
+	case BoundingVolumeType::OBB:
+		return new OBB(origin, tempExt);
+
+	case BoundingVolumeType::HULL:
+		{
+			auto shape = p_Description.volumeID ? m_HullTemplates.find(p_Description.volumeID) : m_HullTemplates.end();
+			if (shape == m_HullTemplates.end())
+			{
+				PhysicsLogger::log(PhysicsLogger::Level::ERROR_L, "Bounding Volume from template is empty");
+				return nullptr;
+			}
+
+			return new Hull(shape->second);
+		}
+
+	default:
+		throw PhysicsException("Error! Trying to create a body with an unknown volume type!", __LINE__, __FILE__);
+	}
+}
+
+void Physics::createBodies(const BodyDescription* p_Descriptions, unsigned int p_NumBodies, BodyHandle* p_Handles)
+{
+	const bool wasBatching = m_BatchingBodies;
+	m_BatchingBodies = true;
+	m_Bodies.reserve(m_Bodies.size() + p_NumBodies);
+
+	for (unsigned int i = 0; i < p_NumBodies; ++i)
+	{
+		const BodyDescription& description = p_Descriptions[i];
+		p_Handles[i] = 0;
+
+		BoundingVolume* volume = createVolume(description);
+		if (!volume)
+			continue;
+
+		// Place the body before storing it, so that it is only sorted into the octree once
+		Body body(description.mass, BoundingVolume::ptr(volume), description.isImmovable, description.isEdge);
+		body.setGravity(m_GlobalGravity);
+
+		if (description.scale.x != 1.f || description.scale.y != 1.f || description.scale.z != 1.f)
+		{
+			body.getVolume()->scale(Vector3ToXMVECTOR(&description.scale, 0.f));
+		}
+		if (description.rotation.x != 0.f || description.rotation.y != 0.f || description.rotation.z != 0.f)
+		{
+			body.setRotation(XMMatrixRotationRollPitchYaw(description.rotation.y, description.rotation.x, description.rotation.z));
+		}
+		Vector3 convPosition = description.position * 0.01f;	// m
+		body.setPosition(Vector3ToXMFLOAT4(&convPosition, 1.f));
+
+		p_Handles[i] = m_Bodies.add(std::move(body));
+		if (!description.isImmovable)
+		{
+			m_Broadphase.addBody(p_Handles[i], findBody(p_Handles[i])->getSurroundingSphere());
+		}
+	}
+
+	m_BatchingBodies = wasBatching;
+	if (!m_BatchingBodies)
+	{
+		rebuildStaticOctree();
+	}
+}
+
+void Physics::beginBodyBatch()
+{
+	m_BatchingBodies = true;
+}
+
+void Physics::endBodyBatch()
+{
+	if (!m_BatchingBodies)
+		return;
+
+	m_BatchingBodies = false;
+	rebuildStaticOctree();
+}
+
+void Physics::addStaticBody(const Body& p_Body)
+{
+	// Every immovable body is sorted into the octree when the batch ends
+	if (!m_BatchingBodies)
+	{
+		m_Octree.addBody(p_Body.getHandle(), p_Body.getSurroundingSphere());
 	}
+}
 
-	return insertedBody.getHandle();
+void Physics::removeStaticBody(const Body& p_Body)
+{
+	if (!m_BatchingBodies)
+	{
+		m_Octree.removeBody(p_Body.getHandle(), p_Body.getSurroundingSphere());
+	}
+}
+
+void Physics::rebuildStaticOctree()
+{
+	// The bodies are collected from the storage rather than from the octree, so that
+	// bodies created or moved during a batch, which are not in the tree, are included
+	const size_t firstStatic = m_Bodies.getMovableCount();
+	std::vector<BodyHandle> handles;
+	std::vector<const Sphere*> spheres;
+	handles.reserve(m_Bodies.size() - firstStatic);
+	spheres.reserve(m_Bodies.size() - firstStatic);
+	for (size_t i = firstStatic; i < m_Bodies.size(); ++i)
+	{
+		handles.push_back(m_Bodies[i].getHandle());
+		spheres.push_back(m_Bodies[i].getSurroundingSphere());
+	}
+
+	m_Octree.reset();
+	m_Octree.addBodies(handles.data(), spheres.data(), handles.size());
 }
 
 void Physics::fillTriangleIndexList()
@@ -465,6 +1042,10 @@ void Physics::setBodyGravity(BodyHandle p_Body, float p_Gravity)
 	if(!body)
 		throw PhysicsException("Error! Trying to set gravity to a a non existing body! BodyHandle =" + std::to_string(p_Body), __LINE__, __FILE__);
 
+	if (body->getGravity() != p_Gravity)
+	{
+		body->wake();
+	}
 	body->setGravity(p_Gravity);
 }
 
@@ -514,6 +1095,33 @@ bool Physics::getBodyLanded(BodyHandle p_Body)
 	return body->getLanded();
 }
 
+bool Physics::getBodySleeping(BodyHandle p_Body)
+{
+	Body *body = findBody(p_Body);
+	if(!body)
+		throw PhysicsException("Error! Trying to get sleeping from a non existing body! BodyHandle =" + std::to_string(p_Body), __LINE__, __FILE__);
+
+	return body->getIsSleeping();
+}
+
+void Physics::wakeBody(BodyHandle p_Body)
+{
+	Body *body = findBody(p_Body);
+	if(!body)
+		throw PhysicsException("Error! Trying to wake a non existing body! BodyHandle =" + std::to_string(p_Body), __LINE__, __FILE__);
+
+	body->wake();
+}
+
+void Physics::setBodyContinuousCollision(BodyHandle p_Body, bool p_Enabled)
+{
+	Body *body = findBody(p_Body);
+	if(!body)
+		throw PhysicsException("Error! Trying to set continuous collision for a non existing body! BodyHandle =" + std::to_string(p_Body), __LINE__, __FILE__);
+
+	body->setContinuousCollision(p_Enabled);
+}
+
 void Physics::setBodyCollisionResponse(BodyHandle p_Body, bool p_State)
 {
 	Body *body = findBody(p_Body);
@@ -553,21 +1161,25 @@ Vector3 Physics::getBodySize(BodyHandle p_Body)
 		throw PhysicsException("Error! Trying to get size on non existing body! BodyHandle =" + std::to_string(p_Body), __LINE__, __FILE__);
 
 	Vector3 temp;
+	XMFLOAT4 size;
 	float r;
 	switch (body->getVolume()->getType())
 	{
 	case BoundingVolume::Type::AABBOX:
-		temp = XMFLOAT4ToVector3(&((AABB*)body->getVolume())->getHalfDiagonal());
+		size = ((AABB*)body->getVolume())->getHalfDiagonal();
+		temp = XMFLOAT4ToVector3(&size);
 		break;
 	case BoundingVolume::Type::SPHERE:
 		r = ((Sphere*)body->getVolume())->getRadius();
 		temp = Vector3(r,r,r);
 		break;
 	case BoundingVolume::Type::OBB:
-		temp = XMFLOAT4ToVector3(&((OBB*)body->getVolume())->getExtents());
+		size = ((OBB*)body->getVolume())->getExtents();
+		temp = XMFLOAT4ToVector3(&size);
 		break;
 	case BoundingVolume::Type::HULL:
-		temp = XMFLOAT4ToVector3(&((Hull*)body->getVolume())->getScale());
+		size = ((Hull*)body->getVolume())->getScale();
+		temp = XMFLOAT4ToVector3(&size);
 		break;
 	default:
 		temp = Vector3(0,0,0);
@@ -592,19 +1204,33 @@ void Physics::setBodyPosition( BodyHandle p_Body, Vector3 p_Position)
 	if(!body)
 		throw PhysicsException("Error! Trying to set position on non existing body! BodyHandle =" + std::to_string(p_Body), __LINE__, __FILE__);
 
-	if (body->getIsImmovable())
+	Vector3 convPosition = p_Position * 0.01f;	// m
+	XMFLOAT4 tempPosition = Vector3ToXMFLOAT4(&convPosition, 1.f);	// m
+
+	const XMFLOAT4 oldPosition = body->getPosition();
+	const XMFLOAT3 movement(tempPosition.x - oldPosition.x, tempPosition.y - oldPosition.y, tempPosition.z - oldPosition.z);
+	const bool moved = movement.x * movement.x + movement.y * movement.y + movement.z * movement.z > wakeDistance * wakeDistance;
+	if (moved)
 	{
-		m_Octree.removeBody(body->getHandle(), body->getSurroundingSphere());
+		body->wake();
+		wakeBodiesNear(*body);
 	}
 
-	Vector3 convPosition = p_Position * 0.01f;	// m
-	XMFLOAT4 tempPosition = Vector3ToXMFLOAT4(&convPosition, 1.f);	// m
+	if (body->getIsImmovable())
+	{
+		removeStaticBody(*body);
+	}
 
 	body->setPosition(tempPosition);
 
 	if (body->getIsImmovable())
 	{
-		m_Octree.addBody(body->getHandle(), body->getSurroundingSphere());
+		addStaticBody(*body);
+	}
+
+	if (moved)
+	{
+		wakeBodiesNear(*body);
 	}
 }
 
@@ -614,9 +1240,12 @@ void Physics::setBodyVolumePosition( BodyHandle p_Body, unsigned p_Volume, Vecto
 	if(!body)
 		throw PhysicsException("Error! Trying to set volume position on non existing body! BodyHandle =" + std::to_string(p_Body), __LINE__, __FILE__);
 	
+	body->wake();
+	wakeBodiesNear(*body);
+
 	if (body->getIsImmovable())
 	{
-		m_Octree.removeBody(body->getHandle(), body->getSurroundingSphere());
+		removeStaticBody(*body);
 	}
 
 	Vector3 convPosition = p_Position * 0.01f;	// m
@@ -624,8 +1253,10 @@ void Physics::setBodyVolumePosition( BodyHandle p_Body, unsigned p_Volume, Vecto
 
 	if (body->getIsImmovable())
 	{
-		m_Octree.addBody(body->getHandle(), body->getSurroundingSphere());
+		addStaticBody(*body);
 	}
+
+	wakeBodiesNear(*body);
 }
 
 
@@ -638,6 +1269,11 @@ void Physics::setBodyVelocity( BodyHandle p_Body, Vector3 p_Velocity)
 	Vector3 convVelocity = p_Velocity * 0.01f;	// m
 	XMFLOAT4 tempPosition = Vector3ToXMFLOAT4(&convVelocity, 0.f);	// m
 
+	// Setting the velocity of a resting body to about zero, like an idle player, keeps it asleep
+	if (convVelocity.x * convVelocity.x + convVelocity.y * convVelocity.y + convVelocity.z * convVelocity.z >= sleepSpeed * sleepSpeed)
+	{
+		body->wake();
+	}
 	body->setVelocity(tempPosition);
 }
 
@@ -760,16 +1396,19 @@ void Physics::setRotation(BodyHandle p_Body, XMMATRIX& p_Rotation)
 	if(!body)
 		throw PhysicsException("Error! Trying to set rotation on non existing body! BodyHandle =" + std::to_string(p_Body), __LINE__, __FILE__);
 	
+	// Movable bodies, like players, are turned every frame without being moved
 	if (body->getIsImmovable())
 	{
-		m_Octree.removeBody(body->getHandle(), body->getSurroundingSphere());
+		wakeBodiesNear(*body);
+		removeStaticBody(*body);
 	}
 
 	body->setRotation(p_Rotation);
 
 	if (body->getIsImmovable())
 	{
-		m_Octree.addBody(body->getHandle(), body->getSurroundingSphere());
+		addStaticBody(*body);
+		wakeBodiesNear(*body);
 	}
 }
 
@@ -846,7 +1485,8 @@ void Physics::setBodyForceCollisionNormal(BodyHandle p_Body, BodyHandle p_BodyVi
 					posNorm = XMVectorSet(0.f, 1.f, 0.f, 0.f);
 				}
 
-				temp = XMLoadFloat4(&body->getPosition()) + posNorm * hit.colLength;
+				const XMFLOAT4 position = body->getPosition();
+				temp = XMLoadFloat4(&position) + posNorm * hit.colLength;
 				XMStoreFloat4(&tempPos, temp);
 
 				body->setPosition(tempPos);
@@ -858,44 +1498,194 @@ void Physics::setBodyForceCollisionNormal(BodyHandle p_Body, BodyHandle p_BodyVi
 
 BodyHandle Physics::rayCast(const XMFLOAT4 &p_RayDirection, const XMFLOAT4 &p_RayOrigin)
 {
+	return rayCastHit(p_RayDirection, p_RayOrigin).body;
+}
+
+RayHit Physics::rayCastHit(const XMFLOAT4 &p_RayDirection, const XMFLOAT4 &p_RayOrigin)
+{
+	RayHit result;
+
+	XMVECTOR direction = XMVectorSetW(XMLoadFloat4(&p_RayDirection), 0.f);
+	if (XMVector3Equal(direction, XMVectorZero()))
+		return result;
+	direction = XMVector3Normalize(direction);
+
 	//Transfrom ray to meters instead of cm
-	XMFLOAT4 rayOriginConv = p_RayOrigin;
-	rayOriginConv.x *= 0.01f;
-	rayOriginConv.y *= 0.01f;
-	rayOriginConv.z *= 0.01f;
+	const XMVECTOR origin = XMVectorSetW(XMLoadFloat4(&p_RayOrigin) * 0.01f, 1.f);
+
+	XMFLOAT4 rayDirection;
+	XMFLOAT4 rayOrigin;
+	XMStoreFloat4(&rayDirection, direction);
+	XMStoreFloat4(&rayOrigin, origin);
 
 	float dist = FLT_MAX;
-	BodyHandle closestBody = (BodyHandle)-1;
+	BodyHandle closestBody = 0;
+	XMFLOAT4 closestNormal(0.f, 0.f, 0.f, 0.f);
 
-	for(auto& body : m_Bodies)
+	// The octree only holds immovable bodies and visits them roughly front to back,
+	// skipping every node further away than the closest hit found so far
+	m_Octree.castRay(rayOrigin, rayDirection, FLT_MAX,
+		[&] (BodyHandle p_Body) -> float
+		{
+			const Body* b = findBody(p_Body);
+			if (!b || b->getIsEdge())
+				return -1.f;
+
+			float tempDist = -1.f;
+			XMFLOAT4 tempNormal;
+			const BoundingVolume* volume = b->getVolume();
+			if (volume->getType() == BoundingVolume::Type::HULL)
+				tempDist = Collision::rayTriangleIntersect((Hull&)*volume, rayDirection, rayOrigin, tempNormal);
+			else if(volume->getType() == BoundingVolume::Type::SPHERE)
+				tempDist = Collision::raySphereIntersect((Sphere&)*volume, rayDirection, rayOrigin, tempNormal);
+
+			if(tempDist > 0.f && tempDist < dist)
+			{
+				dist = tempDist;
+				closestBody = p_Body;
+				closestNormal = tempNormal;
+			}
+
+			return tempDist;
+		});
+
+	if(dist == FLT_MAX)
 	{
-		const Body &b = body.second;
-		if(!b.getIsImmovable())
-			continue;
-		if(b.getIsEdge())
-			continue;
-		
-		float tempDist;
-		const BoundingVolume* volume = b.getVolume();
-		if (volume->getType() == BoundingVolume::Type::HULL)
-			tempDist = Collision::rayTriangleIntersect((Hull&)*volume, p_RayDirection, rayOriginConv);
-		else if(volume->getType() == BoundingVolume::Type::SPHERE)
-			tempDist = Collision::raySphereIntersect((Sphere&)*volume, p_RayDirection, rayOriginConv);
-
-		
-		if(tempDist > 0.f && tempDist < dist)
-		{
-			dist = tempDist;
-			closestBody = b.getHandle();
+		return result;
+	}
+
+	XMFLOAT4 hitPos;
+	XMStoreFloat4(&hitPos, XMVectorSetW((origin + direction * dist) * 100.f, 1.f));
+
+	result.hitPos = hitPos;
+	result.hitNorm = closestNormal;
+	result.distance = dist * 100.f;
+	result.body = closestBody;
+	result.hit = true;
+
+	return result;
+}
+
+void Physics::rayCastBatch(unsigned int p_NumRays, const XMFLOAT4* p_RayDirections, const XMFLOAT4* p_RayOrigins, RayHit* p_Hits)
+{
+	const unsigned int numBatches = std::min<unsigned int>(m_WorkerPool.getNumThreads(),
+		(p_NumRays + minRaysPerBatch - 1) / minRaysPerBatch);
+
+	if (numBatches <= 1)
+	{
+		for (unsigned int i = 0; i < p_NumRays; ++i)
+		{
+			p_Hits[i] = rayCastHit(p_RayDirections[i], p_RayOrigins[i]);
 		}
+		return;
 	}
 
-	if(dist == FLT_MAX)
+	// Ray casts only read the static bodies, so the rays can be split over the worker threads
+	m_WorkerPool.run(numBatches, [=] (unsigned int p_Batch)
 	{
-		return 0;
+		const unsigned int first = p_NumRays * p_Batch / numBatches;
+		const unsigned int last = p_NumRays * (p_Batch + 1) / numBatches;
+		for (unsigned int i = first; i < last; ++i)
+		{
+			p_Hits[i] = rayCastHit(p_RayDirections[i], p_RayOrigins[i]);
+		}
+	});
+}
+
+unsigned int Physics::overlapSphere(Vector3 p_Position, float p_Radius, bool p_Exact,
+	BodyHandle* p_Bodies, unsigned int p_MaxBodies)
+{
+	Vector3 convPosition = p_Position * 0.01f;	// m
+	const Sphere sphere(p_Radius * 0.01f, Vector3ToXMFLOAT4(&convPosition, 1.f));
+
+	return overlapVolume(sphere, p_Exact, p_Bodies, p_MaxBodies);
+}
+
+unsigned int Physics::overlapAABB(Vector3 p_CenterPos, Vector3 p_Extents, bool p_Exact,
+	BodyHandle* p_Bodies, unsigned int p_MaxBodies)
+{
+	// Boxes are tested as OBBs, since there is no AABB versus hull test
+	return overlapOBB(p_CenterPos, p_Extents, Vector3(0.f, 0.f, 0.f), p_Exact, p_Bodies, p_MaxBodies);
+}
+
+unsigned int Physics::overlapOBB(Vector3 p_CenterPos, Vector3 p_Extents, Vector3 p_Rotation, bool p_Exact,
+	BodyHandle* p_Bodies, unsigned int p_MaxBodies)
+{
+	Vector3 convPosition = p_CenterPos * 0.01f;	// m
+	Vector3 convExtents = p_Extents * 0.01f;	// m
+	OBB box(Vector3ToXMFLOAT4(&convPosition, 1.f), Vector3ToXMFLOAT4(&convExtents, 0.f));
+	if (p_Rotation.x != 0.f || p_Rotation.y != 0.f || p_Rotation.z != 0.f)
+	{
+		box.setRotation(XMMatrixRotationRollPitchYaw(p_Rotation.y, p_Rotation.x, p_Rotation.z));
 	}
 
-	return closestBody;
+	return overlapVolume(box, p_Exact, p_Bodies, p_MaxBodies);
+}
+
+unsigned int Physics::overlapVolume(const BoundingVolume& p_Volume, bool p_Exact, BodyHandle* p_Bodies, unsigned int p_MaxBodies)
+{
+	const Sphere& bounds = *p_Volume.getSurroundingSphere();
+
+	// Movable bodies can have been moved since the broadphase was last sorted
+	m_Broadphase.update();
+
+	m_OverlapCandidates.clear();
+	m_Octree.findPotentialIntersections(&bounds, std::back_inserter(m_OverlapCandidates));
+	m_Broadphase.findPotentialIntersections(&bounds, std::back_inserter(m_OverlapCandidates));
+
+	// Bodies overlapping several octree nodes are reported once per node
+	std::sort(m_OverlapCandidates.begin(), m_OverlapCandidates.end());
+	m_OverlapCandidates.erase(
+		std::unique(m_OverlapCandidates.begin(), m_OverlapCandidates.end()),
+		m_OverlapCandidates.end());
+
+	unsigned int numFound = 0;
+	for (const auto& candidate : m_OverlapCandidates)
+	{
+		Body& body = *findBody(candidate);
+		if (!Collision::surroundingSphereVsSphere(*body.getSurroundingSphere(), bounds))
+			continue;
+
+		if (p_Exact)
+		{
+			bool overlaps = false;
+			for (unsigned int i = 0; i < body.getVolumeListSize() && !overlaps; ++i)
+			{
+				overlaps = Collision::boundingVolumeVsBoundingVolume(*body.getVolume(i), p_Volume).intersect;
+			}
+
+			if (!overlaps)
+				continue;
+		}
+
+		if (numFound < p_MaxBodies)
+		{
+			p_Bodies[numFound] = candidate;
+		}
+		++numFound;
+	}
+
+	return numFound;
+}
+
+void Physics::setProfilingEnabled(bool p_Enabled)
+{
+	m_Profiler.setEnabled(p_Enabled);
+}
+
+bool Physics::isProfilingEnabled() const
+{
+	return m_Profiler.isEnabled();
+}
+
+unsigned int Physics::getNumProfiledSteps() const
+{
+	return m_Profiler.getNumSteps();
+}
+
+PhysicsStepStats Physics::getProfiledStep(unsigned int p_Index) const
+{
+	return m_Profiler.getStep(p_Index);
 }
 
 bool Physics::validBody(BodyHandle p_BodyHandle)
@@ -925,3 +1715,50 @@ bool Physics::isCameraPlayerCollision(Body const &p_Collider, Body const &p_Vict
 
 	return false;
 }
+
+void Physics::setSnapshotCapacity(unsigned int p_NumSnapshots, unsigned int p_NumBodies)
+{
+	m_Snapshots.reserve(p_NumSnapshots, p_NumBodies);
+}
+
+unsigned int Physics::captureSnapshot()
+{
+	if (m_Snapshots.getCapacity() == 0)
+		throw PhysicsException("Error! Trying to capture a snapshot without room for any snapshots!", __LINE__, __FILE__);
+
+	SnapshotBuffer::Snapshot& snapshot = m_Snapshots.beginSnapshot();
+	snapshot.leftOverTime = m_LeftOverTime;
+
+	const size_t numBodies = m_Bodies.getMovableCount();
+	snapshot.bodies.resize(numBodies);
+	for (size_t i = 0; i < numBodies; ++i)
+	{
+		m_Bodies[i].saveState(snapshot.bodies[i]);
+	}
+
+	return snapshot.id;
+}
+
+bool Physics::hasSnapshot(unsigned int p_Snapshot) const
+{
+	return m_Snapshots.find(p_Snapshot) != nullptr;
+}
+
+bool Physics::restoreSnapshot(unsigned int p_Snapshot)
+{
+	const SnapshotBuffer::Snapshot* snapshot = m_Snapshots.find(p_Snapshot);
+	if (!snapshot)
+		return false;
+
+	for (const auto& state : snapshot->bodies)
+	{
+		Body* body = findBody(state.handle);
+		if (!body || body->getIsImmovable())
+			continue;
+
+		body->loadState(state);
+	}
+	m_LeftOverTime = snapshot->leftOverTime;
+
+	return true;
+}
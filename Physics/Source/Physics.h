@@ -1,37 +1,70 @@
 #pragma once
 #include "IPhysics.h"
 #include "Body.h"
+#include "BodyStorage.h"
 #include "BVLoader.h"
+#include "Broadphase.h"
+#include "ContactBuffer.h"
+#include "HullShape.h"
 #include "Octree.h"
+#include "StepProfiler.h"
+#include "SnapshotBuffer.h"
+#include "WorkerPool.h"
 
-#include <map>
-#include <set>
+#include <unordered_map>
+#include <vector>
 
 class Physics : public IPhysics
 {
 public:
 private:
+	/**
+	 * The state a worker needs to check a range of movable bodies against the static geometry.
+	 */
+	struct StaticCheckBatch
+	{
+		std::vector<BodyHandle> potentialIntersections;
+		ContactBuffer contacts;
+		PhysicsStepStats counters;
+	};
+
 	float m_GlobalGravity;
 	float m_Timestep;
 	float m_LeftOverTime;
-	std::vector<HitData> m_HitDatas;
+	unsigned int m_StepCount;
+	ContactBuffer m_HitDatas;
 	BVLoader m_BVLoader;
 	bool m_LoadBVSphereTemplateOnce;
-	std::vector<std::pair<std::string, std::vector<BVLoader::BoundingVolume>>> m_TemplateBVList;
+	std::unordered_map<std::string, HullShape::ptr> m_HullTemplates;
 	std::vector<BVLoader::BoundingVolume> m_sphereBoundingVolume;
 	bool m_IsServer;
 	std::vector<DirectX::XMFLOAT3> m_BoxTriangleIndex;
 
-	std::map<BodyHandle, Body> m_Bodies;
+	BodyStorage m_Bodies;
 	Octree m_Octree;
-	std::set<BodyHandle> m_PotentialIntersections;
-	std::set<BodyHandle> m_MovableBodies;
+	bool m_BatchingBodies;
+	std::vector<BodyHandle> m_PotentialIntersections;
+	std::vector<BodyHandle> m_OverlapCandidates;
+	Broadphase m_Broadphase;
+	std::vector<Broadphase::Pair> m_MovablePairs;
+	std::vector<Broadphase::Pair> m_TouchingPairs;
+	std::vector<BodyHandle> m_IslandBodies;
+	std::vector<unsigned int> m_IslandParents;
+	std::vector<unsigned char> m_IslandStates;
+
+	WorkerPool m_WorkerPool;
+	std::vector<StaticCheckBatch> m_StaticCheckBatches;
+
+	StepProfiler m_Profiler;
+	PhysicsStepStats m_StepCounters;
+
+	SnapshotBuffer m_Snapshots;
 
 public:
 	Physics();
 	~Physics();
 
-	void initialize(bool p_IsServer, float p_Timestep) override;
+	void initialize(bool p_IsServer, float p_Timestep, unsigned int p_NumThreads = 1) override;
 
 	void update(float p_DeltaTime, unsigned p_MaxSteps) override;
 	void applyForce(BodyHandle p_Body, Vector3 p_Force) override;
@@ -47,6 +80,10 @@ public:
 	BodyHandle createBVInstance(const char* p_VolumeID) override;
 	bool createBV(const char* m_ModelID, const char* m_FilePath) override;
 
+	void createBodies(const BodyDescription* p_Descriptions, unsigned int p_NumBodies, BodyHandle* p_Handles) override;
+	void beginBodyBatch() override;
+	void endBodyBatch() override;
+
 	bool releaseBV(const char* p_ModelID) override; 
 	void releaseBody(BodyHandle p_Body) override;
 	void releaseAllBoundingVolumes(void) override;
@@ -60,6 +97,9 @@ public:
 	unsigned int getHitDataSize() override;
 
 	bool getBodyLanded(BodyHandle p_Body) override;
+	bool getBodySleeping(BodyHandle p_Body) override;
+	void wakeBody(BodyHandle p_Body) override;
+	void setBodyContinuousCollision(BodyHandle p_Body, bool p_Enabled) override;
 
 	void setBodyCollisionResponse(BodyHandle p_Body, bool p_State) override;
 	void setBodyVolumeCollisionResponse(BodyHandle p_Body, int volume, bool p_State) override;
@@ -92,11 +132,36 @@ public:
 	float getTimestep() const override;
 
 	BodyHandle rayCast(const DirectX::XMFLOAT4 &p_RayDirection, const DirectX::XMFLOAT4 &p_RayOrigin) override;
+	RayHit rayCastHit(const DirectX::XMFLOAT4 &p_RayDirection, const DirectX::XMFLOAT4 &p_RayOrigin) override;
+	void rayCastBatch(unsigned int p_NumRays, const DirectX::XMFLOAT4* p_RayDirections,
+		const DirectX::XMFLOAT4* p_RayOrigins, RayHit* p_Hits) override;
+
+	unsigned int overlapSphere(Vector3 p_Position, float p_Radius, bool p_Exact,
+		BodyHandle* p_Bodies, unsigned int p_MaxBodies) override;
+	unsigned int overlapAABB(Vector3 p_CenterPos, Vector3 p_Extents, bool p_Exact,
+		BodyHandle* p_Bodies, unsigned int p_MaxBodies) override;
+	unsigned int overlapOBB(Vector3 p_CenterPos, Vector3 p_Extents, Vector3 p_Rotation, bool p_Exact,
+		BodyHandle* p_Bodies, unsigned int p_MaxBodies) override;
+
+	void setProfilingEnabled(bool p_Enabled) override;
+	bool isProfilingEnabled() const override;
+	unsigned int getNumProfiledSteps() const override;
+	PhysicsStepStats getProfiledStep(unsigned int p_Index) const override;
+
+	void setSnapshotCapacity(unsigned int p_NumSnapshots, unsigned int p_NumBodies) override;
+	unsigned int captureSnapshot() override;
+	bool hasSnapshot(unsigned int p_Snapshot) const override;
+	bool restoreSnapshot(unsigned int p_Snapshot) override;
 
 private:
 	Body* findBody(BodyHandle p_Body);
 	
 	BodyHandle createBody(float p_Mass, BoundingVolume* p_BoundingVolume, bool p_IsImmovable, bool p_IsEdge);
+	BoundingVolume* createVolume(const BodyDescription& p_Description) const;
+
+	void addStaticBody(const Body& p_Body);
+	void removeStaticBody(const Body& p_Body);
+	void rebuildStaticOctree();
 
 	BoundingVolume* getVolume(BodyHandle p_Body);
 
@@ -104,8 +169,24 @@ private:
 
 	void setRotation(BodyHandle p_Body, DirectX::XMMATRIX& p_Rotation);
 
-	void singleCollisionCheck(Body& p_Collider, Body& p_Victim, bool& p_IsOnGround);
-	void handleCollision(HitData p_Hit, Body& p_Collider, int p_ColliderVolumeId, Body& p_Victim, int p_VictimVolumeID, bool &p_IsOnGround);
+	size_t getNumMovableBatches() const;
+	void integrateMovableBodies();
+	void integrateBodyRange(size_t p_First, size_t p_Last);
+	void checkStaticCollisions();
+	void staticCollisionCheck(Body& p_Collider, std::vector<BodyHandle>& p_PotentialIntersections, ContactBuffer& p_Contacts,
+		PhysicsStepStats& p_Counters);
+	void singleCollisionCheck(Body& p_Collider, Body& p_Victim, ContactBuffer& p_Contacts, PhysicsStepStats& p_Counters);
+	void sweepStaticCollision(Body& p_Collider, std::vector<BodyHandle>& p_PotentialIntersections);
+	static float getSweepRadius(const Body& p_Body);
+	void pairCollisionCheck(Body& p_Body1, Body& p_Body2);
+	void handleCollision(HitData p_Hit, Body& p_Collider, int p_ColliderVolumeId, Body& p_Victim, int p_VictimVolumeID,
+		ContactBuffer& p_Contacts, float p_PushFraction = 1.f);
+
+	void updateSleeping();
+	unsigned int findIsland(unsigned int p_IslandBody);
+	void wakeBodiesNear(const Body& p_Body);
+
+	unsigned int overlapVolume(const BoundingVolume& p_Volume, bool p_Exact, BodyHandle* p_Bodies, unsigned int p_MaxBodies);
 
 	bool isCameraPlayerCollision(Body const &p_Collider, Body const &p_Victim);
 };
@@ -0,0 +1,43 @@
+#pragma once
+#include "../include/PhysicsTypes.h"
+
+#include <vector>
+
+/**
+ * The separating axes found the last time a pair of volumes was tested with the
+ * separating axis test. Pairs that are tested step after step usually stay separated
+ * along the same axis, so the cached axis is tried first and most tests can stop after it.
+ *
+ * The cached axes are only hints, any axis that separates the volumes is a valid
+ * reason to report a miss.
+ */
+struct SeparatingAxisCache
+{
+	static const unsigned int noAxis = 0xffffffff;
+
+	struct TriangleAxis
+	{
+		unsigned int triangle;
+		unsigned int axis;
+	};
+
+	unsigned int boxAxis;						// One of the 15 box versus box axes, or noAxis
+	std::vector<TriangleAxis> triangleAxes;		// Box versus triangle axes, sorted on triangle
+
+	SeparatingAxisCache() :
+		boxAxis(noAxis)
+	{
+	}
+};
+
+/**
+ * A separating axis cache for one pair of volumes in two bodies, owned by the first body.
+ */
+struct CachedVolumePair
+{
+	BodyHandle victim;
+	unsigned int volume;
+	unsigned int victimVolume;
+	unsigned int lastStep;	// The last step the pair was tested
+	SeparatingAxisCache cache;
+};
@@ -0,0 +1,50 @@
+#include "SnapshotBuffer.h"
+
+SnapshotBuffer::SnapshotBuffer() :
+	m_NextId(1)
+{
+}
+
+void SnapshotBuffer::reserve(unsigned int p_NumSnapshots, unsigned int p_NumBodies)
+{
+	m_Snapshots.resize(p_NumSnapshots);
+	for (auto& snapshot : m_Snapshots)
+	{
+		snapshot.id = 0;
+		snapshot.leftOverTime = 0.f;
+		snapshot.bodies.clear();
+		snapshot.bodies.reserve(p_NumBodies);
+	}
+}
+
+unsigned int SnapshotBuffer::getCapacity() const
+{
+	return (unsigned int)m_Snapshots.size();
+}
+
+SnapshotBuffer::Snapshot& SnapshotBuffer::beginSnapshot()
+{
+	const unsigned int id = m_NextId++;
+	// Id 0 is never used, even after the counter wraps
+	if (m_NextId == 0)
+		m_NextId = 1;
+
+	Snapshot& snapshot = m_Snapshots[id % m_Snapshots.size()];
+	snapshot.id = id;
+	snapshot.leftOverTime = 0.f;
+	snapshot.bodies.clear();
+
+	return snapshot;
+}
+
+const SnapshotBuffer::Snapshot* SnapshotBuffer::find(unsigned int p_Id) const
+{
+	if (p_Id == 0 || m_Snapshots.empty())
+		return nullptr;
+
+	const Snapshot& snapshot = m_Snapshots[p_Id % m_Snapshots.size()];
+	if (snapshot.id != p_Id)
+		return nullptr;
+
+	return &snapshot;
+}
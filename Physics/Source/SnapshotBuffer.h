@@ -0,0 +1,57 @@
+#pragma once
+#include "Body.h"
+
+#include <vector>
+
+/**
+ * Ring buffer of snapshots of the movable bodies in a physics world.
+ *
+ * Each snapshot only holds the simulated state of the bodies, never volumes or
+ * geometry. The storage is allocated up front and reused, so taking a snapshot
+ * every step does not allocate once the buffer has seen the largest world.
+ */
+class SnapshotBuffer
+{
+public:
+	struct Snapshot
+	{
+		unsigned int id;		// 0 for a slot that has not been used
+		float leftOverTime;		// s, simulation time not yet stepped when the snapshot was taken
+		std::vector<BodyState> bodies;
+	};
+
+private:
+	std::vector<Snapshot> m_Snapshots;
+	unsigned int m_NextId;
+
+public:
+	SnapshotBuffer();
+
+	/**
+	 * Allocate room for snapshots, removing all current snapshots.
+	 *
+	 * @param p_NumSnapshots the number of snapshots to keep, 0 to keep none
+	 * @param p_NumBodies the number of bodies to make room for in each snapshot
+	 */
+	void reserve(unsigned int p_NumSnapshots, unsigned int p_NumBodies);
+
+	/**
+	 * @return the number of snapshots kept
+	 */
+	unsigned int getCapacity() const;
+
+	/**
+	 * Start a new snapshot in place of the oldest one.
+	 *
+	 * @return the new snapshot, with an id and no bodies
+	 */
+	Snapshot& beginSnapshot();
+
+	/**
+	 * Find a snapshot that has not been overwritten yet.
+	 *
+	 * @param p_Id the id of the snapshot
+	 * @return the snapshot or nullptr if it is not kept
+	 */
+	const Snapshot* find(unsigned int p_Id) const;
+};
@@ -0,0 +1,118 @@
+#include "StepProfiler.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <chrono>
+#endif
+
+StepProfiler::StepProfiler() :
+	m_Enabled(false),
+	m_StepStart(0),
+	m_PhaseStart(0),
+	m_NextStep(0),
+	m_NumSteps(0)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	m_MsPerTick = 1000.0 / (double)frequency.QuadPart;
+#else
+	typedef std::chrono::steady_clock::period period;
+	m_MsPerTick = 1000.0 * (double)period::num / (double)period::den;
+#endif
+}
+
+void StepProfiler::setEnabled(bool p_Enabled)
+{
+	m_Enabled = p_Enabled;
+}
+
+bool StepProfiler::isEnabled() const
+{
+	return m_Enabled;
+}
+
+void StepProfiler::beginStep()
+{
+	if (!m_Enabled)
+		return;
+
+	m_Current = PhysicsStepStats();
+	m_StepStart = getTicks();
+	m_PhaseStart = m_StepStart;
+}
+
+void StepProfiler::endPhase(Phase p_Phase)
+{
+	if (!m_Enabled)
+		return;
+
+	const long long now = getTicks();
+	m_Current.*p_Phase += (float)((now - m_PhaseStart) * m_MsPerTick);
+	m_PhaseStart = now;
+}
+
+void StepProfiler::endStep(const PhysicsStepStats& p_Counters)
+{
+	if (!m_Enabled)
+		return;
+
+	addCounters(m_Current, p_Counters);
+	m_Current.totalTime = (float)((getTicks() - m_StepStart) * m_MsPerTick);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Steps[m_NextStep] = m_Current;
+	m_NextStep = (m_NextStep + 1) % maxSteps;
+	if (m_NumSteps < maxSteps)
+	{
+		++m_NumSteps;
+	}
+}
+
+void StepProfiler::clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_NextStep = 0;
+	m_NumSteps = 0;
+}
+
+unsigned int StepProfiler::getNumSteps() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_NumSteps;
+}
+
+PhysicsStepStats StepProfiler::getStep(unsigned int p_Index) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (p_Index >= m_NumSteps)
+		return PhysicsStepStats();
+
+	return m_Steps[(m_NextStep + maxSteps - 1 - p_Index) % maxSteps];
+}
+
+void StepProfiler::addCounters(PhysicsStepStats& p_Target, const PhysicsStepStats& p_Source)
+{
+	p_Target.bodiesIntegrated += p_Source.bodiesIntegrated;
+	p_Target.bodiesSleeping += p_Source.bodiesSleeping;
+	p_Target.broadphaseCandidates += p_Source.broadphaseCandidates;
+	p_Target.volumeTests += p_Source.volumeTests;
+	p_Target.triangleTests += p_Source.triangleTests;
+	p_Target.cachedAxisExits += p_Source.cachedAxisExits;
+	p_Target.hits += p_Source.hits;
+}
+
+long long StepProfiler::getTicks()
+{
+#ifdef _WIN32
+	LARGE_INTEGER ticks;
+	QueryPerformanceCounter(&ticks);
+	return ticks.QuadPart;
+#else
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
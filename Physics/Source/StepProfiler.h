@@ -0,0 +1,93 @@
+#pragma once
+#include "../include/PhysicsTypes.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+/**
+ * Keeps the timings and counters of the most recent physics steps.
+ *
+ * Timing is skipped entirely while the profiler is disabled. The recorded steps
+ * can be read from another thread than the one running the simulation.
+ */
+class StepProfiler
+{
+public:
+	/**
+	 * The number of steps kept, older steps are overwritten.
+	 */
+	static const unsigned int maxSteps = 128;
+
+	/**
+	 * Pointer to one of the timings in PhysicsStepStats.
+	 */
+	typedef float PhysicsStepStats::*Phase;
+
+private:
+	std::atomic<bool> m_Enabled;
+	double m_MsPerTick;
+
+	PhysicsStepStats m_Current;
+	long long m_StepStart;
+	long long m_PhaseStart;
+
+	mutable std::mutex m_Mutex;
+	std::array<PhysicsStepStats, maxSteps> m_Steps;
+	unsigned int m_NextStep;
+	unsigned int m_NumSteps;
+
+public:
+	StepProfiler();
+
+	void setEnabled(bool p_Enabled);
+	bool isEnabled() const;
+
+	/**
+	 * Start timing a new step.
+	 */
+	void beginStep();
+
+	/**
+	 * Add the time since the step or the last phase ended to a phase.
+	 *
+	 * @param p_Phase the timing to add to
+	 */
+	void endPhase(Phase p_Phase);
+
+	/**
+	 * Finish the step and store it together with the counters of the step.
+	 *
+	 * @param p_Counters the counters of the step, the timings are ignored
+	 */
+	void endStep(const PhysicsStepStats& p_Counters);
+
+	/**
+	 * Remove all recorded steps.
+	 */
+	void clear();
+
+	/**
+	 * @return the number of recorded steps, at most maxSteps
+	 */
+	unsigned int getNumSteps() const;
+
+	/**
+	 * Get a recorded step.
+	 *
+	 * @param p_Index 0 for the most recent step, 1 for the one before and so on
+	 * @return the step, or an empty step if there is no such step
+	 */
+	PhysicsStepStats getStep(unsigned int p_Index) const;
+
+	/**
+	 * Add the counters of one set of stats to another, the timings are left untouched.
+	 *
+	 * @param p_Target the stats to add to
+	 * @param p_Source the stats to add
+	 */
+	static void addCounters(PhysicsStepStats& p_Target, const PhysicsStepStats& p_Source);
+
+private:
+	static long long getTicks();
+};
@@ -0,0 +1,123 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool() :
+	m_Task(nullptr),
+	m_NumItems(0),
+	m_NextItem(0),
+	m_ItemsLeft(0),
+	m_Stop(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+	stop();
+}
+
+void WorkerPool::start(unsigned int p_NumThreads)
+{
+	stop();
+
+	m_Stop = false;
+	for (unsigned int i = 1; i < p_NumThreads; ++i)
+	{
+		m_Threads.push_back(std::thread(&WorkerPool::workerLoop, this));
+	}
+}
+
+void WorkerPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_WorkAvailable.notify_all();
+
+	for (auto& thread : m_Threads)
+	{
+		thread.join();
+	}
+	m_Threads.clear();
+}
+
+unsigned int WorkerPool::getNumThreads() const
+{
+	return (unsigned int)m_Threads.size() + 1;
+}
+
+void WorkerPool::run(unsigned int p_NumItems, const Task& p_Task)
+{
+	if (p_NumItems == 0)
+		return;
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Task = &p_Task;
+	m_NumItems = p_NumItems;
+	m_NextItem = 0;
+	m_ItemsLeft = p_NumItems;
+	m_Exception = nullptr;
+	m_WorkAvailable.notify_all();
+
+	while (processItem(lock))
+		;
+
+	while (m_ItemsLeft > 0)
+	{
+		m_WorkDone.wait(lock);
+	}
+
+	m_Task = nullptr;
+	m_NumItems = 0;
+
+	if (m_Exception)
+	{
+		std::exception_ptr exception = m_Exception;
+		m_Exception = nullptr;
+		std::rethrow_exception(exception);
+	}
+}
+
+void WorkerPool::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (!m_Stop)
+	{
+		if (!processItem(lock))
+		{
+			m_WorkAvailable.wait(lock);
+		}
+	}
+}
+
+bool WorkerPool::processItem(std::unique_lock<std::mutex>& p_Lock)
+{
+	if (m_NextItem >= m_NumItems)
+		return false;
+
+	const unsigned int item = m_NextItem++;
+	const Task& task = *m_Task;
+
+	p_Lock.unlock();
+	std::exception_ptr exception;
+	try
+	{
+		task(item);
+	}
+	catch (...)
+	{
+		exception = std::current_exception();
+	}
+	p_Lock.lock();
+
+	if (exception && !m_Exception)
+	{
+		m_Exception = exception;
+	}
+
+	if (--m_ItemsLeft == 0)
+	{
+		m_WorkDone.notify_all();
+	}
+
+	return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A small pool of threads used to split the work of a physics step.
+ *
+ * The thread calling run takes part in the work, so a pool started
+ * with one thread runs everything on the calling thread.
+ */
+class WorkerPool
+{
+public:
+	/**
+	 * A task gets the index of the work item it should process.
+	 */
+	typedef std::function<void(unsigned int)> Task;
+
+private:
+	std::vector<std::thread> m_Threads;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::condition_variable m_WorkDone;
+
+	const Task* m_Task;
+	unsigned int m_NumItems;
+	unsigned int m_NextItem;
+	unsigned int m_ItemsLeft;
+	std::exception_ptr m_Exception;
+	bool m_Stop;
+
+public:
+	WorkerPool();
+	~WorkerPool();
+
+	/**
+	 * Start the pool. Any previously started threads are stopped first.
+	 *
+	 * @param p_NumThreads the total number of threads to work with, including the calling thread
+	 */
+	void start(unsigned int p_NumThreads);
+
+	/**
+	 * Stop and join all worker threads.
+	 */
+	void stop();
+
+	/**
+	 * @return the total number of threads working on a run, including the calling thread
+	 */
+	unsigned int getNumThreads() const;
+
+	/**
+	 * Process a number of work items and wait for all of them to finish.
+	 * If a task throws, the first exception is rethrown once all items are done.
+	 *
+	 * @param p_NumItems the number of work items
+	 * @param p_Task the task to run once for each item
+	 */
+	void run(unsigned int p_NumItems, const Task& p_Task);
+
+private:
+	WorkerPool(const WorkerPool&);
+	WorkerPool& operator=(const WorkerPool&);
+
+	void workerLoop();
+	bool processItem(std::unique_lock<std::mutex>& p_Lock);
+};
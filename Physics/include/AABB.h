@@ -78,7 +78,7 @@ public:
 		vDiag = vTop - vBot;
 		vDiag *= 0.5f;
 
-		m_Sphere.setRadius(XMVector3Length(vDiag).m128_f32[0]);
+		m_Sphere.setRadius(XMVectorGetX(XMVector3Length(vDiag)));
 
 		DirectX::XMStoreFloat4(&m_HalfDiagonal, vDiag);
 	}
@@ -182,7 +182,7 @@ public:
 	* Does nothing since an AABB can not be rotated.
 	* @param p_Rotation vector to scale the box with..
 	*/
-	void setRotation(DirectX::XMMATRIX const &p_Rotation) override
+	void setRotation(DirectX::XMMATRIX const &/*p_Rotation*/) override
 	{
 		
 	}
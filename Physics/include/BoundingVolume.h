@@ -38,6 +38,15 @@ public:
 	 * @param p_Position, move the BV in to this position.
 	 */
 	virtual void setPosition(DirectX::XMVECTOR const &p_Position) = 0;
+	/**
+	 * Move the BoundingVolume without building a transformation matrix.
+	 * @param p_Translation, the relative movement in m, the w component is ignored.
+	 */
+	virtual void translate(DirectX::XMVECTOR const &p_Translation)
+	{
+		const DirectX::XMVECTOR position = DirectX::XMLoadFloat4(&m_Position);
+		setPosition(DirectX::XMVectorSelect(position, DirectX::XMVectorAdd(position, p_Translation), DirectX::g_XMSelect1110));
+	}
 	/**
 	 * Get the current position for the bounding volume.
 	 * @return the position of the bounding volume in m
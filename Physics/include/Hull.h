@@ -1,6 +1,7 @@
 #pragma once
 #include "Sphere.h"
 #include "PhysicsTypes.h"
+#include "HullShape.h"
 #include <DirectXMath.h>
 #include <vector>
 
@@ -8,7 +9,9 @@ class Hull : public BoundingVolume
 {
 private:
 	Sphere m_Sphere; //Sphere surrounding the hull
-	std::vector<Triangle> m_Triangles; //Triangles that make up the hull
+	HullShape::ptr m_Shape; //Triangles that make up the hull, possibly shared with other hulls
+	DirectX::XMFLOAT4X4 m_Transform; //Rotation and scale from the shape to world orientation
+	DirectX::XMFLOAT4X4 m_InvTransform;
 	DirectX::XMFLOAT4	m_Scale;
 
 public:
@@ -18,17 +21,22 @@ public:
 	 * @param p_Triangles, a list of triangles that make up the hull
 	 */
 	Hull(std::vector<Triangle> p_Triangles) :
-		BoundingVolume(&m_Sphere)
+		BoundingVolume(&m_Sphere),
+		m_Shape(HullShape::create(std::move(p_Triangles)))
 	{
-		m_BodyHandle = 0;
-		m_Position = DirectX::XMFLOAT4(0.f, 0.f, 0.f, 1.f);
-		m_Triangles = p_Triangles;
-		m_Type = Type::HULL;
-		float radius = findFarthestDistanceOnTriangle();
-		m_Scale = DirectX::XMFLOAT4(1.f, 1.f, 1.f, 0.f);
-		m_Sphere = Sphere( radius, m_Position );
-		m_CollisionResponse = true;
-		m_IDInBody = 0;
+		initialize();
+	}
+
+	/**
+	 * Constructor.
+	 * Creates a hull using the triangles of an existing shape without copying them.
+	 * @param p_Shape, the shape of the hull
+	 */
+	Hull(HullShape::ptr p_Shape) :
+		BoundingVolume(&m_Sphere),
+		m_Shape(std::move(p_Shape))
+	{
+		initialize();
 	}
 
 	/**
@@ -69,23 +77,10 @@ public:
 	 */
 	void scale(DirectX::XMVECTOR const &p_Scale) override
 	{
-		DirectX::XMVECTOR c1, c2, c3;
 		DirectX::XMMATRIX m = DirectX::XMMatrixScalingFromVector(p_Scale);
 		DirectX::XMStoreFloat4(&m_Scale, p_Scale);
-		for(auto &tri : m_Triangles)
-		{
-			c1 = Vector4ToXMVECTOR(&tri.corners[0]);
-			c2 = Vector4ToXMVECTOR(&tri.corners[1]);
-			c3 = Vector4ToXMVECTOR(&tri.corners[2]);
-
-			c1 = DirectX::XMVector4Transform(c1, m);
-			c2 = DirectX::XMVector4Transform(c2, m);
-			c3 = DirectX::XMVector4Transform(c3, m);
 
-			tri.corners[0] = c1; 
-			tri.corners[1] = c2; 
-			tri.corners[2] = c3;
-		}
+		setTransform(DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&m_Transform), m));
 		float radius = findFarthestDistanceOnTriangle();
 		m_Sphere.setRadius(radius);
 
@@ -96,21 +91,7 @@ public:
 	 */
 	void setRotation(DirectX::XMMATRIX const &p_Rotation) override
 	{
-		DirectX::XMVECTOR c1, c2, c3;
-		for(auto& tri : m_Triangles)
-		{
-			c1 = Vector4ToXMVECTOR(&tri.corners[0]);
-			c2 = Vector4ToXMVECTOR(&tri.corners[1]);
-			c3 = Vector4ToXMVECTOR(&tri.corners[2]);
-
-			c1 = XMVector4Transform(c1, p_Rotation);
-			c2 = XMVector4Transform(c2, p_Rotation);
-			c3 = XMVector4Transform(c3, p_Rotation);
-
-			tri.corners[0] = c1;
-			tri.corners[1] = c2;
-			tri.corners[2] = c3;
-		}
+		setTransform(DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&m_Transform), p_Rotation));
 	}
 	/**
 	 * Get the sphere surrounding the hull.
@@ -121,22 +102,91 @@ public:
 		return m_Sphere;
 	}
 
+	/**
+	 * Get the shape of the hull, which may be shared with other hulls.
+	 * @return the shape of the hull
+	 */
+	const HullShape::ptr& getShape() const
+	{
+		return m_Shape;
+	}
+
+	/**
+	 * Get the hierarchy over the triangles, in the space of the shape before rotation and scale.
+	 * @return the triangle hierarchy
+	 */
+	const TriangleBVH& getBVH() const
+	{
+		return m_Shape->getBVH();
+	}
+
+	/**
+	 * Transform a point from world coordinates to the space of the shape.
+	 * @param p_Point a point in m
+	 * @return the point relative to the hull, before rotation and scale
+	 */
+	DirectX::XMVECTOR toShapeSpace(DirectX::FXMVECTOR p_Point) const
+	{
+		using namespace DirectX;
+
+		return DirectX::XMVector3TransformNormal(p_Point - DirectX::XMLoadFloat4(&m_Position),
+			DirectX::XMLoadFloat4x4(&m_InvTransform));
+	}
+
+	/**
+	 * Transform a direction from world coordinates to the space of the shape.
+	 * Distances along a ray are kept, as long as the direction is not normalized afterwards.
+	 * @param p_Direction a direction in world space
+	 * @return the direction before rotation and scale
+	 */
+	DirectX::XMVECTOR toShapeDirection(DirectX::FXMVECTOR p_Direction) const
+	{
+		return DirectX::XMVector3TransformNormal(p_Direction, DirectX::XMLoadFloat4x4(&m_InvTransform));
+	}
+
+	/**
+	 * Find the triangles that might overlap a box in world coordinates.
+	 * @param p_MinPos the lower corner of the box in m
+	 * @param p_MaxPos the upper corner of the box in m
+	 * @param p_Func called with the index of every triangle that might overlap the box
+	 */
+	template <typename Func>
+	void findTrianglesInBox(DirectX::FXMVECTOR p_MinPos, DirectX::FXMVECTOR p_MaxPos, Func p_Func) const
+	{
+		using namespace DirectX;
+
+		// Find the box in the space of the shape that contains the rotated world box
+		const XMMATRIX invTransform = XMLoadFloat4x4(&m_InvTransform);
+		const XMVECTOR center = toShapeSpace(XMVectorScale(XMVectorAdd(p_MinPos, p_MaxPos), 0.5f));
+		const XMVECTOR halfSize = XMVectorScale(XMVectorSubtract(p_MaxPos, p_MinPos), 0.5f);
+		const XMVECTOR extents = XMVectorAdd(XMVectorAdd(
+			XMVectorAbs(XMVectorScale(invTransform.r[0], XMVectorGetX(halfSize))),
+			XMVectorAbs(XMVectorScale(invTransform.r[1], XMVectorGetY(halfSize)))),
+			XMVectorAbs(XMVectorScale(invTransform.r[2], XMVectorGetZ(halfSize))));
+
+		XMFLOAT3 localMin, localMax;
+		XMStoreFloat3(&localMin, XMVectorSubtract(center, extents));
+		XMStoreFloat3(&localMax, XMVectorAdd(center, extents));
+
+		m_Shape->getBVH().findTriangles(localMin, localMax, p_Func);
+	}
+
 	/**
 	 * Gets the number of triangles in the hull
 	 * @return size of the triangle list
 	 */
-	const unsigned int getTriangleListSize() const
+	unsigned int getTriangleListSize() const
 	{
-		return m_Triangles.size();
+		return m_Shape->getTriangles().size();
 	}
 	/**
 	 * Gets a triangle from the hull
 	 * @param p_Index index of the triangle int the hulls triangle list
-	 * @return a triangle with local coordinates from the hulls triangle list at the specified index
+	 * @return a triangle from the shared shape, before the hull is rotated, scaled and positioned
 	 */
 	const Triangle& getTriangleAt(int p_Index) const
 	{
-		return m_Triangles.at(p_Index);
+		return m_Shape->getTriangles().at(p_Index);
 	}
 	/**
 	 * Gets the current scale of the Hull based on it's orginial scale, the default value of scale is XMFLOAT4(1.f, 1.f, 1.f, 0.f).
@@ -155,22 +205,11 @@ public:
 	 */
 	Triangle getTriangleInWorldCoord(unsigned int p_Index) const
 	{
-		//Triangle triangle;
-		//triangle = m_Triangles[p_Index];
-
-		//triangle.corners[0] = triangle.corners[0] + m_Position;
-		//triangle.corners[1] = triangle.corners[1] + m_Position;
-		//triangle.corners[2] = triangle.corners[2] + m_Position;
+		const Triangle& triangle = m_Shape->getTriangles()[p_Index];
 
-		//triangle.corners[0].w = 1.f;
-		//triangle.corners[1].w = 1.f;
-		//triangle.corners[2].w = 1.f;
-
-		//return triangle;
-
-		return Triangle(Vector4(m_Triangles[p_Index].corners[0].x + m_Position.x, m_Triangles[p_Index].corners[0].y + m_Position.y, m_Triangles[p_Index].corners[0].z + m_Position.z, 1.0f),
-			Vector4(m_Triangles[p_Index].corners[1].x + m_Position.x, m_Triangles[p_Index].corners[1].y + m_Position.y, m_Triangles[p_Index].corners[1].z + m_Position.z, 1.0f),
-			Vector4(m_Triangles[p_Index].corners[2].x + m_Position.x, m_Triangles[p_Index].corners[2].y + m_Position.y, m_Triangles[p_Index].corners[2].z + m_Position.z, 1.0f));
+		return Triangle(Vector4(getCornerInWorldCoord(triangle.corners[0])),
+			Vector4(getCornerInWorldCoord(triangle.corners[1])),
+			Vector4(getCornerInWorldCoord(triangle.corners[2])));
 	}
 
 		/**
@@ -183,26 +222,20 @@ public:
 	*/
 	DirectX::XMVECTOR findClosestPointOnTriangle(DirectX::XMFLOAT4 const &p_Point, int p_TriangleIndex) const
 	{
-		DirectX::XMVECTOR p = XMLoadFloat4(&m_Position);
-
-		using DirectX::operator-;
-		using DirectX::operator*;
-		using DirectX::operator+;
-
-		DirectX::XMVECTOR a = XMLoadFloat3(&m_Triangles[p_TriangleIndex].corners[0].xyz()) + p;
-		//a.m128_f32[3] = 1.f;
-		DirectX::XMVECTOR b = XMLoadFloat3(&m_Triangles[p_TriangleIndex].corners[1].xyz()) + p;
-		//b.m128_f32[3] = 1.f;
-		DirectX::XMVECTOR c = XMLoadFloat3(&m_Triangles[p_TriangleIndex].corners[2].xyz()) + p;
-		//c.m128_f32[3] = 1.f;
+		using namespace DirectX;
+
+		const Triangle& triangle = m_Shape->getTriangles()[p_TriangleIndex];
+		DirectX::XMVECTOR a = getCornerInWorldCoord(triangle.corners[0]);
+		DirectX::XMVECTOR b = getCornerInWorldCoord(triangle.corners[1]);
+		DirectX::XMVECTOR c = getCornerInWorldCoord(triangle.corners[2]);
 		DirectX::XMVECTOR pos = DirectX::XMLoadFloat4(&p_Point);
 
 		DirectX::XMVECTOR ab = b - a;
 		DirectX::XMVECTOR ac = c - a;
 		DirectX::XMVECTOR ap = pos - a;
 
-		float d1 = DirectX::XMVector3Dot(ab, ap).m128_f32[0];
-		float d2 = DirectX::XMVector3Dot(ac, ap).m128_f32[0];
+		float d1 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(ab, ap));
+		float d2 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(ac, ap));
 
 		//DirectX::XMFLOAT4 ret;
 		if(d1 <= 0.f && d2 <= 0.f)
@@ -212,8 +245,8 @@ public:
 		}
 
 		DirectX::XMVECTOR bp = pos - b;
-		float d3 = DirectX::XMVector3Dot(ab, bp).m128_f32[0];
-		float d4 = DirectX::XMVector3Dot(ac, bp).m128_f32[0];
+		float d3 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(ab, bp));
+		float d4 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(ac, bp));
 
 		if(d3 >= 0.f && d4 <= d3)
 		{
@@ -222,8 +255,7 @@ public:
 		}
 
 		float vc = d1*d4 - d3*d2;
-		using DirectX::operator*;
-		using DirectX::operator+;
+		using namespace DirectX;
 
 		if(vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
 		{
@@ -233,8 +265,8 @@ public:
 		}
 
 		DirectX::XMVECTOR cp = pos - c;
-		float d5 = DirectX::XMVector3Dot(ab, cp).m128_f32[0];
-		float d6 = DirectX::XMVector3Dot(ac, cp).m128_f32[0];
+		float d5 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(ab, cp));
+		float d6 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(ac, cp));
 
 		if(d6 >= 0.f && d5 <= d6)
 		{
@@ -266,6 +298,34 @@ public:
 		return a + ab * v + ac * w;
 	}
 private:
+	void initialize()
+	{
+		m_BodyHandle = 0;
+		m_Position = DirectX::XMFLOAT4(0.f, 0.f, 0.f, 1.f);
+		m_Type = Type::HULL;
+		DirectX::XMStoreFloat4x4(&m_Transform, DirectX::XMMatrixIdentity());
+		DirectX::XMStoreFloat4x4(&m_InvTransform, DirectX::XMMatrixIdentity());
+		float radius = findFarthestDistanceOnTriangle();
+		m_Scale = DirectX::XMFLOAT4(1.f, 1.f, 1.f, 0.f);
+		m_Sphere = Sphere( radius, m_Position );
+		m_CollisionResponse = true;
+		m_IDInBody = 0;
+	}
+
+	void setTransform(DirectX::CXMMATRIX p_Transform)
+	{
+		DirectX::XMStoreFloat4x4(&m_Transform, p_Transform);
+		DirectX::XMStoreFloat4x4(&m_InvTransform, DirectX::XMMatrixInverse(nullptr, p_Transform));
+	}
+
+	DirectX::XMVECTOR getCornerInWorldCoord(const Vector4& p_Corner) const
+	{
+		DirectX::XMVECTOR corner = DirectX::XMVector3TransformNormal(Vector4ToXMVECTOR(&p_Corner), DirectX::XMLoadFloat4x4(&m_Transform));
+		corner = DirectX::XMVectorAdd(corner, DirectX::XMLoadFloat4(&m_Position));
+
+		return DirectX::XMVectorSetW(corner, 1.f);
+	}
+
 	float findFarthestDistanceOnTriangle() const
 	{
 		//The idea is that to find the furthest point away from the center
@@ -274,13 +334,14 @@ private:
 		centerPos = DirectX::XMVectorSet(0.f, 0.f, 0.f, 1.f);
 
 		float farthestDistance = 0.f;
+		const DirectX::XMMATRIX transform = DirectX::XMLoadFloat4x4(&m_Transform);
 
-		for(auto& tri : m_Triangles)
+		for(auto& tri : m_Shape->getTriangles())
 		{
-			using DirectX::operator-;
-			corner = Vector4ToXMVECTOR(&tri.corners[0]);
+			using namespace DirectX;
+			corner = DirectX::XMVector3TransformNormal(Vector4ToXMVECTOR(&tri.corners[0]), transform);
 			v = corner - centerPos;
-			float c1 = DirectX::XMVector3Dot(v, v).m128_f32[0];
+			float c1 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(v, v));
 			
 			if(c1 > farthestDistance)
 			{
@@ -288,9 +349,9 @@ private:
 				farthest = v;
 			}
 
-			corner = Vector4ToXMVECTOR(&tri.corners[1]);
+			corner = DirectX::XMVector3TransformNormal(Vector4ToXMVECTOR(&tri.corners[1]), transform);
 			v = corner - centerPos;
-			float c2 = DirectX::XMVector3Dot(v, v).m128_f32[0];
+			float c2 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(v, v));
 
 			if(c2 > farthestDistance)
 			{
@@ -298,9 +359,9 @@ private:
 				farthest = v;
 			}
 
-			corner = Vector4ToXMVECTOR(&tri.corners[2]);
+			corner = DirectX::XMVector3TransformNormal(Vector4ToXMVECTOR(&tri.corners[2]), transform);
 			v = corner - centerPos;
-			float c3 = DirectX::XMVector3Dot(v, v).m128_f32[0];
+			float c3 = DirectX::XMVectorGetX(DirectX::XMVector3Dot(v, v));
 
 			if(c3 > farthestDistance)
 			{
@@ -310,7 +371,7 @@ private:
 
 		}
 	
-		farthest.m128_f32[3] = 1.f;
+		farthest = DirectX::XMVectorSetW(farthest, 1.f);
 		return sqrtf(farthestDistance);
 	}
 };
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include "PhysicsTypes.h"
+#include "TriangleBVH.h"
+#include <DirectXMath.h>
+
+#include <memory>
+#include <vector>
+
+/**
+ * The geometry of a hull, shared between every hull created from the same template.
+ *
+ * A shape never changes once created, the position, rotation and scale of a hull
+ * is kept in the hull itself.
+ */
+class HullShape
+{
+public:
+	typedef std::shared_ptr<const HullShape> ptr;
+
+private:
+	std::vector<Triangle> m_Triangles; //Triangles in local space
+	TriangleBVH m_BVH; //Hierarchy over the triangles in local space
+
+public:
+	/**
+	 * Constructor.
+	 * @param p_Triangles the triangles in local space
+	 */
+	explicit HullShape(std::vector<Triangle> p_Triangles)
+	{
+		m_Triangles.swap(p_Triangles);
+		m_BVH.build(m_Triangles);
+	}
+
+	/**
+	 * Constructor.
+	 * @param p_Triangles the triangles in local space
+	 * @param p_BVH a hierarchy already built over the triangles
+	 */
+	HullShape(std::vector<Triangle> p_Triangles, const TriangleBVH& p_BVH) :
+		m_BVH(p_BVH)
+	{
+		m_Triangles.swap(p_Triangles);
+	}
+
+	/**
+	 * Create a shape that can be shared by several hulls.
+	 * @param p_Triangles the triangles in local space
+	 * @return a shared pointer to the new shape
+	 */
+	static ptr create(std::vector<Triangle> p_Triangles)
+	{
+		return ptr(new HullShape(std::move(p_Triangles)));
+	}
+
+	/**
+	 * Create a shape that can be shared by several hulls, using a prebuilt hierarchy.
+	 * @param p_Triangles the triangles in local space
+	 * @param p_BVH a hierarchy already built over the triangles
+	 * @return a shared pointer to the new shape
+	 */
+	static ptr create(std::vector<Triangle> p_Triangles, const TriangleBVH& p_BVH)
+	{
+		return ptr(new HullShape(std::move(p_Triangles), p_BVH));
+	}
+
+	const std::vector<Triangle>& getTriangles() const
+	{
+		return m_Triangles;
+	}
+
+	const TriangleBVH& getBVH() const
+	{
+		return m_BVH;
+	}
+
+private:
+	HullShape(const HullShape&);
+	HullShape& operator=(const HullShape&);
+};
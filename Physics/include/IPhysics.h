@@ -1,11 +1,17 @@
 #pragma once
 #include "PhysicsTypes.h"
 
+#ifdef _MSC_VER
+#define PHYSICS_DLL_EXPORT __declspec(dllexport)
+#else
+#define PHYSICS_DLL_EXPORT
+#endif
+
 class IPhysics
 {	
 public:
-	__declspec(dllexport) static IPhysics *createPhysics(void);
-	__declspec(dllexport) static void deletePhysics(IPhysics* p_Physics);
+	PHYSICS_DLL_EXPORT static IPhysics *createPhysics(void);
+	PHYSICS_DLL_EXPORT static void deletePhysics(IPhysics* p_Physics);
 
 	/**
 	 * Deconstructor
@@ -17,8 +23,10 @@ public:
 	 * @param p_IsServer, used to determine wether the collisions should modify body position or not, 
 	 *			true if the server is initializing the physics, false when the clients do.
 	 * @param p_Timestep the time used to incrementally update the physics simulation
+	 * @param p_NumThreads the number of threads used to check movable bodies against
+	 *			the static geometry, 1 keeps the whole step on the calling thread
 	 */
-	virtual void initialize(bool p_IsServer, float p_Timestep) = 0;
+	virtual void initialize(bool p_IsServer, float p_Timestep, unsigned int p_NumThreads = 1) = 0;
 
 	/**
 	 * Create a boundingVolume sphere with a body.
@@ -70,6 +78,28 @@ public:
 	 */
 	virtual bool createBV(const char* p_VolumeID, const char* p_FilePath) = 0;
 
+	/**
+	 * Create several bodies at once, such as all the bodies of a level.
+	 * The immovable bodies are sorted into the octree once, after all of them are created.
+	 *
+	 * @param p_Descriptions the bodies to create
+	 * @param p_NumBodies the number of descriptions
+	 * @param p_Handles receives the handle of each created body, 0 for hulls whose template is not loaded
+	 */
+	virtual void createBodies(const BodyDescription* p_Descriptions, unsigned int p_NumBodies, BodyHandle* p_Handles) = 0;
+
+	/**
+	 * Start creating and placing immovable bodies without sorting them into the octree one at a time.
+	 * The octree is built once when the batch ends. Immovable bodies created or moved during the batch
+	 * are not found by collision checks or ray casts until then.
+	 */
+	virtual void beginBodyBatch() = 0;
+
+	/**
+	 * End a batch started by beginBodyBatch and build the octree over all immovable bodies.
+	 */
+	virtual void endBodyBatch() = 0;
+
 	/**
 	 * Add a boundingVolume Sphere to an existing body.
 	 *
@@ -246,6 +276,33 @@ public:
 	 * @return true if this body has landed on something this frame, otherwise false.
 	 */
 	virtual bool getBodyLanded(BodyHandle p_Body) = 0;
+	/**
+	 * Check if a body has been put to sleep.
+	 *
+	 * Movable bodies that have moved slower than a threshold for a while are
+	 * not simulated until a force, an impulse, a new velocity or position, or
+	 * a moving body touching them wakes them up.
+	 *
+	 * @param p_Body the body to check
+	 * @return true if the body is sleeping, otherwise false
+	 */
+	virtual bool getBodySleeping(BodyHandle p_Body) = 0;
+	/**
+	 * Wake a sleeping body so that it is simulated again.
+	 *
+	 * @param p_Body the body to wake
+	 */
+	virtual void wakeBody(BodyHandle p_Body) = 0;
+	/**
+	 * Sweep the movement of a body against the static geometry every step, so that
+	 * fast bodies like spells can not pass through thin walls between two steps.
+	 * The body is stopped where it first touches the geometry and the contact is then
+	 * reported and resolved like any other collision.
+	 *
+	 * @param p_Body the body to change
+	 * @param p_Enabled true to use continuous collision for the body, false to only use the discrete tests
+	 */
+	virtual void setBodyContinuousCollision(BodyHandle p_Body, bool p_Enabled) = 0;
 	/**
 	 * Vector size, with hitData.
 	 *
@@ -332,4 +389,122 @@ public:
 	 * @returns the first body that intersects with the ray
 	 */
 	virtual BodyHandle rayCast(const DirectX::XMFLOAT4 &p_RayDirection, const DirectX::XMFLOAT4 &p_RayOrigin) = 0;
+
+	/**
+	 * Find the closest point where a ray hits an immovable body.
+	 * @param p_RayDirection direction of the ray in world space, does not need to be normalized
+	 * @param p_RayOrigin origin of the ray in world space in cm
+	 * @return the closest hit, with hit set to false if the ray does not hit anything
+	 */
+	virtual RayHit rayCastHit(const DirectX::XMFLOAT4 &p_RayDirection, const DirectX::XMFLOAT4 &p_RayOrigin) = 0;
+
+	/**
+	 * Cast several rays in one call, see rayCastHit.
+	 * @param p_NumRays the number of rays to cast
+	 * @param p_RayDirections the direction of each ray
+	 * @param p_RayOrigins the origin of each ray in cm
+	 * @param p_Hits filled with the closest hit of each ray, must have room for p_NumRays hits
+	 */
+	virtual void rayCastBatch(unsigned int p_NumRays, const DirectX::XMFLOAT4* p_RayDirections,
+		const DirectX::XMFLOAT4* p_RayOrigins, RayHit* p_Hits) = 0;
+
+	/**
+	 * Find the bodies overlapping a sphere, such as the bodies caught in an explosion.
+	 * Immovable bodies are found through the octree and movable bodies through the broadphase.
+	 *
+	 * @param p_Position the center of the sphere in cm
+	 * @param p_Radius the radius of the sphere in cm
+	 * @param p_Exact true to test against the volumes of the bodies, false to only test the spheres surrounding them
+	 * @param p_Bodies receives the overlapping bodies in no particular order, at most p_MaxBodies of them
+	 * @param p_MaxBodies the number of bodies p_Bodies has room for
+	 * @return the number of overlapping bodies, which can be more than p_MaxBodies
+	 */
+	virtual unsigned int overlapSphere(Vector3 p_Position, float p_Radius, bool p_Exact,
+		BodyHandle* p_Bodies, unsigned int p_MaxBodies) = 0;
+
+	/**
+	 * Find the bodies overlapping an axis aligned box, see overlapSphere.
+	 *
+	 * @param p_CenterPos the center of the box in cm
+	 * @param p_Extents the half lengths of the box in cm
+	 */
+	virtual unsigned int overlapAABB(Vector3 p_CenterPos, Vector3 p_Extents, bool p_Exact,
+		BodyHandle* p_Bodies, unsigned int p_MaxBodies) = 0;
+
+	/**
+	 * Find the bodies overlapping a rotated box, see overlapSphere.
+	 *
+	 * @param p_CenterPos the center of the box in cm
+	 * @param p_Extents the half lengths of the box in cm
+	 * @param p_Rotation the rotation of the box in radians, in the same order as setBodyRotation
+	 */
+	virtual unsigned int overlapOBB(Vector3 p_CenterPos, Vector3 p_Extents, Vector3 p_Rotation, bool p_Exact,
+		BodyHandle* p_Bodies, unsigned int p_MaxBodies) = 0;
+
+	/**
+	 * Start or stop recording timings and counters for each simulation step.
+	 * Profiling is disabled by default.
+	 *
+	 * @param p_Enabled true to record the steps
+	 */
+	virtual void setProfilingEnabled(bool p_Enabled) = 0;
+
+	/**
+	 * @return true if the simulation steps are recorded
+	 */
+	virtual bool isProfilingEnabled() const = 0;
+
+	/**
+	 * Get the number of recorded steps. Only the most recent steps are kept.
+	 * Safe to call from another thread than the one updating the physics.
+	 *
+	 * @return the number of steps that can be read with getProfiledStep
+	 */
+	virtual unsigned int getNumProfiledSteps() const = 0;
+
+	/**
+	 * Get the timings and counters of a recorded step.
+	 * Safe to call from another thread than the one updating the physics.
+	 *
+	 * @param p_Index 0 for the most recent step, 1 for the one before and so on
+	 * @return the recorded step, or empty stats if there is no such step
+	 */
+	virtual PhysicsStepStats getProfiledStep(unsigned int p_Index) const = 0;
+
+	/**
+	 * Allocate room for snapshots of the movable bodies, used to rewind the world.
+	 * Only the most recent snapshots are kept, older snapshots are overwritten.
+	 * Removes all current snapshots. No snapshots are kept by default.
+	 *
+	 * @param p_NumSnapshots the number of snapshots to keep, 0 to keep none
+	 * @param p_NumBodies the number of movable bodies to make room for in each snapshot,
+	 *			snapshots of larger worlds grow as needed
+	 */
+	virtual void setSnapshotCapacity(unsigned int p_NumSnapshots, unsigned int p_NumBodies) = 0;
+
+	/**
+	 * Save the position, velocity and other simulated state of every movable body.
+	 * Static bodies, volumes and geometry are not copied.
+	 *
+	 * @return the id of the snapshot, never 0
+	 */
+	virtual unsigned int captureSnapshot() = 0;
+
+	/**
+	 * Check if a snapshot is still kept.
+	 *
+	 * @param p_Snapshot the id of the snapshot
+	 * @return true if the snapshot can be restored
+	 */
+	virtual bool hasSnapshot(unsigned int p_Snapshot) const = 0;
+
+	/**
+	 * Return the movable bodies to the state they had when a snapshot was captured.
+	 * Bodies released since are ignored and bodies created since are left as they are.
+	 * Stepping the world forward from the restored state replays the steps since the snapshot.
+	 *
+	 * @param p_Snapshot the id of the snapshot
+	 * @return true if the snapshot was restored, false if it is no longer kept
+	 */
+	virtual bool restoreSnapshot(unsigned int p_Snapshot) = 0;
 };
\ No newline at end of file
@@ -178,9 +178,7 @@ public:
 		DirectX::XMVECTOR tExtent	= XMLoadFloat4(&m_Extents);
 		DirectX::XMVECTOR result;
 
-		using DirectX::operator-;
-		using DirectX::operator+=;
-		using DirectX::operator*;
+		using namespace DirectX;
 		DirectX::XMVECTOR d = p_Point - tPos;
 		result = tPos;
 		// For each OBB axis.
@@ -189,16 +187,16 @@ public:
 			//project d onto that axis to get the distance
 			//along the axis of d from the box center
 			DirectX::XMVECTOR dotResult = DirectX::XMVector4Dot(d, tAxes.r[i]);
-			float dist = dotResult.m128_f32[0];
+			float dist = DirectX::XMVectorGetX(dotResult);
 			
-			if(dist > tExtent.m128_f32[i])
+			if(dist > DirectX::XMVectorGetByIndex(tExtent, i))
 			{
-				dist = tExtent.m128_f32[i];
+				dist = DirectX::XMVectorGetByIndex(tExtent, i);
 			}
 
-			if(dist < -tExtent.m128_f32[i])
+			if(dist < -DirectX::XMVectorGetByIndex(tExtent, i))
 			{
-				dist = -tExtent.m128_f32[i];
+				dist = -DirectX::XMVectorGetByIndex(tExtent, i);
 			}
 
 			result += dist * tAxes.r[i];
@@ -92,3 +92,83 @@ struct HitData
 		//IDInBody = 0;
 	}
 };
+
+/**
+ * Description of a body with a single volume, used to create many bodies at once.
+ * The volume is scaled and rotated around the body position before the body is moved into place.
+ */
+struct BodyDescription
+{
+	BoundingVolumeType	type;
+	const char*			volumeID;	// Template of the hull, only used for hulls
+	float				mass;
+	bool				isImmovable;
+	bool				isEdge;
+	Vector3				position;	// cm
+	Vector3				extents;	// cm, box half lengths or the radius of a sphere in x
+	Vector3				rotation;	// Radians, in the same order as IPhysics::setBodyRotation
+	Vector3				scale;
+
+	BodyDescription() : type(BoundingVolumeType::SPHERE),
+		volumeID(nullptr),
+		mass(1.f),
+		isImmovable(true),
+		isEdge(false),
+		position(0.f, 0.f, 0.f),
+		extents(0.f, 0.f, 0.f),
+		rotation(0.f, 0.f, 0.f),
+		scale(1.f, 1.f, 1.f)
+	{
+	}
+};
+
+struct RayHit
+{
+	Vector4			hitPos;		// cm
+	Vector4			hitNorm;
+	float			distance;	// cm
+	BodyHandle		body;
+	bool			hit;
+
+	RayHit() : hitPos(Vector4(0.f, 0.f, 0.f, 0.f)),
+		hitNorm(Vector4(0.f, 0.f, 0.f, 0.f)),
+		distance(-1.f),
+		body(0),
+		hit(false)
+	{
+	}
+};
+
+/**
+ * Timings and counters for one physics step.
+ */
+struct PhysicsStepStats
+{
+	float			integrationTime;		// ms
+	float			staticCollisionTime;	// ms, octree queries, narrowphase and response against immovable bodies
+	float			broadphaseTime;			// ms, finding pairs of movable bodies
+	float			pairCollisionTime;		// ms, narrowphase and response between movable bodies
+	float			totalTime;				// ms
+	unsigned int	bodiesIntegrated;
+	unsigned int	bodiesSleeping;
+	unsigned int	broadphaseCandidates;
+	unsigned int	volumeTests;
+	unsigned int	triangleTests;
+	unsigned int	cachedAxisExits;		// Separating axis tests that stopped at the axis cached from the last step
+	unsigned int	hits;
+
+	PhysicsStepStats() : integrationTime(0.f),
+		staticCollisionTime(0.f),
+		broadphaseTime(0.f),
+		pairCollisionTime(0.f),
+		totalTime(0.f),
+		bodiesIntegrated(0),
+		bodiesSleeping(0),
+		broadphaseCandidates(0),
+		volumeTests(0),
+		triangleTests(0),
+		cachedAxisExits(0),
+		hits(0)
+	{
+	}
+};
@@ -102,7 +102,7 @@ public:
 	* Does nothing since an sphere can not be rotated.
 	* @param p_Rotation vector to scale the box with..
 	*/
-	void setRotation(DirectX::XMMATRIX const &p_Rotation) override
+	void setRotation(DirectX::XMMATRIX const &/*p_Rotation*/) override
 	{
 		
 	}
@@ -0,0 +1,331 @@
+#pragma once
+#include "PhysicsTypes.h"
+#include <DirectXMath.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/**
+ * Bounding volume hierarchy over the triangles of a hull.
+ *
+ * The nodes are axis aligned boxes in the local space of the hull, stored depth first
+ * so that the left child of a node always follows the node itself. Leaves refer to a
+ * range in a list of triangle indices.
+ */
+class TriangleBVH
+{
+public:
+	struct Node
+	{
+		DirectX::XMFLOAT3 minPos;
+		DirectX::XMFLOAT3 maxPos;
+		unsigned int first;	// First triangle index for leaves, the right child for inner nodes
+		unsigned int count;	// Number of triangles for leaves, 0 for inner nodes
+
+		bool isLeaf() const
+		{
+			return count > 0;
+		}
+	};
+
+	static const unsigned int trianglesPerLeaf = 4;
+	static const unsigned int maxDepth = 48;
+
+private:
+	std::vector<Node> m_Nodes;
+	std::vector<unsigned int> m_TriangleIndices;
+
+	struct BuildTriangle
+	{
+		DirectX::XMFLOAT3 minPos;
+		DirectX::XMFLOAT3 maxPos;
+		DirectX::XMFLOAT3 center;
+		unsigned int index;
+	};
+
+public:
+	/**
+	 * Rebuild the hierarchy, must be called whenever the triangles change.
+	 * @param p_Triangles the triangles in local space
+	 */
+	void build(const std::vector<Triangle>& p_Triangles)
+	{
+		m_Nodes.clear();
+		m_TriangleIndices.clear();
+
+		if (p_Triangles.empty())
+			return;
+
+		std::vector<BuildTriangle> buildTriangles(p_Triangles.size());
+		for (unsigned int i = 0; i < p_Triangles.size(); ++i)
+		{
+			using namespace DirectX;
+
+			const XMVECTOR c0 = XMLoadFloat4(&p_Triangles[i].corners[0]);
+			const XMVECTOR c1 = XMLoadFloat4(&p_Triangles[i].corners[1]);
+			const XMVECTOR c2 = XMLoadFloat4(&p_Triangles[i].corners[2]);
+			const XMVECTOR minPos = XMVectorMin(c0, XMVectorMin(c1, c2));
+			const XMVECTOR maxPos = XMVectorMax(c0, XMVectorMax(c1, c2));
+
+			BuildTriangle& triangle = buildTriangles[i];
+			XMStoreFloat3(&triangle.minPos, minPos);
+			XMStoreFloat3(&triangle.maxPos, maxPos);
+			XMStoreFloat3(&triangle.center, XMVectorScale(XMVectorAdd(minPos, maxPos), 0.5f));
+			triangle.index = i;
+		}
+
+		m_Nodes.reserve(2 * (p_Triangles.size() / trianglesPerLeaf + 1));
+		m_TriangleIndices.reserve(p_Triangles.size());
+		buildNode(buildTriangles, 0, (unsigned int)buildTriangles.size(), 0);
+	}
+
+	/**
+	 * Use a hierarchy that was built in advance, such as one loaded from a file.
+	 * The hierarchy must have been built by build, possibly scaled afterwards.
+	 *
+	 * @param p_Nodes the nodes of the hierarchy
+	 * @param p_NumNodes the number of nodes
+	 * @param p_TriangleIndices the triangle indices referred to by the leaves
+	 * @param p_NumTriangleIndices the number of triangle indices
+	 * @param p_Scale uniform scale applied to the node bounds
+	 */
+	void assign(const Node* p_Nodes, unsigned int p_NumNodes,
+		const unsigned int* p_TriangleIndices, unsigned int p_NumTriangleIndices, float p_Scale)
+	{
+		m_Nodes.assign(p_Nodes, p_Nodes + p_NumNodes);
+		m_TriangleIndices.assign(p_TriangleIndices, p_TriangleIndices + p_NumTriangleIndices);
+
+		if (p_Scale != 1.f)
+		{
+			for (auto& node : m_Nodes)
+			{
+				using namespace DirectX;
+
+				XMStoreFloat3(&node.minPos, XMVectorScale(XMLoadFloat3(&node.minPos), p_Scale));
+				XMStoreFloat3(&node.maxPos, XMVectorScale(XMLoadFloat3(&node.maxPos), p_Scale));
+			}
+		}
+	}
+
+	/**
+	 * Find all triangles whose bounds overlap a box.
+	 *
+	 * @param p_MinPos the lower corner of the box in local space
+	 * @param p_MaxPos the upper corner of the box in local space
+	 * @param p_Func called with the index of every triangle that might overlap the box
+	 */
+	template <typename Func>
+	void findTriangles(const DirectX::XMFLOAT3& p_MinPos, const DirectX::XMFLOAT3& p_MaxPos, Func p_Func) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		unsigned int stack[maxDepth];
+		unsigned int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const unsigned int nodeIndex = stack[--stackSize];
+			const Node& node = m_Nodes[nodeIndex];
+
+			if (node.minPos.x > p_MaxPos.x || node.maxPos.x < p_MinPos.x ||
+				node.minPos.y > p_MaxPos.y || node.maxPos.y < p_MinPos.y ||
+				node.minPos.z > p_MaxPos.z || node.maxPos.z < p_MinPos.z)
+			{
+				continue;
+			}
+
+			if (node.isLeaf())
+			{
+				for (unsigned int i = node.first; i < node.first + node.count; ++i)
+				{
+					p_Func(m_TriangleIndices[i]);
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.first;
+				stack[stackSize++] = nodeIndex + 1;
+			}
+		}
+	}
+
+	/**
+	 * Visit the triangles along a ray, closest nodes first.
+	 * Nodes further away than the closest hit so far are skipped.
+	 *
+	 * @param p_Origin the origin of the ray in local space
+	 * @param p_Direction the direction of the ray
+	 * @param p_MaxDistance the length of the ray, in lengths of the direction
+	 * @param p_Func called with the index of each triangle to test, returns the distance
+	 *			to the hit along the ray or a negative value if the triangle was missed
+	 */
+	template <typename Func>
+	void castRay(const DirectX::XMFLOAT3& p_Origin, const DirectX::XMFLOAT3& p_Direction, float p_MaxDistance, Func p_Func) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		const DirectX::XMFLOAT3 invDirection(1.f / p_Direction.x, 1.f / p_Direction.y, 1.f / p_Direction.z);
+
+		struct StackEntry
+		{
+			unsigned int node;
+			float distance;
+		};
+		StackEntry stack[maxDepth];
+		unsigned int stackSize = 0;
+
+		float entryDistance;
+		if (!rayIntersectsNode(m_Nodes[0], p_Origin, invDirection, p_MaxDistance, entryDistance))
+			return;
+
+		stack[stackSize].node = 0;
+		stack[stackSize].distance = entryDistance;
+		++stackSize;
+
+		while (stackSize > 0)
+		{
+			const StackEntry entry = stack[--stackSize];
+			if (entry.distance > p_MaxDistance)
+				continue;
+
+			const Node& node = m_Nodes[entry.node];
+			if (node.isLeaf())
+			{
+				for (unsigned int i = node.first; i < node.first + node.count; ++i)
+				{
+					const float distance = p_Func(m_TriangleIndices[i]);
+					if (distance > 0.f && distance < p_MaxDistance)
+					{
+						p_MaxDistance = distance;
+					}
+				}
+				continue;
+			}
+
+			StackEntry children[2];
+			unsigned int numChildren = 0;
+			const unsigned int childNodes[2] = { entry.node + 1, node.first };
+			for (unsigned int i = 0; i < 2; ++i)
+			{
+				if (rayIntersectsNode(m_Nodes[childNodes[i]], p_Origin, invDirection, p_MaxDistance, entryDistance))
+				{
+					children[numChildren].node = childNodes[i];
+					children[numChildren].distance = entryDistance;
+					++numChildren;
+				}
+			}
+
+			// Push the far child first so the near child is visited first
+			if (numChildren == 2 && children[0].distance < children[1].distance)
+			{
+				std::swap(children[0], children[1]);
+			}
+			for (unsigned int i = 0; i < numChildren; ++i)
+			{
+				stack[stackSize++] = children[i];
+			}
+		}
+	}
+
+	const std::vector<Node>& getNodes() const
+	{
+		return m_Nodes;
+	}
+
+	const std::vector<unsigned int>& getTriangleIndices() const
+	{
+		return m_TriangleIndices;
+	}
+
+private:
+	static bool rayIntersectsNode(const Node& p_Node, const DirectX::XMFLOAT3& p_Origin, const DirectX::XMFLOAT3& p_InvDirection,
+		float p_MaxDistance, float& p_EntryDistance)
+	{
+		float entry = 0.f;
+		float exit = p_MaxDistance;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float t0 = (getAxis(p_Node.minPos, axis) - getAxis(p_Origin, axis)) * getAxis(p_InvDirection, axis);
+			const float t1 = (getAxis(p_Node.maxPos, axis) - getAxis(p_Origin, axis)) * getAxis(p_InvDirection, axis);
+
+			entry = std::max(entry, std::min(t0, t1));
+			exit = std::min(exit, std::max(t0, t1));
+		}
+
+		p_EntryDistance = entry;
+		return entry <= exit;
+	}
+
+	static float getAxis(const DirectX::XMFLOAT3& p_Vector, int p_Axis)
+	{
+		switch (p_Axis)
+		{
+		case 0:
+			return p_Vector.x;
+		case 1:
+			return p_Vector.y;
+		default:
+			return p_Vector.z;
+		}
+	}
+
+	void buildNode(std::vector<BuildTriangle>& p_Triangles, unsigned int p_First, unsigned int p_Last, unsigned int p_Depth)
+	{
+		using namespace DirectX;
+
+		XMVECTOR minPos = XMLoadFloat3(&p_Triangles[p_First].minPos);
+		XMVECTOR maxPos = XMLoadFloat3(&p_Triangles[p_First].maxPos);
+		XMVECTOR minCenter = XMLoadFloat3(&p_Triangles[p_First].center);
+		XMVECTOR maxCenter = minCenter;
+		for (unsigned int i = p_First + 1; i < p_Last; ++i)
+		{
+			minPos = XMVectorMin(minPos, XMLoadFloat3(&p_Triangles[i].minPos));
+			maxPos = XMVectorMax(maxPos, XMLoadFloat3(&p_Triangles[i].maxPos));
+			minCenter = XMVectorMin(minCenter, XMLoadFloat3(&p_Triangles[i].center));
+			maxCenter = XMVectorMax(maxCenter, XMLoadFloat3(&p_Triangles[i].center));
+		}
+
+		const unsigned int nodeIndex = (unsigned int)m_Nodes.size();
+		m_Nodes.push_back(Node());
+		XMStoreFloat3(&m_Nodes[nodeIndex].minPos, minPos);
+		XMStoreFloat3(&m_Nodes[nodeIndex].maxPos, maxPos);
+
+		// The stack used when searching holds at most one entry per level plus one
+		if (p_Last - p_First <= trianglesPerLeaf || p_Depth + 2 >= maxDepth)
+		{
+			m_Nodes[nodeIndex].first = (unsigned int)m_TriangleIndices.size();
+			m_Nodes[nodeIndex].count = p_Last - p_First;
+			for (unsigned int i = p_First; i < p_Last; ++i)
+			{
+				m_TriangleIndices.push_back(p_Triangles[i].index);
+			}
+			return;
+		}
+
+		// Split on the median of the triangle centers along the longest axis
+		XMFLOAT3 extents;
+		XMStoreFloat3(&extents, XMVectorSubtract(maxCenter, minCenter));
+		int axisIndex = 0;
+		if (extents.y > extents.x && extents.y >= extents.z)
+			axisIndex = 1;
+		else if (extents.z > extents.x && extents.z > extents.y)
+			axisIndex = 2;
+
+		const unsigned int middle = p_First + (p_Last - p_First) / 2;
+		std::nth_element(p_Triangles.begin() + p_First, p_Triangles.begin() + middle, p_Triangles.begin() + p_Last,
+			[axisIndex] (const BuildTriangle& p_Lhs, const BuildTriangle& p_Rhs)
+			{
+				return getAxis(p_Lhs.center, axisIndex) < getAxis(p_Rhs.center, axisIndex);
+			});
+
+		m_Nodes[nodeIndex].count = 0;
+		buildNode(p_Triangles, p_First, middle, p_Depth + 1);
+		m_Nodes[nodeIndex].first = (unsigned int)m_Nodes.size();
+		buildNode(p_Triangles, middle, p_Last, p_Depth + 1);
+	}
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+/**
+ * Empty source annotations for building DirectXMath with GCC or Clang.
+ * Only the Visual Studio code analysis reads them, so they can expand to nothing.
+ */
+
+#define _Analysis_assume_(expr)
+#define _Check_return_
+#define _In_
+#define _In_opt_
+#define _In_reads_(size)
+#define _In_reads_bytes_(size)
+#define _In_reads_opt_(size)
+#define _Inout_
+#define _Inout_opt_
+#define _Inout_updates_(size)
+#define _Inout_updates_bytes_(size)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Out_writes_all_(size)
+#define _Out_writes_bytes_(size)
+#define _Out_writes_opt_(size)
+#define _Outptr_
+#define _Outptr_opt_
+#define _Printf_format_string_
+#define _Ret_maybenull_
+#define _Success_(expr)
+#define _Use_decl_annotations_
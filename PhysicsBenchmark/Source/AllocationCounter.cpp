@@ -0,0 +1,65 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<unsigned long long> g_NumAllocations(0);
+
+	void* allocate(size_t p_Size)
+	{
+		++g_NumAllocations;
+
+		void* memory = std::malloc(p_Size > 0 ? p_Size : 1);
+		if (!memory)
+			throw std::bad_alloc();
+
+		return memory;
+	}
+}
+
+namespace AllocationCounter
+{
+	void reset()
+	{
+		g_NumAllocations = 0;
+	}
+
+	unsigned long long getCount()
+	{
+		return g_NumAllocations;
+	}
+}
+
+void* operator new(size_t p_Size)
+{
+	return allocate(p_Size);
+}
+
+void* operator new[](size_t p_Size)
+{
+	return allocate(p_Size);
+}
+
+void operator delete(void* p_Memory) throw()
+{
+	std::free(p_Memory);
+}
+
+void operator delete[](void* p_Memory) throw()
+{
+	std::free(p_Memory);
+}
+
+// Compilers with sized deallocation call these instead, which would bypass the replacements above
+void operator delete(void* p_Memory, size_t) throw()
+{
+	operator delete(p_Memory);
+}
+
+void operator delete[](void* p_Memory, size_t) throw()
+{
+	operator delete[](p_Memory);
+}
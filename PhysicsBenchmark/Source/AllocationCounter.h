@@ -0,0 +1,20 @@
+#pragma once
+
+/**
+ * Counts the calls to the global operator new of the benchmark.
+ *
+ * The physics sources are compiled into the benchmark itself, so every allocation made by
+ * the physics, including those made by the worker threads, passes through the counter.
+ */
+namespace AllocationCounter
+{
+	/**
+	 * Start counting from zero.
+	 */
+	void reset();
+
+	/**
+	 * @return the number of allocations since the last reset
+	 */
+	unsigned long long getCount();
+}
@@ -0,0 +1,365 @@
+#include "Benchmark.h"
+#include "AllocationCounter.h"
+#include "../../Physics/Source/Octree.h"
+
+#include <CommonExceptions.h>
+#include <InstanceBinaryLoader.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <chrono>
+#endif
+
+using namespace DirectX;
+
+static const float serverTimestep = 1.f / 30.f;	// s, same step as the game rounds
+static const unsigned int numWarmupSteps = 30;
+static const float hullSpacing = 1500.f;	// cm
+static const float queryRadius = 100.f;	// cm, about the size of a player
+
+Benchmark::Benchmark(const Settings& p_Settings) :
+	m_Physics(IPhysics::createPhysics()),
+	m_Settings(p_Settings),
+	m_Random(p_Settings.seed),
+	m_MinPos(FLT_MAX, FLT_MAX, FLT_MAX),
+	m_MaxPos(-FLT_MAX, -FLT_MAX, -FLT_MAX)
+{
+	m_Physics->initialize(true, serverTimestep, m_Settings.numThreads);
+}
+
+Benchmark::~Benchmark()
+{
+	IPhysics::deletePhysics(m_Physics);
+}
+
+unsigned int Benchmark::loadHullTemplates(const std::string& p_VolumeFolder)
+{
+	namespace fs = boost::filesystem;
+
+	boost::system::error_code error;
+	for (fs::directory_iterator it(p_VolumeFolder, error), end; !error && it != end; ++it)
+	{
+		const fs::path& path = it->path();
+		const std::string name = path.stem().string();
+		if (path.extension() != ".txc" || name.compare(0, 3, "CB_") != 0)
+			continue;
+
+		const std::string volumeID = name.substr(3);
+		if (m_Physics->createBV(volumeID.c_str(), path.string().c_str()))
+		{
+			m_HullTemplates.push_back(volumeID);
+		}
+	}
+
+	return (unsigned int)m_HullTemplates.size();
+}
+
+void Benchmark::createSyntheticWorld(unsigned int p_NumHulls, unsigned int p_NumSpheres, unsigned int p_NumBoxes)
+{
+	const unsigned int side = (unsigned int)std::ceil(std::sqrt((float)std::max(p_NumHulls, 1u)));
+	const float halfSize = side * hullSpacing * 0.5f;
+
+	std::vector<BodyDescription> descriptions(p_NumHulls + 1);
+
+	BodyDescription& ground = descriptions[0];
+	ground.type = BoundingVolumeType::AABB;
+	ground.position = Vector3(halfSize, -100.f, halfSize);
+	ground.extents = Vector3(halfSize + hullSpacing, 100.f, halfSize + hullSpacing);
+
+	for (unsigned int i = 0; i < p_NumHulls; ++i)
+	{
+		BodyDescription& body = descriptions[i + 1];
+		body.position = Vector3(
+			((float)(i % side) + 0.5f) * hullSpacing + random(-300.f, 300.f),
+			0.f,
+			((float)(i / side) + 0.5f) * hullSpacing + random(-300.f, 300.f));
+		body.rotation = Vector3(random(0.f, XM_2PI), 0.f, 0.f);
+
+		if (m_HullTemplates.empty())
+		{
+			body.type = BoundingVolumeType::OBB;
+			body.extents = Vector3(random(100.f, 400.f), random(100.f, 400.f), random(100.f, 400.f));
+		}
+		else
+		{
+			body.type = BoundingVolumeType::HULL;
+			body.volumeID = m_HullTemplates[i % m_HullTemplates.size()].c_str();
+		}
+	}
+
+	addStaticBodies(descriptions);
+	addMovableBodies(p_NumSpheres, p_NumBoxes);
+}
+
+bool Benchmark::loadLevel(const std::string& p_LevelPath, const std::string& p_VolumeFolder,
+	unsigned int p_NumSpheres, unsigned int p_NumBoxes)
+{
+	InstanceBinaryLoader levelLoader;
+	try
+	{
+		levelLoader.loadBinaryFile(p_LevelPath);
+	}
+	catch (CommonException& err)
+	{
+		std::cerr << err.what() << std::endl;
+		return false;
+	}
+
+	std::vector<BodyDescription> descriptions;
+	for (const auto& model : levelLoader.getModelData())
+	{
+		if (!model.m_CollideAble)
+			continue;
+
+		const std::string volumePath = p_VolumeFolder + "/CB_" + model.m_MeshName + ".txc";
+		if (!m_Physics->createBV(model.m_MeshName.c_str(), volumePath.c_str()))
+		{
+			std::cerr << "Missing collision mesh " << volumePath << std::endl;
+			continue;
+		}
+
+		for (unsigned int i = 0; i < model.m_Translation.size(); ++i)
+		{
+			BodyDescription body;
+			body.type = BoundingVolumeType::HULL;
+			body.volumeID = model.m_MeshName.c_str();
+			body.position = model.m_Translation[i];
+			body.rotation = model.m_Rotation[i];
+			body.scale = model.m_Scale[i];
+			descriptions.push_back(body);
+		}
+	}
+
+	if (descriptions.empty())
+		return false;
+
+	addStaticBodies(descriptions);
+	addMovableBodies(p_NumSpheres, p_NumBoxes);
+
+	return true;
+}
+
+BenchmarkResult Benchmark::run()
+{
+	BenchmarkResult result;
+	result.numStaticBodies = (unsigned int)m_StaticBodies.size();
+	result.numMovableBodies = (unsigned int)m_MovableBodies.size();
+
+	// Let the bodies fall into contact with the static geometry before measuring
+	m_Physics->update(serverTimestep * numWarmupSteps, numWarmupSteps);
+	m_Physics->setProfilingEnabled(true);
+
+	measureSteps(result);
+	measureRays(result);
+	measureOctree(result);
+
+	m_Physics->setProfilingEnabled(false);
+
+	return result;
+}
+
+void Benchmark::addStaticBodies(const std::vector<BodyDescription>& p_Descriptions)
+{
+	std::vector<BodyHandle> handles(p_Descriptions.size());
+	m_Physics->createBodies(p_Descriptions.data(), (unsigned int)p_Descriptions.size(), handles.data());
+
+	for (const BodyHandle handle : handles)
+	{
+		if (handle == 0)
+			continue;
+
+		m_StaticBodies.push_back(handle);
+
+		const Vector3 position = m_Physics->getBodyPosition(handle);
+		const float radius = m_Physics->getSurroundingSphereRadius(handle);
+		m_MinPos = Vector3(std::min(m_MinPos.x, position.x - radius), std::min(m_MinPos.y, position.y - radius),
+			std::min(m_MinPos.z, position.z - radius));
+		m_MaxPos = Vector3(std::max(m_MaxPos.x, position.x + radius), std::max(m_MaxPos.y, position.y + radius),
+			std::max(m_MaxPos.z, position.z + radius));
+	}
+}
+
+void Benchmark::addMovableBodies(unsigned int p_NumSpheres, unsigned int p_NumBoxes)
+{
+	if (m_StaticBodies.empty())
+		return;
+
+	std::vector<BodyDescription> descriptions(p_NumSpheres + p_NumBoxes);
+	for (unsigned int i = 0; i < descriptions.size(); ++i)
+	{
+		BodyDescription& body = descriptions[i];
+		body.mass = 68.f;
+		body.isImmovable = false;
+		body.position = Vector3(random(m_MinPos.x, m_MaxPos.x), m_MaxPos.y + random(100.f, 1000.f),
+			random(m_MinPos.z, m_MaxPos.z));
+
+		if (i < p_NumSpheres)
+		{
+			body.type = BoundingVolumeType::SPHERE;
+			body.extents = Vector3(random(30.f, 60.f), 0.f, 0.f);
+		}
+		else
+		{
+			body.type = BoundingVolumeType::OBB;
+			body.extents = Vector3(random(30.f, 80.f), random(30.f, 80.f), random(30.f, 80.f));
+		}
+	}
+
+	std::vector<BodyHandle> handles(descriptions.size());
+	m_Physics->createBodies(descriptions.data(), (unsigned int)descriptions.size(), handles.data());
+
+	for (const BodyHandle handle : handles)
+	{
+		m_Physics->setBodyVelocity(handle, Vector3(random(-500.f, 500.f), 0.f, random(-500.f, 500.f)));
+		m_MovableBodies.push_back(handle);
+	}
+}
+
+void Benchmark::measureSteps(BenchmarkResult& p_Result)
+{
+	PhysicsStepStats total;
+
+	AllocationCounter::reset();
+	const double start = getSeconds();
+	for (unsigned int i = 0; i < m_Settings.numSteps; ++i)
+	{
+		m_Physics->update(serverTimestep, 1);
+
+		const PhysicsStepStats step = m_Physics->getProfiledStep(0);
+		total.broadphaseCandidates += step.broadphaseCandidates;
+		total.volumeTests += step.volumeTests;
+		total.triangleTests += step.triangleTests;
+		total.hits += step.hits;
+	}
+	const double elapsed = getSeconds() - start;
+	const unsigned long long allocations = AllocationCounter::getCount();
+
+	if (m_Settings.numSteps == 0)
+		return;
+
+	const double numSteps = (double)m_Settings.numSteps;
+	p_Result.numSteps = m_Settings.numSteps;
+	p_Result.stepsPerSecond = elapsed > 0.0 ? numSteps / elapsed : 0.0;
+	p_Result.candidatesPerStep = total.broadphaseCandidates / numSteps;
+	p_Result.volumeTestsPerStep = total.volumeTests / numSteps;
+	p_Result.triangleTestsPerStep = total.triangleTests / numSteps;
+	p_Result.hitsPerStep = total.hits / numSteps;
+	p_Result.allocationsPerStep = allocations / numSteps;
+}
+
+void Benchmark::measureRays(BenchmarkResult& p_Result)
+{
+	if (m_Settings.numRays == 0 || m_StaticBodies.empty())
+		return;
+
+	// Rays cast down into the world from above, like the server looking for the ground below a player
+	std::vector<XMFLOAT4> origins(m_Settings.numRays);
+	std::vector<XMFLOAT4> directions(m_Settings.numRays);
+	for (unsigned int i = 0; i < m_Settings.numRays; ++i)
+	{
+		origins[i] = XMFLOAT4(random(m_MinPos.x, m_MaxPos.x), m_MaxPos.y + 500.f, random(m_MinPos.z, m_MaxPos.z), 1.f);
+		directions[i] = XMFLOAT4(random(-0.3f, 0.3f), -1.f, random(-0.3f, 0.3f), 0.f);
+	}
+
+	AllocationCounter::reset();
+	const double start = getSeconds();
+	for (unsigned int i = 0; i < m_Settings.numRays; ++i)
+	{
+		m_Physics->rayCastHit(directions[i], origins[i]);
+	}
+	const double elapsed = getSeconds() - start;
+
+	p_Result.raysPerSecond = elapsed > 0.0 ? m_Settings.numRays / elapsed : 0.0;
+	p_Result.allocationsPerRay = AllocationCounter::getCount() / (double)m_Settings.numRays;
+}
+
+void Benchmark::measureOctree(BenchmarkResult& p_Result)
+{
+	if (m_Settings.numQueries == 0 || m_StaticBodies.empty())
+		return;
+
+	// The physics does not expose its octree, so an octree is built over spheres
+	// surrounding the static bodies in the same way the physics builds its own
+	std::vector<Sphere> spheres;
+	spheres.reserve(m_StaticBodies.size());
+	for (const BodyHandle body : m_StaticBodies)
+	{
+		const Vector3 position = m_Physics->getBodyPosition(body) * 0.01f;	// m
+		spheres.push_back(Sphere(m_Physics->getSurroundingSphereRadius(body) * 0.01f,
+			XMFLOAT4(position.x, position.y, position.z, 1.f)));
+	}
+	std::vector<const Sphere*> spherePointers;
+	spherePointers.reserve(spheres.size());
+	for (const auto& sphere : spheres)
+	{
+		spherePointers.push_back(&sphere);
+	}
+
+	Octree octree;
+	octree.addBodies(m_StaticBodies.data(), spherePointers.data(), m_StaticBodies.size());
+
+	std::vector<Sphere> queries;
+	queries.reserve(m_Settings.numQueries);
+	for (unsigned int i = 0; i < m_Settings.numQueries; ++i)
+	{
+		queries.push_back(Sphere(queryRadius * 0.01f, XMFLOAT4(
+			random(m_MinPos.x, m_MaxPos.x) * 0.01f,
+			random(m_MinPos.y, m_MaxPos.y) * 0.01f,
+			random(m_MinPos.z, m_MaxPos.z) * 0.01f,
+			1.f)));
+	}
+
+	std::vector<BodyHandle> candidates;
+	candidates.reserve(m_StaticBodies.size());
+	unsigned long long numCandidates = 0;
+
+	AllocationCounter::reset();
+	const double start = getSeconds();
+	for (const auto& query : queries)
+	{
+		candidates.clear();
+		octree.findPotentialIntersections(&query, std::back_inserter(candidates));
+		numCandidates += candidates.size();
+	}
+	const double elapsed = getSeconds() - start;
+
+	const double numQueries = (double)m_Settings.numQueries;
+	p_Result.queriesPerSecond = elapsed > 0.0 ? numQueries / elapsed : 0.0;
+	p_Result.candidatesPerQuery = numCandidates / numQueries;
+	p_Result.allocationsPerQuery = AllocationCounter::getCount() / numQueries;
+}
+
+float Benchmark::random(float p_Min, float p_Max)
+{
+	if (p_Max <= p_Min)
+		return p_Min;
+
+	std::uniform_real_distribution<float> distribution(p_Min, p_Max);
+	return distribution(m_Random);
+}
+
+double Benchmark::getSeconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <IPhysics.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Throughput of the physics in one benchmarked world, averaged over the measured steps and queries.
+ */
+struct BenchmarkResult
+{
+	unsigned int numStaticBodies;
+	unsigned int numMovableBodies;
+	unsigned int numSteps;
+	double stepsPerSecond;
+	double candidatesPerStep;		// Bodies found by the octree and the broadphase
+	double volumeTestsPerStep;		// Narrowphase tests between pairs of volumes
+	double triangleTestsPerStep;
+	double hitsPerStep;
+	double allocationsPerStep;
+	double raysPerSecond;
+	double allocationsPerRay;
+	double queriesPerSecond;		// Sphere queries against the octree of the static bodies
+	double candidatesPerQuery;
+	double allocationsPerQuery;
+
+	BenchmarkResult() : numStaticBodies(0),
+		numMovableBodies(0),
+		numSteps(0),
+		stepsPerSecond(0.0),
+		candidatesPerStep(0.0),
+		volumeTestsPerStep(0.0),
+		triangleTestsPerStep(0.0),
+		hitsPerStep(0.0),
+		allocationsPerStep(0.0),
+		raysPerSecond(0.0),
+		allocationsPerRay(0.0),
+		queriesPerSecond(0.0),
+		candidatesPerQuery(0.0),
+		allocationsPerQuery(0.0)
+	{
+	}
+};
+
+/**
+ * A physics world built for measuring, either from generated bodies or from the
+ * collision data of a real level. Each benchmark owns its own physics and measures one world.
+ */
+class Benchmark
+{
+public:
+	struct Settings
+	{
+		unsigned int numThreads;
+		unsigned int numSteps;
+		unsigned int numRays;
+		unsigned int numQueries;
+		unsigned int seed;
+	};
+
+private:
+	IPhysics* m_Physics;
+	Settings m_Settings;
+	std::mt19937 m_Random;
+	std::vector<std::string> m_HullTemplates;
+	std::vector<BodyHandle> m_StaticBodies;
+	std::vector<BodyHandle> m_MovableBodies;
+	Vector3 m_MinPos;	// cm, bounds of the static bodies
+	Vector3 m_MaxPos;	// cm
+
+public:
+	explicit Benchmark(const Settings& p_Settings);
+	~Benchmark();
+
+	/**
+	 * Load every collision mesh (CB_*.txc) in a folder, to be used as the static hulls of a generated world.
+	 *
+	 * @param p_VolumeFolder the folder with the collision meshes
+	 * @return the number of loaded meshes
+	 */
+	unsigned int loadHullTemplates(const std::string& p_VolumeFolder);
+
+	/**
+	 * Generate a world of static hulls spread out on a ground box, with movable bodies falling onto them.
+	 * Static boxes are used instead of hulls if no hull templates are loaded.
+	 *
+	 * @param p_NumHulls the number of static hulls
+	 * @param p_NumSpheres the number of movable spheres
+	 * @param p_NumBoxes the number of movable boxes
+	 */
+	void createSyntheticWorld(unsigned int p_NumHulls, unsigned int p_NumSpheres, unsigned int p_NumBoxes);
+
+	/**
+	 * Create the collidable instances of a converted level (.btxl) as static hulls,
+	 * with movable bodies falling onto the level.
+	 *
+	 * @param p_LevelPath the level file
+	 * @param p_VolumeFolder the folder with the collision meshes of the level models
+	 * @param p_NumSpheres the number of movable spheres
+	 * @param p_NumBoxes the number of movable boxes
+	 * @return true if the level was loaded, otherwise false
+	 */
+	bool loadLevel(const std::string& p_LevelPath, const std::string& p_VolumeFolder,
+		unsigned int p_NumSpheres, unsigned int p_NumBoxes);
+
+	/**
+	 * Step the world and cast rays and octree queries into it.
+	 *
+	 * @return the measured throughput
+	 */
+	BenchmarkResult run();
+
+private:
+	Benchmark(const Benchmark&);
+	Benchmark& operator=(const Benchmark&);
+
+	void addStaticBodies(const std::vector<BodyDescription>& p_Descriptions);
+	void addMovableBodies(unsigned int p_NumSpheres, unsigned int p_NumBoxes);
+
+	void measureSteps(BenchmarkResult& p_Result);
+	void measureRays(BenchmarkResult& p_Result);
+	void measureOctree(BenchmarkResult& p_Result);
+
+	float random(float p_Min, float p_Max);
+	static double getSeconds();
+};
@@ -0,0 +1,107 @@
+#include "Benchmark.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+static void printResult(const char* p_Name, const BenchmarkResult& p_Result)
+{
+	std::cout << std::fixed << std::setprecision(1)
+		<< p_Name
+		<< " static=" << p_Result.numStaticBodies
+		<< " movable=" << p_Result.numMovableBodies
+		<< " steps=" << p_Result.numSteps
+		<< " steps/s=" << p_Result.stepsPerSecond
+		<< " candidates/step=" << p_Result.candidatesPerStep
+		<< " pairtests/step=" << p_Result.volumeTestsPerStep
+		<< " triangletests/step=" << p_Result.triangleTestsPerStep
+		<< " hits/step=" << p_Result.hitsPerStep
+		<< " allocs/step=" << p_Result.allocationsPerStep
+		<< " rays/s=" << p_Result.raysPerSecond
+		<< " allocs/ray=" << p_Result.allocationsPerRay
+		<< " queries/s=" << p_Result.queriesPerSecond
+		<< " candidates/query=" << p_Result.candidatesPerQuery
+		<< " allocs/query=" << p_Result.allocationsPerQuery
+		<< std::endl;
+}
+
+/**
+ * Runs the physics without a window or graphics, on a generated world and optionally on the
+ * collision data of a real level, and prints the throughput of each world on one line.
+ * Returns EXIT_FAILURE if a world could not be created.
+ *
+ * Usage: PhysicsBenchmark [--hulls N] [--spheres N] [--boxes N] [--steps N] [--rays N]
+ *		[--queries N] [--threads N] [--seed N] [--volumes folder] [--level file.btxl]
+ */
+int main(int argc, char* argv[])
+{
+	Benchmark::Settings settings;
+	settings.numThreads = 1;
+	settings.numSteps = 600;
+	settings.numRays = 10000;
+	settings.numQueries = 100000;
+	settings.seed = 1;
+
+	unsigned int numHulls = 1000;
+	unsigned int numSpheres = 200;
+	unsigned int numBoxes = 50;
+	std::string volumeFolder = "assets/volumes";
+	std::string levelPath;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const char* option = argv[i];
+		const char* value = argv[i + 1];
+		const unsigned int number = (unsigned int)std::strtoul(value, nullptr, 10);
+
+		if (std::strcmp(option, "--hulls") == 0)
+			numHulls = number;
+		else if (std::strcmp(option, "--spheres") == 0)
+			numSpheres = number;
+		else if (std::strcmp(option, "--boxes") == 0)
+			numBoxes = number;
+		else if (std::strcmp(option, "--steps") == 0)
+			settings.numSteps = number;
+		else if (std::strcmp(option, "--rays") == 0)
+			settings.numRays = number;
+		else if (std::strcmp(option, "--queries") == 0)
+			settings.numQueries = number;
+		else if (std::strcmp(option, "--threads") == 0)
+			settings.numThreads = number;
+		else if (std::strcmp(option, "--seed") == 0)
+			settings.seed = number;
+		else if (std::strcmp(option, "--volumes") == 0)
+			volumeFolder = value;
+		else if (std::strcmp(option, "--level") == 0)
+			levelPath = value;
+		else
+		{
+			std::cerr << "Unknown option " << option << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	{
+		Benchmark synthetic(settings);
+		if (synthetic.loadHullTemplates(volumeFolder) == 0)
+		{
+			std::cerr << "No collision meshes found in " << volumeFolder << ", using boxes as static bodies" << std::endl;
+		}
+		synthetic.createSyntheticWorld(numHulls, numSpheres, numBoxes);
+		printResult("synthetic", synthetic.run());
+	}
+
+	if (!levelPath.empty())
+	{
+		Benchmark level(settings);
+		if (!level.loadLevel(levelPath, volumeFolder, numSpheres, numBoxes))
+		{
+			std::cerr << "Could not load the level " << levelPath << std::endl;
+			return EXIT_FAILURE;
+		}
+		printResult("level", level.run());
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -141,14 +141,17 @@ void FileGameRound::sendUpdates()
 		extra.push_back(getExtraData(player));
 		extraC.push_back(extra.back().c_str());
 	}
+	std::vector<IConnectionController*> connections;
 	for (auto& player : m_Players)
 	{
 		User::ptr user = player->getUser().lock();
 		if (user)
 		{
-			user->getConnection()->sendUpdateObjects(data.data(), data.size(), extraC.data(), extraC.size());
+			connections.push_back(user->getConnection());
 		}
 	}
+	IConnectionController::broadcastUpdateObjects(connections.data(), connections.size(),
+		data.data(), data.size(), extraC.data(), extraC.size());
 
 	const bool updatePositions = !m_SendHitData.empty();
 	for(const auto& hitData : m_SendHitData)
@@ -41,7 +41,7 @@ GameRound::~GameRound()
 	m_Physics = nullptr;
 }
 
-void GameRound::initialize(ActorFactory::ptr p_ActorFactory, Lobby* p_ReturnLobby)
+void GameRound::initialize(ActorFactory::ptr p_ActorFactory, Lobby* p_ReturnLobby, unsigned int p_NumPhysicsThreads)
 {
 	m_ActorFactory = p_ActorFactory;
 	m_ReturnLobby = p_ReturnLobby;
@@ -51,7 +51,9 @@ void GameRound::initialize(ActorFactory::ptr p_ActorFactory, Lobby* p_ReturnLobb
 
 	m_Physics = IPhysics::createPhysics();
 	m_Physics->setLogFunction(&Logger::logRaw);
-	m_Physics->initialize(true, 1.f / 60.f);
+	// Fast bodies are swept against the level, so the server does not need a short step to keep them from tunnelling
+	m_Physics->initialize(true, 1.f / 30.f, std::max(p_NumPhysicsThreads, 1u));
+	m_Physics->setProfilingEnabled(true);
 
 	m_EventManager.reset(new EventManager);
 
@@ -102,6 +104,49 @@ std::string GameRound::getGameType() const
 	return m_TypeName;
 }
 
+PhysicsStepStats GameRound::getAveragePhysicsStep(unsigned int& p_NumSteps) const
+{
+	PhysicsStepStats average;
+	p_NumSteps = m_Physics ? m_Physics->getNumProfiledSteps() : 0;
+	if (p_NumSteps == 0)
+	{
+		return average;
+	}
+
+	for (unsigned int i = 0; i < p_NumSteps; ++i)
+	{
+		const PhysicsStepStats step = m_Physics->getProfiledStep(i);
+		average.integrationTime += step.integrationTime;
+		average.staticCollisionTime += step.staticCollisionTime;
+		average.broadphaseTime += step.broadphaseTime;
+		average.pairCollisionTime += step.pairCollisionTime;
+		average.totalTime += step.totalTime;
+		average.bodiesIntegrated += step.bodiesIntegrated;
+		average.bodiesSleeping += step.bodiesSleeping;
+		average.broadphaseCandidates += step.broadphaseCandidates;
+		average.volumeTests += step.volumeTests;
+		average.triangleTests += step.triangleTests;
+		average.cachedAxisExits += step.cachedAxisExits;
+		average.hits += step.hits;
+	}
+
+	const float invNumSteps = 1.f / (float)p_NumSteps;
+	average.integrationTime *= invNumSteps;
+	average.staticCollisionTime *= invNumSteps;
+	average.broadphaseTime *= invNumSteps;
+	average.pairCollisionTime *= invNumSteps;
+	average.totalTime *= invNumSteps;
+	average.bodiesIntegrated /= p_NumSteps;
+	average.bodiesSleeping /= p_NumSteps;
+	average.broadphaseCandidates /= p_NumSteps;
+	average.volumeTests /= p_NumSteps;
+	average.triangleTests /= p_NumSteps;
+	average.cachedAxisExits /= p_NumSteps;
+	average.hits /= p_NumSteps;
+
+	return average;
+}
+
 void GameRound::handleExtraPackage(Player::ptr p_Player, Package p_Package)
 {
 	User::ptr user = p_Player->getUser().lock();
@@ -62,8 +62,10 @@ public:
 	 *
 	 * @param p_ActorFactory the factory to be used for any created actors
 	 * @param p_ReturnLobby the lobby where leaving users should be returned
+	 * @param p_NumPhysicsThreads the number of threads to step the physics on,
+	 *			more than one only for rounds with many bodies, since every round has its own threads
 	 */
-	void initialize(ActorFactory::ptr p_ActorFactory, Lobby* p_ReturnLobby);
+	void initialize(ActorFactory::ptr p_ActorFactory, Lobby* p_ReturnLobby, unsigned int p_NumPhysicsThreads = 1);
 	/**
 	 * Set the game list that should be notified when the game ends.
 	 *
@@ -105,6 +107,13 @@ public:
 	 * @return the game type name
 	 */
 	std::string getGameType() const;
+	/**
+	 * Get the average of the recently profiled physics steps.
+	 *
+	 * @param p_NumSteps set to the number of steps the average is based on
+	 * @return the averaged timings and counters
+	 */
+	PhysicsStepStats getAveragePhysicsStep(unsigned int& p_NumSteps) const;
 
 protected:
 	/**
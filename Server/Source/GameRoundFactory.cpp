@@ -17,9 +17,9 @@ GameRound::ptr GameRoundFactory::createRound(const std::string& p_GameType)
 		ActorFactory::ptr actorFactory(new ActorFactory(0));
 
 		std::shared_ptr<FileGameRound> gameRound(new FileGameRound);
-		gameRound->setFilePath(level->second);
+		gameRound->setFilePath(level->second.m_Path);
 		gameRound->setGameType(level->first);
-		gameRound->initialize(actorFactory, m_ReturnLobby);
+		gameRound->initialize(actorFactory, m_ReturnLobby, level->second.m_NumPhysicsThreads);
 
 		return gameRound;
 	}
@@ -29,7 +29,9 @@ GameRound::ptr GameRoundFactory::createRound(const std::string& p_GameType)
 	}
 }
 
-void GameRoundFactory::addLevelPath(const std::string& p_GameType, const std::string& p_LevelPath)
+void GameRoundFactory::addLevelPath(const std::string& p_GameType, const std::string& p_LevelPath, unsigned int p_NumPhysicsThreads)
 {
-	m_Levels[p_GameType] = p_LevelPath;
+	Level& level = m_Levels[p_GameType];
+	level.m_Path = p_LevelPath;
+	level.m_NumPhysicsThreads = p_NumPhysicsThreads;
 }
@@ -18,9 +18,15 @@ class Lobby;
 class GameRoundFactory
 {
 private:
+	struct Level
+	{
+		std::string m_Path;
+		unsigned int m_NumPhysicsThreads;
+	};
+
 	Lobby* m_ReturnLobby;
 
-	std::map<std::string, std::string> m_Levels;
+	std::map<std::string, Level> m_Levels;
 
 public:
 	/**
@@ -43,6 +49,7 @@ public:
 	 *
 	 * @param p_LevelName the name of the level that is later used with #createRound
 	 * @param p_LevelPath the path to the level file describing a game round
+	 * @param p_NumPhysicsThreads the number of threads each round of the level steps its physics on
 	 */
-	void addLevelPath(const std::string& p_GameType, const std::string& p_LevelPath);
+	void addLevelPath(const std::string& p_GameType, const std::string& p_LevelPath, unsigned int p_NumPhysicsThreads = 1);
 };
@@ -42,9 +42,10 @@ void Lobby::checkFreeUsers(float p_DeltaTime)
 void Lobby::addAvailableLevel(const std::string& p_LevelName,
 							  const std::string& p_LevelPath,
 							  unsigned int p_MaxPlayers,
-							  float p_WaitTime)
+							  float p_WaitTime,
+							  unsigned int p_NumPhysicsThreads)
 {
-	m_GameFactory.addLevelPath(p_LevelName, p_LevelPath);
+	m_GameFactory.addLevelPath(p_LevelName, p_LevelPath, p_NumPhysicsThreads);
 
 	AvailableLevel level =
 	{
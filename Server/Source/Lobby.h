@@ -61,8 +61,10 @@ public:
 	 * @param p_MaxPlayers the maximum number of players that
 	 *				can connect before the game should start
 	 * @param p_WaitTime the max time a game waits for more players
+	 * @param p_NumPhysicsThreads the number of threads each game of the level steps its physics on
 	 */
-	void addAvailableLevel(const std::string& p_LevelName, const std::string& p_LevelPath, unsigned int p_MaxPlayers, float p_WaitTime);
+	void addAvailableLevel(const std::string& p_LevelName, const std::string& p_LevelPath, unsigned int p_MaxPlayers, float p_WaitTime,
+		unsigned int p_NumPhysicsThreads = 1);
 	/**
 	 * Add an user to the lobby.
 	 *
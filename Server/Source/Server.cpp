@@ -2,6 +2,10 @@
 
 #include <Logger.h>
 
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
 Server::Server()
 	:	m_RemoveBox(false),
 		m_PulseObject(false)
@@ -70,6 +74,36 @@ std::vector<std::string> Server::getGameDescriptions()
 	return descriptions;
 }
 
+std::vector<std::string> Server::getPhysicsDescriptions()
+{
+	std::vector<std::string> descriptions;
+
+	for (const auto& game : m_Games.getRunningGames())
+	{
+		unsigned int numSteps;
+		const PhysicsStepStats step = game->getAveragePhysicsStep(numSteps);
+
+		std::ostringstream description;
+		description << std::fixed << std::setprecision(3)
+			<< "Game \"" << game->getGameType() << "\", average of " << numSteps << " steps:\n"
+			<< "  total " << step.totalTime << " ms"
+			<< ", integration " << step.integrationTime << " ms"
+			<< ", static collision " << step.staticCollisionTime << " ms"
+			<< ", broadphase " << step.broadphaseTime << " ms"
+			<< ", pair collision " << step.pairCollisionTime << " ms\n"
+			<< "  " << step.bodiesIntegrated << " bodies, "
+			<< step.bodiesSleeping << " sleeping, "
+			<< step.broadphaseCandidates << " pairs, "
+			<< step.volumeTests << " volume tests, "
+			<< step.triangleTests << " triangle tests, "
+			<< step.cachedAxisExits << " cached axis exits, "
+			<< step.hits << " hits";
+		descriptions.push_back(description.str());
+	}
+
+	return descriptions;
+}
+
 void Server::sendTestData()
 {
 	m_RemoveBox = true;
@@ -206,14 +240,17 @@ void Server::addGamesFromFile(const std::string& p_Filename)
 	{
 		int levelMaxPlayers = 8;
 		float levelTimeOut = 20.f;
+		int levelPhysicsThreads = 1;
 		const char* levelName = levelElem->Attribute("Name");
 		const char* levelPath = levelElem->Attribute("Path");
 		levelElem->QueryAttribute("MaxPlayers", &levelMaxPlayers);
 		levelElem->QueryAttribute("TimeOut", &levelTimeOut);
+		levelElem->QueryAttribute("PhysicsThreads", &levelPhysicsThreads);
 
 		if (levelName && levelPath && levelMaxPlayers > 0)
 		{
-			m_Lobby->addAvailableLevel(levelName, levelPath, (unsigned int)levelMaxPlayers, levelTimeOut);
+			m_Lobby->addAvailableLevel(levelName, levelPath, (unsigned int)levelMaxPlayers, levelTimeOut,
+				(unsigned int)std::max(levelPhysicsThreads, 1));
 			++numAddedGames;
 		}
 	}
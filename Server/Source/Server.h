@@ -68,6 +68,12 @@ public:
 	 * @return game descriptions
 	 */
 	std::vector<std::string> getGameDescriptions();
+	/**
+	 * Get the average physics step timings for all running games.
+	 *
+	 * @return one description per game
+	 */
+	std::vector<std::string> getPhysicsDescriptions();
 	/**
 	 * Send some test data.
 	 */
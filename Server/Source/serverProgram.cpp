@@ -18,6 +18,7 @@ void printHelp()
 		"  pulse    Pulse an object\n"
 		"  list     List all the connected clients\n"
 		"  games    List all running games\n"
+		"  physics  Show physics step timings of the running games\n"
 		"  exit     Shutdown the server\n";
 
 	std::cout << helpMessage;
@@ -39,6 +40,14 @@ void listGames()
 	}
 }
 
+void listPhysics()
+{
+	for (const auto& game : server.getPhysicsDescriptions())
+	{
+		std::cout << game << std::endl;
+	}
+}
+
 void printUnknownCommand()
 {
 	std::cout << "Unknown command. Use 'help' for available commands." << std::endl;
@@ -76,6 +85,8 @@ int main(int argc, char* argv[])
 			listUsers();
 		else if (input == "games")
 			listGames();
+		else if (input == "physics")
+			listPhysics();
 		else if (input == "pulse")
 			server.sendPulseObject();
 		else